@@ -33,8 +33,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <array>
+#include <unordered_map>
+#include <vector>
 #include "rnp.h"
 #include "librepgp/stream-common.h"
+#include "sig-cache.h"
+#include "arena.h"
+#include "parallel.h"
 
 typedef struct pgp_key_t pgp_key_t;
 
@@ -122,13 +129,90 @@ typedef enum pgp_key_import_status_t {
     PGP_KEY_IMPORT_STATUS_NEW,
 } pgp_key_import_status_t;
 
+typedef std::array<uint8_t, PGP_KEY_GRIP_SIZE>   pgp_key_grip_t;
+typedef std::array<uint8_t, PGP_KEY_ID_SIZE>     pgp_key_id_t;
+typedef std::array<uint8_t, PGP_KEY_ID_SIZE / 2> pgp_key_short_id_t;
+
+/* FNV-1a over the identifier bytes, collisions are resolved by the map itself */
+struct pgp_key_ident_hash {
+    size_t
+    hash(const uint8_t *data, size_t len) const noexcept
+    {
+        uint64_t res = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < len; i++) {
+            res = (res ^ data[i]) * 0x100000001b3ULL;
+        }
+        return (size_t) res;
+    }
+
+    template <size_t N>
+    size_t
+    operator()(const std::array<uint8_t, N> &id) const noexcept
+    {
+        return hash(id.data(), N);
+    }
+
+    size_t
+    operator()(const pgp_fingerprint_t &fp) const noexcept
+    {
+        return hash(fp.fingerprint, fp.length);
+    }
+};
+
+struct pgp_fingerprint_equal {
+    bool
+    operator()(const pgp_fingerprint_t &fp1, const pgp_fingerprint_t &fp2) const noexcept
+    {
+        return (fp1.length == fp2.length) &&
+               !memcmp(fp1.fingerprint, fp2.fingerprint, fp1.length);
+    }
+};
+
+/* keys with the same identifier, in the order of rnp_key_store_t::keys */
+typedef std::vector<pgp_key_t *> pgp_key_bucket_t;
+
+typedef std::unordered_map<pgp_key_grip_t, pgp_key_t *, pgp_key_ident_hash> pgp_grip_index_t;
+typedef std::unordered_map<pgp_fingerprint_t,
+                           pgp_key_bucket_t,
+                           pgp_key_ident_hash,
+                           pgp_fingerprint_equal>
+  pgp_fp_index_t;
+typedef std::unordered_map<pgp_key_id_t, pgp_key_bucket_t, pgp_key_ident_hash>
+  pgp_keyid_index_t;
+typedef std::unordered_map<pgp_key_short_id_t, pgp_key_bucket_t, pgp_key_ident_hash>
+  pgp_short_id_index_t;
+
+/* issuers of the subkey binding signatures, under which orphaned subkey is registered */
+typedef struct pgp_subkey_issuers_t {
+    std::vector<pgp_fingerprint_t> fps;
+    std::vector<pgp_key_id_t>      keyids;
+} pgp_subkey_issuers_t;
+
 typedef struct rnp_key_store_t {
     const char *           path;
     pgp_key_store_format_t format;
     bool disable_validation; /* do not automatically validate keys, added to this key store */
-
-    list keys;  // list of pgp_key_t
-    list blobs; // list of kbx_blob_t
+    pgp_sig_cache_t *sigcache;   /* optional signature verification cache, not owned */
+    size_t           cert_limit; /* max third-party certifications per userid, 0 - no limit */
+
+    rnp_thread_pool_t *pool; /* optional workers for rnp_key_store_validate(), not owned */
+
+    list  keys;    // list of pgp_key_t
+    list  blobs;   // list of kbx_blob_t
+    arena packets; // raw packets of the loaded keys, released by rnp_key_store_clear()
+
+    /* lookup indexes over the keys list, kept up to date by add/remove/clear functions */
+    uint64_t                                        nextseq;
+    std::unordered_map<const pgp_key_t *, uint64_t> keyseq; // position of the key in keys
+    pgp_grip_index_t                                keybygrip;
+    pgp_fp_index_t                                  keybyfp;
+    pgp_keyid_index_t                               keybyid;
+    pgp_short_id_index_t                            keybyshortid;
+
+    /* subkeys without primary_grip, waiting for their primary key to be added */
+    std::unordered_map<const pgp_key_t *, pgp_subkey_issuers_t> orphans;
+    pgp_fp_index_t                                              orphansbyfp;
+    pgp_keyid_index_t                                           orphansbyid;
 } rnp_key_store_t;
 
 rnp_key_store_t *rnp_key_store_new(pgp_key_store_format_t format, const char *path);
@@ -150,6 +234,16 @@ list       rnp_key_store_get_keys(const rnp_key_store_t *);
 
 pgp_key_t *rnp_key_store_add_key(rnp_key_store_t *, pgp_key_t *);
 
+/**
+ * @brief Validate keys of the keyring which are not validated yet (i.e. were added with
+ *        disable_validation set), as well as subkeys of such keys. Self-signatures of all
+ *        those keys are checked in parallel, see pgp_key_validate_batch().
+ *
+ * @param keyring keyring, which must not be modified concurrently
+ * @param threads maximum number of threads to use, 0 means number of available cores
+ */
+void rnp_key_store_validate(rnp_key_store_t *keyring, size_t threads);
+
 pgp_key_t *rnp_key_store_import_key(rnp_key_store_t *,
                                     pgp_key_t *,
                                     bool,
@@ -163,6 +257,18 @@ pgp_key_t *rnp_key_store_get_key_by_id(const rnp_key_store_t *,
 
 bool rnp_key_store_get_key_grip(const pgp_key_material_t *, uint8_t *);
 
+/**
+ * @brief Calculate grips of a number of keys, hashing them in a batch.
+ *
+ * @param keys array of count key materials
+ * @param count number of keys
+ * @param grips output buffer of count * PGP_KEY_GRIP_SIZE bytes
+ * @return true on success or false otherwise
+ */
+bool rnp_key_store_get_key_grips(const pgp_key_material_t *const *keys,
+                                 size_t                           count,
+                                 uint8_t *                        grips);
+
 pgp_key_t *rnp_key_store_get_key_by_grip(const rnp_key_store_t *, const uint8_t *);
 pgp_key_t *rnp_key_store_get_key_by_fpr(const rnp_key_store_t *, const pgp_fingerprint_t *fpr);
 pgp_key_t *rnp_key_store_get_primary_key(const rnp_key_store_t *, const pgp_key_t *);
@@ -74,6 +74,13 @@ typedef uint32_t rnp_result_t;
  */
 #define RNP_LOAD_SAVE_PUBLIC_KEYS (1U << 0)
 #define RNP_LOAD_SAVE_SECRET_KEYS (1U << 1)
+/* rnp_load_keys only: validate loaded keys in a single parallel pass after loading */
+#define RNP_LOAD_BULK_VALIDATION (1U << 2)
+
+/**
+ * Flags for input structure creation.
+ */
+#define RNP_INPUT_FILE_MMAP (1U << 0)
 
 /**
  * Flags for output structure creation.
@@ -153,6 +160,20 @@ rnp_result_t rnp_enable_debug(const char *file);
  */
 rnp_result_t rnp_disable_debug();
 
+/**
+ * @brief Configure process-wide cache of the keys, derived from passwords during the
+ *        decryption of messages and secret keys. It allows to avoid repeated expensive
+ *        key derivation when the same password and S2K parameters are used again.
+ *        Cached keys are kept in locked memory and wiped on expiration. Cache is disabled
+ *        by default.
+ *
+ * @param size maximum number of the cached keys. 0 disables the cache and wipes it.
+ * @param ttl number of seconds during which derived key stays in the cache, must be
+ *        non-zero if size is non-zero.
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_set_s2k_cache(size_t size, uint32_t ttl);
+
 /*
  * Opaque structures
  */
@@ -165,6 +186,7 @@ typedef struct rnp_op_sign_st *            rnp_op_sign_t;
 typedef struct rnp_op_sign_signature_st *  rnp_op_sign_signature_t;
 typedef struct rnp_op_verify_st *          rnp_op_verify_t;
 typedef struct rnp_op_verify_signature_st *rnp_op_verify_signature_t;
+typedef struct rnp_op_verify_batch_st *    rnp_op_verify_batch_t;
 typedef struct rnp_op_encrypt_st *         rnp_op_encrypt_t;
 typedef struct rnp_identifier_iterator_st *rnp_identifier_iterator_t;
 typedef struct rnp_uid_handle_st *         rnp_uid_handle_t;
@@ -236,6 +258,37 @@ typedef void (*rnp_get_key_cb)(rnp_ffi_t   ffi,
                                bool        secret);
 
 /** create the top-level object used for interacting with the library
+ *
+ *  Single ffi object may be used by multiple threads at once:
+ *  - operations which only read the keyrings take the shared lock and may run concurrently:
+ *    encryption, signing, decryption and verification (rnp_op_*_execute(), rnp_decrypt()),
+ *    key lookup and iteration, key export, keyring saving and key counting, and the key and
+ *    uid property getters (rnp_key_get_*(), rnp_key_is_*(), rnp_uid_*() and so on).
+ *  - operations which modify the keyrings or keys take the exclusive lock, waiting for the
+ *    running readers and blocking the new ones: key loading and unloading (where the keys are
+ *    parsed before taking the lock), import, removal and generation, adding the userid,
+ *    key locking, unlocking, protection and unprotection.
+ *  - keys which already exist are updated by loading and importing in place: key and uid
+ *    handles stay valid and see the updated key, uid indexes do not change. Signature
+ *    handles keep their own copy of the signature, so they are not affected by the update.
+ *  - random number generator is maintained per thread, so encryption and signing do not
+ *    serialize on it.
+ *  - parallel work (AEAD chunks, compression blocks, bulk key validation and batch
+ *    verification) is done by the worker threads, kept by the ffi object until it is
+ *    destroyed. They are started on first use, up to the number of available cores, and are
+ *    shared by all threads which use the ffi object.
+ *  Application must follow these rules:
+ *  - ffi settings (rnp_ffi_set_*()) must be set up before starting the concurrent use.
+ *  - key, uid and signature handles, op, input and output objects must not be used by
+ *    multiple threads at once. They may be passed between threads.
+ *  - keys must not be removed or unloaded while the handles or operations which use them
+ *    are alive. Loading and importing keys is always safe.
+ *  - callbacks (key and password providers, input and output callbacks) may be called
+ *    concurrently from the different threads. Key provider callback is called while the
+ *    calling thread holds the shared lock: from rnp_op_*_execute(), rnp_decrypt() and key
+ *    handle functions. It may load or import keys: then the thread's shared lock is
+ *    upgraded to the exclusive one, which waits until other threads leave their reads.
+ *    It must not remove or unload keys.
  *
  *  @param ffi pointer that will be set to the created ffi object
  *  @param pub_format the format of the public keyring, RNP_KEYSTORE_GPG or other
@@ -264,6 +317,59 @@ rnp_result_t rnp_ffi_set_pass_provider(rnp_ffi_t       ffi,
                                        rnp_password_cb getpasscb,
                                        void *          getpasscb_ctx);
 
+/** enable or disable cache of the signature verification results.
+ *  When enabled, public key operation is not repeated for signatures which were already
+ *  checked, i.e. when the same key is imported or merged again. Time-dependent checks,
+ *  like signature expiration, are still performed each time.
+ *
+ *  @param ffi the ffi object
+ *  @param size maximum number of the cached results, or 0 to disable the cache (default)
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_ffi_set_signature_cache(rnp_ffi_t ffi, size_t size);
+
+/** limit number of the third-party certifications per userid, accepted during the key import
+ *  via rnp_import_keys(). Certifications over the limit are skipped, so certificate flooded
+ *  with the signatures doesn't stall the import and use all the memory.
+ *  Self-signatures and revocations are not counted and always kept. Keys loaded via
+ *  rnp_load_keys() are not limited, and certifications, which key already has in the
+ *  keyring, are never dropped: new ones are only added while there are less than the limit.
+ *  Note: certifications are not verified before the limit is applied, so if certificate
+ *  has more of them than the limit, bogus ones going first may push out the valid ones.
+ *
+ *  @param ffi the ffi object
+ *  @param limit maximum number of the certifications, or 0 to accept all of them (default)
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_ffi_set_certification_limit(rnp_ffi_t ffi, size_t limit);
+
+/** set number of threads used to encrypt or decrypt AEAD chunks in parallel.
+ *  Chunks are read ahead, processed on the separate threads and written out in order. This
+ *  requires memory for one chunk per thread, so is used only for chunks up to 4 MB, i.e. with
+ *  the chunk size bits up to 16 (see rnp_op_encrypt_set_aead_bits()). Larger chunks are
+ *  processed sequentially.
+ *
+ *  @param ffi the ffi object
+ *  @param threads number of threads, 0 or 1 to process chunks sequentially (default).
+ *         Values above the number of available CPU cores are lowered to it.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_ffi_set_aead_threads(rnp_ffi_t ffi, size_t threads);
+
+/** enable or disable pipelined processing of the encryption and signing operations.
+ *  When enabled, compression, encryption and armoring of the large (1 MB and more, or of
+ *  unknown size) inputs are run on their own threads, connected with bounded queues, while
+ *  the calling thread reads and hashes the input. So operation takes about the time of its
+ *  slowest stage instead of the sum of all stages.
+ *  Note: in this mode output callbacks are called from the worker thread.
+ *
+ *  @param ffi the ffi object
+ *  @param enable true to enable pipelining, false to process data on the calling thread
+ *         (default).
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_ffi_set_pipeline(rnp_ffi_t ffi, bool enable);
+
 /* Operations on key rings */
 
 /** retrieve the default homedir (example: /home/user/.rnp)
@@ -344,7 +450,10 @@ rnp_result_t rnp_supported_features(const char *type, char **result);
  * @param ffi
  * @param format the key format of the data (GPG, KBX, G10). Must not be NULL.
  * @param input source to read from.
- * @param flags the flags. See RNP_LOAD_SAVE_*.
+ * @param flags the flags. See RNP_LOAD_SAVE_*. Additionally RNP_LOAD_BULK_VALIDATION may be
+ *              specified: then key validation is not done one by one during the load, but
+ *              after the whole input is parsed, using all available cores. This speeds up
+ *              loading of the large keyrings.
  * @return RNP_SUCCESS on success, or any other value on error
  */
 rnp_result_t rnp_load_keys(rnp_ffi_t   ffi,
@@ -1385,6 +1494,17 @@ rnp_result_t rnp_op_sign_signature_set_expiration_time(rnp_op_sign_signature_t s
  */
 rnp_result_t rnp_op_sign_set_compression(rnp_op_sign_t op, const char *compression, int level);
 
+/** @brief Set number of threads used to compress data. Input is split into blocks of 128 KB
+ *         for ZIP/ZLIB or of the maximum bzip2 block size for BZip2, which are compressed in
+ *         parallel and concatenated into a single compressed stream. Deflate blocks are primed
+ *         with the end of the previous block, so compression ratio is almost unchanged.
+ *  @param op opaque signing context. Must be initialized with rnp_op_sign_create function
+ *  @param threads number of threads, 0 or 1 to compress data sequentially (default).
+ *         Values above the number of available CPU cores are lowered to it.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+rnp_result_t rnp_op_sign_set_compression_threads(rnp_op_sign_t op, size_t threads);
+
 /** @brief Enabled or disable armored (textual) output. Doesn't make sense for cleartext sign.
  *  @param op opaque signing context. Must be initialized with rnp_op_sign_create or
  *         rnp_op_sign_detached_create function.
@@ -1436,6 +1556,16 @@ rnp_result_t rnp_op_sign_set_file_name(rnp_op_sign_t op, const char *filename);
  */
 rnp_result_t rnp_op_sign_set_file_mtime(rnp_op_sign_t op, uint32_t mtime);
 
+/** @brief Set size of the buffers used to read and write data during the operation.
+ *         By default buffer size is picked basing on the input size, if it is known: small
+ *         buffers are used for the small messages and larger ones for the bulk data.
+ *  @param op opaque signing context. Must be initialized with rnp_op_sign_create function
+ *  @param size buffer size in bytes, up to 4 MB. It will be rounded up to the power of two,
+ *         starting from 8 KB. 0 restores the default behaviour.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+rnp_result_t rnp_op_sign_set_buffer_size(rnp_op_sign_t op, size_t size);
+
 /** @brief Execute previously initialized signing operation.
  *  @param op opaque signing context. Must be successfully initialized with one of the
  *         rnp_op_sign_*_create functions. At least one signing key should be added.
@@ -1480,6 +1610,14 @@ rnp_result_t rnp_op_verify_detached_create(rnp_op_verify_t *op,
                                            rnp_input_t      input,
                                            rnp_input_t      signature);
 
+/** @brief Set size of the buffers used to read and write data during the operation.
+ *         See rnp_op_sign_set_buffer_size() for the details.
+ *  @param op opaque verification context. Must be successfully initialized.
+ *  @param size buffer size in bytes, or 0 to use the default behaviour.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+rnp_result_t rnp_op_verify_set_buffer_size(rnp_op_verify_t op, size_t size);
+
 /** @brief Execute previously initialized verification operation.
  *  @param op opaque verification context. Must be successfully initialized.
  *  @return RNP_SUCCESS if data was processed successfully and all signatures are valid.
@@ -1572,6 +1710,107 @@ rnp_result_t rnp_op_verify_signature_get_times(rnp_op_verify_signature_t sig,
                                                uint32_t *                create,
                                                uint32_t *                expires);
 
+/** @brief Callback, called for each item of the batch verification once it is processed.
+ *         May be called concurrently from the different threads, and must not call
+ *         functions which access the keyrings, since batch holds the lock on them.
+ *
+ *  @param op batch verification context
+ *  @param idx index of the item, in order of adding to the batch
+ *  @param verify verification context of the item, which may be queried for the signatures
+ *         and file information. It is owned by the batch and must not be destroyed.
+ *  @param status result of the item's verification, as rnp_op_verify_execute() would return
+ *  @param app_ctx context, provided to the rnp_op_verify_batch_set_callback()
+ */
+typedef void (*rnp_op_verify_batch_cb)(rnp_op_verify_batch_t op,
+                                       size_t                idx,
+                                       rnp_op_verify_t       verify,
+                                       rnp_result_t          status,
+                                       void *                app_ctx);
+
+/** @brief Create batch verification context. It verifies many independent inputs with
+ *         embedded, cleartext or detached signatures on the internal thread pool, sharing
+ *         signer key lookups between the items. Keys must be loaded before the execution:
+ *         key provider callback set via rnp_ffi_set_key_provider() is not called.
+ *  @param op pointer to opaque batch verification context
+ *  @param ffi
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_create(rnp_op_verify_batch_t *op, rnp_ffi_t ffi);
+
+/** @brief Add input with embedded or cleartext signature to the batch.
+ *  @param op opaque batch verification context
+ *  @param input stream with signed data. Must be valid until the batch is destroyed, and not
+ *         used by the other items.
+ *  @param output where to write the verified data. May be NULL to discard it.
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_add(rnp_op_verify_batch_t op,
+                                     rnp_input_t           input,
+                                     rnp_output_t          output);
+
+/** @brief Add data with detached signature to the batch.
+ *  @param op opaque batch verification context
+ *  @param input stream with the signed data. Must be valid until the batch is destroyed.
+ *  @param signature stream with the detached signature. Must be valid until the batch is
+ *         destroyed.
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_add_detached(rnp_op_verify_batch_t op,
+                                              rnp_input_t           input,
+                                              rnp_input_t           signature);
+
+/** @brief Set number of threads used to verify the batch.
+ *  @param op opaque batch verification context
+ *  @param threads number of threads, 0 to use all of the available cores (default).
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_set_threads(rnp_op_verify_batch_t op, size_t threads);
+
+/** @brief Set callback, which is called for each item once it is verified.
+ *  @param op opaque batch verification context
+ *  @param callback see rnp_op_verify_batch_cb. May be NULL.
+ *  @param app_ctx context, passed to the callback
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_set_callback(rnp_op_verify_batch_t  op,
+                                              rnp_op_verify_batch_cb callback,
+                                              void *                 app_ctx);
+
+/** @brief Verify all items of the batch.
+ *  @param op opaque batch verification context
+ *  @return RNP_SUCCESS if all items were processed, results of the items must be checked via
+ *          the callback or rnp_op_verify_batch_get_item().
+ */
+rnp_result_t rnp_op_verify_batch_execute(rnp_op_verify_batch_t op);
+
+/** @brief Get number of items in the batch.
+ *  @param op opaque batch verification context
+ *  @param count number of items will be stored here
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_get_item_count(rnp_op_verify_batch_t op, size_t *count);
+
+/** @brief Get verification results of the batch item.
+ *  @param op opaque batch verification context
+ *  @param idx index of the item, in order of adding to the batch
+ *  @param verify verification context of the item will be stored here. It may be queried
+ *         for the signatures and file information, and is owned by the batch. May be NULL.
+ *  @param status result of the item's verification, as rnp_op_verify_execute() would return,
+ *         will be stored here. May be NULL.
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+rnp_result_t rnp_op_verify_batch_get_item(rnp_op_verify_batch_t op,
+                                          size_t                idx,
+                                          rnp_op_verify_t *     verify,
+                                          rnp_result_t *        status);
+
+/** @brief Free resources allocated in batch verification context, including the items'
+ *         verification contexts.
+ *  @param op opaque batch verification context.
+ *  @return RNP_SUCCESS if call succeeded.
+ */
+rnp_result_t rnp_op_verify_batch_destroy(rnp_op_verify_batch_t op);
+
 /* TODO define functions for encrypt+sign */
 
 /**
@@ -1591,6 +1830,21 @@ void rnp_buffer_destroy(void *ptr);
  */
 rnp_result_t rnp_input_from_path(rnp_input_t *input, const char *path);
 
+/**
+ * @brief Initialize input struct to read from a file
+ *
+ * @param input pointer to the input opaque structure
+ * @param path path of the file to read from
+ * @param flags additional flags, see RNP_INPUT_FILE_* flags:
+ *        RNP_INPUT_FILE_MMAP: map non-empty regular file to memory when system supports it,
+ *        so data is parsed without read() calls and copying. Other files are read as usual.
+ *        File must not be truncated or rewritten in place until input is destroyed, otherwise
+ *        process gets SIGBUS signal on reading. Replacing file via rename() is safe.
+ * @return RNP_SUCCESS if operation succeeded and input struct is ready to read, or error code
+ * otherwise
+ */
+rnp_result_t rnp_input_from_file(rnp_input_t *input, const char *path, uint32_t flags);
+
 /**
  * @brief Initialize input struct to read from memory
  *
@@ -1879,6 +2133,17 @@ rnp_result_t rnp_op_encrypt_set_compression(rnp_op_encrypt_t op,
                                             const char *     compression,
                                             int              level);
 
+/**
+ * @brief set number of threads used to compress data.
+ *        See rnp_op_sign_set_compression_threads() for the details.
+ *
+ * @param op opaque encrypted context. Must be allocated and initialized
+ * @param threads number of threads, 0 or 1 to compress data sequentially (default).
+ *        Values above the number of available CPU cores are lowered to it.
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_op_encrypt_set_compression_threads(rnp_op_encrypt_t op, size_t threads);
+
 /**
  * @brief set the internally stored file name for the data being encrypted
  *
@@ -1898,6 +2163,16 @@ rnp_result_t rnp_op_encrypt_set_file_name(rnp_op_encrypt_t op, const char *filen
  */
 rnp_result_t rnp_op_encrypt_set_file_mtime(rnp_op_encrypt_t op, uint32_t mtime);
 
+/**
+ * @brief set size of the buffers used to read and write data during the operation.
+ *        See rnp_op_sign_set_buffer_size() for the details.
+ *
+ * @param op opaque encrypted context. Must be allocated and initialized
+ * @param size buffer size in bytes, or 0 to use the default behaviour.
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+rnp_result_t rnp_op_encrypt_set_buffer_size(rnp_op_encrypt_t op, size_t size);
+
 rnp_result_t rnp_op_encrypt_execute(rnp_op_encrypt_t op);
 rnp_result_t rnp_op_encrypt_destroy(rnp_op_encrypt_t op);
 
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "arena.h"
+
+/* alignment, suitable for any of the fundamental types */
+#define ARENA_ALIGN alignof(max_align_t)
+
+/* block header, followed by the data */
+struct arena_block {
+    arena_block *next; /* previously allocated block */
+    size_t       size; /* number of bytes available for allocations */
+    size_t       used; /* number of bytes already allocated */
+};
+
+static size_t
+arena_align(size_t size)
+{
+    return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+static uint8_t *
+arena_block_data(arena_block *block)
+{
+    return (uint8_t *) block + arena_align(sizeof(*block));
+}
+
+static arena_block *
+arena_add_block(arena *mem, size_t size)
+{
+    size_t hdr = arena_align(sizeof(arena_block));
+    if (size > SIZE_MAX - hdr) {
+        return NULL;
+    }
+    arena_block *block = (arena_block *) malloc(hdr + size);
+    if (!block) {
+        return NULL;
+    }
+    block->size = size;
+    block->used = 0;
+    /* dedicated blocks go behind the current one so its free space is still used */
+    if (mem->blocks && (size > (mem->block_size ? mem->block_size : ARENA_BLOCK_SIZE))) {
+        block->next = mem->blocks->next;
+        mem->blocks->next = block;
+    } else {
+        block->next = mem->blocks;
+        mem->blocks = block;
+    }
+    return block;
+}
+
+void *
+arena_alloc(arena *mem, size_t size)
+{
+    if (!mem || !size || (size > SIZE_MAX - ARENA_ALIGN)) {
+        return NULL;
+    }
+    size = arena_align(size);
+
+    arena_block *block = mem->blocks;
+    if (!block || (block->size - block->used < size)) {
+        size_t block_size = mem->block_size ? mem->block_size : ARENA_BLOCK_SIZE;
+        if (!(block = arena_add_block(mem, size > block_size ? size : block_size))) {
+            return NULL;
+        }
+    }
+    void *res = arena_block_data(block) + block->used;
+    block->used += size;
+    mem->total += size;
+    return res;
+}
+
+void *
+arena_memdup(arena *mem, const void *data, size_t size)
+{
+    void *res = arena_alloc(mem, size);
+    if (res) {
+        memcpy(res, data, size);
+    }
+    return res;
+}
+
+size_t
+arena_block_count(const arena *mem)
+{
+    size_t count = 0;
+    for (arena_block *block = mem ? mem->blocks : NULL; block; block = block->next) {
+        count++;
+    }
+    return count;
+}
+
+void
+arena_splice(arena *dst, arena *src)
+{
+    if (!src->blocks) {
+        return;
+    }
+    arena_block *last = src->blocks;
+    while (last->next) {
+        last = last->next;
+    }
+    /* current block of dst goes first, so its free space is still used */
+    if (dst->blocks) {
+        last->next = dst->blocks->next;
+        dst->blocks->next = src->blocks;
+    } else {
+        dst->blocks = src->blocks;
+    }
+    dst->total += src->total;
+    src->blocks = NULL;
+    src->total = 0;
+}
+
+void
+arena_destroy(arena *mem)
+{
+    arena_block *block = mem->blocks;
+    while (block) {
+        arena_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    mem->blocks = NULL;
+    mem->total = 0;
+}
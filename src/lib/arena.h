@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** Region-based allocator
+ *  @file
+ */
+#ifndef RNP_ARENA_H
+#define RNP_ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Default size of the arena block */
+#define ARENA_BLOCK_SIZE 65536
+
+typedef struct arena_block arena_block;
+
+/**
+ *  @private
+ *  Bump allocator for many small allocations sharing the same lifetime.
+ *
+ *  Memory is carved from large blocks, so the allocation is a pointer increment
+ *  in the common case, and there is no way to release a single allocation:
+ *  everything is released at once by arena_destroy(). Allocations larger than the
+ *  block size get a dedicated block.
+ *
+ *  A zero-initialized structure is a valid empty arena, which uses
+ *  ARENA_BLOCK_SIZE blocks. Moving the arena with memcpy() or plain assignment
+ *  transfers ownership of the allocated memory.
+ *
+ *  @code
+ *  arena    mem = {};
+ *  uint8_t *buf = (uint8_t *) arena_alloc(&mem, 100);
+ *  char *   str = (char *) arena_memdup(&mem, "text", 5);
+ *  arena_destroy(&mem);
+ *  @endcode
+ */
+typedef struct arena {
+    arena_block *blocks;     /* list of the blocks, the current one goes first */
+    size_t       block_size; /* size of the block, 0 means ARENA_BLOCK_SIZE */
+    size_t       total;      /* number of bytes allocated from the arena */
+} arena;
+
+/** @private
+ *  allocate memory from the arena. Returned pointer is aligned for any type.
+ *
+ *  @param mem pointer to the arena, which should not be NULL
+ *  @param size number of bytes to allocate, must be >= 1
+ *  @return pointer to the uninitialized memory or NULL if allocation failed
+ **/
+void *arena_alloc(arena *mem, size_t size);
+
+/** @private
+ *  allocate memory from the arena and copy data into it
+ *
+ *  @param mem pointer to the arena, which should not be NULL
+ *  @param data pointer to the data, which should not be NULL
+ *  @param size number of bytes to copy, must be >= 1
+ *  @return pointer to the copy or NULL if allocation failed
+ **/
+void *arena_memdup(arena *mem, const void *data, size_t size);
+
+/** @private
+ *  get the number of blocks, allocated by the arena
+ *
+ *  @param mem pointer to the arena, may be NULL
+ *  @return the number of blocks
+ **/
+size_t arena_block_count(const arena *mem);
+
+/** @private
+ *  move all memory, allocated from the src arena, to the dst one, leaving src empty. So
+ *  allocations from src stay valid until dst is destroyed.
+ *
+ *  @param dst pointer to the destination arena, which should not be NULL
+ *  @param src pointer to the source arena, which should not be NULL
+ **/
+void arena_splice(arena *dst, arena *src);
+
+/** @private
+ *  release all memory, allocated from the arena, leaving the empty arena with the
+ *  same block size
+ *
+ *  @param mem pointer to the arena, which should not be NULL
+ **/
+void arena_destroy(arena *mem);
+
+#endif
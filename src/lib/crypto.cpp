@@ -198,6 +198,191 @@ key_material_equal(const pgp_key_material_t *key1, const pgp_key_material_t *key
     }
 }
 
+/* Maximum number of mpis in the key, signature or encrypted material */
+#define PGP_MATERIAL_MAX_MPIS 6
+
+/* Collect pointers to the key mpis: public ones first, then secret if requested */
+static size_t
+key_material_mpis(pgp_key_material_t *key, pgp_mpi_t **mpis, bool secret)
+{
+    switch (key->alg) {
+    case PGP_PKA_RSA:
+    case PGP_PKA_RSA_ENCRYPT_ONLY:
+    case PGP_PKA_RSA_SIGN_ONLY:
+        mpis[0] = &key->rsa.n;
+        mpis[1] = &key->rsa.e;
+        if (!secret) {
+            return 2;
+        }
+        mpis[2] = &key->rsa.d;
+        mpis[3] = &key->rsa.p;
+        mpis[4] = &key->rsa.q;
+        mpis[5] = &key->rsa.u;
+        return 6;
+    case PGP_PKA_DSA:
+        mpis[0] = &key->dsa.p;
+        mpis[1] = &key->dsa.q;
+        mpis[2] = &key->dsa.g;
+        mpis[3] = &key->dsa.y;
+        mpis[4] = &key->dsa.x;
+        return secret ? 5 : 4;
+    case PGP_PKA_ELGAMAL:
+    case PGP_PKA_ELGAMAL_ENCRYPT_OR_SIGN:
+        mpis[0] = &key->eg.p;
+        mpis[1] = &key->eg.g;
+        mpis[2] = &key->eg.y;
+        mpis[3] = &key->eg.x;
+        return secret ? 4 : 3;
+    case PGP_PKA_ECDSA:
+    case PGP_PKA_EDDSA:
+    case PGP_PKA_SM2:
+    case PGP_PKA_ECDH:
+        mpis[0] = &key->ec.p;
+        mpis[1] = &key->ec.x;
+        return secret ? 2 : 1;
+    default:
+        return 0;
+    }
+}
+
+static size_t
+signature_material_mpis(pgp_signature_material_t *sig, pgp_pubkey_alg_t alg, pgp_mpi_t **mpis)
+{
+    switch (alg) {
+    case PGP_PKA_RSA:
+    case PGP_PKA_RSA_ENCRYPT_ONLY:
+    case PGP_PKA_RSA_SIGN_ONLY:
+        mpis[0] = &sig->rsa.s;
+        return 1;
+    case PGP_PKA_DSA:
+        mpis[0] = &sig->dsa.r;
+        mpis[1] = &sig->dsa.s;
+        return 2;
+    case PGP_PKA_EDDSA:
+    case PGP_PKA_ECDSA:
+    case PGP_PKA_SM2:
+    case PGP_PKA_ECDH:
+        mpis[0] = &sig->ecc.r;
+        mpis[1] = &sig->ecc.s;
+        return 2;
+    case PGP_PKA_ELGAMAL:
+    case PGP_PKA_ELGAMAL_ENCRYPT_OR_SIGN:
+        mpis[0] = &sig->eg.r;
+        mpis[1] = &sig->eg.s;
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+static bool
+material_mpis_copy(pgp_mpi_t **dst, pgp_mpi_t **src, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i]->mpi = NULL;
+        dst[i]->len = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!mpi_copy(dst[i], src[i])) {
+            for (size_t j = 0; j < i; j++) {
+                mpi_forget(dst[j]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+key_material_copy(pgp_key_material_t *dst, const pgp_key_material_t *src, bool pubonly)
+{
+    pgp_mpi_t *dstmpis[PGP_MATERIAL_MAX_MPIS];
+    pgp_mpi_t *srcmpis[PGP_MATERIAL_MAX_MPIS];
+
+    *dst = *src;
+    /* secret mpis of the destination are left empty if only public part is copied */
+    size_t count = key_material_mpis(dst, dstmpis, true);
+    size_t ccount = key_material_mpis((pgp_key_material_t *) src, srcmpis, !pubonly);
+    for (size_t i = ccount; i < count; i++) {
+        dstmpis[i]->mpi = NULL;
+        dstmpis[i]->len = 0;
+    }
+    if (pubonly) {
+        dst->secret = false;
+    }
+    if (!material_mpis_copy(dstmpis, srcmpis, ccount)) {
+        RNP_LOG("allocation failed");
+        return false;
+    }
+    return true;
+}
+
+void
+key_material_free(pgp_key_material_t *key)
+{
+    pgp_mpi_t *mpis[PGP_MATERIAL_MAX_MPIS];
+    size_t     count = key_material_mpis(key, mpis, true);
+
+    for (size_t i = 0; i < count; i++) {
+        mpi_forget(mpis[i]);
+    }
+    key->secret = false;
+}
+
+bool
+signature_material_copy(pgp_signature_material_t *      dst,
+                        const pgp_signature_material_t *src,
+                        pgp_pubkey_alg_t                alg)
+{
+    pgp_mpi_t *dstmpis[PGP_MATERIAL_MAX_MPIS];
+    pgp_mpi_t *srcmpis[PGP_MATERIAL_MAX_MPIS];
+
+    *dst = *src;
+    size_t count = signature_material_mpis(dst, alg, dstmpis);
+    signature_material_mpis((pgp_signature_material_t *) src, alg, srcmpis);
+    if (!material_mpis_copy(dstmpis, srcmpis, count)) {
+        RNP_LOG("allocation failed");
+        return false;
+    }
+    return true;
+}
+
+void
+signature_material_free(pgp_signature_material_t *sig, pgp_pubkey_alg_t alg)
+{
+    pgp_mpi_t *mpis[PGP_MATERIAL_MAX_MPIS];
+    size_t     count = signature_material_mpis(sig, alg, mpis);
+
+    for (size_t i = 0; i < count; i++) {
+        mpi_free(mpis[i]);
+    }
+}
+
+void
+encrypted_material_free(pgp_encrypted_material_t *enc, pgp_pubkey_alg_t alg)
+{
+    switch (alg) {
+    case PGP_PKA_RSA:
+    case PGP_PKA_RSA_ENCRYPT_ONLY:
+    case PGP_PKA_RSA_SIGN_ONLY:
+        mpi_free(&enc->rsa.m);
+        break;
+    case PGP_PKA_ELGAMAL:
+    case PGP_PKA_ELGAMAL_ENCRYPT_OR_SIGN:
+        mpi_free(&enc->eg.g);
+        mpi_free(&enc->eg.m);
+        break;
+    case PGP_PKA_SM2:
+        mpi_free(&enc->sm2.m);
+        break;
+    case PGP_PKA_ECDH:
+        mpi_free(&enc->ecdh.p);
+        break;
+    default:
+        break;
+    }
+}
+
 rnp_result_t
 validate_pgp_key_material(const pgp_key_material_t *material, rng_t *rng)
 {
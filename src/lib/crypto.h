@@ -136,6 +136,36 @@ bool pgp_generate_keypair(rng_t *                    rng,
  */
 bool key_material_equal(const pgp_key_material_t *key1, const pgp_key_material_t *key2);
 
+/**
+ * @brief Copy key material, allocating new storage for the mpis.
+ *
+ * @param dst destination, its previous contents are overwritten without releasing
+ * @param src source key material
+ * @param pubonly copy only public part of the key material
+ * @return true on success or false otherwise. On failure dst is left empty.
+ */
+bool key_material_copy(pgp_key_material_t *      dst,
+                       const pgp_key_material_t *src,
+                       bool                      pubonly);
+
+/**
+ * @brief Securely wipe and release all mpis of the key material, public and secret ones.
+ */
+void key_material_free(pgp_key_material_t *key);
+
+/**
+ * @brief Copy signature material. See key_material_copy() for the details.
+ *
+ * @param alg public key algorithm of the signature
+ */
+bool signature_material_copy(pgp_signature_material_t *      dst,
+                             const pgp_signature_material_t *src,
+                             pgp_pubkey_alg_t                alg);
+
+void signature_material_free(pgp_signature_material_t *sig, pgp_pubkey_alg_t alg);
+
+void encrypted_material_free(pgp_encrypted_material_t *enc, pgp_pubkey_alg_t alg);
+
 rnp_result_t validate_pgp_key_material(const pgp_key_material_t *material, rng_t *rng);
 
 size_t key_bitlength(const pgp_key_material_t *key);
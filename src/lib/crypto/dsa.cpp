@@ -77,9 +77,11 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #include <botan/ffi.h>
 #include <rnp/rnp_def.h>
 #include "dsa.h"
+#include "pubkey_cache.h"
 #include "hash.h"
 #include "utils.h"
 
@@ -168,7 +170,6 @@ dsa_sign(rng_t *              rng,
 
     size_t z_len = 0;
 
-    memset(sig, 0, sizeof(*sig));
     q_order = mpi_bytes(&key->q);
     if ((2 * q_order) > sizeof(sign_buf)) {
         RNP_LOG("wrong q order");
@@ -225,20 +226,59 @@ end:
     return ret;
 }
 
+static bool
+dsa_load_public_key(botan_pubkey_t *bkey, const pgp_dsa_key_t *key)
+{
+    bignum_t *p = mpi2bn(&key->p);
+    bignum_t *q = mpi2bn(&key->q);
+    bignum_t *g = mpi2bn(&key->g);
+    bignum_t *y = mpi2bn(&key->y);
+    bool      res = false;
+
+    *bkey = NULL;
+    if (!p || !q || !g || !y) {
+        RNP_LOG("out of memory");
+        goto done;
+    }
+
+    res = !botan_pubkey_load_dsa(
+      bkey, BN_HANDLE_PTR(p), BN_HANDLE_PTR(q), BN_HANDLE_PTR(g), BN_HANDLE_PTR(y));
+done:
+    bn_free(p);
+    bn_free(q);
+    bn_free(g);
+    bn_free(y);
+    return res;
+}
+
+static pgp_cached_pubkey_t
+dsa_cached_public_key(const pgp_dsa_key_t *key)
+{
+    try {
+        std::string id(1, (char) PGP_PKA_DSA);
+        pubkey_cache_id_add(id, &key->p);
+        pubkey_cache_id_add(id, &key->q);
+        pubkey_cache_id_add(id, &key->g);
+        pubkey_cache_id_add(id, &key->y);
+        return pubkey_cache_get(
+          id, [key](botan_pubkey_t *bkey) { return dsa_load_public_key(bkey, key); });
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+}
+
 rnp_result_t
 dsa_verify(const pgp_dsa_signature_t *sig,
            const uint8_t *            hash,
            size_t                     hash_len,
            const pgp_dsa_key_t *      key)
 {
-    botan_pubkey_t       dsa_key = NULL;
-    botan_pk_op_verify_t verify_op = NULL;
-    uint8_t              sign_buf[2 * BITS_TO_BYTES(DSA_MAX_Q_BITLEN)] = {0};
-    size_t               q_order = 0;
-    size_t               r_blen, s_blen;
-    bignum_t *           p = NULL, *q = NULL, *g = NULL, *y = NULL;
-    rnp_result_t         ret = RNP_ERROR_GENERIC;
-    size_t               z_len = 0;
+    pgp_cached_pubkey_t dsa_key;
+    uint8_t             sign_buf[2 * BITS_TO_BYTES(DSA_MAX_Q_BITLEN)] = {0};
+    size_t              q_order = 0;
+    size_t              r_blen, s_blen;
+    size_t              z_len = 0;
 
     q_order = mpi_bytes(&key->q);
     if ((2 * q_order) > sizeof(sign_buf)) {
@@ -254,47 +294,17 @@ dsa_verify(const pgp_dsa_signature_t *sig,
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    p = mpi2bn(&key->p);
-    q = mpi2bn(&key->q);
-    g = mpi2bn(&key->g);
-    y = mpi2bn(&key->y);
-
-    if (!p || !q || !g || !y) {
-        RNP_LOG("out of memory");
-        ret = RNP_ERROR_OUT_OF_MEMORY;
-        goto end;
-    }
-
-    if (botan_pubkey_load_dsa(
-          &dsa_key, BN_HANDLE_PTR(p), BN_HANDLE_PTR(q), BN_HANDLE_PTR(g), BN_HANDLE_PTR(y))) {
+    if (!(dsa_key = dsa_cached_public_key(key))) {
         RNP_LOG("Wrong key");
-        goto end;
+        return RNP_ERROR_GENERIC;
     }
 
     mpi2mem(&sig->r, sign_buf + q_order - r_blen);
     mpi2mem(&sig->s, sign_buf + 2 * q_order - s_blen);
 
-    if (botan_pk_op_verify_create(&verify_op, dsa_key, "Raw", 0)) {
-        RNP_LOG("Can't create verifier");
-        goto end;
-    }
-
-    if (botan_pk_op_verify_update(verify_op, hash, z_len)) {
-        goto end;
-    }
-
-    ret = (botan_pk_op_verify_finish(verify_op, sign_buf, 2 * q_order) == BOTAN_FFI_SUCCESS) ?
-            RNP_SUCCESS :
-            RNP_ERROR_SIGNATURE_INVALID;
-
-end:
-    bn_free(p);
-    bn_free(q);
-    bn_free(g);
-    bn_free(y);
-    botan_pk_op_verify_destroy(verify_op);
-    botan_pubkey_destroy(dsa_key);
-    return ret;
+    return pubkey_cache_verify(dsa_key, "Raw", hash, z_len, sign_buf, 2 * q_order) ?
+             RNP_SUCCESS :
+             RNP_ERROR_SIGNATURE_INVALID;
 }
 
 rnp_result_t
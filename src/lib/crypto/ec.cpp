@@ -256,15 +256,17 @@ x25519_generate(rng_t *rng, pgp_ec_key_t *key)
     if (botan_privkey_x25519_get_privkey(pr_key, keyle)) {
         goto end;
     }
+    if (!mpi_alloc(&key->x, 32) || !mpi_alloc(&key->p, 33)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
     for (int i = 0; i < 32; i++) {
         key->x.mpi[31 - i] = keyle[i];
     }
-    key->x.len = 32;
 
     if (botan_pubkey_x25519_get_pubkey(pu_key, &key->p.mpi[1])) {
         goto end;
     }
-    key->p.len = 33;
     key->p.mpi[0] = 0x40;
 
     ret = RNP_SUCCESS;
@@ -381,13 +383,18 @@ ec_generate(rng_t *                rng,
      * Note: Generated pk/sk may not always have exact number of bytes
      *       which is important when converting to octet-string
      */
-    memset(key->p.mpi, 0, sizeof(key->p.mpi));
+    if (!mpi_alloc(&key->p, 2 * filed_byte_size + 1)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
     key->p.mpi[0] = 0x04;
     bn_bn2bin(px, &key->p.mpi[1 + filed_byte_size - x_bytes]);
     bn_bn2bin(py, &key->p.mpi[1 + filed_byte_size + (filed_byte_size - y_bytes)]);
-    key->p.len = 2 * filed_byte_size + 1;
     /* secret key value */
-    bn2mpi(x, &key->x);
+    if (!bn2mpi(x, &key->x)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
     ret = RNP_SUCCESS;
 end:
     botan_privkey_destroy(pr_key);
@@ -384,16 +384,16 @@ ecdh_encrypt_pkcs5(rng_t *                  rng,
 
     /* we need to prepend 0x40 for the x25519 */
     if (key->curve == PGP_CURVE_25519) {
-        out->p.len = sizeof(out->p.mpi) - 1;
-        if (botan_pk_op_key_agreement_export_public(
-              eph_prv_key, out->p.mpi + 1, &out->p.len)) {
+        size_t plen = 32;
+        if (!mpi_alloc(&out->p, plen + 1) ||
+            botan_pk_op_key_agreement_export_public(eph_prv_key, out->p.mpi + 1, &plen)) {
             goto end;
         }
         out->p.mpi[0] = 0x40;
-        out->p.len++;
+        out->p.len = plen + 1;
     } else {
-        out->p.len = sizeof(out->p.mpi);
-        if (botan_pk_op_key_agreement_export_public(eph_prv_key, out->p.mpi, &out->p.len)) {
+        if (!mpi_alloc(&out->p, 2 * BITS_TO_BYTES(curve_desc->bitlen) + 1) ||
+            botan_pk_op_key_agreement_export_public(eph_prv_key, out->p.mpi, &out->p.len)) {
             goto end;
         }
     }
@@ -26,8 +26,10 @@
 
 #include "ecdsa.h"
 #include "utils.h"
+#include "pubkey_cache.h"
 #include <botan/ffi.h>
 #include <string.h>
+#include <string>
 
 static bool
 ecdsa_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
@@ -63,6 +65,21 @@ end:
     return res;
 }
 
+static pgp_cached_pubkey_t
+ecdsa_cached_public_key(const pgp_ec_key_t *key)
+{
+    try {
+        std::string id(1, (char) PGP_PKA_ECDSA);
+        id.push_back((char) key->curve);
+        pubkey_cache_id_add(id, &key->p);
+        return pubkey_cache_get(
+          id, [key](botan_pubkey_t *bkey) { return ecdsa_load_public_key(bkey, key); });
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+}
+
 static bool
 ecdsa_load_secret_key(botan_privkey_t *seckey, const pgp_ec_key_t *keydata)
 {
@@ -198,12 +215,10 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
              size_t                    hash_len,
              const pgp_ec_key_t *      key)
 {
-    botan_pubkey_t       pub = NULL;
-    botan_pk_op_verify_t verifier = NULL;
-    rnp_result_t         ret = RNP_ERROR_SIGNATURE_INVALID;
-    uint8_t              sign_buf[2 * MAX_CURVE_BYTELEN] = {0};
-    size_t               r_blen, s_blen;
-    const char *         padding_str = ecdsa_padding_str_for(hash_alg);
+    pgp_cached_pubkey_t pub;
+    uint8_t             sign_buf[2 * MAX_CURVE_BYTELEN] = {0};
+    size_t              r_blen, s_blen;
+    const char *        padding_str = ecdsa_padding_str_for(hash_alg);
 
     const ec_curve_desc_t *curve = get_curve_desc(key->curve);
     if (!curve) {
@@ -212,37 +227,25 @@ ecdsa_verify(const pgp_ec_signature_t *sig,
     }
     const size_t curve_order = BITS_TO_BYTES(curve->bitlen);
 
-    if (!ecdsa_load_public_key(&pub, key)) {
-        goto end;
-    }
-
-    if (botan_pk_op_verify_create(&verifier, pub, padding_str, 0)) {
-        goto end;
-    }
-
-    if (botan_pk_op_verify_update(verifier, hash, hash_len)) {
-        goto end;
+    if (!(pub = ecdsa_cached_public_key(key))) {
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
 
     r_blen = mpi_bytes(&sig->r);
     s_blen = mpi_bytes(&sig->s);
     if ((r_blen > curve_order) || (s_blen > curve_order) ||
         (curve_order > MAX_CURVE_BYTELEN)) {
-        ret = RNP_ERROR_BAD_PARAMETERS;
-        goto end;
+        return RNP_ERROR_BAD_PARAMETERS;
     }
 
     // Both can't fail
     mpi2mem(&sig->r, &sign_buf[curve_order - r_blen]);
     mpi2mem(&sig->s, &sign_buf[curve_order + curve_order - s_blen]);
 
-    if (!botan_pk_op_verify_finish(verifier, sign_buf, curve_order * 2)) {
-        ret = RNP_SUCCESS;
+    if (!pubkey_cache_verify(pub, padding_str, hash, hash_len, sign_buf, curve_order * 2)) {
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
-end:
-    botan_pubkey_destroy(pub);
-    botan_pk_op_verify_destroy(verifier);
-    return ret;
+    return RNP_SUCCESS;
 }
 
 pgp_hash_alg_t
@@ -25,9 +25,11 @@
  */
 
 #include <string.h>
+#include <string>
 #include <botan/ffi.h>
 #include "eddsa.h"
 #include "utils.h"
+#include "pubkey_cache.h"
 
 static bool
 eddsa_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
@@ -48,6 +50,21 @@ eddsa_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
     return true;
 }
 
+static pgp_cached_pubkey_t
+eddsa_cached_public_key(const pgp_ec_key_t *key)
+{
+    try {
+        std::string id(1, (char) PGP_PKA_EDDSA);
+        id.push_back((char) key->curve);
+        pubkey_cache_id_add(id, &key->p);
+        return pubkey_cache_get(
+          id, [key](botan_pubkey_t *bkey) { return eddsa_load_public_key(bkey, key); });
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+}
+
 static bool
 eddsa_load_secret_key(botan_privkey_t *seckey, const pgp_ec_key_t *keydata)
 {
@@ -119,10 +136,16 @@ eddsa_generate(rng_t *rng, pgp_ec_key_t *key, size_t numbits)
     // First 32 bytes of key_bits are the EdDSA seed (private key)
     // Second 32 bytes are the EdDSA public key
 
-    mem2mpi(&key->x, key_bits, 32);
+    if (!mem2mpi(&key->x, key_bits, 32)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
     // insert the required 0x40 prefix on the public key
     key_bits[31] = 0x40;
-    mem2mpi(&key->p, key_bits + 31, 33);
+    if (!mem2mpi(&key->p, key_bits + 31, 33)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
     key->curve = PGP_CURVE_ED25519;
 
     ret = RNP_SUCCESS;
@@ -137,38 +160,24 @@ eddsa_verify(const pgp_ec_signature_t *sig,
              size_t                    hash_len,
              const pgp_ec_key_t *      key)
 {
-    botan_pubkey_t       eddsa = NULL;
-    botan_pk_op_verify_t verify_op = NULL;
-    rnp_result_t         ret = RNP_ERROR_SIGNATURE_INVALID;
-    uint8_t              bn_buf[64] = {0};
-
-    if (!eddsa_load_public_key(&eddsa, key)) {
-        ret = RNP_ERROR_BAD_PARAMETERS;
-        goto done;
-    }
+    pgp_cached_pubkey_t eddsa = eddsa_cached_public_key(key);
+    uint8_t             bn_buf[64] = {0};
 
-    if (botan_pk_op_verify_create(&verify_op, eddsa, "Pure", 0) != 0) {
-        goto done;
-    }
-
-    if (botan_pk_op_verify_update(verify_op, hash, hash_len) != 0) {
-        goto done;
+    if (!eddsa) {
+        return RNP_ERROR_BAD_PARAMETERS;
     }
 
     // Unexpected size for Ed25519 signature
     if ((mpi_bytes(&sig->r) > 32) || (mpi_bytes(&sig->s) > 32)) {
-        goto done;
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
     mpi2mem(&sig->r, &bn_buf[32 - mpi_bytes(&sig->r)]);
     mpi2mem(&sig->s, &bn_buf[64 - mpi_bytes(&sig->s)]);
 
-    if (botan_pk_op_verify_finish(verify_op, bn_buf, 64) == 0) {
-        ret = RNP_SUCCESS;
+    if (!pubkey_cache_verify(eddsa, "Pure", hash, hash_len, bn_buf, 64)) {
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
-done:
-    botan_pk_op_verify_destroy(verify_op);
-    botan_pubkey_destroy(eddsa);
-    return ret;
+    return RNP_SUCCESS;
 }
 
 rnp_result_t
@@ -206,8 +215,10 @@ eddsa_sign(rng_t *             rng,
         goto done;
     }
 
-    mem2mpi(&sig->r, bn_buf, 32);
-    mem2mpi(&sig->s, bn_buf + 32, 32);
+    if (!mem2mpi(&sig->r, bn_buf, 32) || !mem2mpi(&sig->s, bn_buf + 32, 32)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto done;
+    }
     ret = RNP_SUCCESS;
 done:
     botan_pk_op_sign_destroy(sign_op);
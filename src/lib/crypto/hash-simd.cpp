@@ -0,0 +1,497 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "hash-simd.h"
+#include "utils.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RNP_HASH_X86 1
+#include <immintrin.h>
+#include <cpuid.h>
+#define RNP_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(RNP_HASH_X86)
+static const uint32_t SHA1_K[4] = {0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6};
+
+static const uint32_t SHA256_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+  0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+  0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+  0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+  0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+  0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+  0xc67178f2};
+
+/* Load 8 consecutive big-endian words at offset from each of 8 blocks, transposing them so
+ * w[i] keeps word i of all the lanes. */
+RNP_TARGET("avx2") static inline void
+hash_load8_avx2(__m256i *w, const uint8_t *const *blocks, size_t offset)
+{
+    const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13,
+                                           12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14,
+                                           13, 12);
+    __m256i r[8];
+    for (int i = 0; i < 8; i++) {
+        r[i] = _mm256_loadu_si256((const __m256i *) (blocks[i] + offset));
+    }
+    /* 8x8 transpose: pairs of words, then pairs of qwords, then 128-bit halves */
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    w[0] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u0, u4, 0x20), bswap);
+    w[1] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u1, u5, 0x20), bswap);
+    w[2] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u2, u6, 0x20), bswap);
+    w[3] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u3, u7, 0x20), bswap);
+    w[4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u0, u4, 0x31), bswap);
+    w[5] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u1, u5, 0x31), bswap);
+    w[6] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u2, u6, 0x31), bswap);
+    w[7] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(u3, u7, 0x31), bswap);
+}
+
+#define ROL_AVX2(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define ROR_AVX2(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define XOR3_AVX2(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+
+RNP_TARGET("avx2") static void
+sha1_x8_avx2(uint32_t *state, const uint8_t *const *blocks)
+{
+    __m256i w[16];
+    hash_load8_avx2(w, blocks, 0);
+    hash_load8_avx2(w + 8, blocks, 32);
+
+    __m256i s[5];
+    for (int i = 0; i < 5; i++) {
+        s[i] = _mm256_loadu_si256((const __m256i *) (state + 8 * i));
+    }
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+
+    for (int t = 0; t < 80; t++) {
+        if (t >= 16) {
+            __m256i wt = XOR3_AVX2(w[(t - 3) & 15], w[(t - 8) & 15], w[(t - 14) & 15]);
+            w[t & 15] = ROL_AVX2(_mm256_xor_si256(wt, w[t & 15]), 1);
+        }
+        __m256i f;
+        if (t < 20) {
+            f = _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d)));
+        } else if ((t >= 40) && (t < 60)) {
+            f = _mm256_or_si256(_mm256_and_si256(b, c),
+                                _mm256_and_si256(d, _mm256_or_si256(b, c)));
+        } else {
+            f = XOR3_AVX2(b, c, d);
+        }
+        __m256i k = _mm256_set1_epi32(SHA1_K[t / 20]);
+        __m256i tmp = _mm256_add_epi32(_mm256_add_epi32(ROL_AVX2(a, 5), f),
+                                       _mm256_add_epi32(_mm256_add_epi32(e, k), w[t & 15]));
+        e = d;
+        d = c;
+        c = ROL_AVX2(b, 30);
+        b = a;
+        a = tmp;
+    }
+
+    s[0] = _mm256_add_epi32(s[0], a);
+    s[1] = _mm256_add_epi32(s[1], b);
+    s[2] = _mm256_add_epi32(s[2], c);
+    s[3] = _mm256_add_epi32(s[3], d);
+    s[4] = _mm256_add_epi32(s[4], e);
+    for (int i = 0; i < 5; i++) {
+        _mm256_storeu_si256((__m256i *) (state + 8 * i), s[i]);
+    }
+}
+
+RNP_TARGET("avx2") static void
+sha256_x8_avx2(uint32_t *state, const uint8_t *const *blocks)
+{
+    __m256i w[16];
+    hash_load8_avx2(w, blocks, 0);
+    hash_load8_avx2(w + 8, blocks, 32);
+
+    __m256i s[8];
+    __m256i v[8];
+    for (int i = 0; i < 8; i++) {
+        v[i] = s[i] = _mm256_loadu_si256((const __m256i *) (state + 8 * i));
+    }
+
+    for (int t = 0; t < 64; t++) {
+        if (t >= 16) {
+            __m256i w15 = w[(t - 15) & 15];
+            __m256i w2 = w[(t - 2) & 15];
+            __m256i s0 =
+              XOR3_AVX2(ROR_AVX2(w15, 7), ROR_AVX2(w15, 18), _mm256_srli_epi32(w15, 3));
+            __m256i s1 =
+              XOR3_AVX2(ROR_AVX2(w2, 17), ROR_AVX2(w2, 19), _mm256_srli_epi32(w2, 10));
+            w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                         _mm256_add_epi32(w[(t - 7) & 15], s1));
+        }
+        __m256i a = v[0], b = v[1], c = v[2], e = v[4], f = v[5], g = v[6];
+        __m256i S1 = XOR3_AVX2(ROR_AVX2(e, 6), ROR_AVX2(e, 11), ROR_AVX2(e, 25));
+        __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(v[7], S1),
+                                      _mm256_add_epi32(ch, _mm256_set1_epi32(SHA256_K[t])));
+        t1 = _mm256_add_epi32(t1, w[t & 15]);
+        __m256i S0 = XOR3_AVX2(ROR_AVX2(a, 2), ROR_AVX2(a, 13), ROR_AVX2(a, 22));
+        __m256i maj =
+          _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(S0, maj);
+        v[7] = g;
+        v[6] = f;
+        v[5] = e;
+        v[4] = _mm256_add_epi32(v[3], t1);
+        v[3] = c;
+        v[2] = b;
+        v[1] = a;
+        v[0] = _mm256_add_epi32(t1, t2);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i *) (state + 8 * i), _mm256_add_epi32(s[i], v[i]));
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+/* GCC 12 avx-512 intrinsics produce false uninitialized warnings, see GCC bug 105593 */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/* 16 lanes, loaded as two halves of 8 */
+RNP_TARGET("avx512f,avx2") static inline void
+hash_load16_avx512(__m512i *w, const uint8_t *const *blocks, size_t offset)
+{
+    __m256i lo[8];
+    __m256i hi[8];
+    hash_load8_avx2(lo, blocks, offset);
+    hash_load8_avx2(hi, blocks + 8, offset);
+    for (int i = 0; i < 8; i++) {
+        w[i] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[i]), hi[i], 1);
+    }
+}
+
+/* ternary logic immediates: bitwise select, majority and xor of three values */
+#define TL_CH 0xCA
+#define TL_MAJ 0xE8
+#define TL_XOR3 0x96
+
+RNP_TARGET("avx512f,avx2") static void
+sha1_x16_avx512(uint32_t *state, const uint8_t *const *blocks)
+{
+    __m512i w[16];
+    hash_load16_avx512(w, blocks, 0);
+    hash_load16_avx512(w + 8, blocks, 32);
+
+    __m512i s[5];
+    for (int i = 0; i < 5; i++) {
+        s[i] = _mm512_loadu_si512(state + 16 * i);
+    }
+    __m512i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+
+    for (int t = 0; t < 80; t++) {
+        if (t >= 16) {
+            __m512i wt = _mm512_ternarylogic_epi32(
+              w[(t - 3) & 15], w[(t - 8) & 15], w[(t - 14) & 15], TL_XOR3);
+            w[t & 15] = _mm512_rol_epi32(_mm512_xor_si512(wt, w[t & 15]), 1);
+        }
+        __m512i f;
+        if (t < 20) {
+            f = _mm512_ternarylogic_epi32(b, c, d, TL_CH);
+        } else if ((t >= 40) && (t < 60)) {
+            f = _mm512_ternarylogic_epi32(b, c, d, TL_MAJ);
+        } else {
+            f = _mm512_ternarylogic_epi32(b, c, d, TL_XOR3);
+        }
+        __m512i k = _mm512_set1_epi32(SHA1_K[t / 20]);
+        __m512i tmp = _mm512_add_epi32(_mm512_add_epi32(_mm512_rol_epi32(a, 5), f),
+                                       _mm512_add_epi32(_mm512_add_epi32(e, k), w[t & 15]));
+        e = d;
+        d = c;
+        c = _mm512_rol_epi32(b, 30);
+        b = a;
+        a = tmp;
+    }
+
+    s[0] = _mm512_add_epi32(s[0], a);
+    s[1] = _mm512_add_epi32(s[1], b);
+    s[2] = _mm512_add_epi32(s[2], c);
+    s[3] = _mm512_add_epi32(s[3], d);
+    s[4] = _mm512_add_epi32(s[4], e);
+    for (int i = 0; i < 5; i++) {
+        _mm512_storeu_si512(state + 16 * i, s[i]);
+    }
+}
+
+RNP_TARGET("avx512f,avx2") static void
+sha256_x16_avx512(uint32_t *state, const uint8_t *const *blocks)
+{
+    __m512i w[16];
+    hash_load16_avx512(w, blocks, 0);
+    hash_load16_avx512(w + 8, blocks, 32);
+
+    __m512i s[8];
+    __m512i v[8];
+    for (int i = 0; i < 8; i++) {
+        v[i] = s[i] = _mm512_loadu_si512(state + 16 * i);
+    }
+
+    for (int t = 0; t < 64; t++) {
+        if (t >= 16) {
+            __m512i w15 = w[(t - 15) & 15];
+            __m512i w2 = w[(t - 2) & 15];
+            __m512i s0 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w15, 7),
+                                                   _mm512_ror_epi32(w15, 18),
+                                                   _mm512_srli_epi32(w15, 3),
+                                                   TL_XOR3);
+            __m512i s1 = _mm512_ternarylogic_epi32(_mm512_ror_epi32(w2, 17),
+                                                   _mm512_ror_epi32(w2, 19),
+                                                   _mm512_srli_epi32(w2, 10),
+                                                   TL_XOR3);
+            w[t & 15] = _mm512_add_epi32(_mm512_add_epi32(w[t & 15], s0),
+                                         _mm512_add_epi32(w[(t - 7) & 15], s1));
+        }
+        __m512i a = v[0], e = v[4];
+        __m512i S1 = _mm512_ternarylogic_epi32(
+          _mm512_ror_epi32(e, 6), _mm512_ror_epi32(e, 11), _mm512_ror_epi32(e, 25), TL_XOR3);
+        __m512i ch = _mm512_ternarylogic_epi32(e, v[5], v[6], TL_CH);
+        __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(v[7], S1),
+                                      _mm512_add_epi32(ch, _mm512_set1_epi32(SHA256_K[t])));
+        t1 = _mm512_add_epi32(t1, w[t & 15]);
+        __m512i S0 = _mm512_ternarylogic_epi32(
+          _mm512_ror_epi32(a, 2), _mm512_ror_epi32(a, 13), _mm512_ror_epi32(a, 22), TL_XOR3);
+        __m512i t2 = _mm512_add_epi32(S0, _mm512_ternarylogic_epi32(a, v[1], v[2], TL_MAJ));
+        v[7] = v[6];
+        v[6] = v[5];
+        v[5] = e;
+        v[4] = _mm512_add_epi32(v[3], t1);
+        v[3] = v[2];
+        v[2] = v[1];
+        v[1] = a;
+        v[0] = _mm512_add_epi32(t1, t2);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        _mm512_storeu_si512(state + 16 * i, _mm512_add_epi32(s[i], v[i]));
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static bool
+hash_has_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+static bool
+hash_has_avx512(void)
+{
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2");
+}
+
+static bool
+hash_has_sha_ni(void)
+{
+    /* __builtin_cpu_supports() doesn't know about "sha" in older compilers */
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & (1 << 29);
+}
+#endif
+
+typedef struct pgp_hash_simd_impl_t {
+    pgp_hash_simd_t kernels;
+    bool (*supported)(void);
+} pgp_hash_simd_impl_t;
+
+static const pgp_hash_simd_impl_t hash_impls[] = {
+#if defined(RNP_HASH_X86)
+  {{"avx512", 16, sha1_x16_avx512, sha256_x16_avx512}, hash_has_avx512},
+  {{"avx2", 8, sha1_x8_avx2, sha256_x8_avx2}, hash_has_avx2},
+#endif
+  {{NULL, 0, NULL, NULL}, NULL}};
+
+size_t
+hash_simd_count(void)
+{
+    size_t count = 0;
+    for (const pgp_hash_simd_impl_t *impl = hash_impls; impl->supported; impl++) {
+        count += impl->supported();
+    }
+    return count;
+}
+
+const pgp_hash_simd_t *
+hash_simd_get(size_t idx)
+{
+    for (const pgp_hash_simd_impl_t *impl = hash_impls; impl->supported; impl++) {
+        if (impl->supported() && !idx--) {
+            return &impl->kernels;
+        }
+    }
+    return NULL;
+}
+
+static const pgp_hash_simd_t *
+hash_simd_detect(void)
+{
+#if defined(RNP_HASH_X86)
+    /* backend hashes single messages with SHA extensions if CPU has them. For key-sized
+     * messages this is as fast as the AVX-512 kernels and up to twice faster than AVX2 ones */
+    if (hash_has_sha_ni()) {
+        return NULL;
+    }
+#endif
+    return hash_simd_get(0);
+}
+
+const pgp_hash_simd_t *
+hash_simd(void)
+{
+    /* CPU features do not change at runtime, so detect them once */
+    static const pgp_hash_simd_t *kernels = hash_simd_detect();
+    return kernels;
+}
+
+static const uint32_t SHA1_IV[5] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+static const uint32_t SHA256_IV[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static void
+hash_simd_batch_do(const pgp_hash_simd_t *simd,
+                   bool                   sha1,
+                   const pgp_hash_msg_t * msgs,
+                   size_t                 count,
+                   uint8_t *              out)
+{
+    static const uint8_t zero_block[64] = {0};
+    const size_t         lanes = simd->lanes;
+    const size_t         words = sha1 ? 5 : 8;
+    const uint32_t *     iv = sha1 ? SHA1_IV : SHA256_IV;
+    auto                 compress = sha1 ? simd->sha1 : simd->sha256;
+
+    /* messages of the similar length go to the same group, so lanes don't idle */
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [msgs](size_t l, size_t r) {
+        return msgs[l].len < msgs[r].len;
+    });
+
+    std::vector<uint32_t>        state(words * lanes);
+    std::vector<uint8_t>         tails(lanes * 128);
+    std::vector<const uint8_t *> blocks(lanes);
+    std::vector<size_t>          full(lanes);
+    std::vector<size_t>          total(lanes);
+
+    for (size_t base = 0; base < count; base += lanes) {
+        size_t n = std::min(lanes, count - base);
+        size_t maxblocks = 0;
+        /* last one or two blocks of the message with padding and bit length */
+        for (size_t lane = 0; lane < n; lane++) {
+            const pgp_hash_msg_t &msg = msgs[order[base + lane]];
+            uint8_t *             tail = &tails[lane * 128];
+            size_t                rest = msg.len % 64;
+            full[lane] = msg.len / 64;
+            total[lane] = (msg.len + 9 + 63) / 64;
+            memset(tail, 0, 128);
+            if (rest) {
+                memcpy(tail, msg.data + full[lane] * 64, rest);
+            }
+            tail[rest] = 0x80;
+            STORE64BE(tail + (total[lane] - full[lane]) * 64 - 8, (uint64_t) msg.len * 8);
+            maxblocks = std::max(maxblocks, total[lane]);
+        }
+        for (size_t w = 0; w < words; w++) {
+            for (size_t lane = 0; lane < lanes; lane++) {
+                state[w * lanes + lane] = iv[w];
+            }
+        }
+
+        for (size_t blk = 0; blk < maxblocks; blk++) {
+            for (size_t lane = 0; lane < lanes; lane++) {
+                if ((lane >= n) || (blk >= total[lane])) {
+                    blocks[lane] = zero_block;
+                } else if (blk < full[lane]) {
+                    blocks[lane] = msgs[order[base + lane]].data + blk * 64;
+                } else {
+                    blocks[lane] = &tails[lane * 128 + (blk - full[lane]) * 64];
+                }
+            }
+            compress(state.data(), blocks.data());
+            for (size_t lane = 0; lane < n; lane++) {
+                if (blk + 1 != total[lane]) {
+                    continue;
+                }
+                uint8_t *digest = out + order[base + lane] * words * 4;
+                for (size_t w = 0; w < words; w++) {
+                    STORE32BE(digest + w * 4, state[w * lanes + lane]);
+                }
+            }
+        }
+    }
+}
+
+bool
+hash_simd_batch(const pgp_hash_simd_t *simd,
+                bool                   sha1,
+                const pgp_hash_msg_t * msgs,
+                size_t                 count,
+                uint8_t *              out)
+{
+    try {
+        hash_simd_batch_do(simd, sha1, msgs, count, out);
+        return true;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+}
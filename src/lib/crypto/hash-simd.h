@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_HASH_SIMD_H
+#define RNP_HASH_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* one of the independent messages, hashed by the batch */
+typedef struct pgp_hash_msg_t {
+    const uint8_t *data;
+    size_t         len;
+} pgp_hash_msg_t;
+
+/**
+ * @brief Multi-buffer hash kernels, used by pgp_hash_batch(). Each kernel compresses one
+ *        64-byte block of every lane, so the same number of independent messages are hashed
+ *        at once with a single SIMD instruction stream.
+ *        State is stored word-major: state[word * lanes + lane].
+ */
+typedef struct pgp_hash_simd_t {
+    const char *name;
+    size_t      lanes;
+    /**
+     * @brief Compress SHA-1 block of each lane.
+     * @param state 5 * lanes words of the transposed state, updated in place
+     * @param blocks array of lanes pointers to the 64-byte blocks
+     */
+    void (*sha1)(uint32_t *state, const uint8_t *const *blocks);
+    /**
+     * @brief Compress SHA-256 block of each lane.
+     * @param state 8 * lanes words of the transposed state, updated in place
+     * @param blocks array of lanes pointers to the 64-byte blocks
+     */
+    void (*sha256)(uint32_t *state, const uint8_t *const *blocks);
+} pgp_hash_simd_t;
+
+/**
+ * @brief Get the fastest multi-buffer hash kernels, supported by the current CPU.
+ *
+ * @return pointer to the kernels or NULL if messages should be hashed one by one
+ */
+const pgp_hash_simd_t *hash_simd(void);
+
+/**
+ * @brief Get number of the multi-buffer hash kernels, supported by the current CPU.
+ */
+size_t hash_simd_count(void);
+
+/**
+ * @brief Get the multi-buffer hash kernels by index, the fastest come first.
+ *
+ * @param idx index, must be less than hash_simd_count()
+ * @return pointer to the kernels
+ */
+const pgp_hash_simd_t *hash_simd_get(size_t idx);
+
+/**
+ * @brief Calculate SHA-1 or SHA-256 of the messages, using all lanes of the kernels.
+ *        Messages are grouped by length, so lanes are not idle while waiting for the longest
+ *        message of the group.
+ *
+ * @param simd kernels to use
+ * @param sha1 true to calculate SHA-1, false for SHA-256
+ * @param msgs array of messages
+ * @param count number of messages
+ * @param out output buffer, i-th digest is stored at out + i * digest size
+ * @return true on success or false if allocation failed
+ */
+bool hash_simd_batch(const pgp_hash_simd_t *simd,
+                     bool                   sha1,
+                     const pgp_hash_msg_t * msgs,
+                     size_t                 count,
+                     uint8_t *              out);
+
+#endif
@@ -75,6 +75,8 @@
 
 #include <stdio.h>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include <rnp/rnp_sdk.h>
 #include <botan/hash.h>
 #include "hash.h"
@@ -147,6 +149,41 @@ pgp_str_to_hash_alg(const char *hash)
     return PGP_HASH_UNKNOWN;
 }
 
+/* maximum number of the finished hash objects per algorithm, kept for reuse by each thread */
+#define PGP_HASH_POOL_SIZE 4
+
+typedef std::vector<std::unique_ptr<Botan::HashFunction>> pgp_hash_pool_t;
+
+/* Botan::HashFunction::create() does lookup by name and allocation, which is noticeable for
+ * the short inputs like key fingerprints, so objects are reused within the thread */
+static thread_local std::unordered_map<int, pgp_hash_pool_t> hash_pool;
+
+static std::unique_ptr<Botan::HashFunction>
+hash_pool_get(pgp_hash_alg_t alg)
+{
+    auto it = hash_pool.find(alg);
+    if ((it == hash_pool.end()) || it->second.empty()) {
+        return Botan::HashFunction::create(pgp_hash_name_botan(alg));
+    }
+    std::unique_ptr<Botan::HashFunction> hash_fn = std::move(it->second.back());
+    it->second.pop_back();
+    return hash_fn;
+}
+
+static void
+hash_pool_put(pgp_hash_alg_t alg, Botan::HashFunction *hash_fn)
+{
+    std::unique_ptr<Botan::HashFunction> handle(hash_fn);
+    try {
+        pgp_hash_pool_t &pool = hash_pool[alg];
+        if (pool.size() < PGP_HASH_POOL_SIZE) {
+            pool.push_back(std::move(handle));
+        }
+    } catch (const std::exception &) {
+        /* not fatal, object is just destroyed */
+    }
+}
+
 /**
 \ingroup Core_Hashes
 \brief Setup hash for given hash algorithm
@@ -164,7 +201,7 @@ pgp_hash_create(pgp_hash_t *hash, pgp_hash_alg_t alg)
 
     std::unique_ptr<Botan::HashFunction> hash_fn;
     try {
-        hash_fn = Botan::HashFunction::create(hash_name);
+        hash_fn = hash_pool_get(alg);
     } catch (std::exception &ex) {
         RNP_LOG("Error creating HashFunction ('%s')", ex.what());
     }
@@ -263,18 +300,51 @@ pgp_hash_finish(pgp_hash_t *hash, uint8_t *out)
     size_t outlen = hash->_output_len;
     hash->handle = NULL;
     try {
+        /* both reset the object state so it may be reused */
         if (out) {
             hash_fn->final(out);
+        } else {
+            hash_fn->clear();
         }
-        delete hash_fn;
     } catch (std::exception &ex) {
         RNP_LOG("Error finishing HashFunction ('%s')", ex.what());
-        outlen = 0;
+        delete hash_fn;
+        hash->_output_len = 0;
+        return 0;
     }
+    hash_pool_put(hash->_alg, hash_fn);
     hash->_output_len = 0;
     return outlen;
 }
 
+bool
+pgp_hash_batch(pgp_hash_alg_t alg, const pgp_hash_msg_t *msgs, size_t count, uint8_t *out)
+{
+    size_t                 len = pgp_digest_length(alg);
+    const pgp_hash_simd_t *simd = hash_simd();
+
+    if (!len) {
+        return false;
+    }
+    /* half-empty lanes are still worth it, smaller batches are faster one by one */
+    if (simd && (count >= simd->lanes / 2) &&
+        ((alg == PGP_HASH_SHA1) || (alg == PGP_HASH_SHA256))) {
+        return hash_simd_batch(simd, alg == PGP_HASH_SHA1, msgs, count, out);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        pgp_hash_t hash = {};
+        if (!pgp_hash_create(&hash, alg)) {
+            return false;
+        }
+        pgp_hash_add(&hash, msgs[i].data, msgs[i].len);
+        if (pgp_hash_finish(&hash, out + i * len) != len) {
+            return false;
+        }
+    }
+    return true;
+}
+
 pgp_hash_alg_t
 pgp_hash_alg_type(const pgp_hash_t *hash)
 {
@@ -302,15 +372,15 @@ pgp_digest_length(pgp_hash_alg_t alg)
 }
 
 bool
-pgp_hash_list_add(list *hashes, pgp_hash_alg_t alg)
+pgp_hash_list_add(dynarray *hashes, pgp_hash_alg_t alg)
 {
     pgp_hash_t hash = {0};
 
-    if (!pgp_hash_list_get(*hashes, alg)) {
+    if (!pgp_hash_list_get(hashes, alg)) {
         if (!pgp_hash_create(&hash, alg)) {
             RNP_LOG("failed to initialize hash algorithm %d", (int) alg);
             return false;
-        } else if (!list_append(hashes, &hash, sizeof(hash))) {
+        } else if (!dynarray_append(hashes, &hash, sizeof(hash))) {
             pgp_hash_finish(&hash, NULL);
             RNP_LOG("allocation failed");
             return false;
@@ -321,11 +391,12 @@ pgp_hash_list_add(list *hashes, pgp_hash_alg_t alg)
 }
 
 const pgp_hash_t *
-pgp_hash_list_get(list hashes, pgp_hash_alg_t alg)
+pgp_hash_list_get(const dynarray *hashes, pgp_hash_alg_t alg)
 {
-    for (list_item *hash = list_front(hashes); hash; hash = list_next(hash)) {
-        if (pgp_hash_alg_type((pgp_hash_t *) hash) == alg) {
-            return (pgp_hash_t *) hash;
+    for (size_t i = 0; i < dynarray_length(hashes); i++) {
+        pgp_hash_t *hash = (pgp_hash_t *) dynarray_at(hashes, i);
+        if (pgp_hash_alg_type(hash) == alg) {
+            return hash;
         }
     }
 
@@ -333,20 +404,20 @@ pgp_hash_list_get(list hashes, pgp_hash_alg_t alg)
 }
 
 void
-pgp_hash_list_update(list hashes, const void *buf, size_t len)
+pgp_hash_list_update(dynarray *hashes, const void *buf, size_t len)
 {
-    for (list_item *hash = list_front(hashes); hash; hash = list_next(hash)) {
-        pgp_hash_add((pgp_hash_t *) hash, buf, len);
+    for (size_t i = 0; i < dynarray_length(hashes); i++) {
+        pgp_hash_add((pgp_hash_t *) dynarray_at(hashes, i), buf, len);
     }
 }
 
 void
-pgp_hash_list_free(list *hashes)
+pgp_hash_list_free(dynarray *hashes)
 {
-    for (list_item *hash = list_front(*hashes); hash; hash = list_next(hash)) {
-        pgp_hash_finish((pgp_hash_t *) hash, NULL);
+    for (size_t i = 0; i < dynarray_length(hashes); i++) {
+        pgp_hash_finish((pgp_hash_t *) dynarray_at(hashes, i), NULL);
     }
-    list_destroy(hashes);
+    dynarray_destroy(hashes);
 }
 
 bool
@@ -35,7 +35,8 @@
 #include <rnp/rnp_sdk.h>
 #include <repgp/repgp_def.h>
 #include "types.h"
-#include "list.h"
+#include "dynarray.h"
+#include "hash-simd.h"
 
 /**
  * Output size (in bytes) of biggest supported hash algo
@@ -57,6 +58,23 @@ void   pgp_hash_add_int(pgp_hash_t *hash, unsigned n, size_t bytes);
 int    pgp_hash_add(pgp_hash_t *hash, const void *buf, size_t len);
 size_t pgp_hash_finish(pgp_hash_t *hash, uint8_t *output);
 
+/**
+ * @brief Hash a number of independent messages at once. SHA-1 and SHA-256 are calculated in
+ *        the parallel SIMD lanes if CPU supports this, otherwise messages are hashed one by
+ *        one.
+ *
+ * @param alg hash algorithm
+ * @param msgs array of messages
+ * @param count number of messages
+ * @param out output buffer of count * pgp_digest_length(alg) bytes, i-th digest is stored at
+ *        out + i * pgp_digest_length(alg)
+ * @return true on success or false otherwise
+ */
+bool pgp_hash_batch(pgp_hash_alg_t        alg,
+                    const pgp_hash_msg_t *msgs,
+                    size_t                count,
+                    uint8_t *             out);
+
 const char *pgp_hash_name(const pgp_hash_t *hash);
 
 pgp_hash_alg_t pgp_hash_alg_type(const pgp_hash_t *hash);
@@ -79,38 +97,38 @@ size_t pgp_digest_length(pgp_hash_alg_t alg);
 /*
  * @brief Add hash for the corresponding algorithm to the list
  *
- * @param hashes non-NULL pointer to the list structure
+ * @param hashes non-NULL pointer to the array of pgp_hash_t structures
  * @param alg hash algorithm
  *
  * @return true if hash was added successfully or already exists in the list.
  *         false will be returned if memory allocation failed, or alg is not supported, or
  *         on other error
  **/
-bool pgp_hash_list_add(list *hashes, pgp_hash_alg_t alg);
+bool pgp_hash_list_add(dynarray *hashes, pgp_hash_alg_t alg);
 
 /* @brief Get hash structure for the corresponding algorithm
  *
- * @param hashes List of pgp_hash_t structures
+ * @param hashes Array of pgp_hash_t structures
  * @param alg Hash algorithm
  *
  * @return pointer to the pgp_hash_t structure or NULL if list doesn't contain alg
  **/
-const pgp_hash_t *pgp_hash_list_get(list hashes, pgp_hash_alg_t alg);
+const pgp_hash_t *pgp_hash_list_get(const dynarray *hashes, pgp_hash_alg_t alg);
 
 /*
  * @brief Update list of hashes with the data
  *
- * @param hashes List of pgp_hash_t structures
+ * @param hashes Array of pgp_hash_t structures
  * @param buf buffer with data
  * @param len number of bytes in the buffer
  **/
-void pgp_hash_list_update(list hashes, const void *buf, size_t len);
+void pgp_hash_list_update(dynarray *hashes, const void *buf, size_t len);
 
 /* @brief Free the list of hashes and deallocate all internal structures
  *
- * @param hashes List of pgp_hash_t structures
+ * @param hashes Array of pgp_hash_t structures
  **/
-void pgp_hash_list_free(list *hashes);
+void pgp_hash_list_free(dynarray *hashes);
 
 /*
  * @brief Hashes 4 bytes stored as big endian
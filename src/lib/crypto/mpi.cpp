@@ -40,12 +40,6 @@ to_buf(buf_t *b, const uint8_t *in, size_t len)
     return true;
 }
 
-const buf_t
-mpi2buf(pgp_mpi_t *val, bool uselen)
-{
-    return (buf_t){.pbuf = val->mpi, .len = uselen ? val->len : sizeof(val->mpi)};
-}
-
 bignum_t *
 mpi2bn(const pgp_mpi_t *val)
 {
@@ -55,7 +49,8 @@ mpi2bn(const pgp_mpi_t *val)
 bool
 bn2mpi(bignum_t *bn, pgp_mpi_t *val)
 {
-    return bn_num_bytes(bn, &val->len) && (bn_bn2bin(bn, val->mpi) == 0);
+    size_t len = 0;
+    return bn_num_bytes(bn, &len) && mpi_alloc(val, len) && (bn_bn2bin(bn, val->mpi) == 0);
 }
 
 size_t
@@ -83,17 +78,45 @@ mpi_bytes(const pgp_mpi_t *val)
 }
 
 bool
-mem2mpi(pgp_mpi_t *val, const void *mem, size_t len)
+mpi_alloc(pgp_mpi_t *val, size_t len)
 {
-    if (len > sizeof(val->mpi)) {
+    uint8_t *buf = NULL;
+
+    if (len > PGP_MPINT_SIZE) {
+        return false;
+    }
+    if (len && !(buf = (uint8_t *) calloc(1, len))) {
         return false;
     }
 
-    memcpy(val->mpi, mem, len);
+    mpi_forget(val);
+    val->mpi = buf;
     val->len = len;
     return true;
 }
 
+bool
+mem2mpi(pgp_mpi_t *val, const void *mem, size_t len)
+{
+    if (!mpi_alloc(val, len)) {
+        return false;
+    }
+
+    if (len) {
+        memcpy(val->mpi, mem, len);
+    }
+    return true;
+}
+
+bool
+mpi_copy(pgp_mpi_t *dst, const pgp_mpi_t *src)
+{
+    if (dst == src) {
+        return true;
+    }
+    return mem2mpi(dst, src->mpi, src->len);
+}
+
 void
 mpi2mem(const pgp_mpi_t *val, void *mem)
 {
@@ -188,8 +211,18 @@ mpi_hash(const pgp_mpi_t *val, pgp_hash_t *hash)
 }
 
 void
-mpi_forget(pgp_mpi_t *val)
+mpi_free(pgp_mpi_t *val)
 {
-    pgp_forget(val, sizeof(*val));
+    free(val->mpi);
+    val->mpi = NULL;
     val->len = 0;
 }
+
+void
+mpi_forget(pgp_mpi_t *val)
+{
+    if (val->mpi) {
+        pgp_forget(val->mpi, val->len);
+    }
+    mpi_free(val);
+}
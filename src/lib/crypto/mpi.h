@@ -38,10 +38,14 @@
 
 typedef struct pgp_hash_t pgp_hash_t;
 
-/** multi-precision integer, used in signatures and public/secret keys */
+/** multi-precision integer, used in signatures and public/secret keys.
+ *  Value is stored in the heap-allocated buffer of len bytes, so structure must be
+ *  zero-initialized before the first use and released via mpi_free() or mpi_forget().
+ *  Plain assignment moves the value, mpi_copy() should be used to duplicate it.
+ */
 typedef struct pgp_mpi_t {
-    uint8_t mpi[PGP_MPINT_SIZE];
-    size_t  len;
+    uint8_t *mpi;
+    size_t   len;
 } pgp_mpi_t;
 
 /*
@@ -55,14 +59,23 @@ typedef struct buf_t {
 
 bool to_buf(buf_t *b, const uint8_t *in, size_t len);
 
-const buf_t mpi2buf(pgp_mpi_t *val, bool uselen);
-
 bignum_t *mpi2bn(const pgp_mpi_t *val);
 
 bool bn2mpi(bignum_t *bn, pgp_mpi_t *val);
 
+/**
+ * @brief Replace value of the mpi with len zero bytes. Previous value is destroyed.
+ *
+ * @param val mpi, zero-initialized or holding some value
+ * @param len length of the new value in bytes, may not exceed PGP_MPINT_SIZE
+ * @return true on success or false otherwise
+ */
+bool mpi_alloc(pgp_mpi_t *val, size_t len);
+
 bool mem2mpi(pgp_mpi_t *val, const void *mem, size_t len);
 
+bool mpi_copy(pgp_mpi_t *dst, const pgp_mpi_t *src);
+
 bool hex2mpi(pgp_mpi_t *val, const char *hex);
 
 void mpi2mem(const pgp_mpi_t *val, void *mem);
@@ -77,6 +90,9 @@ bool mpi_hash(const pgp_mpi_t *val, pgp_hash_t *hash);
 
 bool mpi_equal(const pgp_mpi_t *val1, const pgp_mpi_t *val2);
 
+void mpi_free(pgp_mpi_t *val);
+
+/* securely wipe the value and release it */
 void mpi_forget(pgp_mpi_t *val);
 
 #endif // MPI_H_
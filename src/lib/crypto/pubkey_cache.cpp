@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <botan/ffi.h>
+#include "pubkey_cache.h"
+#include "utils.h"
+
+/* maximum number of cached keys */
+#define PUBKEY_CACHE_MAX_KEYS 4096
+/* maximum number of idle verify operations per key and padding */
+#define PUBKEY_CACHE_MAX_OPS 8
+
+struct pgp_pubkey_cache_entry_t {
+    botan_pubkey_t key;
+    bool           checked;
+    bool           check_result;
+    /* idle verify operations, by padding. Protected by the cache lock. */
+    std::unordered_map<std::string, std::vector<botan_pk_op_verify_t>> ops;
+
+    pgp_pubkey_cache_entry_t(botan_pubkey_t bkey)
+        : key(bkey), checked(false), check_result(false){};
+
+    ~pgp_pubkey_cache_entry_t()
+    {
+        /* operations may reference key's data so must be destroyed first */
+        for (auto &pool : ops) {
+            for (auto op : pool.second) {
+                botan_pk_op_verify_destroy(op);
+            }
+        }
+        botan_pubkey_destroy(key);
+    }
+};
+
+typedef std::list<std::string> pgp_pubkey_lru_t;
+
+struct pgp_pubkey_cache_item_t {
+    pgp_cached_pubkey_t        key;
+    pgp_pubkey_lru_t::iterator lru;
+};
+
+static std::mutex                                               cache_lock;
+static pgp_pubkey_lru_t                                         cache_lru;
+static std::unordered_map<std::string, pgp_pubkey_cache_item_t> cache_keys;
+
+void
+pubkey_cache_id_add(std::string &id, const pgp_mpi_t *mpi)
+{
+    uint8_t len[4];
+    STORE32BE(len, mpi->len);
+    id.append((const char *) len, sizeof(len));
+    id.append((const char *) mpi->mpi, mpi->len);
+}
+
+static pgp_cached_pubkey_t
+pubkey_cache_find(const std::string &id)
+{
+    auto it = cache_keys.find(id);
+    if (it == cache_keys.end()) {
+        return NULL;
+    }
+    cache_lru.splice(cache_lru.begin(), cache_lru, it->second.lru);
+    return it->second.key;
+}
+
+pgp_cached_pubkey_t
+pubkey_cache_get(const std::string &id, const pgp_pubkey_loader_t &load)
+{
+    try {
+        {
+            std::lock_guard<std::mutex> lock(cache_lock);
+            pgp_cached_pubkey_t         res = pubkey_cache_find(id);
+            if (res) {
+                return res;
+            }
+        }
+
+        /* key loading may be expensive so do it without lock held */
+        botan_pubkey_t bkey = NULL;
+        if (!load(&bkey)) {
+            return NULL;
+        }
+        pgp_cached_pubkey_t res;
+        try {
+            res = std::make_shared<pgp_pubkey_cache_entry_t>(bkey);
+        } catch (...) {
+            botan_pubkey_destroy(bkey);
+            throw;
+        }
+
+        std::lock_guard<std::mutex> lock(cache_lock);
+        /* other thread could add the same key meanwhile */
+        pgp_cached_pubkey_t found = pubkey_cache_find(id);
+        if (found) {
+            return found;
+        }
+        cache_lru.push_front(id);
+        try {
+            cache_keys[id] = {res, cache_lru.begin()};
+        } catch (...) {
+            cache_lru.pop_front();
+            throw;
+        }
+        if (cache_keys.size() > PUBKEY_CACHE_MAX_KEYS) {
+            cache_keys.erase(cache_lru.back());
+            cache_lru.pop_back();
+        }
+        return res;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+}
+
+botan_pubkey_t
+pubkey_cache_handle(const pgp_cached_pubkey_t &key)
+{
+    return key->key;
+}
+
+bool
+pubkey_cache_check(const pgp_cached_pubkey_t &key, rng_t *rng)
+{
+    {
+        std::lock_guard<std::mutex> lock(cache_lock);
+        if (key->checked) {
+            return key->check_result;
+        }
+    }
+    bool res = !botan_pubkey_check_key(key->key, rng_handle(rng), 0);
+    std::lock_guard<std::mutex> lock(cache_lock);
+    key->checked = true;
+    key->check_result = res;
+    return res;
+}
+
+static botan_pk_op_verify_t
+pubkey_cache_acquire_op(const pgp_cached_pubkey_t &key, const char *padding)
+{
+    botan_pk_op_verify_t op = NULL;
+    try {
+        std::lock_guard<std::mutex> lock(cache_lock);
+        auto                        it = key->ops.find(padding);
+        if ((it != key->ops.end()) && !it->second.empty()) {
+            op = it->second.back();
+            it->second.pop_back();
+            return op;
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+    }
+
+    if (botan_pk_op_verify_create(&op, key->key, padding, 0)) {
+        return NULL;
+    }
+    return op;
+}
+
+static void
+pubkey_cache_release_op(const pgp_cached_pubkey_t &key,
+                        const char *               padding,
+                        botan_pk_op_verify_t       op)
+{
+    try {
+        std::lock_guard<std::mutex> lock(cache_lock);
+        auto &                      pool = key->ops[padding];
+        if (pool.size() < PUBKEY_CACHE_MAX_OPS) {
+            pool.push_back(op);
+            return;
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+    }
+    botan_pk_op_verify_destroy(op);
+}
+
+bool
+pubkey_cache_verify(const pgp_cached_pubkey_t &key,
+                    const char *               padding,
+                    const uint8_t *            hash,
+                    size_t                     hash_len,
+                    const uint8_t *            sig,
+                    size_t                     sig_len)
+{
+    botan_pk_op_verify_t op = pubkey_cache_acquire_op(key, padding);
+    if (!op) {
+        return false;
+    }
+
+    if (botan_pk_op_verify_update(op, hash, hash_len)) {
+        botan_pk_op_verify_destroy(op);
+        return false;
+    }
+    /* operation state is reset only by the successful finish call, so reuse it only then */
+    if (botan_pk_op_verify_finish(op, sig, sig_len)) {
+        botan_pk_op_verify_destroy(op);
+        return false;
+    }
+    pubkey_cache_release_op(key, padding, op);
+    return true;
+}
+
+void
+pubkey_cache_clear(void)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+    cache_keys.clear();
+    cache_lru.clear();
+}
+
+size_t
+pubkey_cache_size(void)
+{
+    std::lock_guard<std::mutex> lock(cache_lock);
+    return cache_keys.size();
+}
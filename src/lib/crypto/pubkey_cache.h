@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_PUBKEY_CACHE_H_
+#define RNP_PUBKEY_CACHE_H_
+
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include "mpi.h"
+#include "rng.h"
+
+typedef struct botan_pubkey_struct *botan_pubkey_t;
+
+/* loaded Botan public key, together with pool of the reusable verify operations */
+struct pgp_pubkey_cache_entry_t;
+typedef std::shared_ptr<pgp_pubkey_cache_entry_t> pgp_cached_pubkey_t;
+
+/* function which loads Botan public key from the key material */
+typedef std::function<bool(botan_pubkey_t *)> pgp_pubkey_loader_t;
+
+/**
+ * @brief Append public mpi to the key identifier, used as cache lookup key. Identifier
+ *        should start from the algorithm (and curve, if applicable) and include all of the
+ *        public key mpis.
+ */
+void pubkey_cache_id_add(std::string &id, const pgp_mpi_t *mpi);
+
+/**
+ * @brief Get loaded Botan public key from the cache, loading it on cache miss. Cache is
+ *        shared between threads and keeps the most recently used keys only. Secret keys are
+ *        never cached.
+ *
+ * @param id key identifier, see pubkey_cache_id_add()
+ * @param load function to load key if it is not in the cache yet
+ * @return cached key or NULL if key failed to load
+ */
+pgp_cached_pubkey_t pubkey_cache_get(const std::string &id, const pgp_pubkey_loader_t &load);
+
+/**
+ * @brief Get Botan handle of the cached key. It is valid while cached key object is alive.
+ */
+botan_pubkey_t pubkey_cache_handle(const pgp_cached_pubkey_t &key);
+
+/**
+ * @brief Check the public key with botan_pubkey_check_key(), doing it only once per cached
+ *        key.
+ *
+ * @return true if key is valid or false otherwise
+ */
+bool pubkey_cache_check(const pgp_cached_pubkey_t &key, rng_t *rng);
+
+/**
+ * @brief Verify signature, using verify operation from the key's pool.
+ *
+ * @param key cached key
+ * @param padding Botan's padding/EMSA name
+ * @param hash hash to verify
+ * @param hash_len length of the hash
+ * @param sig raw signature in Botan's format
+ * @param sig_len length of the signature
+ * @return true if signature is valid or false otherwise
+ */
+bool pubkey_cache_verify(const pgp_cached_pubkey_t &key,
+                         const char *               padding,
+                         const uint8_t *            hash,
+                         size_t                     hash_len,
+                         const uint8_t *            sig,
+                         size_t                     sig_len);
+
+/**
+ * @brief Drop all cached keys. Keys which are in use are destroyed once released.
+ */
+void pubkey_cache_clear(void);
+
+/**
+ * @brief Get the number of currently cached keys.
+ */
+size_t pubkey_cache_size(void);
+
+#endif
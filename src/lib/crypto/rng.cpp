@@ -32,6 +32,7 @@
 #include <assert.h>
 #include <botan/ffi.h>
 #include "rng.h"
+#include "utils.h"
 
 static inline bool
 rng_ensure_initialized(rng_t *ctx)
@@ -111,3 +112,29 @@ rng_generate(uint8_t *data, size_t data_len)
     (void) botan_rng_destroy(rng);
     return rc;
 }
+
+/* thread's generator, destroyed on thread exit */
+struct rng_thread_t {
+    rng_t rng;
+    bool  ok;
+
+    rng_thread_t()
+    {
+        /* initialize DRBG right away so failure is reported to the caller */
+        ok = rng_init(&rng, RNG_DRBG) && rng_ensure_initialized(&rng);
+        if (!ok) {
+            RNP_LOG("failed to initialize thread's DRBG");
+        }
+    }
+    ~rng_thread_t()
+    {
+        rng_destroy(&rng);
+    }
+};
+
+rng_t *
+rng_thread_local(void)
+{
+    static thread_local rng_thread_t trng;
+    return trng.ok ? &trng.rng : NULL;
+}
@@ -103,4 +103,16 @@ struct botan_rng_struct *rng_handle(rng_t *);
  */
 bool rng_generate(uint8_t *data, size_t data_len);
 
+/*
+ * @brief   Returns DRBG instance of the calling thread, initialized on
+ *          first use and destroyed on thread exit. rng_t must not be
+ *          used by the multiple threads at once, so this one allows
+ *          to avoid locking without creating generator for each call.
+ *          Returned pointer must not be passed to the other threads,
+ *          or stored in objects which may be used by the other threads.
+ *
+ * @returns pointer to rng_t, or NULL if DRBG failed to initialize
+ */
+rng_t *rng_thread_local(void);
+
 #endif // RNP_RANDOM_H_
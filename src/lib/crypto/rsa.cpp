@@ -79,33 +79,44 @@
 #include <cstring>
 #include <botan/ffi.h>
 #include "crypto/rsa.h"
+#include "crypto/pubkey_cache.h"
 #include "hash.h"
 #include "config.h"
 #include "utils.h"
 
-rnp_result_t
-rsa_validate_key(rng_t *rng, const pgp_rsa_key_t *key, bool secret)
-{
-    bignum_t *      n = NULL;
-    bignum_t *      e = NULL;
-    bignum_t *      p = NULL;
-    bignum_t *      q = NULL;
-    botan_pubkey_t  bpkey = NULL;
-    botan_privkey_t bskey = NULL;
-    rnp_result_t    ret = RNP_ERROR_GENERIC;
+static bool rsa_load_public_key(botan_pubkey_t *bkey, const pgp_rsa_key_t *key);
 
-    /* load and check public key part */
-    if (!(n = mpi2bn(&key->n)) || !(e = mpi2bn(&key->e))) {
-        RNP_LOG("out of memory");
-        ret = RNP_ERROR_OUT_OF_MEMORY;
-        goto done;
+static pgp_cached_pubkey_t
+rsa_cached_public_key(const pgp_rsa_key_t *key)
+{
+    try {
+        std::string id(1, (char) PGP_PKA_RSA);
+        pubkey_cache_id_add(id, &key->n);
+        pubkey_cache_id_add(id, &key->e);
+        return pubkey_cache_get(
+          id, [key](botan_pubkey_t *bkey) { return rsa_load_public_key(bkey, key); });
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
     }
+}
 
-    if (botan_pubkey_load_rsa(&bpkey, BN_HANDLE_PTR(n), BN_HANDLE_PTR(e)) != 0) {
+rnp_result_t
+rsa_validate_key(rng_t *rng, const pgp_rsa_key_t *key, bool secret)
+{
+    bignum_t *          e = NULL;
+    bignum_t *          p = NULL;
+    bignum_t *          q = NULL;
+    botan_privkey_t     bskey = NULL;
+    pgp_cached_pubkey_t bpkey;
+    rnp_result_t        ret = RNP_ERROR_GENERIC;
+
+    /* load and check public key part, check result is cached together with the key */
+    if (!(bpkey = rsa_cached_public_key(key))) {
         goto done;
     }
 
-    if (botan_pubkey_check_key(bpkey, rng_handle(rng), 0)) {
+    if (!pubkey_cache_check(bpkey, rng)) {
         goto done;
     }
 
@@ -115,7 +126,7 @@ rsa_validate_key(rng_t *rng, const pgp_rsa_key_t *key, bool secret)
     }
 
     /* load and check secret key part */
-    if (!(p = mpi2bn(&key->p)) || !(q = mpi2bn(&key->q))) {
+    if (!(e = mpi2bn(&key->e)) || !(p = mpi2bn(&key->p)) || !(q = mpi2bn(&key->q))) {
         RNP_LOG("out of memory");
         ret = RNP_ERROR_OUT_OF_MEMORY;
         goto done;
@@ -131,9 +142,7 @@ rsa_validate_key(rng_t *rng, const pgp_rsa_key_t *key, bool secret)
     }
     ret = RNP_SUCCESS;
 done:
-    botan_pubkey_destroy(bpkey);
     botan_privkey_destroy(bskey);
-    bn_free(n);
     bn_free(e);
     bn_free(p);
     bn_free(q);
@@ -210,9 +219,12 @@ rsa_encrypt_pkcs1(rng_t *              rng,
         goto done;
     }
 
-    out->m.len = sizeof(out->m.mpi);
+    if (!mpi_alloc(&out->m, mpi_bytes(&key->n))) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto done;
+    }
     if (botan_pk_op_encrypt(enc_op, rng_handle(rng), out->m.mpi, &out->m.len, in, in_len)) {
-        out->m.len = 0;
+        mpi_free(&out->m);
         goto done;
     }
     ret = RNP_SUCCESS;
@@ -229,12 +241,10 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
                  size_t                     hash_len,
                  const pgp_rsa_key_t *      key)
 {
-    char                 padding_name[64] = {0};
-    botan_pubkey_t       rsa_key = NULL;
-    botan_pk_op_verify_t verify_op = NULL;
-    rnp_result_t         ret = RNP_ERROR_SIGNATURE_INVALID;
+    char                padding_name[64] = {0};
+    pgp_cached_pubkey_t rsa_key = rsa_cached_public_key(key);
 
-    if (!rsa_load_public_key(&rsa_key, key)) {
+    if (!rsa_key) {
         RNP_LOG("failed to load key");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
@@ -244,23 +254,10 @@ rsa_verify_pkcs1(const pgp_rsa_signature_t *sig,
              "EMSA-PKCS1-v1_5(Raw,%s)",
              pgp_hash_name_botan(hash_alg));
 
-    if (botan_pk_op_verify_create(&verify_op, rsa_key, padding_name, 0) != 0) {
-        goto done;
+    if (!pubkey_cache_verify(rsa_key, padding_name, hash, hash_len, sig->s.mpi, sig->s.len)) {
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
-
-    if (botan_pk_op_verify_update(verify_op, hash, hash_len) != 0) {
-        goto done;
-    }
-
-    if (botan_pk_op_verify_finish(verify_op, sig->s.mpi, sig->s.len) != 0) {
-        goto done;
-    }
-
-    ret = RNP_SUCCESS;
-done:
-    botan_pk_op_verify_destroy(verify_op);
-    botan_pubkey_destroy(rsa_key);
-    return ret;
+    return RNP_SUCCESS;
 }
 
 rnp_result_t
@@ -299,8 +296,12 @@ rsa_sign_pkcs1(rng_t *              rng,
         goto done;
     }
 
-    sig->s.len = sizeof(sig->s.mpi);
+    if (!mpi_alloc(&sig->s, mpi_bytes(&key->n))) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto done;
+    }
     if (botan_pk_op_sign_finish(sign_op, rng_handle(rng), sig->s.mpi, &sig->s.len)) {
+        mpi_free(&sig->s);
         goto done;
     }
 
@@ -398,12 +399,11 @@ rsa_generate(rng_t *rng, pgp_rsa_key_t *key, size_t numbits)
         goto end;
     }
 
-    bn2mpi(n, &key->n);
-    bn2mpi(e, &key->e);
-    bn2mpi(p, &key->p);
-    bn2mpi(q, &key->q);
-    bn2mpi(d, &key->d);
-    bn2mpi(u, &key->u);
+    if (!bn2mpi(n, &key->n) || !bn2mpi(e, &key->e) || !bn2mpi(p, &key->p) ||
+        !bn2mpi(q, &key->q) || !bn2mpi(d, &key->d) || !bn2mpi(u, &key->u)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto end;
+    }
 
     ret = RNP_SUCCESS;
 end:
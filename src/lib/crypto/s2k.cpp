@@ -29,8 +29,12 @@
  */
 
 #include <botan/ffi.h>
+#include <botan/secmem.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include <time.h>
+#include <map>
+#include <mutex>
 
 #include "crypto/s2k.h"
 #include "defaults.h"
@@ -70,6 +74,160 @@ pgp_s2k_derive_key(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysi
     return true;
 }
 
+typedef Botan::secure_vector<uint8_t> pgp_s2k_cache_id_t;
+
+typedef struct pgp_s2k_cache_entry_t {
+    Botan::secure_vector<uint8_t> key;
+    time_t                        expires;
+} pgp_s2k_cache_entry_t;
+
+/* derived keys cache, both keys and ids are kept in the locked and wiped on free memory */
+static std::mutex                                          s2k_cache_lock;
+static size_t                                              s2k_cache_size = 0;
+static uint32_t                                            s2k_cache_ttl = 0;
+static std::map<pgp_s2k_cache_id_t, pgp_s2k_cache_entry_t> s2k_cache;
+static pgp_s2k_cache_clock_t                               s2k_cache_clock = NULL;
+
+/* should be called with cache lock held */
+static time_t
+s2k_cache_now(void)
+{
+    return s2k_cache_clock ? s2k_cache_clock() : time(NULL);
+}
+
+/* should be called with cache lock held */
+static void
+s2k_cache_expire(time_t now)
+{
+    for (auto it = s2k_cache.begin(); it != s2k_cache.end();) {
+        it = (it->second.expires <= now) ? s2k_cache.erase(it) : std::next(it);
+    }
+}
+
+static bool
+s2k_cache_id(pgp_s2k_cache_id_t &id, const pgp_s2k_t *s2k, const char *password)
+{
+    pgp_hash_t hash = {};
+    uint8_t    iters[4];
+    size_t     iterations = s2k->iterations;
+
+    if ((s2k->specifier == PGP_S2KS_ITERATED_AND_SALTED) && (iterations < 256)) {
+        iterations = pgp_s2k_decode_iterations(iterations);
+    }
+    STORE32BE(iters, iterations);
+    id.push_back(s2k->specifier);
+    id.push_back(s2k->hash_alg);
+    id.insert(id.end(), s2k->salt, s2k->salt + PGP_SALT_SIZE);
+    id.insert(id.end(), iters, iters + sizeof(iters));
+
+    /* password is not stored as is, but its digest. Resize first since it may throw */
+    size_t pos = id.size();
+    id.resize(pos + pgp_digest_length(PGP_HASH_SHA256));
+    if (!pgp_hash_create(&hash, PGP_HASH_SHA256)) {
+        return false;
+    }
+    pgp_hash_add(&hash, password, strlen(password));
+    pgp_hash_finish(&hash, id.data() + pos);
+    return true;
+}
+
+bool
+pgp_s2k_derive_key_cached(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysize)
+{
+    pgp_s2k_cache_id_t id;
+    time_t             now = 0;
+
+    try {
+        {
+            std::lock_guard<std::mutex> lock(s2k_cache_lock);
+            if (!s2k_cache_size) {
+                goto nocache;
+            }
+            now = s2k_cache_now();
+            s2k_cache_expire(now);
+        }
+
+        if (!s2k_cache_id(id, s2k, password)) {
+            goto nocache;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s2k_cache_lock);
+            auto                        it = s2k_cache.find(id);
+            /* S2K output for the shorter key is a prefix of the longer one's */
+            if ((it != s2k_cache.end()) && (it->second.key.size() >= (size_t) keysize)) {
+                memcpy(key, it->second.key.data(), keysize);
+                return true;
+            }
+        }
+
+        /* derivation is expensive, so do it without lock held */
+        if (!pgp_s2k_derive_key(s2k, password, key, keysize)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(s2k_cache_lock);
+        if (!s2k_cache_size) {
+            return true;
+        }
+        pgp_s2k_cache_entry_t &entry = s2k_cache[id];
+        if (entry.key.size() < (size_t) keysize) {
+            entry.key.assign(key, key + keysize);
+        }
+        entry.expires = now + s2k_cache_ttl;
+        /* evict the oldest entries */
+        while (s2k_cache.size() > s2k_cache_size) {
+            auto oldest = s2k_cache.begin();
+            for (auto it = s2k_cache.begin(); it != s2k_cache.end(); it++) {
+                if (it->second.expires < oldest->second.expires) {
+                    oldest = it;
+                }
+            }
+            s2k_cache.erase(oldest);
+        }
+        return true;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+    }
+nocache:
+    return pgp_s2k_derive_key(s2k, password, key, keysize);
+}
+
+bool
+pgp_s2k_cache_configure(size_t size, uint32_t ttl)
+{
+    if (size && !ttl) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(s2k_cache_lock);
+    s2k_cache_size = size;
+    s2k_cache_ttl = ttl;
+    s2k_cache.clear();
+    return true;
+}
+
+void
+pgp_s2k_cache_clear(void)
+{
+    std::lock_guard<std::mutex> lock(s2k_cache_lock);
+    s2k_cache.clear();
+}
+
+size_t
+pgp_s2k_cache_count(void)
+{
+    std::lock_guard<std::mutex> lock(s2k_cache_lock);
+    s2k_cache_expire(s2k_cache_now());
+    return s2k_cache.size();
+}
+
+void
+pgp_s2k_cache_set_clock(pgp_s2k_cache_clock_t clock)
+{
+    std::lock_guard<std::mutex> lock(s2k_cache_lock);
+    s2k_cache_clock = clock;
+}
+
 int
 pgp_s2k_simple(pgp_hash_alg_t alg, uint8_t *out, size_t output_len, const char *password)
 {
@@ -31,6 +31,7 @@
 #ifndef RNP_S2K_H_
 #define RNP_S2K_H_
 
+#include <time.h>
 #include "hash.h"
 
 typedef struct pgp_s2k_t pgp_s2k_t;
@@ -69,4 +70,36 @@ size_t pgp_s2k_compute_iters(pgp_hash_alg_t alg, size_t desired_msec, size_t tri
  */
 bool pgp_s2k_derive_key(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysize);
 
+/** @brief Same as pgp_s2k_derive_key(), but looks up the derived key in the process-wide
+ *         cache first, and stores it there on cache miss. Should be used only for the key
+ *         derivation for the decryption, where the same S2K parameters may be met again.
+ *         If cache is disabled then just calls pgp_s2k_derive_key().
+ */
+bool pgp_s2k_derive_key_cached(pgp_s2k_t * s2k,
+                               const char *password,
+                               uint8_t *   key,
+                               int         keysize);
+
+/** @brief Configure the derived keys cache. Cache is disabled by default. Derived keys are
+ *         kept in the locked memory, which is wiped on entry removal.
+ *  @param size maximum number of the cached keys, 0 disables the cache and wipes it
+ *  @param ttl number of seconds during which cached key may be used, must be non-zero if
+ *         cache is enabled
+ *  @return true on success or false if parameters are invalid
+ */
+bool pgp_s2k_cache_configure(size_t size, uint32_t ttl);
+
+/** @brief Wipe all of the cached keys. */
+void pgp_s2k_cache_clear(void);
+
+/** @brief Get the number of currently cached, non-expired, keys. */
+size_t pgp_s2k_cache_count(void);
+
+typedef time_t (*pgp_s2k_cache_clock_t)(void);
+
+/** @brief Set the clock used to expire cached keys, mostly for the testing purposes.
+ *  @param clock function returning the current time, or NULL to use time(NULL)
+ */
+void pgp_s2k_cache_set_clock(pgp_s2k_cache_clock_t clock);
+
 #endif
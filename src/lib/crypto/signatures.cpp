@@ -25,7 +25,9 @@
  */
 
 #include <string.h>
+#include <string>
 #include "crypto/signatures.h"
+#include "sig-cache.h"
 #include "utils.h"
 
 /**
@@ -183,12 +185,88 @@ signature_calculate(pgp_signature_t *         sig,
     return ret;
 }
 
+static void
+signature_cache_id_add(std::string &id, const pgp_mpi_t *mpi)
+{
+    uint8_t len[4];
+    STORE32BE(len, mpi->len);
+    id.append((const char *) len, sizeof(len));
+    id.append((const char *) mpi->mpi, mpi->len);
+}
+
+/* cache identifier: signer's fingerprint, algorithms, digest and signature material */
+static bool
+signature_cache_id(std::string &            id,
+                   const pgp_signature_t *  sig,
+                   const pgp_fingerprint_t *signer_fp,
+                   const uint8_t *          hval,
+                   size_t                   hlen)
+{
+    id.assign((const char *) signer_fp->fingerprint, signer_fp->length);
+    id.push_back((char) sig->palg);
+    id.push_back((char) sig->halg);
+    id.append((const char *) hval, hlen);
+    switch (sig->palg) {
+    case PGP_PKA_RSA:
+        signature_cache_id_add(id, &sig->material.rsa.s);
+        return true;
+    case PGP_PKA_DSA:
+        signature_cache_id_add(id, &sig->material.dsa.r);
+        signature_cache_id_add(id, &sig->material.dsa.s);
+        return true;
+    case PGP_PKA_EDDSA:
+    case PGP_PKA_ECDSA:
+    case PGP_PKA_SM2:
+        signature_cache_id_add(id, &sig->material.ecc.r);
+        signature_cache_id_add(id, &sig->material.ecc.s);
+        return true;
+    default:
+        return false;
+    }
+}
+
+static rnp_result_t
+signature_verify_hash(const pgp_signature_t *   sig,
+                      const pgp_key_material_t *key,
+                      pgp_hash_alg_t            hash_alg,
+                      const uint8_t *           hval,
+                      size_t                    hlen)
+{
+    switch (sig->palg) {
+    case PGP_PKA_DSA:
+        return dsa_verify(&sig->material.dsa, hval, hlen, &key->dsa);
+    case PGP_PKA_EDDSA:
+        return eddsa_verify(&sig->material.ecc, hval, hlen, &key->ec);
+    case PGP_PKA_SM2:
+        return sm2_verify(&sig->material.ecc, hash_alg, hval, hlen, &key->ec);
+    case PGP_PKA_RSA:
+        return rsa_verify_pkcs1(&sig->material.rsa, sig->halg, hval, hlen, &key->rsa);
+    case PGP_PKA_ECDSA:
+        return ecdsa_verify(&sig->material.ecc, hash_alg, hval, hlen, &key->ec);
+    default:
+        RNP_LOG("Unknown algorithm");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+}
+
 rnp_result_t
 signature_validate(const pgp_signature_t *sig, const pgp_key_material_t *key, pgp_hash_t *hash)
+{
+    return signature_validate_cached(sig, key, hash, NULL, NULL);
+}
+
+rnp_result_t
+signature_validate_cached(const pgp_signature_t *   sig,
+                          const pgp_key_material_t *key,
+                          pgp_hash_t *              hash,
+                          pgp_sig_cache_t *         cache,
+                          const pgp_fingerprint_t * signer_fp)
 {
     uint8_t      hval[PGP_MAX_HASH_SIZE];
     size_t       hlen = 0;
     rnp_result_t ret = RNP_ERROR_GENERIC;
+    std::string  id;
+    bool         cached = false;
 
     const pgp_hash_alg_t hash_alg = pgp_hash_alg_type(hash);
 
@@ -213,28 +291,25 @@ signature_validate(const pgp_signature_t *sig, const pgp_key_material_t *key, pg
         return RNP_ERROR_SIGNATURE_INVALID;
     }
 
+    /* lookup the cache, if any */
+    if (cache && signer_fp) {
+        try {
+            cached = signature_cache_id(id, sig, signer_fp, hval, hlen);
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+        }
+        bool valid = false;
+        if (cached && sig_cache_get(cache, id, &valid)) {
+            return valid ? RNP_SUCCESS : RNP_ERROR_SIGNATURE_INVALID;
+        }
+    }
+
     /* validate signature */
+    ret = signature_verify_hash(sig, key, hash_alg, hval, hlen);
 
-    switch (sig->palg) {
-    case PGP_PKA_DSA:
-        ret = dsa_verify(&sig->material.dsa, hval, hlen, &key->dsa);
-        break;
-    case PGP_PKA_EDDSA:
-        ret = eddsa_verify(&sig->material.ecc, hval, hlen, &key->ec);
-        break;
-    case PGP_PKA_SM2:
-        ret = sm2_verify(&sig->material.ecc, hash_alg, hval, hlen, &key->ec);
-        break;
-    case PGP_PKA_RSA:
-        ret = rsa_verify_pkcs1(&sig->material.rsa, sig->halg, hval, hlen, &key->rsa);
-        break;
-    case PGP_PKA_ECDSA:
-        ret = ecdsa_verify(&sig->material.ecc, hash_alg, hval, hlen, &key->ec);
-        break;
-    default:
-        RNP_LOG("Unknown algorithm");
-        ret = RNP_ERROR_BAD_PARAMETERS;
+    /* other errors do not depend on the signature contents so are not cached */
+    if (cached && ((ret == RNP_SUCCESS) || (ret == RNP_ERROR_SIGNATURE_INVALID))) {
+        sig_cache_put(cache, id, ret == RNP_SUCCESS);
     }
-
     return ret;
 }
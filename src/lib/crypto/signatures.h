@@ -29,6 +29,7 @@
 
 #include "types.h"
 #include "crypto/hash.h"
+#include "sig-cache.h"
 
 /**
  * Initialize a signature computation.
@@ -68,4 +69,18 @@ rnp_result_t signature_validate(const pgp_signature_t *   sig,
                                 const pgp_key_material_t *key,
                                 pgp_hash_t *              hash);
 
+/**
+ * @brief Same as signature_validate(), but looks up verification result in the cache first
+ *        and stores it there on cache miss. Only the public key operation result is cached:
+ *        hash is always calculated and checked.
+ * @param cache verification results cache, may be NULL
+ * @param signer_fp fingerprint of the verifying key, used as part of the cache lookup key.
+ *                  If NULL then cache is not used.
+ */
+rnp_result_t signature_validate_cached(const pgp_signature_t *   sig,
+                                       const pgp_key_material_t *key,
+                                       pgp_hash_t *              hash,
+                                       pgp_sig_cache_t *         cache,
+                                       const pgp_fingerprint_t * signer_fp);
+
 #endif
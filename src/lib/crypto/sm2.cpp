@@ -25,10 +25,12 @@
  */
 
 #include <string.h>
+#include <string>
 #include <botan/ffi.h>
 #include "sm2.h"
 #include "hash.h"
 #include "utils.h"
+#include "pubkey_cache.h"
 
 static bool
 sm2_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
@@ -61,6 +63,21 @@ end:
     return res;
 }
 
+static pgp_cached_pubkey_t
+sm2_cached_public_key(const pgp_ec_key_t *key)
+{
+    try {
+        std::string id(1, (char) PGP_PKA_SM2);
+        id.push_back((char) key->curve);
+        pubkey_cache_id_add(id, &key->p);
+        return pubkey_cache_get(
+          id, [key](botan_pubkey_t *bkey) { return sm2_load_public_key(bkey, key); });
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+}
+
 static bool
 sm2_load_secret_key(botan_privkey_t *seckey, const pgp_ec_key_t *keydata)
 {
@@ -223,9 +240,7 @@ sm2_verify(const pgp_ec_signature_t *sig,
            const pgp_ec_key_t *      key)
 {
     const ec_curve_desc_t *curve = NULL;
-    botan_pubkey_t         pub = NULL;
-    botan_pk_op_verify_t   verifier = NULL;
-    rnp_result_t           ret = RNP_ERROR_SIGNATURE_INVALID;
+    pgp_cached_pubkey_t    pub;
     uint8_t                sign_buf[2 * MAX_CURVE_BYTELEN] = {0};
     size_t                 r_blen, s_blen, sign_half_len;
 
@@ -244,36 +259,25 @@ sm2_verify(const pgp_ec_signature_t *sig,
     }
     sign_half_len = BITS_TO_BYTES(curve->bitlen);
 
-    if (!sm2_load_public_key(&pub, key)) {
+    if (!(pub = sm2_cached_public_key(key))) {
         RNP_LOG("Failed to load public key");
-        goto end;
-    }
-
-    if (botan_pk_op_verify_create(&verifier, pub, ",Raw", 0)) {
-        goto end;
-    }
-
-    if (botan_pk_op_verify_update(verifier, hash, hash_len)) {
-        goto end;
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
 
     r_blen = sig->r.len;
     s_blen = sig->s.len;
     if (!r_blen || (r_blen > sign_half_len) || !s_blen || (s_blen > sign_half_len) ||
         (sign_half_len > MAX_CURVE_BYTELEN)) {
-        goto end;
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
 
     mpi2mem(&sig->r, sign_buf + sign_half_len - r_blen);
     mpi2mem(&sig->s, sign_buf + 2 * sign_half_len - s_blen);
 
-    if (!botan_pk_op_verify_finish(verifier, sign_buf, sign_half_len * 2)) {
-        ret = RNP_SUCCESS;
+    if (!pubkey_cache_verify(pub, ",Raw", hash, hash_len, sign_buf, sign_half_len * 2)) {
+        return RNP_ERROR_SIGNATURE_INVALID;
     }
-end:
-    botan_pubkey_destroy(pub);
-    botan_pk_op_verify_destroy(verifier);
-    return ret;
+    return RNP_SUCCESS;
 }
 
 rnp_result_t
@@ -291,6 +295,8 @@ sm2_encrypt(rng_t *              rng,
     size_t                 point_len;
     size_t                 hash_alg_len;
     size_t                 ctext_len;
+    uint8_t                outbuf[PGP_MPINT_SIZE];
+    size_t                 outlen = 0;
 
     curve = get_curve_desc(key->curve);
     if (curve == NULL) {
@@ -327,12 +333,13 @@ sm2_encrypt(rng_t *              rng,
         goto done;
     }
 
-    out->m.len = sizeof(out->m.mpi);
-    if (botan_pk_op_encrypt(enc_op, rng_handle(rng), out->m.mpi, &out->m.len, in, in_len) ==
-        0) {
-        out->m.mpi[out->m.len++] = hash_algo;
-        ret = RNP_SUCCESS;
+    /* last byte is reserved for the hash algorithm */
+    outlen = sizeof(outbuf) - 1;
+    if (botan_pk_op_encrypt(enc_op, rng_handle(rng), outbuf, &outlen, in, in_len)) {
+        goto done;
     }
+    outbuf[outlen++] = hash_algo;
+    ret = mem2mpi(&out->m, outbuf, outlen) ? RNP_SUCCESS : RNP_ERROR_OUT_OF_MEMORY;
 done:
     botan_pk_op_encrypt_destroy(enc_op);
     botan_pubkey_destroy(sm2_key);
@@ -58,8 +58,13 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <botan/ffi.h>
+#include <botan/block_cipher.h>
+#include <botan/mem_ops.h>
 #include "utils.h"
 
+/* number of bytes, processed by a single bulk call during CFB decryption */
+#define PGP_CFB_BULK_SIZE 4096
+
 static const char *
 pgp_sa_to_botan_string(pgp_symm_alg_t alg)
 {
@@ -172,15 +177,24 @@ pgp_cipher_cfb_start(pgp_crypt_t *  crypt,
     crypt->blocksize = pgp_block_size(alg);
 
     // This shouldn't happen if pgp_sa_to_botan_string returned a ptr
-    if (botan_block_cipher_init(&(crypt->cfb.obj), cipher_name) != 0) {
+    try {
+        crypt->cfb.obj = Botan::BlockCipher::create(cipher_name).release();
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+    }
+    if (!crypt->cfb.obj) {
         RNP_LOG("Block cipher '%s' not available", cipher_name);
         return false;
     }
 
     const size_t keysize = pgp_key_size(alg);
 
-    if (botan_block_cipher_set_key(crypt->cfb.obj, key, keysize) != 0) {
-        RNP_LOG("Failure setting key on block cipher object");
+    try {
+        crypt->cfb.obj->set_key(key, keysize);
+    } catch (const std::exception &e) {
+        RNP_LOG("Failure setting key on block cipher object: %s", e.what());
+        delete crypt->cfb.obj;
+        crypt->cfb.obj = NULL;
         return false;
     }
 
@@ -208,10 +222,8 @@ pgp_cipher_cfb_finish(pgp_crypt_t *crypt)
     if (!crypt) {
         return 0;
     }
-    if (crypt->cfb.obj) {
-        botan_block_cipher_destroy(crypt->cfb.obj);
-        crypt->cfb.obj = NULL;
-    }
+    delete crypt->cfb.obj;
+    crypt->cfb.obj = NULL;
     botan_scrub_mem((uint8_t *) crypt, sizeof(*crypt));
     return 0;
 }
@@ -220,11 +232,7 @@ pgp_cipher_cfb_finish(pgp_crypt_t *crypt)
 int
 pgp_cipher_cfb_encrypt(pgp_crypt_t *crypt, uint8_t *out, const uint8_t *in, size_t bytes)
 {
-    uint64_t *in64;
-    uint64_t  buf64[512]; // 4KB - page size
-    uint64_t  iv64[2];
-    size_t    blocks, blockb;
-    unsigned  blsize = crypt->blocksize;
+    unsigned blsize = crypt->blocksize;
 
     /* encrypting till the block boundary */
     while (bytes && crypt->cfb.remaining) {
@@ -238,51 +246,24 @@ pgp_cipher_cfb_encrypt(pgp_crypt_t *crypt, uint8_t *out, const uint8_t *in, size
         return 0;
     }
 
-    /* encrypting full blocks */
+    /* encrypting full blocks. Each block depends on the previous ciphertext, so this could
+     * not be done in bulk, but at least cipher is called directly, without FFI layer */
     if (bytes > blsize) {
-        memcpy(iv64, crypt->cfb.iv, blsize);
-        while ((blocks = bytes & ~(blsize - 1)) > 0) {
-            if (blocks > sizeof(buf64)) {
-                blocks = sizeof(buf64);
-            }
-            bytes -= blocks;
-            blockb = blocks;
-            memcpy(buf64, in, blockb);
-            in64 = buf64;
-
-            if (blsize == 16) {
-                blocks >>= 4;
-                while (blocks--) {
-                    botan_block_cipher_encrypt_blocks(
-                      crypt->cfb.obj, (uint8_t *) iv64, (uint8_t *) iv64, 1);
-                    *in64 ^= iv64[0];
-                    iv64[0] = *in64++;
-                    *in64 ^= iv64[1];
-                    iv64[1] = *in64++;
-                }
-            } else {
-                blocks >>= 3;
-                while (blocks--) {
-                    botan_block_cipher_encrypt_blocks(
-                      crypt->cfb.obj, (uint8_t *) iv64, (uint8_t *) iv64, 1);
-                    *in64 ^= iv64[0];
-                    iv64[0] = *in64++;
-                }
-            }
-
-            memcpy(out, buf64, blockb);
-            out += blockb;
-            in += blockb;
+        while (bytes >= blsize) {
+            crypt->cfb.obj->encrypt(crypt->cfb.iv);
+            Botan::xor_buf(crypt->cfb.iv, in, blsize);
+            memcpy(out, crypt->cfb.iv, blsize);
+            out += blsize;
+            in += blsize;
+            bytes -= blsize;
         }
-
-        memcpy(crypt->cfb.iv, iv64, blsize);
     }
 
     if (!bytes) {
         return 0;
     }
 
-    botan_block_cipher_encrypt_blocks(crypt->cfb.obj, crypt->cfb.iv, crypt->cfb.iv, 1);
+    crypt->cfb.obj->encrypt(crypt->cfb.iv);
     crypt->cfb.remaining = blsize;
 
     /* encrypting tail */
@@ -300,13 +281,9 @@ pgp_cipher_cfb_encrypt(pgp_crypt_t *crypt, uint8_t *out, const uint8_t *in, size
 int
 pgp_cipher_cfb_decrypt(pgp_crypt_t *crypt, uint8_t *out, const uint8_t *in, size_t bytes)
 {
-    /* for better code readability */
-    uint64_t *out64, *in64;
-    uint64_t  inbuf64[512]; // 4KB - page size
-    uint64_t  outbuf64[512];
-    uint64_t  iv64[2];
-    size_t    blocks, blockb;
-    unsigned  blsize = crypt->blocksize;
+    uint8_t  keystream[PGP_CFB_BULK_SIZE];
+    size_t   blockb;
+    unsigned blsize = crypt->blocksize;
 
     /* decrypting till the block boundary */
     while (bytes && crypt->cfb.remaining) {
@@ -321,53 +298,31 @@ pgp_cipher_cfb_decrypt(pgp_crypt_t *crypt, uint8_t *out, const uint8_t *in, size
         return 0;
     }
 
-    /* decrypting full blocks */
+    /* decrypting full blocks. Keystream block is the encrypted previous ciphertext block, so
+     * all of them are known in advance and may be calculated by a single cipher call */
     if (bytes > blsize) {
-        memcpy(iv64, crypt->cfb.iv, blsize);
-
-        while ((blocks = bytes & ~(blsize - 1)) > 0) {
-            if (blocks > sizeof(inbuf64)) {
-                blocks = sizeof(inbuf64);
+        while ((blockb = bytes & ~(blsize - 1)) > 0) {
+            if (blockb > sizeof(keystream)) {
+                blockb = sizeof(keystream);
             }
-            bytes -= blocks;
-            blockb = blocks;
-            memcpy(inbuf64, in, blockb);
-            out64 = outbuf64;
-            in64 = inbuf64;
-
-            if (blsize == 16) {
-                blocks >>= 4;
-                while (blocks--) {
-                    botan_block_cipher_encrypt_blocks(
-                      crypt->cfb.obj, (uint8_t *) iv64, (uint8_t *) iv64, 1);
-                    *out64++ = *in64 ^ iv64[0];
-                    iv64[0] = *in64++;
-                    *out64++ = *in64 ^ iv64[1];
-                    iv64[1] = *in64++;
-                }
-            } else {
-                blocks >>= 3;
-                while (blocks--) {
-                    botan_block_cipher_encrypt_blocks(
-                      crypt->cfb.obj, (uint8_t *) iv64, (uint8_t *) iv64, 1);
-                    *out64++ = *in64 ^ iv64[0];
-                    iv64[0] = *in64++;
-                }
-            }
-
-            memcpy(out, outbuf64, blockb);
+            memcpy(keystream, crypt->cfb.iv, blsize);
+            memcpy(keystream + blsize, in, blockb - blsize);
+            /* save last ciphertext block: in-place decryption will overwrite it */
+            memcpy(crypt->cfb.iv, in + blockb - blsize, blsize);
+            crypt->cfb.obj->encrypt_n(keystream, keystream, blockb / blsize);
+            Botan::xor_buf(out, in, keystream, blockb);
             out += blockb;
             in += blockb;
+            bytes -= blockb;
         }
-
-        memcpy(crypt->cfb.iv, iv64, blsize);
+        botan_scrub_mem(keystream, sizeof(keystream));
     }
 
     if (!bytes) {
         return 0;
     }
 
-    botan_block_cipher_encrypt_blocks(crypt->cfb.obj, crypt->cfb.iv, crypt->cfb.iv, 1);
+    crypt->cfb.obj->encrypt(crypt->cfb.iv);
     crypt->cfb.remaining = blsize;
 
     /* decrypting tail */
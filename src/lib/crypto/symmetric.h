@@ -54,6 +54,10 @@
 
 #include "crypto/rng.h"
 
+namespace Botan {
+class BlockCipher;
+}
+
 /* Nonce len for AEAD/EAX */
 #define PGP_AEAD_EAX_NONCE_LEN 16
 
@@ -76,9 +80,9 @@
 #define PGP_AEAD_MAX_AD_LEN 32
 
 struct pgp_crypt_cfb_param_t {
-    struct botan_block_cipher_struct *obj;
-    size_t                            remaining;
-    uint8_t                           iv[PGP_MAX_BLOCK_SIZE];
+    Botan::BlockCipher *obj; /* used directly to avoid FFI overhead on each block */
+    size_t              remaining;
+    uint8_t             iv[PGP_MAX_BLOCK_SIZE];
 };
 
 struct pgp_crypt_aead_param_t {
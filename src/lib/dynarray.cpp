@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "dynarray.h"
+
+bool
+dynarray_reserve(dynarray *arr, size_t count, size_t item_size)
+{
+    if (!arr || !item_size || (arr->item_size && (arr->item_size != item_size))) {
+        return false;
+    }
+    if (count <= arr->capacity) {
+        return true;
+    }
+    if (count > SIZE_MAX / item_size) {
+        return false;
+    }
+    uint8_t *items = (uint8_t *) realloc(arr->items, count * item_size);
+    if (!items) {
+        return false;
+    }
+    arr->items = items;
+    arr->capacity = count;
+    arr->item_size = item_size;
+    return true;
+}
+
+void *
+dynarray_append(dynarray *arr, const void *data, size_t item_size)
+{
+    if (!arr) {
+        return NULL;
+    }
+    if (arr->length == arr->capacity) {
+        size_t capacity = arr->capacity ? arr->capacity * 2 : 4;
+        if (!dynarray_reserve(arr, capacity, item_size)) {
+            return NULL;
+        }
+    } else if (arr->item_size != item_size) {
+        return NULL;
+    }
+
+    uint8_t *item = arr->items + arr->length * item_size;
+    if (data) {
+        memcpy(item, data, item_size);
+    } else {
+        memset(item, 0, item_size);
+    }
+    arr->length++;
+    return item;
+}
+
+size_t
+dynarray_length(const dynarray *arr)
+{
+    return arr ? arr->length : 0;
+}
+
+void *
+dynarray_at(const dynarray *arr, size_t idx)
+{
+    if (!arr || (idx >= arr->length)) {
+        return NULL;
+    }
+    return arr->items + idx * arr->item_size;
+}
+
+void *
+dynarray_back(const dynarray *arr)
+{
+    if (!arr || !arr->length) {
+        return NULL;
+    }
+    return arr->items + (arr->length - 1) * arr->item_size;
+}
+
+void
+dynarray_remove(dynarray *arr, size_t idx)
+{
+    if (!arr || (idx >= arr->length)) {
+        return;
+    }
+    uint8_t *item = arr->items + idx * arr->item_size;
+    memmove(item, item + arr->item_size, (arr->length - idx - 1) * arr->item_size);
+    arr->length--;
+}
+
+void
+dynarray_destroy(dynarray *arr)
+{
+    if (!arr) {
+        return;
+    }
+    free(arr->items);
+    memset(arr, 0, sizeof(*arr));
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** Contiguous growable array
+ *  @file
+ */
+#ifndef RNP_DYNARRAY_H
+#define RNP_DYNARRAY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ *  @private
+ *  Array of fixed-size items, stored contiguously in a single heap block.
+ *  Unlike list, indexed access is O(1) and iteration does not chase pointers.
+ *
+ *  A zero-initialized structure is a valid empty array, so it may be embedded
+ *  in structures which are calloc()-ed or memset() to zero. Moving the array
+ *  with memcpy() or plain assignment transfers ownership of the items.
+ *
+ *  **Note**: appending or removing items may move the storage, so pointers to
+ *  items are valid only until the next modification of the array. Use indexes
+ *  to keep a long-living reference.
+ *
+ *  @code
+ *  dynarray arr = {};
+ *  int      val = 1;
+ *  dynarray_append(&arr, &val, sizeof(val));
+ *  for (size_t i = 0; i < dynarray_length(&arr); i++) {
+ *      printf("%d\n", *(int *) dynarray_at(&arr, i));
+ *  }
+ *  dynarray_destroy(&arr);
+ *  @endcode
+ */
+typedef struct dynarray {
+    uint8_t *items;     /* item storage */
+    size_t   length;    /* number of items */
+    size_t   capacity;  /* number of items which fit into the storage */
+    size_t   item_size; /* size of the single item, set on first allocation */
+} dynarray;
+
+/** @private
+ *  make sure that array is able to hold at least count items without reallocation
+ *
+ *  @param arr pointer to the array, which should not be NULL
+ *  @param count number of items
+ *  @param item_size size of the item, must be the same for all calls on the array
+ *  @return true on success or false if memory allocation failed
+ **/
+bool dynarray_reserve(dynarray *arr, size_t count, size_t item_size);
+
+/** @private
+ *  append item to the end of the array
+ *
+ *  @param arr pointer to the array, which should not be NULL
+ *  @param data pointer to the data. If NULL, the new item will
+ *         be zero-initialized. Otherwise, the data will be
+ *         copied to the new item
+ *  @param item_size size of the item, which must be >= 1 and the same for all items
+ *  @return pointer to the new item or NULL if memory allocation failed
+ **/
+void *dynarray_append(dynarray *arr, const void *data, size_t item_size);
+
+/** @private
+ *  get the number of items in the array
+ *
+ *  @param arr pointer to the array, may be NULL
+ *  @return the number of items
+ **/
+size_t dynarray_length(const dynarray *arr);
+
+/** @private
+ *  get the array item at specified index
+ *
+ *  @param arr pointer to the array, may be NULL
+ *  @param idx index of the item
+ *  @return pointer to the item, or NULL if idx is out of range
+ **/
+void *dynarray_at(const dynarray *arr, size_t idx);
+
+/** @private
+ *  get the last item of the array
+ *
+ *  @param arr pointer to the array, may be NULL
+ *  @return pointer to the item, if any, otherwise NULL
+ **/
+void *dynarray_back(const dynarray *arr);
+
+/** @private
+ *  remove item at the specified index, shifting the following items
+ *
+ *  @param arr pointer to the array, which should not be NULL
+ *  @param idx index of the item. Nothing is done if it is out of range
+ **/
+void dynarray_remove(dynarray *arr, size_t idx);
+
+/** @private
+ *  destroy the array storage, leaving the empty array
+ *
+ *  @param arr pointer to the array, which should not be NULL
+ **/
+void dynarray_destroy(dynarray *arr);
+
+#endif
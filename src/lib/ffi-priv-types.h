@@ -25,9 +25,15 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <rnp/rnp.h>
 #include <json.h>
 #include "utils.h"
+#include "sig-cache.h"
+#include "rwlock.h"
+#include "parallel.h"
 
 struct rnp_key_handle_st {
     rnp_ffi_t        ffi;
@@ -57,9 +63,14 @@ struct rnp_ffi_st {
     void *                  getkeycb_ctx;
     rnp_password_cb         getpasscb;
     void *                  getpasscb_ctx;
-    rng_t                   rng;
     pgp_key_provider_t      key_provider;
     pgp_password_provider_t pass_provider;
+    pgp_sig_cache_t *       sigcache;
+    size_t                  cert_limit;
+    rnp_rwlock_t *          lock; /* guards pubring and secring */
+    size_t                  aead_threads;
+    rnp_thread_pool_t *     pool; /* worker threads of the parallel operations */
+    bool                    pipeline;
 };
 
 struct rnp_input_st {
@@ -134,6 +145,19 @@ struct rnp_op_verify_st {
     uint32_t                  file_mtime;
 };
 
+struct rnp_op_verify_batch_st {
+    rnp_ffi_t                    ffi;
+    std::vector<rnp_op_verify_t> items;
+    std::vector<rnp_result_t>    results;
+    std::vector<rnp_output_t>    outputs; /* null outputs, created for the items */
+    size_t                       threads;
+    rnp_op_verify_batch_cb       callback;
+    void *                       callback_ctx;
+    /* signer keys, shared between the items */
+    std::mutex                                   keys_lock;
+    std::unordered_map<std::string, pgp_key_t *> keys;
+};
+
 struct rnp_op_encrypt_st {
     rnp_ffi_t    ffi;
     rnp_input_t  input;
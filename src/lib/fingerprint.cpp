@@ -30,6 +30,7 @@
  */
 
 #include <string.h>
+#include <vector>
 #include "fingerprint.h"
 #include "crypto/hash.h"
 #include <librepgp/stream-key.h>
@@ -106,6 +107,83 @@ pgp_keyid(uint8_t *keyid, const size_t idlen, const pgp_key_pkt_t *key)
     return RNP_SUCCESS;
 }
 
+rnp_result_t
+pgp_keyid_from_fingerprint(uint8_t *                keyid,
+                           const pgp_fingerprint_t *fp,
+                           const pgp_key_pkt_t *    key)
+{
+    /* v2/v3 key id is taken from the modulus so doesn't need hashing */
+    if ((key->version == PGP_V2) || (key->version == PGP_V3)) {
+        return pgp_keyid(keyid, PGP_KEY_ID_SIZE, key);
+    }
+    (void) memcpy(keyid, fp->fingerprint + fp->length - PGP_KEY_ID_SIZE, PGP_KEY_ID_SIZE);
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+pgp_fingerprint_keyid(pgp_fingerprint_t *fp, uint8_t *keyid, const pgp_key_pkt_t *key)
+{
+    rnp_result_t ret = pgp_fingerprint(fp, key);
+    if (ret) {
+        return ret;
+    }
+    return pgp_keyid_from_fingerprint(keyid, fp, key);
+}
+
+rnp_result_t
+pgp_fingerprint_batch(pgp_fingerprint_t *fps, const pgp_key_pkt_t *const *keys, size_t count)
+{
+    try {
+        std::vector<uint8_t>        data;
+        std::vector<pgp_hash_msg_t> msgs;
+        std::vector<size_t>         idxs;
+        size_t                      total = 0;
+        rnp_result_t                ret = RNP_ERROR_GENERIC;
+
+        /* v4 fingerprints go to the batch, others are calculated right away */
+        for (size_t i = 0; i < count; i++) {
+            if ((keys[i]->version == PGP_V4) && keys[i]->hashed_data) {
+                idxs.push_back(i);
+                total += 3 + keys[i]->hashed_len;
+                continue;
+            }
+            if ((ret = pgp_fingerprint(&fps[i], keys[i]))) {
+                return ret;
+            }
+        }
+        if (idxs.empty()) {
+            return RNP_SUCCESS;
+        }
+
+        /* the same data as signature_hash_key() adds */
+        data.resize(total);
+        msgs.resize(idxs.size());
+        uint8_t *ptr = data.data();
+        for (size_t i = 0; i < idxs.size(); i++) {
+            const pgp_key_pkt_t *key = keys[idxs[i]];
+            ptr[0] = 0x99;
+            write_uint16(ptr + 1, key->hashed_len);
+            memcpy(ptr + 3, key->hashed_data, key->hashed_len);
+            msgs[i] = {ptr, 3 + key->hashed_len};
+            ptr += msgs[i].len;
+        }
+
+        std::vector<uint8_t> digests(idxs.size() * PGP_FINGERPRINT_SIZE);
+        if (!pgp_hash_batch(PGP_HASH_SHA1, msgs.data(), msgs.size(), digests.data())) {
+            return RNP_ERROR_GENERIC;
+        }
+        for (size_t i = 0; i < idxs.size(); i++) {
+            pgp_fingerprint_t *fp = &fps[idxs[i]];
+            memcpy(fp->fingerprint, &digests[i * PGP_FINGERPRINT_SIZE], PGP_FINGERPRINT_SIZE);
+            fp->length = PGP_FINGERPRINT_SIZE;
+        }
+        return RNP_SUCCESS;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+}
+
 bool
 fingerprint_equal(const pgp_fingerprint_t *fp1, const pgp_fingerprint_t *fp2)
 {
@@ -38,6 +38,42 @@ rnp_result_t pgp_fingerprint(pgp_fingerprint_t *fp, const pgp_key_pkt_t *key);
 
 rnp_result_t pgp_keyid(uint8_t *out, const size_t len, const pgp_key_pkt_t *key);
 
+/**
+ * @brief Calculate both fingerprint and key id, hashing the key only once.
+ *
+ * @param fp fingerprint structure to fill
+ * @param keyid buffer of PGP_KEY_ID_SIZE bytes to store key id
+ * @param key key packet
+ * @return RNP_SUCCESS or error code if failed
+ */
+rnp_result_t pgp_fingerprint_keyid(pgp_fingerprint_t *  fp,
+                                   uint8_t *            keyid,
+                                   const pgp_key_pkt_t *key);
+
+/**
+ * @brief Get key id from the already calculated fingerprint of the key.
+ *
+ * @param keyid buffer of PGP_KEY_ID_SIZE bytes to store key id
+ * @param fp fingerprint of the key
+ * @param key key packet
+ * @return RNP_SUCCESS or error code if failed
+ */
+rnp_result_t pgp_keyid_from_fingerprint(uint8_t *                keyid,
+                                        const pgp_fingerprint_t *fp,
+                                        const pgp_key_pkt_t *    key);
+
+/**
+ * @brief Calculate fingerprints of a number of keys, hashing them in a batch.
+ *
+ * @param fps array of count fingerprints to fill
+ * @param keys array of count key packets
+ * @param count number of keys
+ * @return RNP_SUCCESS or error code if failed
+ */
+rnp_result_t pgp_fingerprint_batch(pgp_fingerprint_t *         fps,
+                                   const pgp_key_pkt_t *const *keys,
+                                   size_t                      count);
+
 bool fingerprint_equal(const pgp_fingerprint_t *fp1, const pgp_fingerprint_t *fp2);
 
 #endif
@@ -101,7 +101,7 @@ load_generated_g10_key(pgp_key_t *    dst,
     }
 
     // this would be better on the stack but the key store does not allow it
-    key_store = (rnp_key_store_t *) calloc(1, sizeof(*key_store));
+    key_store = rnp_key_store_new(PGP_KEY_STORE_G10, "");
     if (!key_store) {
         goto end;
     }
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "parallel.h"
+#include "utils.h"
+
+size_t
+rnp_parallel_threads(void)
+{
+    size_t res = std::thread::hardware_concurrency();
+    return res ? res : 1;
+}
+
+size_t
+rnp_parallel_clamp_threads(size_t threads)
+{
+    size_t max = rnp_parallel_threads();
+    return threads > max ? max : threads;
+}
+
+static size_t
+rnp_parallel_count(size_t count, size_t threads)
+{
+    if (!threads) {
+        threads = rnp_parallel_threads();
+    }
+    return threads > count ? count : threads;
+}
+
+void
+rnp_thread_pool_t::process(job_t &job)
+{
+    for (size_t idx = job.next++; idx < job.count; idx = job.next++) {
+        (*job.func)(idx);
+    }
+}
+
+void
+rnp_thread_pool_t::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (stop_) {
+            return;
+        }
+        job_t *job = queue_.front();
+        queue_.pop_front();
+        job->active++;
+        idle_--;
+        lock.unlock();
+        process(*job);
+        lock.lock();
+        idle_++;
+        if (!--job->active) {
+            done_cond_.notify_all();
+        }
+    }
+}
+
+rnp_thread_pool_t::~rnp_thread_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cond_.notify_all();
+    for (auto &thread : workers_) {
+        thread.join();
+    }
+}
+
+void
+rnp_thread_pool_t::run(size_t count, size_t threads, const std::function<void(size_t)> &func)
+{
+    job_t job;
+    job.next = 0;
+    job.count = count;
+    job.func = &func;
+    job.active = 0;
+
+    threads = rnp_parallel_count(count, threads);
+    if (threads > 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        try {
+            for (size_t i = 1; i < threads; i++) {
+                queue_.push_back(&job);
+            }
+            size_t max = rnp_parallel_threads();
+            while ((idle_ < queue_.size()) && (workers_.size() < max)) {
+                workers_.emplace_back(&rnp_thread_pool_t::worker, this);
+                idle_++;
+            }
+        } catch (const std::exception &e) {
+            /* not fatal: items are processed by the workers which are available */
+            RNP_LOG("failed to start worker thread: %s", e.what());
+        }
+        work_cond_.notify_all();
+    }
+    process(job);
+    if (threads > 1) {
+        /* all items are taken, so drop the queue entries which were not picked by workers */
+        std::unique_lock<std::mutex> lock(mutex_);
+        queue_.erase(std::remove(queue_.begin(), queue_.end(), &job), queue_.end());
+        done_cond_.wait(lock, [&job]() { return !job.active; });
+    }
+}
+
+void
+rnp_parallel_for(rnp_thread_pool_t *                pool,
+                 size_t                             count,
+                 size_t                             threads,
+                 const std::function<void(size_t)> &func)
+{
+    if (pool) {
+        pool->run(count, threads, func);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto                worker = [&next, count, &func]() {
+        for (size_t idx = next++; idx < count; idx = next++) {
+            func(idx);
+        }
+    };
+
+    threads = rnp_parallel_count(count, threads);
+    std::vector<std::thread> workers;
+    try {
+        for (size_t i = 1; i < threads; i++) {
+            workers.emplace_back(worker);
+        }
+    } catch (const std::exception &e) {
+        /* not fatal: items are processed by the threads which were started */
+        RNP_LOG("failed to start worker thread: %s", e.what());
+    }
+    worker();
+    for (auto &thread : workers) {
+        thread.join();
+    }
+}
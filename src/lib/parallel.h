@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef RNP_PARALLEL_H
+#define RNP_PARALLEL_H
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Get the number of worker threads to use by default, i.e. number of available cores.
+ *
+ * @return number of threads, at least 1
+ */
+size_t rnp_parallel_threads(void);
+
+/**
+ * @brief Limit the user-supplied number of threads to the number of available cores, since
+ *        callers allocate per-thread buffers and more threads would not speed up anything.
+ *
+ * @param threads requested number of threads
+ * @return threads or rnp_parallel_threads(), whichever is less
+ */
+size_t rnp_parallel_clamp_threads(size_t threads);
+
+/**
+ * @brief Long-lived worker threads for rnp_parallel_for(). Workers are started on demand, up
+ *        to the number of available cores, and are kept until the pool is destroyed, so
+ *        repeated calls (i.e. for each batch of AEAD chunks) do not create threads. Pool may
+ *        be used by several threads at once: their items are queued and picked by the
+ *        first free worker.
+ */
+class rnp_thread_pool_t {
+    struct job_t {
+        std::atomic<size_t>                next;   /* next item to process */
+        size_t                             count;  /* number of items */
+        const std::function<void(size_t)> *func;   /* item processing function */
+        size_t                             active; /* number of workers running the job */
+    };
+
+    std::mutex               mutex_;
+    std::condition_variable  work_cond_; /* queue is not empty or pool is stopped */
+    std::condition_variable  done_cond_; /* worker finished a job */
+    std::deque<job_t *>      queue_;     /* one entry per requested helper thread */
+    std::vector<std::thread> workers_;
+    size_t                   idle_; /* number of workers not running a job */
+    bool                     stop_;
+
+    static void process(job_t &job);
+    void        worker();
+
+  public:
+    rnp_thread_pool_t() : idle_(0), stop_(false)
+    {
+    }
+    ~rnp_thread_pool_t();
+    rnp_thread_pool_t(const rnp_thread_pool_t &) = delete;
+    rnp_thread_pool_t &operator=(const rnp_thread_pool_t &) = delete;
+
+    void run(size_t count, size_t threads, const std::function<void(size_t)> &func);
+};
+
+/**
+ * @brief Call func for each index in range [0, count), spreading calls over worker threads.
+ *        Calling thread takes part in the work as well, and function returns only when all
+ *        items are processed. Items must be independent of each other.
+ *
+ * @param pool worker threads to use. If NULL then threads are created for this call only.
+ * @param count number of items
+ * @param threads maximum number of threads to use, 0 means rnp_parallel_threads()
+ * @param func function which processes a single item, must not throw
+ */
+void rnp_parallel_for(rnp_thread_pool_t *                pool,
+                      size_t                             count,
+                      size_t                             threads,
+                      const std::function<void(size_t)> &func);
+
+#endif
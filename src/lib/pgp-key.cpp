@@ -56,6 +56,7 @@
 #include "crypto.h"
 #include "crypto/s2k.h"
 #include "fingerprint.h"
+#include "parallel.h"
 
 #include <rnp/rnp_sdk.h>
 #include <librepgp/stream-packet.h>
@@ -67,6 +68,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <vector>
 #include "defaults.h"
 
 static bool
@@ -214,19 +216,30 @@ pgp_userid_free(pgp_userid_t *uid)
 static void
 pgp_rawpacket_free(pgp_rawpacket_t *packet)
 {
-    free(packet->raw);
+    if (!packet->in_arena) {
+        free(packet->raw);
+    }
     packet->raw = NULL;
+    packet->in_arena = false;
 }
 
 bool
-pgp_key_from_pkt(pgp_key_t *key, const pgp_key_pkt_t *pkt, const pgp_content_enum tag)
+pgp_key_from_pkt(pgp_key_t *          key,
+                 const pgp_key_pkt_t *pkt,
+                 const pgp_content_enum tag,
+                 const pgp_key_ids_t *ids)
 {
     assert(!key->pkt.version);
     assert(is_key_pkt(tag));
     assert(pkt->material.alg);
-    if (pgp_keyid(key->keyid, PGP_KEY_ID_SIZE, pkt) ||
-        pgp_fingerprint(&key->fingerprint, pkt) ||
-        !rnp_key_store_get_key_grip(&pkt->material, key->grip)) {
+    if (ids) {
+        key->fingerprint = ids->fp;
+        memcpy(key->grip, ids->grip, PGP_KEY_GRIP_SIZE);
+        if (pgp_keyid_from_fingerprint(key->keyid, &key->fingerprint, pkt)) {
+            return false;
+        }
+    } else if (pgp_fingerprint_keyid(&key->fingerprint, key->keyid, pkt) ||
+               !rnp_key_store_get_key_grip(&pkt->material, key->grip)) {
         return false;
     }
     /* this is correct since changes ownership */
@@ -235,6 +248,32 @@ pgp_key_from_pkt(pgp_key_t *key, const pgp_key_pkt_t *pkt, const pgp_content_enu
     return true;
 }
 
+bool
+pgp_key_ids_batch(const pgp_key_pkt_t *const *pkts, size_t count, pgp_key_ids_t *ids)
+{
+    try {
+        std::vector<pgp_fingerprint_t>          fps(count);
+        std::vector<const pgp_key_material_t *> materials(count);
+        std::vector<uint8_t>                    grips(count * PGP_KEY_GRIP_SIZE);
+
+        for (size_t i = 0; i < count; i++) {
+            materials[i] = &pkts[i]->material;
+        }
+        if (pgp_fingerprint_batch(fps.data(), pkts, count) ||
+            !rnp_key_store_get_key_grips(materials.data(), count, grips.data())) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            ids[i].fp = fps[i];
+            memcpy(ids[i].grip, &grips[i * PGP_KEY_GRIP_SIZE], PGP_KEY_GRIP_SIZE);
+        }
+        return true;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+}
+
 void
 pgp_key_free_data(pgp_key_t *key)
 {
@@ -247,26 +286,26 @@ pgp_key_free_data(pgp_key_t *key)
     for (n = 0; n < pgp_key_get_userid_count(key); ++n) {
         pgp_userid_free(pgp_key_get_userid(key, n));
     }
-    list_destroy(&key->uids);
+    dynarray_destroy(&key->uids);
 
     for (n = 0; n < pgp_key_get_rawpacket_count(key); ++n) {
         pgp_rawpacket_free(pgp_key_get_rawpacket(key, n));
     }
-    list_destroy(&key->packets);
+    dynarray_destroy(&key->packets);
 
     for (n = 0; n < pgp_key_get_subsig_count(key); n++) {
         pgp_subsig_free(pgp_key_get_subsig(key, n));
     }
-    list_destroy(&key->subsigs);
+    dynarray_destroy(&key->subsigs);
 
     for (n = 0; n < pgp_key_get_revoke_count(key); n++) {
         revoke_free(pgp_key_get_revoke(key, n));
     }
-    list_destroy(&key->revokes);
+    dynarray_destroy(&key->revokes);
     revoke_free(&key->revocation);
     free(key->primary_grip);
     key->primary_grip = NULL;
-    list_destroy(&key->subkey_grips);
+    dynarray_destroy(&key->subkey_grips);
     free_key_pkt(&key->pkt);
 }
 
@@ -286,7 +325,7 @@ pgp_key_copy_raw_packets(pgp_key_t *dst, const pgp_key_t *src, bool pubonly)
     size_t start = 0;
 
     if (pubonly) {
-        if (!pgp_key_add_key_rawpacket(dst, &dst->pkt)) {
+        if (!pgp_key_add_key_rawpacket(dst, &dst->pkt, NULL)) {
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         start = 1;
@@ -415,7 +454,7 @@ error:
     return ret;
 }
 
-static rnp_result_t
+rnp_result_t
 pgp_subsig_copy(pgp_subsig_t *dst, const pgp_subsig_t *src)
 {
     memcpy(dst, src, sizeof(*dst));
@@ -510,10 +549,13 @@ pgp_key_copy_fields(pgp_key_t *dst, const pgp_key_t *src)
     }
 
     /* subkey grips */
-    for (list_item *grip = list_front(src->subkey_grips); grip; grip = list_next(grip)) {
-        if (!list_append(&dst->subkey_grips, grip, PGP_KEY_GRIP_SIZE)) {
-            goto error;
-        }
+    if (!dynarray_reserve(
+          &dst->subkey_grips, pgp_key_get_subkey_count(src), PGP_KEY_GRIP_SIZE)) {
+        goto error;
+    }
+    for (size_t i = 0; i < pgp_key_get_subkey_count(src); i++) {
+        const uint8_t *grip = pgp_key_get_subkey_grip(src, i);
+        dynarray_append(&dst->subkey_grips, grip, PGP_KEY_GRIP_SIZE);
     }
 
     /* primary grip */
@@ -847,13 +889,13 @@ pgp_key_link_subkey_grip(pgp_key_t *key, pgp_key_t *subkey)
 size_t
 pgp_key_get_userid_count(const pgp_key_t *key)
 {
-    return list_length(key->uids);
+    return dynarray_length(&key->uids);
 }
 
 pgp_userid_t *
 pgp_key_get_userid(const pgp_key_t *key, size_t idx)
 {
-    return (pgp_userid_t *) list_at(key->uids, idx);
+    return (pgp_userid_t *) dynarray_at(&key->uids, idx);
 }
 
 pgp_revoke_t *
@@ -871,8 +913,8 @@ pgp_key_get_userid_revoke(const pgp_key_t *key, size_t uid)
 bool
 pgp_key_has_userid(const pgp_key_t *key, const char *uid)
 {
-    for (list_item *li = list_front(key->uids); li; li = list_next(li)) {
-        pgp_userid_t *userid = (pgp_userid_t *) li;
+    for (size_t i = 0; i < pgp_key_get_userid_count(key); i++) {
+        pgp_userid_t *userid = pgp_key_get_userid(key, i);
         if (!strcmp(uid, userid->str)) {
             return true;
         }
@@ -884,69 +926,90 @@ pgp_key_has_userid(const pgp_key_t *key, const char *uid)
 pgp_userid_t *
 pgp_key_add_userid(pgp_key_t *key)
 {
-    return (pgp_userid_t *) list_append(&key->uids, NULL, sizeof(pgp_userid_t));
+    return (pgp_userid_t *) dynarray_append(&key->uids, NULL, sizeof(pgp_userid_t));
 }
 
 pgp_revoke_t *
 pgp_key_add_revoke(pgp_key_t *key)
 {
-    return (pgp_revoke_t *) list_append(&key->revokes, NULL, sizeof(pgp_revoke_t));
+    return (pgp_revoke_t *) dynarray_append(&key->revokes, NULL, sizeof(pgp_revoke_t));
 }
 
 size_t
 pgp_key_get_revoke_count(const pgp_key_t *key)
 {
-    return list_length(key->revokes);
+    return dynarray_length(&key->revokes);
 }
 
 pgp_revoke_t *
 pgp_key_get_revoke(const pgp_key_t *key, size_t idx)
 {
-    return (pgp_revoke_t *) list_at(key->revokes, idx);
+    return (pgp_revoke_t *) dynarray_at(&key->revokes, idx);
 }
 
 pgp_subsig_t *
 pgp_key_add_subsig(pgp_key_t *key)
 {
-    return (pgp_subsig_t *) list_append(&key->subsigs, NULL, sizeof(pgp_subsig_t));
+    return (pgp_subsig_t *) dynarray_append(&key->subsigs, NULL, sizeof(pgp_subsig_t));
 }
 
 size_t
 pgp_key_get_subsig_count(const pgp_key_t *key)
 {
-    return list_length(key->subsigs);
+    return dynarray_length(&key->subsigs);
 }
 
 pgp_subsig_t *
 pgp_key_get_subsig(const pgp_key_t *key, size_t idx)
 {
-    return (pgp_subsig_t *) list_at(key->subsigs, idx);
+    return (pgp_subsig_t *) dynarray_at(&key->subsigs, idx);
 }
 
 pgp_rawpacket_t *
 pgp_key_add_rawpacket(pgp_key_t *key, void *data, size_t len, pgp_content_enum tag)
+{
+    return pgp_key_add_arena_rawpacket(key, data, len, tag, NULL);
+}
+
+pgp_rawpacket_t *
+pgp_key_add_arena_rawpacket(pgp_key_t *      key,
+                            const void *     data,
+                            size_t           len,
+                            pgp_content_enum tag,
+                            arena *          mem)
 {
     pgp_rawpacket_t *packet;
-    if (!(packet = (pgp_rawpacket_t *) list_append(&key->packets, NULL, sizeof(*packet)))) {
-        return NULL;
-    }
-    if (data) {
-        if (!(packet->raw = (uint8_t *) malloc(len))) {
-            list_remove((list_item *) packet);
+    uint8_t *        raw = NULL;
+
+    if (data && len) {
+        raw = (uint8_t *) (mem ? arena_alloc(mem, len) : malloc(len));
+        if (!raw) {
             return NULL;
         }
-        memcpy(packet->raw, data, len);
+        memcpy(raw, data, len);
     }
+    packet = (pgp_rawpacket_t *) dynarray_append(&key->packets, NULL, sizeof(*packet));
+    if (!packet) {
+        if (!mem) {
+            free(raw);
+        }
+        return NULL;
+    }
+    packet->raw = raw;
     packet->length = len;
     packet->tag = tag;
+    packet->in_arena = raw && mem;
     return packet;
 }
 
 pgp_rawpacket_t *
-pgp_key_add_stream_rawpacket(pgp_key_t *key, pgp_content_enum tag, pgp_dest_t *memdst)
+pgp_key_add_stream_rawpacket(pgp_key_t *      key,
+                             pgp_content_enum tag,
+                             pgp_dest_t *     memdst,
+                             arena *          mem)
 {
-    pgp_rawpacket_t *res =
-      pgp_key_add_rawpacket(key, mem_dest_get_memory(memdst), memdst->writeb, tag);
+    pgp_rawpacket_t *res = pgp_key_add_arena_rawpacket(
+      key, mem_dest_get_memory(memdst), memdst->writeb, tag, mem);
     if (!res) {
         RNP_LOG("Failed to add packet");
     }
@@ -955,7 +1018,7 @@ pgp_key_add_stream_rawpacket(pgp_key_t *key, pgp_content_enum tag, pgp_dest_t *m
 }
 
 pgp_rawpacket_t *
-pgp_key_add_key_rawpacket(pgp_key_t *key, pgp_key_pkt_t *pkt)
+pgp_key_add_key_rawpacket(pgp_key_t *key, pgp_key_pkt_t *pkt, arena *mem)
 {
     pgp_dest_t dst = {};
 
@@ -966,14 +1029,29 @@ pgp_key_add_key_rawpacket(pgp_key_t *key, pgp_key_pkt_t *pkt)
         dst_close(&dst, true);
         return NULL;
     }
-    return pgp_key_add_stream_rawpacket(key, (pgp_content_enum) pkt->tag, &dst);
+    return pgp_key_add_stream_rawpacket(key, (pgp_content_enum) pkt->tag, &dst, mem);
 }
 
 pgp_rawpacket_t *
-pgp_key_add_sig_rawpacket(pgp_key_t *key, const pgp_signature_t *pkt)
+pgp_key_add_sig_rawpacket(pgp_key_t *key, const pgp_signature_t *pkt, arena *mem)
 {
     pgp_dest_t dst = {};
 
+    /* signature, parsed in place from the arena, already has its packet there */
+    if (mem && pkt->raw) {
+        pgp_rawpacket_t *packet =
+          (pgp_rawpacket_t *) dynarray_append(&key->packets, NULL, sizeof(*packet));
+        if (!packet) {
+            RNP_LOG("Failed to add packet");
+            return NULL;
+        }
+        packet->raw = (uint8_t *) pkt->raw;
+        packet->length = pkt->raw_len;
+        packet->tag = PGP_PTAG_CT_SIGNATURE;
+        packet->in_arena = true;
+        return packet;
+    }
+
     if (init_mem_dest(&dst, NULL, 0)) {
         return NULL;
     }
@@ -981,11 +1059,11 @@ pgp_key_add_sig_rawpacket(pgp_key_t *key, const pgp_signature_t *pkt)
         dst_close(&dst, true);
         return NULL;
     }
-    return pgp_key_add_stream_rawpacket(key, PGP_PTAG_CT_SIGNATURE, &dst);
+    return pgp_key_add_stream_rawpacket(key, PGP_PTAG_CT_SIGNATURE, &dst, mem);
 }
 
 pgp_rawpacket_t *
-pgp_key_add_uid_rawpacket(pgp_key_t *key, const pgp_userid_pkt_t *pkt)
+pgp_key_add_uid_rawpacket(pgp_key_t *key, const pgp_userid_pkt_t *pkt, arena *mem)
 {
     pgp_dest_t dst = {};
 
@@ -996,49 +1074,49 @@ pgp_key_add_uid_rawpacket(pgp_key_t *key, const pgp_userid_pkt_t *pkt)
         dst_close(&dst, true);
         return NULL;
     }
-    return pgp_key_add_stream_rawpacket(key, (pgp_content_enum) pkt->tag, &dst);
+    return pgp_key_add_stream_rawpacket(key, (pgp_content_enum) pkt->tag, &dst, mem);
 }
 
 size_t
 pgp_key_get_rawpacket_count(const pgp_key_t *key)
 {
-    return list_length(key->packets);
+    return dynarray_length(&key->packets);
 }
 
 pgp_rawpacket_t *
 pgp_key_get_rawpacket(const pgp_key_t *key, size_t idx)
 {
-    return (pgp_rawpacket_t *) list_at(key->packets, idx);
+    return (pgp_rawpacket_t *) dynarray_at(&key->packets, idx);
 }
 
 size_t
 pgp_key_get_subkey_count(const pgp_key_t *key)
 {
-    return list_length(key->subkey_grips);
+    return dynarray_length(&key->subkey_grips);
 }
 
 bool
 pgp_key_add_subkey_grip(pgp_key_t *key, const uint8_t *grip)
 {
-    for (list_item *li = list_front(key->subkey_grips); li; li = list_next(li)) {
-        if (!memcmp(grip, (uint8_t *) li, PGP_KEY_GRIP_SIZE)) {
+    for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
+        if (!memcmp(grip, pgp_key_get_subkey_grip(key, i), PGP_KEY_GRIP_SIZE)) {
             return true;
         }
     }
 
-    return list_append(&key->subkey_grips, grip, PGP_KEY_GRIP_SIZE);
+    return dynarray_append(&key->subkey_grips, grip, PGP_KEY_GRIP_SIZE);
 }
 
 const uint8_t *
 pgp_key_get_subkey_grip(const pgp_key_t *key, size_t idx)
 {
-    return (uint8_t *) list_at(key->subkey_grips, idx);
+    return (uint8_t *) dynarray_at(&key->subkey_grips, idx);
 }
 
 pgp_key_t *
 pgp_key_get_subkey(const pgp_key_t *key, const rnp_key_store_t *store, size_t idx)
 {
-    uint8_t *grip = (uint8_t *) list_at(key->subkey_grips, idx);
+    const uint8_t *grip = pgp_key_get_subkey_grip(key, idx);
     if (!grip) {
         return NULL;
     }
@@ -1115,11 +1193,11 @@ pgp_key_unlock(pgp_key_t *key, const pgp_password_provider_t *provider)
     decrypted_seckey = pgp_decrypt_seckey(key, provider, &ctx);
 
     if (decrypted_seckey) {
-        // this shouldn't really be necessary, but just in case
-        forget_secret_key_fields(&key->pkt.material);
-        // copy the decrypted mpis into the pgp_key_t
+        // move the decrypted mpis into the pgp_key_t
+        key_material_free(&key->pkt.material);
         key->pkt.material = decrypted_seckey->material;
         key->pkt.material.secret = true;
+        memset(&decrypted_seckey->material, 0, sizeof(decrypted_seckey->material));
 
         free_key_pkt(decrypted_seckey);
         // free the actual structure
@@ -1493,8 +1571,9 @@ write_xfer_packets(pgp_dest_t *           dst,
     }
 
     // Export subkeys
-    for (list_item *grip = list_front(key->subkey_grips); grip; grip = list_next(grip)) {
-        const pgp_key_t *subkey = rnp_key_store_get_key_by_grip(keyring, (uint8_t *) grip);
+    for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
+        const pgp_key_t *subkey =
+          rnp_key_store_get_key_by_grip(keyring, pgp_key_get_subkey_grip(key, i));
         if (!write_xfer_packets(dst, subkey, NULL, secret)) {
             RNP_LOG("Error occured when exporting a subkey");
             return false;
@@ -1526,17 +1605,15 @@ find_suitable_key(pgp_op_t            op,
     if (pgp_key_get_flags(key) & desired_usage) {
         return key;
     }
-    list_item *           subkey_grip = list_front(key->subkey_grips);
     pgp_key_request_ctx_t ctx{.op = op, .secret = pgp_key_is_secret(key)};
     ctx.search.type = PGP_KEY_SEARCH_GRIP;
 
-    while (subkey_grip) {
-        memcpy(ctx.search.by.grip, subkey_grip, PGP_KEY_GRIP_SIZE);
+    for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
+        memcpy(ctx.search.by.grip, pgp_key_get_subkey_grip(key, i), PGP_KEY_GRIP_SIZE);
         pgp_key_t *subkey = pgp_request_key(key_provider, &ctx);
         if (subkey && (pgp_key_get_flags(subkey) & desired_usage)) {
             return subkey;
         }
-        subkey_grip = list_next(subkey_grip);
     }
     return NULL;
 }
@@ -1709,8 +1786,60 @@ pgp_sig_is_subkey_revocation(const pgp_key_t *key, const pgp_subsig_t *sig)
     return pgp_key_is_subkey(key) && (signature_get_type(&sig->sig) == PGP_SIG_REV_SUBKEY);
 }
 
+static void
+pgp_subsig_validate(pgp_key_t *      key,
+                    pgp_key_t *      signer,
+                    pgp_subsig_t *   sig,
+                    pgp_sig_cache_t *cache)
+{
+    pgp_signature_info_t sinfo = {};
+    sinfo.sig = &sig->sig;
+    sinfo.signer = signer;
+    sinfo.signer_valid = true;
+    sinfo.cache = cache;
+
+    if (pgp_sig_is_self_signature(key, sig)) {
+        pgp_userid_t *uid = pgp_key_get_userid(key, sig->uid);
+        if (uid) {
+            signature_check_certification(&sinfo, pgp_key_get_pkt(key), &uid->pkt);
+        }
+    } else if (pgp_sig_is_key_revocation(key, sig)) {
+        signature_check_direct(&sinfo, pgp_key_get_pkt(key));
+    } else if (pgp_sig_is_subkey_binding(key, sig)) {
+        signature_check_binding(&sinfo, pgp_key_get_pkt(signer), pgp_key_get_pkt(key));
+    } else if (pgp_sig_is_subkey_revocation(key, sig)) {
+        signature_check_subkey_revocation(
+          &sinfo, pgp_key_get_pkt(signer), pgp_key_get_pkt(key));
+    }
+
+    sig->validity.validated = true;
+    sig->validity.valid = sinfo.valid;
+    sig->validity.expired = sinfo.expired;
+}
+
+static bool
+pgp_subsig_is_valid(pgp_key_t *      key,
+                    pgp_key_t *      signer,
+                    pgp_subsig_t *   sig,
+                    bool             allow_expired,
+                    pgp_sig_cache_t *cache)
+{
+    if (!sig->validity.validated) {
+        pgp_subsig_validate(key, signer, sig, cache);
+    }
+    return sig->validity.valid && (allow_expired || !sig->validity.expired);
+}
+
+static void
+pgp_key_reset_subsigs_validity(pgp_key_t *key)
+{
+    for (size_t i = 0; i < pgp_key_get_subsig_count(key); i++) {
+        pgp_key_get_subsig(key, i)->validity = {};
+    }
+}
+
 static rnp_result_t
-pgp_key_validate_primary(pgp_key_t *key)
+pgp_key_validate_primary(pgp_key_t *key, pgp_sig_cache_t *cache)
 {
     /* consider public key as valid on this level if it has at least one non-expired
      * self-signature (or it is secret), and is not revoked */
@@ -1720,28 +1849,14 @@ pgp_key_validate_primary(pgp_key_t *key)
         pgp_subsig_t *sig = pgp_key_get_subsig(key, i);
 
         if (pgp_sig_is_self_signature(key, sig) && !has_cert) {
-            pgp_signature_info_t sinfo = {};
-            sinfo.sig = &sig->sig;
-            sinfo.signer = key;
-            sinfo.signer_valid = true;
-            pgp_userid_t *uid = pgp_key_get_userid(key, sig->uid);
-            if (uid) {
-                signature_check_certification(&sinfo, pgp_key_get_pkt(key), &uid->pkt);
-                has_cert = sinfo.valid && !sinfo.expired;
-            }
+            has_cert = pgp_subsig_is_valid(key, key, sig, false, cache);
             continue;
         }
 
-        if (pgp_sig_is_key_revocation(key, sig)) {
-            pgp_signature_info_t sinfo = {};
-            sinfo.sig = &sig->sig;
-            sinfo.signer = key;
-            sinfo.signer_valid = true;
-            signature_check_direct(&sinfo, pgp_key_get_pkt(key));
-            /* revocation signature cannot expire */
-            if (sinfo.valid) {
-                return RNP_SUCCESS;
-            }
+        /* revocation signature cannot expire */
+        if (pgp_sig_is_key_revocation(key, sig) &&
+            pgp_subsig_is_valid(key, key, sig, true, cache)) {
+            return RNP_SUCCESS;
         }
     }
 
@@ -1750,7 +1865,7 @@ pgp_key_validate_primary(pgp_key_t *key)
 }
 
 static rnp_result_t
-pgp_key_validate_subkey(pgp_key_t *subkey, pgp_key_t *key)
+pgp_key_validate_subkey(pgp_key_t *subkey, pgp_key_t *key, pgp_sig_cache_t *cache)
 {
     /* consider subkey as valid on this level if it has valid primary key, has at least one
      * non-expired binding signature (or is secret), and is not revoked. */
@@ -1764,26 +1879,14 @@ pgp_key_validate_subkey(pgp_key_t *subkey, pgp_key_t *key)
         pgp_subsig_t *sig = pgp_key_get_subsig(subkey, i);
 
         if (pgp_sig_is_subkey_binding(subkey, sig) && !has_binding) {
-            pgp_signature_info_t sinfo = {};
-            sinfo.sig = &sig->sig;
-            sinfo.signer = key;
-            sinfo.signer_valid = true;
-            signature_check_binding(&sinfo, pgp_key_get_pkt(key), pgp_key_get_pkt(subkey));
-            has_binding = sinfo.valid && !sinfo.expired;
+            has_binding = pgp_subsig_is_valid(subkey, key, sig, false, cache);
             continue;
         }
 
-        if (pgp_sig_is_subkey_revocation(subkey, sig)) {
-            pgp_signature_info_t sinfo = {};
-            sinfo.sig = &sig->sig;
-            sinfo.signer = key;
-            sinfo.signer_valid = true;
-            signature_check_subkey_revocation(
-              &sinfo, pgp_key_get_pkt(key), pgp_key_get_pkt(subkey));
-            /* revocation signature cannot expire */
-            if (sinfo.valid) {
-                return RNP_SUCCESS;
-            }
+        /* revocation signature cannot expire */
+        if (pgp_sig_is_subkey_revocation(subkey, sig) &&
+            pgp_subsig_is_valid(subkey, key, sig, true, cache)) {
+            return RNP_SUCCESS;
         }
     }
 
@@ -1791,15 +1894,16 @@ pgp_key_validate_subkey(pgp_key_t *subkey, pgp_key_t *key)
     return RNP_SUCCESS;
 }
 
-rnp_result_t
-pgp_key_validate(pgp_key_t *key, rnp_key_store_t *keyring)
+static rnp_result_t
+pgp_key_validate_cached(pgp_key_t *key, rnp_key_store_t *keyring)
 {
-    rnp_result_t res = RNP_ERROR_GENERIC;
-    pgp_key_t *  primary = NULL;
+    rnp_result_t     res = RNP_ERROR_GENERIC;
+    pgp_key_t *      primary = NULL;
+    pgp_sig_cache_t *cache = keyring ? keyring->sigcache : NULL;
 
     key->valid = false;
     if (!pgp_key_is_subkey(key)) {
-        res = pgp_key_validate_primary(key);
+        res = pgp_key_validate_primary(key, cache);
         goto done;
     }
 
@@ -1807,10 +1911,77 @@ pgp_key_validate(pgp_key_t *key, rnp_key_store_t *keyring)
     if (!primary) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    res = pgp_key_validate_subkey(key, primary);
+    res = pgp_key_validate_subkey(key, primary, cache);
 done:
     if (!res) {
         key->validated = true;
     }
     return res;
 }
+
+rnp_result_t
+pgp_key_validate(pgp_key_t *key, rnp_key_store_t *keyring)
+{
+    /* signature expiration depends on the current time, so always check them again */
+    pgp_key_reset_subsigs_validity(key);
+    return pgp_key_validate_cached(key, keyring);
+}
+
+void
+pgp_key_validate_batch(pgp_key_t **     keys,
+                       size_t           count,
+                       rnp_key_store_t *keyring,
+                       size_t           threads)
+{
+    struct pgp_subsig_task_t {
+        pgp_key_t *   key;
+        pgp_key_t *   signer;
+        pgp_subsig_t *sig;
+    };
+    std::vector<pgp_subsig_task_t> tasks;
+
+    try {
+        for (size_t i = 0; i < count; i++) {
+            pgp_key_t *key = keys[i];
+            pgp_key_t *signer = key;
+            pgp_key_reset_subsigs_validity(key);
+            if (pgp_key_is_subkey(key)) {
+                signer =
+                  rnp_key_store_get_key_by_grip(keyring, pgp_key_get_primary_grip(key));
+                if (!signer) {
+                    continue;
+                }
+            }
+            for (size_t j = 0; j < pgp_key_get_subsig_count(key); j++) {
+                pgp_subsig_t *sig = pgp_key_get_subsig(key, j);
+                if (pgp_sig_is_self_signature(key, sig) ||
+                    pgp_sig_is_key_revocation(key, sig) ||
+                    pgp_sig_is_subkey_binding(key, sig) ||
+                    pgp_sig_is_subkey_revocation(key, sig)) {
+                    tasks.push_back({key, signer, sig});
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        /* not fatal: signatures which are not checked here will be checked on demand */
+        RNP_LOG("%s", e.what());
+    }
+
+    /* signatures are checked independently of each other, as if signer is valid */
+    rnp_parallel_for(keyring->pool, tasks.size(), threads, [&tasks, keyring](size_t idx) {
+        pgp_subsig_validate(
+          tasks[idx].key, tasks[idx].signer, tasks[idx].sig, keyring->sigcache);
+    });
+
+    /* now apply results, subkey validity depends on the primary key's one */
+    for (size_t i = 0; i < count; i++) {
+        if (!pgp_key_is_subkey(keys[i])) {
+            pgp_key_validate_cached(keys[i], keyring);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (pgp_key_is_subkey(keys[i])) {
+            pgp_key_validate_cached(keys[i], keyring);
+        }
+    }
+}
@@ -61,11 +61,11 @@
 
 /* describes a user's key */
 struct pgp_key_t {
-    list          uids;         /* list of user ids as (char*) */
-    list          packets;      /* list of raw packets as pgp_rawpacket_t */
-    list          subsigs;      /* list of signatures as pgp_subsig_t */
-    list          revokes;      /* list of signature revocations pgp_revoke_t */
-    list          subkey_grips; /* list of subkey grips (for primary keys) as uint8_t[20] */
+    dynarray      uids;         /* array of user ids as pgp_userid_t */
+    dynarray      packets;      /* array of raw packets as pgp_rawpacket_t */
+    dynarray      subsigs;      /* array of signatures as pgp_subsig_t */
+    dynarray      revokes;      /* array of signature revocations pgp_revoke_t */
+    dynarray      subkey_grips; /* array of subkey grips (for primary keys) as uint8_t[20] */
     uint8_t *     primary_grip; /* grip of primary key (for subkeys) */
     time_t        expiration;   /* key expiration time, if available */
     pgp_key_pkt_t pkt;          /* pubkey/seckey data packet */
@@ -82,14 +82,35 @@ struct pgp_key_t {
     bool                   validated;    /* this key was validated */
 };
 
+/* precalculated key identifiers, see pgp_key_ids_batch() */
+typedef struct pgp_key_ids_t {
+    pgp_fingerprint_t fp;
+    uint8_t           grip[PGP_KEY_GRIP_SIZE];
+} pgp_key_ids_t;
+
 struct pgp_key_t *pgp_key_new(void);
 
 /** create a key from the key pkt
  *
  *  This sets up basic properties of the key like keyid/fpr/grip, type, etc.
  *  It does not set primary_grip or subkey_grips (the key store does this).
+ *  If ids is not NULL then fingerprint and grip are taken from it instead of calculation.
  */
-bool pgp_key_from_pkt(pgp_key_t *key, const pgp_key_pkt_t *pkt, const pgp_content_enum tag);
+bool pgp_key_from_pkt(pgp_key_t *          key,
+                      const pgp_key_pkt_t *pkt,
+                      const pgp_content_enum tag,
+                      const pgp_key_ids_t *ids);
+
+/** calculate fingerprints and grips of a number of key packets at once
+ *
+ *  Hashing is batched so multi-buffer hash implementations may be used.
+ *
+ *  @param pkts array of count key packets
+ *  @param count number of key packets
+ *  @param ids array of count records to be populated
+ *  @return true on success or false otherwise
+ */
+bool pgp_key_ids_batch(const pgp_key_pkt_t *const *pkts, size_t count, pgp_key_ids_t *ids);
 
 /** free the internal data of a key *and* the key structure itself
  *
@@ -269,15 +290,37 @@ size_t pgp_key_get_subsig_count(const pgp_key_t *);
 
 pgp_subsig_t *pgp_key_get_subsig(const pgp_key_t *, size_t);
 
+rnp_result_t pgp_subsig_copy(pgp_subsig_t *dst, const pgp_subsig_t *src);
+
 void pgp_subsig_free(pgp_subsig_t *subsig);
 
 pgp_rawpacket_t *pgp_key_add_rawpacket(pgp_key_t *, void *, size_t, pgp_content_enum);
 
-pgp_rawpacket_t *pgp_key_add_key_rawpacket(pgp_key_t *key, pgp_key_pkt_t *pkt);
+/**
+ * @brief Add raw packet to the key, copying data to the memory allocated from the arena.
+ *        Such packet data is not released together with the key but with the arena,
+ *        which must outlive the key. If mem is NULL then data is copied to the heap.
+ */
+pgp_rawpacket_t *pgp_key_add_arena_rawpacket(pgp_key_t *      key,
+                                             const void *     data,
+                                             size_t           len,
+                                             pgp_content_enum tag,
+                                             arena *          mem);
+
+pgp_rawpacket_t *pgp_key_add_key_rawpacket(pgp_key_t *key, pgp_key_pkt_t *pkt, arena *mem);
 
-pgp_rawpacket_t *pgp_key_add_sig_rawpacket(pgp_key_t *key, const pgp_signature_t *pkt);
+/**
+ * @brief Add signature raw packet to the key, see pgp_key_add_arena_rawpacket(). If signature
+ *        was parsed in place from the same arena via stream_parse_signature_arena() then its
+ *        packet is referenced instead of copying.
+ */
+pgp_rawpacket_t *pgp_key_add_sig_rawpacket(pgp_key_t *            key,
+                                           const pgp_signature_t *pkt,
+                                           arena *                mem);
 
-pgp_rawpacket_t *pgp_key_add_uid_rawpacket(pgp_key_t *key, const pgp_userid_pkt_t *pkt);
+pgp_rawpacket_t *pgp_key_add_uid_rawpacket(pgp_key_t *             key,
+                                           const pgp_userid_pkt_t *pkt,
+                                           arena *                 mem);
 
 size_t pgp_key_get_rawpacket_count(const pgp_key_t *);
 
@@ -460,4 +503,19 @@ pgp_hash_alg_t pgp_hash_adjust_alg_to_key(pgp_hash_alg_t hash, const pgp_key_pkt
 
 rnp_result_t pgp_key_validate(pgp_key_t *key, rnp_key_store_t *keyring);
 
+/**
+ * @brief Validate a set of keys, checking all of their self-signatures in parallel first.
+ *        Results are the same as of calling pgp_key_validate() for each key, primary keys
+ *        going before subkeys.
+ *
+ * @param keys array of keys to validate
+ * @param count number of keys in array
+ * @param keyring keyring, used to lookup primary keys of subkeys
+ * @param threads maximum number of threads to use, 0 means number of available cores
+ */
+void pgp_key_validate_batch(pgp_key_t **     keys,
+                            size_t           count,
+                            rnp_key_store_t *keyring,
+                            size_t           threads);
+
 #endif // RNP_PACKET_KEY_H
@@ -53,6 +53,7 @@
 #include "version.h"
 #include <botan/secmem.h>
 #include "ffi-priv-types.h"
+#include "parallel.h"
 
 #define FFI_LOG(ffi, ...)            \
     do {                             \
@@ -87,17 +88,21 @@ find_key(rnp_ffi_t               ffi,
 {
     pgp_key_t *key = NULL;
 
-    switch (key_type) {
-    case KEY_TYPE_PUBLIC:
-        key = rnp_key_store_search(ffi->pubring, search, NULL);
-        break;
-    case KEY_TYPE_SECRET:
-        key = rnp_key_store_search(ffi->secring, search, NULL);
-        break;
-    default:
-        assert(false);
-        break;
+    {
+        rnp_shared_lock_t lock(*ffi->lock);
+        switch (key_type) {
+        case KEY_TYPE_PUBLIC:
+            key = rnp_key_store_search(ffi->pubring, search, NULL);
+            break;
+        case KEY_TYPE_SECRET:
+            key = rnp_key_store_search(ffi->secring, search, NULL);
+            break;
+        default:
+            assert(false);
+            break;
+        }
     }
+    /* callback may load keys, taking the exclusive lock, so it is called without any */
     if (!key && ffi->getkeycb && try_key_provider) {
         char        identifier[1 + MAX(MAX(MAX(PGP_KEY_ID_SIZE * 2, PGP_KEY_GRIP_SIZE),
                                     PGP_FINGERPRINT_SIZE * 2),
@@ -124,12 +129,33 @@ ffi_key_provider(const pgp_key_request_ctx_t *ctx, void *userdata)
     return find_key(ffi, &ctx->search, ctx->secret ? KEY_TYPE_SECRET : KEY_TYPE_PUBLIC, true);
 }
 
+/* Binds the calling thread's generator to the operation for the duration of the call only:
+ * operation may be passed to another thread afterwards, and thread's generator must not
+ * be used from there. */
+class rnp_rng_scope_t {
+    rng_t **rng_;
+
+  public:
+    explicit rnp_rng_scope_t(rng_t **rng) : rng_(rng)
+    {
+        *rng_ = rng_thread_local();
+    }
+    ~rnp_rng_scope_t()
+    {
+        *rng_ = NULL;
+    }
+    rnp_rng_scope_t(const rnp_rng_scope_t &) = delete;
+    rnp_rng_scope_t &operator=(const rnp_rng_scope_t &) = delete;
+};
+
 static void
 rnp_ctx_init_ffi(rnp_ctx_t *ctx, rnp_ffi_t ffi)
 {
     memset(ctx, 0, sizeof(*ctx));
-    ctx->rng = &ffi->rng;
     ctx->ealg = DEFAULT_PGP_SYMM_ALG;
+    ctx->aead_threads = ffi->aead_threads;
+    ctx->pipeline = ffi->pipeline;
+    ctx->pool = ffi->pool;
 }
 
 static const pgp_map_t sig_type_map[] = {{PGP_SIG_BINARY, "binary"},
@@ -382,8 +408,14 @@ rnp_ffi_create(rnp_ffi_t *ffi, const char *pub_format, const char *sec_format)
     ob->key_provider = (pgp_key_provider_t){.callback = ffi_key_provider, .userdata = ob};
     ob->pass_provider =
       (pgp_password_provider_t){.callback = rnp_password_cb_bounce, .userdata = ob};
-    if (!rng_init(&ob->rng, RNG_DRBG)) {
-        ret = RNP_ERROR_RNG;
+    try {
+        ob->lock = new rnp_rwlock_t();
+        ob->pool = new rnp_thread_pool_t();
+        ob->pubring->pool = ob->pool;
+        ob->secring->pool = ob->pool;
+    } catch (const std::exception &e) {
+        FFI_LOG(ob, "%s", e.what());
+        ret = RNP_ERROR_OUT_OF_MEMORY;
         goto done;
     }
 
@@ -419,7 +451,9 @@ rnp_ffi_destroy(rnp_ffi_t ffi)
         close_io_file(&ffi->errs);
         rnp_key_store_free(ffi->pubring);
         rnp_key_store_free(ffi->secring);
-        rng_destroy(&ffi->rng);
+        sig_cache_free(ffi->sigcache);
+        delete ffi->lock;
+        delete ffi->pool;
         free(ffi);
     }
     return RNP_SUCCESS;
@@ -469,6 +503,56 @@ rnp_ffi_set_pass_provider(rnp_ffi_t ffi, rnp_password_cb getpasscb, void *getpas
     return RNP_SUCCESS;
 }
 
+rnp_result_t
+rnp_ffi_set_signature_cache(rnp_ffi_t ffi, size_t size)
+{
+    pgp_sig_cache_t *cache = NULL;
+
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (size && !(cache = sig_cache_new(size))) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    std::lock_guard<rnp_rwlock_t> lock(*ffi->lock);
+    sig_cache_free(ffi->sigcache);
+    ffi->sigcache = cache;
+    ffi->pubring->sigcache = cache;
+    ffi->secring->sigcache = cache;
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_ffi_set_certification_limit(rnp_ffi_t ffi, size_t limit)
+{
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    std::lock_guard<rnp_rwlock_t> lock(*ffi->lock);
+    ffi->cert_limit = limit;
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_ffi_set_aead_threads(rnp_ffi_t ffi, size_t threads)
+{
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->aead_threads = rnp_parallel_clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_ffi_set_pipeline(rnp_ffi_t ffi, bool enable)
+{
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->pipeline = enable;
+    return RNP_SUCCESS;
+}
+
 static const char *
 operation_description(uint8_t op)
 {
@@ -650,6 +734,12 @@ rnp_disable_debug()
     return RNP_SUCCESS;
 }
 
+rnp_result_t
+rnp_set_s2k_cache(size_t size, uint32_t ttl)
+{
+    return pgp_s2k_cache_configure(size, ttl) ? RNP_SUCCESS : RNP_ERROR_BAD_PARAMETERS;
+}
+
 rnp_result_t
 rnp_get_default_homedir(char **homedir)
 {
@@ -998,31 +1088,45 @@ key_needs_conversion(const pgp_key_t *key, const rnp_key_store_t *store)
     return key_format != store_format;
 }
 
+/* keyring, to which all of the loaded keys would go as they are, or NULL */
+static rnp_key_store_t *
+loaded_keys_target(rnp_ffi_t ffi, rnp_key_store_t *tmp_store, key_type_t key_type)
+{
+    if (key_type == KEY_TYPE_SECRET) {
+        return ffi->secring;
+    }
+    /* public parts of the secret keys are converted while copying */
+    for (list_item *key_item = list_front(rnp_key_store_get_keys(tmp_store)); key_item;
+         key_item = list_next(key_item)) {
+        if (pgp_key_is_secret((pgp_key_t *) key_item)) {
+            return NULL;
+        }
+    }
+    return ffi->pubring;
+}
+
+/* move the key out of the temporary store, which must be destroyed afterwards */
+static void
+take_loaded_key(pgp_key_t *dst, pgp_key_t *key)
+{
+    *dst = *key;
+    memset(key, 0, sizeof(*key));
+}
+
+/* add keys, loaded to the temporary store, to the ffi's keyrings */
 static rnp_result_t
-do_load_keys(rnp_ffi_t              ffi,
-             rnp_input_t            input,
-             pgp_key_store_format_t format,
-             key_type_t             key_type)
+add_loaded_keys(rnp_ffi_t ffi, rnp_key_store_t *tmp_store, key_type_t key_type)
 {
-    rnp_result_t     ret = RNP_ERROR_GENERIC;
-    rnp_key_store_t *tmp_store = NULL;
-    pgp_key_t        keycp = {};
-    rnp_result_t     tmpret;
+    pgp_key_t    keycp = {};
+    rnp_result_t tmpret;
 
-    // create a temporary key store to hold the keys
-    tmp_store = rnp_key_store_new(format, "");
-    if (!tmp_store) {
-        // TODO: could also be out of mem
-        FFI_LOG(ffi, "Failed to create key store of format: %d", (int) format);
-        return RNP_ERROR_BAD_PARAMETERS;
+    /* if all keys go to the same keyring then they are moved instead of copying, and their
+     * raw packets and signatures stay in the arena, which goes to the keyring as well */
+    rnp_key_store_t *target = loaded_keys_target(ffi, tmp_store, key_type);
+    if (target) {
+        arena_splice(&target->packets, &tmp_store->packets);
     }
 
-    // load keys into our temporary store
-    tmpret = load_keys_from_input(ffi, input, tmp_store);
-    if (tmpret) {
-        ret = tmpret;
-        goto done;
-    }
     // go through all the loaded keys
     for (list_item *key_item = list_front(rnp_key_store_get_keys(tmp_store)); key_item;
          key_item = list_next(key_item)) {
@@ -1033,21 +1137,20 @@ do_load_keys(rnp_ffi_t              ffi,
             ((key_type == KEY_TYPE_SECRET) || (key_type == KEY_TYPE_ANY))) {
             if (key_needs_conversion(key, ffi->secring)) {
                 FFI_LOG(ffi, "This key format conversion is not yet supported");
-                ret = RNP_ERROR_NOT_IMPLEMENTED;
-                goto done;
+                return RNP_ERROR_NOT_IMPLEMENTED;
             }
 
-            if ((tmpret = pgp_key_copy(&keycp, key, false))) {
+            if (target == ffi->secring) {
+                take_loaded_key(&keycp, key);
+            } else if ((tmpret = pgp_key_copy(&keycp, key, false))) {
                 FFI_LOG(ffi, "Failed to copy secret key");
-                ret = tmpret;
-                goto done;
+                return tmpret;
             }
 
             if (!rnp_key_store_add_key(ffi->secring, &keycp)) {
                 FFI_LOG(ffi, "Failed to add secret key");
                 pgp_key_free_data(&keycp);
-                ret = RNP_ERROR_GENERIC;
-                goto done;
+                return RNP_ERROR_GENERIC;
             }
         }
 
@@ -1057,11 +1160,6 @@ do_load_keys(rnp_ffi_t              ffi,
             continue;
         }
 
-        if ((tmpret = pgp_key_copy(&keycp, key, true))) {
-            ret = tmpret;
-            goto done;
-        }
-
         /* TODO: We could do this a few different ways. There isn't an obvious reason
          * to restrict what formats we load, so we don't necessarily need to require a
          * conversion just to load and use a G10 key when using GPG keyrings, for
@@ -1070,22 +1168,71 @@ do_load_keys(rnp_ffi_t              ffi,
 
         if (key_needs_conversion(key, ffi->pubring)) {
             FFI_LOG(ffi, "This key format conversion is not yet supported");
-            pgp_key_free_data(&keycp);
-            ret = RNP_ERROR_NOT_IMPLEMENTED;
-            goto done;
+            return RNP_ERROR_NOT_IMPLEMENTED;
+        }
+
+        if (target == ffi->pubring) {
+            take_loaded_key(&keycp, key);
+        } else if ((tmpret = pgp_key_copy(&keycp, key, true))) {
+            return tmpret;
         }
 
         if (!rnp_key_store_add_key(ffi->pubring, &keycp)) {
             FFI_LOG(ffi, "Failed to add public key");
             pgp_key_free_data(&keycp);
-            ret = RNP_ERROR_GENERIC;
-            goto done;
+            return RNP_ERROR_GENERIC;
         }
     }
 
     // success, even if we didn't actually load any
-    ret = RNP_SUCCESS;
-done:
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+do_load_keys(rnp_ffi_t              ffi,
+             rnp_input_t            input,
+             pgp_key_store_format_t format,
+             key_type_t             key_type,
+             bool                   bulk_validation)
+{
+    rnp_result_t     ret = RNP_ERROR_GENERIC;
+    rnp_key_store_t *tmp_store = NULL;
+
+    // create a temporary key store to hold the keys
+    tmp_store = rnp_key_store_new(format, "");
+    if (!tmp_store) {
+        // TODO: could also be out of mem
+        FFI_LOG(ffi, "Failed to create key store of format: %d", (int) format);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    tmp_store->sigcache = ffi->sigcache;
+    /* keys will be validated after adding to the ffi's keyrings */
+    tmp_store->disable_validation = bulk_validation;
+
+    // load keys into our temporary store, this doesn't block the concurrent readers
+    ret = load_keys_from_input(ffi, input, tmp_store);
+    if (!ret) {
+        std::lock_guard<rnp_rwlock_t> lock(*ffi->lock);
+        bool                          pub_novalidate = ffi->pubring->disable_validation;
+        bool                          sec_novalidate = ffi->secring->disable_validation;
+
+        if (bulk_validation) {
+            ffi->pubring->disable_validation = true;
+            ffi->secring->disable_validation = true;
+        }
+        ret = add_loaded_keys(ffi, tmp_store, key_type);
+        if (bulk_validation) {
+            ffi->pubring->disable_validation = pub_novalidate;
+            ffi->secring->disable_validation = sec_novalidate;
+            if (!pub_novalidate) {
+                rnp_key_store_validate(ffi->pubring, 0);
+            }
+            if (!sec_novalidate) {
+                rnp_key_store_validate(ffi->secring, 0);
+            }
+        }
+    }
     rnp_key_store_free(tmp_store);
     return ret;
 }
@@ -1125,13 +1272,15 @@ rnp_load_keys(rnp_ffi_t ffi, const char *format, rnp_input_t input, uint32_t fla
         FFI_LOG(ffi, "invalid key store format: %s", format);
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    bool bulk_validation = flags & RNP_LOAD_BULK_VALIDATION;
+    flags &= ~RNP_LOAD_BULK_VALIDATION;
 
     // check for any unrecognized flags (not forward-compat, but maybe still a good idea)
     if (flags) {
         FFI_LOG(ffi, "unexpected flags remaining: 0x%X", flags);
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    return do_load_keys(ffi, input, ks_format, type);
+    return do_load_keys(ffi, input, ks_format, type, bulk_validation);
 }
 
 rnp_result_t
@@ -1145,6 +1294,7 @@ rnp_unload_keys(rnp_ffi_t ffi, uint32_t flags)
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
+    std::lock_guard<rnp_rwlock_t> lock(*ffi->lock);
     if (flags & RNP_KEY_UNLOAD_PUBLIC) {
         rnp_key_store_clear(ffi->pubring);
     }
@@ -1192,6 +1342,54 @@ add_key_status(json_object *           keys,
     return RNP_SUCCESS;
 }
 
+/* import keys, loaded to the temporary store, to the ffi's keyrings, adding their statuses
+ * to the json array */
+static rnp_result_t
+import_loaded_keys(rnp_ffi_t        ffi,
+                   rnp_key_store_t *tmp_store,
+                   bool             pub,
+                   bool             sec,
+                   json_object *    jsokeys,
+                   rng_t *          rng)
+{
+    rnp_result_t tmpret;
+
+    for (list_item *ki = list_front(rnp_key_store_get_keys(tmp_store)); ki;
+         ki = list_next(ki)) {
+        pgp_key_t *             key = (pgp_key_t *) ki;
+        pgp_key_import_status_t pub_status = PGP_KEY_IMPORT_STATUS_UNKNOWN;
+        pgp_key_import_status_t sec_status = PGP_KEY_IMPORT_STATUS_UNKNOWN;
+        if (pgp_key_is_public(key) && !pub) {
+            continue;
+        }
+        if (validate_pgp_key_material(pgp_key_get_material(key), rng)) {
+            FFI_LOG(ffi, "attempt to import key with invalid material");
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+        // if we got here then we add public key itself or public part of the secret key
+        if (!rnp_key_store_import_key(ffi->pubring, key, true, &pub_status)) {
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+        // import secret key part if available and requested
+        if (sec && pgp_key_is_secret(key)) {
+            if (!rnp_key_store_import_key(ffi->secring, key, false, &sec_status)) {
+                return RNP_ERROR_BAD_PARAMETERS;
+            }
+            // add uids, certifications and other stuff from the public key if any
+            pgp_key_t *expub =
+              rnp_key_store_get_key_by_grip(ffi->pubring, pgp_key_get_grip(key));
+            if (expub && !rnp_key_store_import_key(ffi->secring, expub, true, NULL)) {
+                return RNP_ERROR_BAD_PARAMETERS;
+            }
+        }
+        // now add key fingerprint to json based on statuses
+        if ((tmpret = add_key_status(jsokeys, key, pub_status, sec_status))) {
+            return tmpret;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_import_keys(rnp_ffi_t ffi, rnp_input_t input, uint32_t flags, char **results)
 {
@@ -1222,6 +1420,12 @@ rnp_import_keys(rnp_ffi_t ffi, rnp_input_t input, uint32_t flags, char **results
     rnp_result_t     tmpret;
     json_object *    jsores = NULL;
     json_object *    jsokeys = NULL;
+    rng_t *          rng = rng_thread_local();
+
+    if (!rng) {
+        FFI_LOG(ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
 
     // load keys to temporary keystore.
     tmp_store = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
@@ -1229,6 +1433,8 @@ rnp_import_keys(rnp_ffi_t ffi, rnp_input_t input, uint32_t flags, char **results
         FFI_LOG(ffi, "Failed to create key store.");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
+    tmp_store->sigcache = ffi->sigcache;
+    tmp_store->cert_limit = ffi->cert_limit;
 
     tmpret = load_keys_from_input(ffi, input, tmp_store);
     if (tmpret) {
@@ -1246,44 +1452,18 @@ rnp_import_keys(rnp_ffi_t ffi, rnp_input_t input, uint32_t flags, char **results
         goto done;
     }
 
-    // import keys to the main keystore.
-    for (list_item *ki = list_front(rnp_key_store_get_keys(tmp_store)); ki;
-         ki = list_next(ki)) {
-        pgp_key_t *             key = (pgp_key_t *) ki;
-        pgp_key_import_status_t pub_status = PGP_KEY_IMPORT_STATUS_UNKNOWN;
-        pgp_key_import_status_t sec_status = PGP_KEY_IMPORT_STATUS_UNKNOWN;
-        if (pgp_key_is_public(key) && !pub) {
-            continue;
-        }
-        if (validate_pgp_key_material(pgp_key_get_material(key), &ffi->rng)) {
-            FFI_LOG(ffi, "attempt to import key with invalid material");
-            ret = RNP_ERROR_BAD_PARAMETERS;
-            goto done;
-        }
-        // if we got here then we add public key itself or public part of the secret key
-        if (!rnp_key_store_import_key(ffi->pubring, key, true, &pub_status)) {
-            ret = RNP_ERROR_BAD_PARAMETERS;
-            goto done;
-        }
-        // import secret key part if available and requested
-        if (sec && pgp_key_is_secret(key)) {
-            if (!rnp_key_store_import_key(ffi->secring, key, false, &sec_status)) {
-                ret = RNP_ERROR_BAD_PARAMETERS;
-                goto done;
-            }
-            // add uids, certifications and other stuff from the public key if any
-            pgp_key_t *expub =
-              rnp_key_store_get_key_by_grip(ffi->pubring, pgp_key_get_grip(key));
-            if (expub && !rnp_key_store_import_key(ffi->secring, expub, true, NULL)) {
-                ret = RNP_ERROR_BAD_PARAMETERS;
-                goto done;
-            }
-        }
-        // now add key fingerprint to json based on statuses
-        if ((tmpret = add_key_status(jsokeys, key, pub_status, sec_status))) {
-            ret = tmpret;
-            goto done;
-        }
+    // import keys to the main keystore, limiting certifications of the imported keys only
+    {
+        std::lock_guard<rnp_rwlock_t> lock(*ffi->lock);
+        ffi->pubring->cert_limit = ffi->cert_limit;
+        ffi->secring->cert_limit = ffi->cert_limit;
+        tmpret = import_loaded_keys(ffi, tmp_store, pub, sec, jsokeys, rng);
+        ffi->pubring->cert_limit = 0;
+        ffi->secring->cert_limit = 0;
+    }
+    if (tmpret) {
+        ret = tmpret;
+        goto done;
     }
 
     if (results) {
@@ -1338,18 +1518,22 @@ do_save_keys(rnp_ffi_t              ffi,
         FFI_LOG(ffi, "Failed to create key store of format: %d", (int) format);
         return RNP_ERROR_BAD_PARAMETERS;
     }
-    // include the public keys, if desired
-    if (key_type == KEY_TYPE_PUBLIC || key_type == KEY_TYPE_ANY) {
-        if (!copy_store_keys(ffi, tmp_store, ffi->pubring)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
-            goto done;
+    // copy keys under the lock, so writing out doesn't block the other threads
+    {
+        rnp_shared_lock_t lock(*ffi->lock);
+        // include the public keys, if desired
+        if (key_type == KEY_TYPE_PUBLIC || key_type == KEY_TYPE_ANY) {
+            if (!copy_store_keys(ffi, tmp_store, ffi->pubring)) {
+                ret = RNP_ERROR_OUT_OF_MEMORY;
+                goto done;
+            }
         }
-    }
-    // include the secret keys, if desired
-    if (key_type == KEY_TYPE_SECRET || key_type == KEY_TYPE_ANY) {
-        if (!copy_store_keys(ffi, tmp_store, ffi->secring)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
-            goto done;
+        // include the secret keys, if desired
+        if (key_type == KEY_TYPE_SECRET || key_type == KEY_TYPE_ANY) {
+            if (!copy_store_keys(ffi, tmp_store, ffi->secring)) {
+                ret = RNP_ERROR_OUT_OF_MEMORY;
+                goto done;
+            }
         }
     }
     // preliminary check on the format
@@ -1422,6 +1606,7 @@ rnp_get_public_key_count(rnp_ffi_t ffi, size_t *count)
     if (!ffi || !count) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*ffi->lock);
     *count = rnp_key_store_get_key_count(ffi->pubring);
     return RNP_SUCCESS;
 }
@@ -1432,6 +1617,7 @@ rnp_get_secret_key_count(rnp_ffi_t ffi, size_t *count)
     if (!ffi || !count) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*ffi->lock);
     *count = rnp_key_store_get_key_count(ffi->secring);
     return RNP_SUCCESS;
 }
@@ -1470,6 +1656,38 @@ rnp_input_from_path(rnp_input_t *input, const char *path)
     return RNP_SUCCESS;
 }
 
+rnp_result_t
+rnp_input_from_file(rnp_input_t *input, const char *path, uint32_t flags)
+{
+    if (!input || !path) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    bool mmap = false;
+    if (flags & RNP_INPUT_FILE_MMAP) {
+        mmap = true;
+        flags &= ~RNP_INPUT_FILE_MMAP;
+    }
+    if (flags) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    rnp_input_t res = (rnp_input_t) calloc(1, sizeof(*res));
+    if (!res) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    rnp_result_t ret = RNP_ERROR_GENERIC;
+    if (mmap) {
+        ret = init_file_or_mmap_src(&res->src, path);
+    } else {
+        ret = init_file_src(&res->src, path);
+    }
+    if (ret) {
+        free(res);
+        return ret;
+    }
+    *input = res;
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_input_from_memory(rnp_input_t *input, const uint8_t buf[], size_t buf_len, bool do_copy)
 {
@@ -1834,6 +2052,7 @@ rnp_op_add_signature(rnp_ffi_t                ffi,
     if (!signatures || !key) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*key->ffi->lock);
 
     newsig = (rnp_op_sign_signature_t) list_append(signatures, NULL, sizeof(*newsig));
     if (!newsig) {
@@ -1952,6 +2171,38 @@ rnp_op_set_file_mtime(rnp_ctx_t *ctx, uint32_t mtime)
     return RNP_SUCCESS;
 }
 
+static rnp_result_t
+rnp_op_set_buffer_size(rnp_ctx_t *ctx, size_t size)
+{
+    if (!ctx) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (size > PGP_STREAM_BUFFER_MAX_SIZE) {
+        RNP_LOG("too large buffer size: %zu", size);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    ctx->bufsize = size;
+    return RNP_SUCCESS;
+}
+
+/* apply stream buffer size to the operation's input and output, and to the streams which
+ * will be created on this thread during the operation. Returns the previous setting. */
+static size_t
+rnp_op_set_stream_buffers(const rnp_ctx_t *ctx, rnp_input_t input, rnp_output_t output)
+{
+    size_t size = ctx->bufsize;
+    if (!size && input && input->src.knownsize) {
+        size = stream_buffer_size_for(input->src.size);
+    }
+    if (input) {
+        src_set_buffer_size(&input->src, size);
+    }
+    if (output) {
+        dst_set_buffer_size(&output->dst, size);
+    }
+    return stream_set_buffer_size(size);
+}
+
 static void
 rnp_op_signatures_destroy(list *signatures)
 {
@@ -1988,6 +2239,7 @@ rnp_op_encrypt_add_recipient(rnp_op_encrypt_t op, rnp_key_handle_t handle)
     if (!op || !handle) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = find_suitable_key(PGP_OP_ENCRYPT,
                                        get_key_prefer_public(handle),
@@ -2150,6 +2402,16 @@ rnp_op_encrypt_set_compression(rnp_op_encrypt_t op, const char *compression, int
     return rnp_op_set_compression(op->ffi, &op->rnpctx, compression, level);
 }
 
+rnp_result_t
+rnp_op_encrypt_set_compression_threads(rnp_op_encrypt_t op, size_t threads)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->rnpctx.zthreads = rnp_parallel_clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_op_encrypt_set_file_name(rnp_op_encrypt_t op, const char *filename)
 {
@@ -2168,6 +2430,15 @@ rnp_op_encrypt_set_file_mtime(rnp_op_encrypt_t op, uint32_t mtime)
     return rnp_op_set_file_mtime(&op->rnpctx, mtime);
 }
 
+rnp_result_t
+rnp_op_encrypt_set_buffer_size(rnp_op_encrypt_t op, size_t size)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    return rnp_op_set_buffer_size(&op->rnpctx, size);
+}
+
 static pgp_write_handler_t
 pgp_write_handler(pgp_password_provider_t *pass_provider,
                   rnp_ctx_t *              rnpctx,
@@ -2221,6 +2492,15 @@ rnp_op_encrypt_execute(rnp_op_encrypt_t op)
         return RNP_ERROR_NULL_POINTER;
     }
 
+    // op may be executed on the other thread than it was created
+    rnp_rng_scope_t rng(&op->rnpctx.rng);
+    if (!op->rnpctx.rng) {
+        FFI_LOG(op->ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
+    // keys, used by the operation, must not be removed meanwhile
+    rnp_shared_lock_t lock(*op->ffi->lock);
+
     // set the default hash alg if none was specified
     if (!op->rnpctx.halg) {
         op->rnpctx.halg = DEFAULT_PGP_HASH_ALG;
@@ -2233,10 +2513,15 @@ rnp_op_encrypt_execute(rnp_op_encrypt_t op)
         if ((ret = rnp_op_add_signatures(op->signatures, &op->rnpctx))) {
             return ret;
         }
+    }
+
+    size_t prevbuf = rnp_op_set_stream_buffers(&op->rnpctx, op->input, op->output);
+    if (list_length(op->signatures)) {
         ret = rnp_encrypt_sign_src(&handler, &op->input->src, &op->output->dst);
     } else {
         ret = rnp_encrypt_src(&handler, &op->input->src, &op->output->dst);
     }
+    stream_set_buffer_size(prevbuf);
 
     dst_flush(&op->output->dst);
     op->output->keep = ret == RNP_SUCCESS;
@@ -2365,6 +2650,16 @@ rnp_op_sign_set_compression(rnp_op_sign_t op, const char *compression, int level
     return rnp_op_set_compression(op->ffi, &op->rnpctx, compression, level);
 }
 
+rnp_result_t
+rnp_op_sign_set_compression_threads(rnp_op_sign_t op, size_t threads)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->rnpctx.zthreads = rnp_parallel_clamp_threads(threads);
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_op_sign_set_hash(rnp_op_sign_t op, const char *hash)
 {
@@ -2410,6 +2705,15 @@ rnp_op_sign_set_file_mtime(rnp_op_sign_t op, uint32_t mtime)
     return rnp_op_set_file_mtime(&op->rnpctx, mtime);
 }
 
+rnp_result_t
+rnp_op_sign_set_buffer_size(rnp_op_sign_t op, size_t size)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    return rnp_op_set_buffer_size(&op->rnpctx, size);
+}
+
 rnp_result_t
 rnp_op_sign_execute(rnp_op_sign_t op)
 {
@@ -2418,6 +2722,15 @@ rnp_op_sign_execute(rnp_op_sign_t op)
         return RNP_ERROR_NULL_POINTER;
     }
 
+    // op may be executed on the other thread than it was created
+    rnp_rng_scope_t rng(&op->rnpctx.rng);
+    if (!op->rnpctx.rng) {
+        FFI_LOG(op->ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
+    // keys, used by the operation, must not be removed meanwhile
+    rnp_shared_lock_t lock(*op->ffi->lock);
+
     // set the default hash alg if none was specified
     if (!op->rnpctx.halg) {
         op->rnpctx.halg = DEFAULT_PGP_HASH_ALG;
@@ -2429,7 +2742,9 @@ rnp_op_sign_execute(rnp_op_sign_t op)
     if ((ret = rnp_op_add_signatures(op->signatures, &op->rnpctx))) {
         return ret;
     }
+    size_t prevbuf = rnp_op_set_stream_buffers(&op->rnpctx, op->input, op->output);
     ret = rnp_sign_src(&handler, &op->input->src, &op->output->dst);
+    stream_set_buffer_size(prevbuf);
 
     dst_flush(&op->output->dst);
     op->output->keep = ret == RNP_SUCCESS;
@@ -2557,19 +2872,37 @@ rnp_op_verify_detached_create(rnp_op_verify_t *op,
 }
 
 rnp_result_t
-rnp_op_verify_execute(rnp_op_verify_t op)
+rnp_op_verify_set_buffer_size(rnp_op_verify_t op, size_t size)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    return rnp_op_set_buffer_size(&op->rnpctx, size);
+}
+
+/* caller must hold the ffi's lock */
+static rnp_result_t
+rnp_op_verify_process(rnp_op_verify_t op, pgp_key_provider_t *key_provider)
 {
     pgp_parse_handler_t handler;
 
     handler.password_provider = &op->ffi->pass_provider;
-    handler.key_provider = &op->ffi->key_provider;
+    handler.key_provider = key_provider;
     handler.on_signatures = rnp_op_verify_on_signatures;
     handler.src_provider = rnp_verify_src_provider;
     handler.dest_provider = rnp_verify_dest_provider;
     handler.param = op;
     handler.ctx = &op->rnpctx;
+    /* batch verification calls this on the worker threads */
+    rnp_rng_scope_t rng(&op->rnpctx.rng);
+    if (!op->rnpctx.rng) {
+        FFI_LOG(op->ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
 
+    size_t       prevbuf = rnp_op_set_stream_buffers(&op->rnpctx, op->input, op->output);
     rnp_result_t ret = process_pgp_source(&handler, &op->input->src);
+    stream_set_buffer_size(prevbuf);
     if (op->output) {
         dst_flush(&op->output->dst);
         op->output->keep = ret == RNP_SUCCESS;
@@ -2577,6 +2910,13 @@ rnp_op_verify_execute(rnp_op_verify_t op)
     return ret;
 }
 
+rnp_result_t
+rnp_op_verify_execute(rnp_op_verify_t op)
+{
+    rnp_shared_lock_t lock(*op->ffi->lock);
+    return rnp_op_verify_process(op, &op->ffi->key_provider);
+}
+
 rnp_result_t
 rnp_op_verify_get_signature_count(rnp_op_verify_t op, size_t *count)
 {
@@ -2700,6 +3040,7 @@ rnp_op_verify_signature_get_key(rnp_op_verify_signature_t sig, rnp_key_handle_t
     memcpy(search.by.keyid, keyid, PGP_KEY_ID_SIZE);
 
     // search the stores
+    rnp_shared_lock_t lock(*ffi->lock);
     pgp_key_t *pub = rnp_key_store_search(ffi->pubring, &search, NULL);
     pgp_key_t *sec = rnp_key_store_search(ffi->secring, &search, NULL);
     if (!pub && !sec) {
@@ -2733,6 +3074,224 @@ rnp_op_verify_signature_get_times(rnp_op_verify_signature_t sig,
     return RNP_SUCCESS;
 }
 
+rnp_result_t
+rnp_op_verify_batch_create(rnp_op_verify_batch_t *op, rnp_ffi_t ffi)
+{
+    if (!op || !ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    try {
+        *op = new rnp_op_verify_batch_st();
+    } catch (const std::exception &e) {
+        FFI_LOG(ffi, "%s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    (*op)->ffi = ffi;
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+rnp_op_verify_batch_add_item(rnp_op_verify_batch_t op, rnp_op_verify_t verify)
+{
+    try {
+        op->items.push_back(verify);
+        op->results.push_back(RNP_ERROR_GENERIC);
+    } catch (const std::exception &e) {
+        FFI_LOG(op->ffi, "%s", e.what());
+        if (op->items.size() > op->results.size()) {
+            op->items.pop_back();
+        }
+        rnp_op_verify_destroy(verify);
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_op_verify_batch_add(rnp_op_verify_batch_t op, rnp_input_t input, rnp_output_t output)
+{
+    rnp_op_verify_t verify = NULL;
+    rnp_result_t    ret;
+
+    if (!op || !input) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!output) {
+        /* verified data is discarded */
+        try {
+            op->outputs.reserve(op->outputs.size() + 1);
+        } catch (const std::exception &e) {
+            FFI_LOG(op->ffi, "%s", e.what());
+            return RNP_ERROR_OUT_OF_MEMORY;
+        }
+        if ((ret = rnp_output_to_null(&output))) {
+            return ret;
+        }
+        op->outputs.push_back(output);
+    }
+    if ((ret = rnp_op_verify_create(&verify, op->ffi, input, output))) {
+        return ret;
+    }
+    return rnp_op_verify_batch_add_item(op, verify);
+}
+
+rnp_result_t
+rnp_op_verify_batch_add_detached(rnp_op_verify_batch_t op,
+                                 rnp_input_t           input,
+                                 rnp_input_t           signature)
+{
+    rnp_op_verify_t verify = NULL;
+    rnp_result_t    ret;
+
+    if (!op || !input || !signature) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if ((ret = rnp_op_verify_detached_create(&verify, op->ffi, input, signature))) {
+        return ret;
+    }
+    return rnp_op_verify_batch_add_item(op, verify);
+}
+
+rnp_result_t
+rnp_op_verify_batch_set_threads(rnp_op_verify_batch_t op, size_t threads)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->threads = threads;
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_op_verify_batch_set_callback(rnp_op_verify_batch_t  op,
+                                 rnp_op_verify_batch_cb callback,
+                                 void *                 app_ctx)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    op->callback = callback;
+    op->callback_ctx = app_ctx;
+    return RNP_SUCCESS;
+}
+
+/* key lookup, shared between the batch items. Keyrings are searched directly: lock is held
+ * by the thread which executes the batch, and taking it from the workers would deadlock with
+ * the waiting writer. */
+static pgp_key_t *
+rnp_verify_batch_key_provider(const pgp_key_request_ctx_t *ctx, void *userdata)
+{
+    rnp_op_verify_batch_t op = (rnp_op_verify_batch_t) userdata;
+    rnp_key_store_t *     store = ctx->secret ? op->ffi->secring : op->ffi->pubring;
+    const uint8_t *       id = NULL;
+    size_t                len = 0;
+
+    switch (ctx->search.type) {
+    case PGP_KEY_SEARCH_KEYID:
+        id = ctx->search.by.keyid;
+        len = PGP_KEY_ID_SIZE;
+        break;
+    case PGP_KEY_SEARCH_FINGERPRINT:
+        id = ctx->search.by.fingerprint.fingerprint;
+        len = ctx->search.by.fingerprint.length;
+        break;
+    case PGP_KEY_SEARCH_GRIP:
+        id = ctx->search.by.grip;
+        len = PGP_KEY_GRIP_SIZE;
+        break;
+    default:
+        return rnp_key_store_search(store, &ctx->search, NULL);
+    }
+
+    try {
+        std::string key_id(1, (char) (ctx->search.type | (ctx->secret ? 0x80 : 0)));
+        key_id.append((const char *) id, len);
+        {
+            std::lock_guard<std::mutex> lock(op->keys_lock);
+            auto                        it = op->keys.find(key_id);
+            if (it != op->keys.end()) {
+                return it->second;
+            }
+        }
+        /* missing keys are cached as well, concurrent lookups may just find the same key */
+        pgp_key_t *                 key = rnp_key_store_search(store, &ctx->search, NULL);
+        std::lock_guard<std::mutex> lock(op->keys_lock);
+        op->keys[key_id] = key;
+        return key;
+    } catch (const std::exception &e) {
+        /* not fatal, key just will not be cached */
+        FFI_LOG(op->ffi, "%s", e.what());
+        return rnp_key_store_search(store, &ctx->search, NULL);
+    }
+}
+
+rnp_result_t
+rnp_op_verify_batch_execute(rnp_op_verify_batch_t op)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+
+    pgp_key_provider_t prov = {.callback = rnp_verify_batch_key_provider, .userdata = op};
+    rnp_shared_lock_t  lock(*op->ffi->lock);
+    rnp_parallel_for(op->ffi->pool, op->items.size(), op->threads, [op, &prov](size_t idx) {
+        op->results[idx] = rnp_op_verify_process(op->items[idx], &prov);
+        if (op->callback) {
+            op->callback(op, idx, op->items[idx], op->results[idx], op->callback_ctx);
+        }
+    });
+    /* keys may be removed after the execution */
+    op->keys.clear();
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_op_verify_batch_get_item_count(rnp_op_verify_batch_t op, size_t *count)
+{
+    if (!op || !count) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    *count = op->items.size();
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_op_verify_batch_get_item(rnp_op_verify_batch_t op,
+                             size_t                idx,
+                             rnp_op_verify_t *     verify,
+                             rnp_result_t *        status)
+{
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (idx >= op->items.size()) {
+        FFI_LOG(op->ffi, "Invalid item index: %zu", idx);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    if (verify) {
+        *verify = op->items[idx];
+    }
+    if (status) {
+        *status = op->results[idx];
+    }
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_op_verify_batch_destroy(rnp_op_verify_batch_t op)
+{
+    if (op) {
+        for (auto verify : op->items) {
+            rnp_op_verify_destroy(verify);
+        }
+        for (auto output : op->outputs) {
+            rnp_output_destroy(output);
+        }
+        delete op;
+    }
+    return RNP_SUCCESS;
+}
+
 static bool
 rnp_decrypt_dest_provider(pgp_parse_handler_t *handler,
                           pgp_dest_t **        dst,
@@ -2754,7 +3313,13 @@ rnp_decrypt(rnp_ffi_t ffi, rnp_input_t input, rnp_output_t output)
         return RNP_ERROR_NULL_POINTER;
     }
 
+    rnp_shared_lock_t lock(*ffi->lock);
     rnp_ctx_init_ffi(&rnpctx, ffi);
+    rnp_rng_scope_t rng(&rnpctx.rng);
+    if (!rnpctx.rng) {
+        FFI_LOG(ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
     pgp_parse_handler_t handler;
     memset(&handler, 0, sizeof(handler));
     handler.password_provider = &ffi->pass_provider;
@@ -2763,7 +3328,9 @@ rnp_decrypt(rnp_ffi_t ffi, rnp_input_t input, rnp_output_t output)
     handler.param = output;
     handler.ctx = &rnpctx;
 
+    size_t       prevbuf = rnp_op_set_stream_buffers(&rnpctx, input, output);
     rnp_result_t ret = process_pgp_source(&handler, &input->src);
+    stream_set_buffer_size(prevbuf);
     dst_flush(&output->dst);
     output->keep = (ret == RNP_SUCCESS);
     return ret;
@@ -2890,6 +3457,7 @@ rnp_locate_key(rnp_ffi_t         ffi,
     if (!ffi || !identifier_type || !identifier || !handle) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*ffi->lock);
 
     // figure out the identifier type
     pgp_key_search_t locator = {(pgp_key_search_type_t) 0};
@@ -2932,6 +3500,7 @@ rnp_key_export(rnp_key_handle_t handle, rnp_output_t output, uint32_t flags)
     if (!handle || !output) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     dst = &output->dst;
     if ((flags & RNP_KEY_EXPORT_PUBLIC) && (flags & RNP_KEY_EXPORT_SECRET)) {
         FFI_LOG(handle->ffi, "Invalid export flags, select only public or secret, not both.");
@@ -3025,6 +3594,7 @@ rnp_key_remove(rnp_key_handle_t key, uint32_t flags)
     if (flags == 0) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    std::lock_guard<rnp_rwlock_t> lock(*key->ffi->lock);
     if (flags & RNP_KEY_REMOVE_PUBLIC) {
         if (!key->ffi->pubring || !key->pub) {
             return RNP_ERROR_BAD_PARAMETERS;
@@ -3479,11 +4049,17 @@ rnp_generate_key_json(rnp_ffi_t ffi, const char *json, char **results)
     json_object *       jsoprimary = NULL;
     json_object *       jsosub = NULL;
     json_tokener_error  error;
+    rng_t *             rng = NULL;
 
     // checks
     if (!ffi || !ffi->secring || !json) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (!(rng = rng_thread_local())) {
+        FFI_LOG(ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
+    std::lock_guard<rnp_rwlock_t> lock(*ffi->lock);
 
     // parse the JSON
     jso = json_tokener_parse_verbose(json, &error);
@@ -3526,7 +4102,7 @@ rnp_generate_key_json(rnp_ffi_t ffi, const char *json, char **results)
             ret = RNP_ERROR_BAD_PARAMETERS;
             goto done;
         }
-        if (!pgp_generate_keypair(&ffi->rng,
+        if (!pgp_generate_keypair(rng,
                                   &keygen_desc.primary.keygen,
                                   &keygen_desc.subkey.keygen,
                                   true,
@@ -3583,7 +4159,7 @@ rnp_generate_key_json(rnp_ffi_t ffi, const char *json, char **results)
         }
         sub_sec = (pgp_key_t){0};
     } else if (jsoprimary && !jsosub) { // generating primary only
-        keygen_desc.primary.keygen.crypto.rng = &ffi->rng;
+        keygen_desc.primary.keygen.crypto.rng = rng;
         if (!parse_keygen_primary(jsoprimary, &keygen_desc)) {
             ret = RNP_ERROR_BAD_PARAMETERS;
             goto done;
@@ -3665,7 +4241,7 @@ rnp_generate_key_json(rnp_ffi_t ffi, const char *json, char **results)
             ret = RNP_ERROR_BAD_PARAMETERS;
             goto done;
         }
-        keygen_desc.subkey.keygen.crypto.rng = &ffi->rng;
+        keygen_desc.subkey.keygen.crypto.rng = rng;
         if (!pgp_generate_subkey(&keygen_desc.subkey.keygen,
                                  true,
                                  primary_sec,
@@ -3939,7 +4515,6 @@ rnp_op_generate_create(rnp_op_generate_t *op, rnp_ffi_t ffi, const char *alg)
     (*op)->ffi = ffi;
     (*op)->primary = true;
     (*op)->crypto.key_alg = key_alg;
-    (*op)->crypto.rng = &ffi->rng;
     (*op)->cert.key_flags = default_key_flags(key_alg, false);
 
     return RNP_SUCCESS;
@@ -3986,7 +4561,6 @@ rnp_op_generate_subkey_create(rnp_op_generate_t *op,
     (*op)->ffi = ffi;
     (*op)->primary = false;
     (*op)->crypto.key_alg = key_alg;
-    (*op)->crypto.rng = &ffi->rng;
     (*op)->binding.key_flags = default_key_flags(key_alg, true);
     (*op)->primary_sec = primary->sec;
     (*op)->primary_pub = primary->pub;
@@ -4331,6 +4905,13 @@ rnp_op_generate_execute(rnp_op_generate_t op)
     pgp_key_t               sec = {};
     pgp_password_provider_t prov = {.callback = NULL};
 
+    /* op may be executed on the other thread than it was created */
+    rnp_rng_scope_t rng(&op->crypto.rng);
+    if (!op->crypto.rng) {
+        FFI_LOG(op->ffi, "failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
+
     if (op->primary) {
         rnp_keygen_primary_desc_t keygen = {};
         keygen.crypto = op->crypto;
@@ -4358,6 +4939,7 @@ rnp_op_generate_execute(rnp_op_generate_t op)
     }
 
     /* add public key part to the keyring */
+    std::lock_guard<rnp_rwlock_t> lock(*op->ffi->lock);
     if (!(op->gen_pub = rnp_key_store_add_key(op->ffi->pubring, &pub))) {
         ret = RNP_ERROR_OUT_OF_MEMORY;
         goto done;
@@ -4545,6 +5127,7 @@ rnp_key_add_uid(rnp_key_handle_t handle,
     if (!handle || !uid || !hash) {
         return RNP_ERROR_NULL_POINTER;
     }
+    std::lock_guard<rnp_rwlock_t> lock(*handle->ffi->lock);
 
     if (!str_to_hash_alg(hash, &hash_alg)) {
         FFI_LOG(handle->ffi, "Invalid hash: %s", hash);
@@ -4599,6 +5182,7 @@ rnp_key_get_primary_uid(rnp_key_handle_t handle, char **uid)
 {
     if (handle == NULL || uid == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     return key_get_uid_at(key, key->uid0_set ? key->uid0 : 0, uid);
@@ -4610,6 +5194,7 @@ rnp_key_get_uid_count(rnp_key_handle_t handle, size_t *count)
     if (handle == NULL || count == NULL) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     *count = pgp_key_get_userid_count(key);
@@ -4621,6 +5206,7 @@ rnp_key_get_uid_at(rnp_key_handle_t handle, size_t idx, char **uid)
 {
     if (handle == NULL || uid == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     return key_get_uid_at(key, idx, uid);
@@ -4632,6 +5218,7 @@ rnp_key_get_uid_handle_at(rnp_key_handle_t key, size_t idx, rnp_uid_handle_t *ui
     if (!key || !uid) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*key->ffi->lock);
 
     pgp_key_t *akey = get_key_prefer_public(key);
     if (!akey) {
@@ -4676,13 +5263,25 @@ rnp_key_get_signature_at_for_uid(
             continue;
         }
         if (skipped == idx) {
+            /* copy the signature so handle stays valid if key is updated by import */
+            pgp_subsig_t *copy = (pgp_subsig_t *) calloc(1, sizeof(*copy));
+            if (!copy) {
+                return RNP_ERROR_OUT_OF_MEMORY;
+            }
+            if (pgp_subsig_copy(copy, subsig)) {
+                free(copy);
+                return RNP_ERROR_OUT_OF_MEMORY;
+            }
             *sig = (rnp_signature_handle_t) calloc(1, sizeof(**sig));
             if (!*sig) {
+                pgp_subsig_free(copy);
+                free(copy);
                 return RNP_ERROR_OUT_OF_MEMORY;
             }
             (*sig)->ffi = ffi;
             (*sig)->key = key;
-            (*sig)->sig = subsig;
+            (*sig)->sig = copy;
+            (*sig)->own_sig = true;
             return RNP_SUCCESS;
         }
         skipped++;
@@ -4696,6 +5295,7 @@ rnp_key_get_signature_count(rnp_key_handle_t handle, size_t *count)
     if (!handle || !count) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -4709,6 +5309,7 @@ rnp_key_get_signature_at(rnp_key_handle_t handle, size_t idx, rnp_signature_hand
     if (!handle || !sig) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key) {
@@ -4723,6 +5324,7 @@ rnp_uid_get_signature_count(rnp_uid_handle_t handle, size_t *count)
     if (!handle || !count) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     if (!handle->key) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -4735,6 +5337,7 @@ rnp_uid_get_signature_at(rnp_uid_handle_t handle, size_t idx, rnp_signature_hand
     if (!handle || !sig) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     if (!handle->key) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -4893,6 +5496,7 @@ rnp_uid_is_revoked(rnp_uid_handle_t uid, bool *result)
     if (!uid || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*uid->ffi->lock);
 
     if (!uid->key) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -4916,6 +5520,7 @@ rnp_key_get_subkey_count(rnp_key_handle_t handle, size_t *count)
     if (!handle || !count) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     *count = pgp_key_get_subkey_count(key);
     return RNP_SUCCESS;
@@ -4927,6 +5532,7 @@ rnp_key_get_subkey_at(rnp_key_handle_t handle, size_t idx, rnp_key_handle_t *sub
     if (!handle || !subkey) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (idx >= pgp_key_get_subkey_count(key)) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -4946,6 +5552,7 @@ rnp_key_get_alg(rnp_key_handle_t handle, char **alg)
     if (!handle || !alg) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t * key = get_key_prefer_public(handle);
     const char *str = NULL;
 
@@ -4969,6 +5576,7 @@ rnp_key_get_bits(rnp_key_handle_t handle, uint32_t *bits)
     if (!handle || !bits) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     size_t     _bits = pgp_key_get_bits(key);
     if (!_bits) {
@@ -4984,6 +5592,7 @@ rnp_key_get_dsa_qbits(rnp_key_handle_t handle, uint32_t *qbits)
     if (!handle || !qbits) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     size_t     _qbits = pgp_key_get_dsa_qbits(key);
     if (!_qbits) {
@@ -4999,6 +5608,7 @@ rnp_key_get_curve(rnp_key_handle_t handle, char **curve)
     if (!handle || !curve) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t * key = get_key_prefer_public(handle);
     pgp_curve_t _curve = pgp_key_get_curve(key);
     if (_curve == PGP_CURVE_UNKNOWN) {
@@ -5021,6 +5631,7 @@ rnp_key_get_fprint(rnp_key_handle_t handle, char **fprint)
 {
     if (handle == NULL || fprint == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     size_t hex_len = PGP_FINGERPRINT_HEX_SIZE + 1;
     *fprint = (char *) malloc(hex_len);
@@ -5043,6 +5654,7 @@ rnp_key_get_keyid(rnp_key_handle_t handle, char **keyid)
 {
     if (handle == NULL || keyid == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     size_t hex_len = PGP_KEY_ID_SIZE * 2 + 1;
     *keyid = (char *) malloc(hex_len);
@@ -5062,6 +5674,7 @@ rnp_key_get_grip(rnp_key_handle_t handle, char **grip)
 {
     if (handle == NULL || grip == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     size_t hex_len = PGP_KEY_GRIP_SIZE * 2 + 1;
     *grip = (char *) malloc(hex_len);
@@ -5082,6 +5695,7 @@ rnp_key_get_primary_grip(rnp_key_handle_t handle, char **grip)
     if (handle == NULL || grip == NULL) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!pgp_key_is_subkey(key)) {
@@ -5113,6 +5727,7 @@ rnp_key_allows_usage(rnp_key_handle_t handle, const char *usage, bool *result)
     if (!handle || !usage || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     uint8_t flag = 0;
     if (!str_to_key_flag(usage, &flag)) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -5131,6 +5746,7 @@ rnp_key_get_creation(rnp_key_handle_t handle, uint32_t *result)
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -5145,6 +5761,7 @@ rnp_key_is_revoked(rnp_key_handle_t handle, bool *result)
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -5159,6 +5776,7 @@ rnp_key_get_expiration(rnp_key_handle_t handle, uint32_t *result)
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -5173,6 +5791,7 @@ rnp_key_get_revocation_reason(rnp_key_handle_t handle, char **result)
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key || !key->revoked) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -5196,6 +5815,7 @@ rnp_key_is_revoked_with_code(rnp_key_handle_t handle, bool *result, int code)
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_prefer_public(handle);
     if (!key || !key->revoked) {
         return RNP_ERROR_BAD_PARAMETERS;
@@ -5228,6 +5848,7 @@ rnp_key_is_locked(rnp_key_handle_t handle, bool *result)
 {
     if (handle == NULL || result == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_require_secret(handle);
     if (!key) {
@@ -5242,6 +5863,7 @@ rnp_key_lock(rnp_key_handle_t handle)
 {
     if (handle == NULL)
         return RNP_ERROR_NULL_POINTER;
+    std::lock_guard<rnp_rwlock_t> lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_require_secret(handle);
     if (!key) {
@@ -5259,6 +5881,7 @@ rnp_key_unlock(rnp_key_handle_t handle, const char *password)
     if (!handle) {
         return RNP_ERROR_NULL_POINTER;
     }
+    std::lock_guard<rnp_rwlock_t> lock(*handle->ffi->lock);
     pgp_key_t *key = get_key_require_secret(handle);
     if (!key) {
         return RNP_ERROR_NO_SUITABLE_KEY;
@@ -5283,6 +5906,7 @@ rnp_key_is_protected(rnp_key_handle_t handle, bool *result)
 {
     if (handle == NULL || result == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_require_secret(handle);
     if (!key) {
@@ -5309,6 +5933,7 @@ rnp_key_protect(rnp_key_handle_t handle,
     if (!handle || !password) {
         return RNP_ERROR_NULL_POINTER;
     }
+    std::lock_guard<rnp_rwlock_t> lock(*handle->ffi->lock);
 
     if (cipher && !str_to_cipher(cipher, &protection.symm_alg)) {
         FFI_LOG(handle->ffi, "Invalid cipher: %s", cipher);
@@ -5356,6 +5981,7 @@ rnp_key_unprotect(rnp_key_handle_t handle, const char *password)
     if (!handle) {
         return RNP_ERROR_NULL_POINTER;
     }
+    std::lock_guard<rnp_rwlock_t> lock(*handle->ffi->lock);
 
     // get the key
     pgp_key_t *key = get_key_require_secret(handle);
@@ -5382,6 +6008,7 @@ rnp_key_is_primary(rnp_key_handle_t handle, bool *result)
 {
     if (handle == NULL || result == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     if (key->format == PGP_KEY_STORE_G10) {
@@ -5397,6 +6024,7 @@ rnp_key_is_sub(rnp_key_handle_t handle, bool *result)
 {
     if (handle == NULL || result == NULL)
         return RNP_ERROR_NULL_POINTER;
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = get_key_prefer_public(handle);
     if (key->format == PGP_KEY_STORE_G10) {
@@ -5458,6 +6086,7 @@ rnp_get_public_key_data(rnp_key_handle_t handle, uint8_t **buf, size_t *buf_len)
     if (!handle || !buf || !buf_len) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = handle->pub;
     if (!key) {
@@ -5473,6 +6102,7 @@ rnp_get_secret_key_data(rnp_key_handle_t handle, uint8_t **buf, size_t *buf_len)
     if (!handle || !buf || !buf_len) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     pgp_key_t *key = handle->sec;
     if (!key) {
@@ -5991,9 +6621,8 @@ key_to_json(json_object *jso, rnp_key_handle_t handle, uint32_t flags)
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         json_object_object_add(jso, "subkey grips", jsosubkeys_arr);
-        list_item *subgrip_item = list_front(key->subkey_grips);
-        while (subgrip_item) {
-            uint8_t *subgrip = (uint8_t *) subgrip_item;
+        for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
+            const uint8_t *subgrip = pgp_key_get_subkey_grip(key, i);
             if (!rnp_hex_encode(
                   subgrip, PGP_KEY_GRIP_SIZE, grip, sizeof(grip), RNP_HEX_UPPERCASE)) {
                 return RNP_ERROR_GENERIC;
@@ -6003,7 +6632,6 @@ key_to_json(json_object *jso, rnp_key_handle_t handle, uint32_t flags)
                 json_object_put(jsostr);
                 return RNP_ERROR_OUT_OF_MEMORY;
             }
-            subgrip_item = list_next(subgrip_item);
         }
     } else {
         if (!rnp_hex_encode(pgp_key_get_primary_grip(key),
@@ -6121,6 +6749,7 @@ rnp_key_to_json(rnp_key_handle_t handle, uint32_t flags, char **result)
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
     jso = json_object_new_object();
     if (!jso) {
         ret = RNP_ERROR_OUT_OF_MEMORY;
@@ -6200,6 +6829,7 @@ rnp_key_packets_to_json(rnp_key_handle_t handle, bool secret, uint32_t flags, ch
     if (!handle || !result) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*handle->ffi->lock);
 
     key = secret ? handle->sec : handle->pub;
     if (!key || (key->format == PGP_KEY_STORE_G10)) {
@@ -6412,6 +7042,7 @@ rnp_identifier_iterator_create(rnp_ffi_t                  ffi,
     if (!ffi || !it || !identifier_type) {
         return RNP_ERROR_NULL_POINTER;
     }
+    rnp_shared_lock_t lock(*ffi->lock);
     // create iterator
     obj = (struct rnp_identifier_iterator_st *) calloc(1, sizeof(*obj));
     if (!obj) {
@@ -6453,6 +7084,7 @@ rnp_identifier_iterator_next(rnp_identifier_iterator_t it, const char **identifi
     }
     // initialize the result to NULL
     *identifier = NULL;
+    rnp_shared_lock_t lock(*it->ffi->lock);
     // this means we reached the end of the rings
     if (!it->store) {
         return RNP_SUCCESS;
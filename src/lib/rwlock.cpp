@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <vector>
+#include "rwlock.h"
+
+/* locks held by the current thread, with nesting depth */
+typedef struct rnp_rwlock_owner_t {
+    const rnp_rwlock_t *lock;
+    size_t              readers;
+    size_t              writers;
+} rnp_rwlock_owner_t;
+
+static thread_local std::vector<rnp_rwlock_owner_t> rwlock_owners;
+
+static rnp_rwlock_owner_t &
+rwlock_owner(const rnp_rwlock_t *lock)
+{
+    for (auto &owner : rwlock_owners) {
+        if (owner.lock == lock) {
+            return owner;
+        }
+    }
+    rwlock_owners.push_back({lock, 0, 0});
+    return rwlock_owners.back();
+}
+
+static void
+rwlock_owner_release(const rnp_rwlock_t *lock)
+{
+    for (auto it = rwlock_owners.begin(); it != rwlock_owners.end(); it++) {
+        if (it->lock == lock) {
+            rwlock_owners.erase(it);
+            return;
+        }
+    }
+}
+
+void
+rnp_rwlock_t::lock_shared()
+{
+    rnp_rwlock_owner_t &owner = rwlock_owner(this);
+    /* do not wait for the pending writers if lock is already held, this would deadlock */
+    if (owner.readers || owner.writers) {
+        owner.readers++;
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return !writer_ && !waiting_; });
+    readers_++;
+    owner.readers = 1;
+}
+
+void
+rnp_rwlock_t::unlock_shared()
+{
+    rnp_rwlock_owner_t &owner = rwlock_owner(this);
+    if (--owner.readers || owner.writers) {
+        return;
+    }
+    rwlock_owner_release(this);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!--readers_) {
+        cond_.notify_all();
+    }
+}
+
+void
+rnp_rwlock_t::lock()
+{
+    rnp_rwlock_owner_t &owner = rwlock_owner(this);
+    if (owner.writers) {
+        owner.writers++;
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    /* upgrade: release the shared lock, otherwise two upgrading threads would deadlock */
+    if (owner.readers && !--readers_) {
+        cond_.notify_all();
+    }
+    waiting_++;
+    cond_.wait(lock, [this]() { return !writer_ && !readers_; });
+    waiting_--;
+    writer_ = true;
+    owner.writers = 1;
+}
+
+void
+rnp_rwlock_t::unlock()
+{
+    rnp_rwlock_owner_t &owner = rwlock_owner(this);
+    if (--owner.writers) {
+        return;
+    }
+    bool reader = owner.readers;
+    if (!reader) {
+        rwlock_owner_release(this);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    writer_ = false;
+    /* restore the shared lock, released during the upgrade */
+    if (reader) {
+        readers_++;
+    }
+    cond_.notify_all();
+}
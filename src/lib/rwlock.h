@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef RNP_RWLOCK_H
+#define RNP_RWLOCK_H
+
+#include <stddef.h>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief Reader/writer lock, preferring writers. Locks are reentrant for the calling thread:
+ *        thread which holds exclusive lock may take shared one as well, and thread which
+ *        holds shared lock may take exclusive one. In the latter case shared lock is
+ *        released while waiting for and holding exclusive lock, and restored afterwards, so
+ *        data read under the shared lock may change meanwhile.
+ */
+class rnp_rwlock_t {
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+    size_t                  readers_; /* number of threads holding shared lock */
+    size_t                  waiting_; /* number of threads waiting for exclusive lock */
+    bool                    writer_;  /* exclusive lock is held */
+
+  public:
+    rnp_rwlock_t() : readers_(0), waiting_(0), writer_(false)
+    {
+    }
+    rnp_rwlock_t(const rnp_rwlock_t &) = delete;
+    rnp_rwlock_t &operator=(const rnp_rwlock_t &) = delete;
+
+    void lock_shared();
+    void unlock_shared();
+    void lock();
+    void unlock();
+};
+
+/* RAII guard for the shared lock, exclusive one may use std::lock_guard */
+class rnp_shared_lock_t {
+    rnp_rwlock_t &lock_;
+
+  public:
+    explicit rnp_shared_lock_t(rnp_rwlock_t &lock) : lock_(lock)
+    {
+        lock_.lock_shared();
+    }
+    ~rnp_shared_lock_t()
+    {
+        lock_.unlock_shared();
+    }
+    rnp_shared_lock_t(const rnp_shared_lock_t &) = delete;
+    rnp_shared_lock_t &operator=(const rnp_shared_lock_t &) = delete;
+};
+
+#endif
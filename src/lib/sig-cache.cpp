@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "sig-cache.h"
+#include "utils.h"
+
+typedef std::list<std::string> pgp_sig_lru_t;
+
+struct pgp_sig_cache_item_t {
+    bool                    valid;
+    pgp_sig_lru_t::iterator lru;
+};
+
+struct pgp_sig_cache_t {
+    size_t                                                capacity;
+    std::mutex                                            lock;
+    pgp_sig_lru_t                                         lru;
+    std::unordered_map<std::string, pgp_sig_cache_item_t> items;
+};
+
+pgp_sig_cache_t *
+sig_cache_new(size_t capacity)
+{
+    if (!capacity) {
+        return NULL;
+    }
+    try {
+        pgp_sig_cache_t *cache = new pgp_sig_cache_t();
+        cache->capacity = capacity;
+        return cache;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+}
+
+void
+sig_cache_free(pgp_sig_cache_t *cache)
+{
+    delete cache;
+}
+
+bool
+sig_cache_get(pgp_sig_cache_t *cache, const std::string &id, bool *valid)
+{
+    std::lock_guard<std::mutex> lock(cache->lock);
+    auto                        it = cache->items.find(id);
+    if (it == cache->items.end()) {
+        return false;
+    }
+    cache->lru.splice(cache->lru.begin(), cache->lru, it->second.lru);
+    *valid = it->second.valid;
+    return true;
+}
+
+void
+sig_cache_put(pgp_sig_cache_t *cache, const std::string &id, bool valid)
+{
+    try {
+        std::lock_guard<std::mutex> lock(cache->lock);
+        auto                        it = cache->items.find(id);
+        if (it != cache->items.end()) {
+            it->second.valid = valid;
+            cache->lru.splice(cache->lru.begin(), cache->lru, it->second.lru);
+            return;
+        }
+        cache->lru.push_front(id);
+        try {
+            cache->items[id] = {valid, cache->lru.begin()};
+        } catch (...) {
+            cache->lru.pop_front();
+            throw;
+        }
+        if (cache->items.size() > cache->capacity) {
+            cache->items.erase(cache->lru.back());
+            cache->lru.pop_back();
+        }
+    } catch (const std::exception &e) {
+        /* not fatal, result just will not be cached */
+        RNP_LOG("%s", e.what());
+    }
+}
+
+size_t
+sig_cache_size(pgp_sig_cache_t *cache)
+{
+    std::lock_guard<std::mutex> lock(cache->lock);
+    return cache->items.size();
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_SIG_CACHE_H_
+#define RNP_SIG_CACHE_H_
+
+#include <stddef.h>
+#include <string>
+
+/* bounded LRU cache of signature verification results, safe for concurrent use */
+typedef struct pgp_sig_cache_t pgp_sig_cache_t;
+
+/**
+ * @brief Create new signature verification cache.
+ *
+ * @param capacity maximum number of results to keep, must be non-zero
+ * @return cache object or NULL if allocation failed
+ */
+pgp_sig_cache_t *sig_cache_new(size_t capacity);
+
+/**
+ * @brief Destroy signature verification cache, releasing all of the stored results.
+ *
+ * @param cache cache object, may be NULL
+ */
+void sig_cache_free(pgp_sig_cache_t *cache);
+
+/**
+ * @brief Lookup verification result.
+ *
+ * @param cache cache object
+ * @param id identifier of the verification: signer, digest and signature itself
+ * @param valid on success will be set to the cached verification result
+ * @return true if result was found in the cache or false otherwise
+ */
+bool sig_cache_get(pgp_sig_cache_t *cache, const std::string &id, bool *valid);
+
+/**
+ * @brief Store verification result, evicting the least recently used one if cache is full.
+ *
+ * @param cache cache object
+ * @param id identifier of the verification, see sig_cache_get()
+ * @param valid verification result
+ */
+void sig_cache_put(pgp_sig_cache_t *cache, const std::string &id, bool valid);
+
+/**
+ * @brief Get the number of results, currently stored in the cache.
+ *
+ * @param cache cache object
+ * @return number of stored results, never exceeds the capacity
+ */
+size_t sig_cache_size(pgp_sig_cache_t *cache);
+
+#endif
@@ -54,6 +54,7 @@
 #include <stdint.h>
 #include <rnp/rnp_def.h>
 #include "list.h"
+#include "dynarray.h"
 #include "crypto/common.h"
 
 /* SHA1 Hash Size */
@@ -174,6 +175,11 @@ typedef struct pgp_userid_pkt_t {
     size_t   uid_len;
 } pgp_userid_pkt_t;
 
+/* Number of subpacket types, covered by the signature's subpacket index */
+#define PGP_SIG_SUBPKT_IDX_SIZE 36
+/* Subpacket index value for the subpacket, offset of which doesn't fit 16 bits */
+#define PGP_SIG_SUBPKT_IDX_FAR 0xffff
+
 typedef struct pgp_signature_t {
     pgp_version_t version;
     /* common v3 and v4 fields */
@@ -191,7 +197,17 @@ typedef struct pgp_signature_t {
     uint8_t  signer[PGP_KEY_ID_SIZE];
 
     /* v4 - only fields */
-    list subpkts;
+    uint8_t *unhashed_data; /* raw unhashed subpackets, excluding the length */
+    size_t   unhashed_len;
+    /* offsets of the first subpacket of each type, see signature_find_raw_subpkt() */
+    uint16_t subpkt_idx[PGP_SIG_SUBPKT_IDX_SIZE];
+    bool     subpkts_expanded; /* subpkts are populated and must be used instead of raw data */
+    dynarray subpkts;          /* array of pgp_sig_subpkt_t */
+
+    /* whole packet, if signature was parsed in place. Then hashed_data, unhashed_data and
+     * material point into it, and packet is owned by the caller */
+    const uint8_t *raw;
+    size_t         raw_len;
 } pgp_signature_t;
 
 /* Signature subpacket, see 5.2.3.1 in RFC 4880 and RFC 4880 bis 02 */
@@ -282,6 +298,7 @@ typedef struct pgp_rawpacket_t {
     pgp_content_enum tag;
     size_t           length;
     uint8_t *        raw;
+    bool             in_arena; /* raw is allocated from the key store arena, not owned */
 } pgp_rawpacket_t;
 
 typedef enum {
@@ -370,14 +387,22 @@ typedef struct pgp_user_prefs_t {
     uint8_t *key_server;
 } pgp_user_prefs_t;
 
+/** cached result of the signature check */
+typedef struct pgp_sig_validity_t {
+    bool validated; /* signature was checked and fields below are filled */
+    bool valid;     /* signature is cryptographically valid */
+    bool expired;   /* signature, or key it certifies, is expired */
+} pgp_sig_validity_t;
+
 /** information about the signature */
 typedef struct pgp_subsig_t {
-    uint32_t         uid;         /* index in userid array in key for certification sig */
-    pgp_signature_t  sig;         /* signature packet */
-    uint8_t          trustlevel;  /* level of trust */
-    uint8_t          trustamount; /* amount of trust */
-    uint8_t          key_flags;   /* key flags for certification/direct key sig */
-    pgp_user_prefs_t prefs;       /* user preferences for certification sig */
+    uint32_t           uid;         /* index in userid array in key for certification sig */
+    pgp_signature_t    sig;         /* signature packet */
+    uint8_t            trustlevel;  /* level of trust */
+    uint8_t            trustamount; /* amount of trust */
+    uint8_t            key_flags;   /* key flags for certification/direct key sig */
+    pgp_user_prefs_t   prefs;       /* user preferences for certification sig */
+    pgp_sig_validity_t validity;    /* cached result of the self-signature check */
 } pgp_subsig_t;
 
 typedef struct pgp_userid_t {
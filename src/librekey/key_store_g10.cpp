@@ -1068,29 +1068,36 @@ done:
 static bool
 copy_secret_fields(pgp_key_pkt_t *dst, const pgp_key_pkt_t *src)
 {
+    bool res = false;
+
     switch (src->alg) {
     case PGP_PKA_DSA:
-        dst->material.dsa.x = src->material.dsa.x;
+        res = mpi_copy(&dst->material.dsa.x, &src->material.dsa.x);
         break;
     case PGP_PKA_RSA:
-        dst->material.rsa.d = src->material.rsa.d;
-        dst->material.rsa.p = src->material.rsa.p;
-        dst->material.rsa.q = src->material.rsa.q;
-        dst->material.rsa.u = src->material.rsa.u;
+        res = mpi_copy(&dst->material.rsa.d, &src->material.rsa.d) &&
+              mpi_copy(&dst->material.rsa.p, &src->material.rsa.p) &&
+              mpi_copy(&dst->material.rsa.q, &src->material.rsa.q) &&
+              mpi_copy(&dst->material.rsa.u, &src->material.rsa.u);
         break;
     case PGP_PKA_ELGAMAL:
-        dst->material.eg.x = src->material.eg.x;
+        res = mpi_copy(&dst->material.eg.x, &src->material.eg.x);
         break;
     case PGP_PKA_ECDSA:
     case PGP_PKA_ECDH:
     case PGP_PKA_EDDSA:
-        dst->material.ec.x = src->material.ec.x;
+        res = mpi_copy(&dst->material.ec.x, &src->material.ec.x);
         break;
     default:
         RNP_LOG("Unsupported public key algorithm: %d", (int) src->alg);
         return false;
     }
 
+    if (!res) {
+        RNP_LOG("allocation failed");
+        return false;
+    }
+
     dst->material.secret = src->material.secret;
     dst->sec_protection = src->sec_protection;
     dst->tag = is_subkey_pkt(dst->tag) ? PGP_PTAG_CT_SECRET_SUBKEY : PGP_PTAG_CT_SECRET_KEY;
@@ -1166,8 +1173,8 @@ rnp_key_store_g10_from_src(rnp_key_store_t *         key_store,
     ret = true;
 done:
     src_close(&memsrc);
+    free_key_pkt(&seckey);
     if (!ret) {
-        free_key_pkt(&seckey);
         pgp_key_free_data(&key);
     }
     return ret;
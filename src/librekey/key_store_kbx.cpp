@@ -539,7 +539,7 @@ rnp_key_store_kbx_write_pgp(rnp_key_store_t *key_store, pgp_key_t *key, pgp_dest
         goto finish;
     }
 
-    if (!pu16(&memdst, 1 + list_length(key->subkey_grips))) { // number of keys in keyblock
+    if (!pu16(&memdst, 1 + pgp_key_get_subkey_count(key))) { // number of keys in keyblock
         goto finish;
     }
     if (!pu16(&memdst, 28)) { // size of key info structure)
@@ -554,9 +554,9 @@ rnp_key_store_kbx_write_pgp(rnp_key_store_t *key_store, pgp_key_t *key, pgp_dest
     }
 
     // same as above, for each subkey
-    for (list_item *sgrip = list_front(key->subkey_grips); sgrip; sgrip = list_next(sgrip)) {
+    for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
         const pgp_key_t *subkey =
-          rnp_key_store_get_key_by_grip(key_store, (const uint8_t *) sgrip);
+          rnp_key_store_get_key_by_grip(key_store, pgp_key_get_subkey_grip(key, i));
         if (!pbuf(&memdst, pgp_key_get_fp(subkey)->fingerprint, PGP_FINGERPRINT_SIZE) ||
             !pu32(&memdst, memdst.writeb - 8) || // offset to keyid (part of fpr for V4)
             !pu16(&memdst, 0) ||                 // flags, not used by GnuPG
@@ -663,8 +663,9 @@ rnp_key_store_kbx_write_pgp(rnp_key_store_t *key_store, pgp_key_t *key, pgp_dest
         goto finish;
     }
 
-    for (list_item *sgrip = list_front(key->subkey_grips); sgrip; sgrip = list_next(sgrip)) {
-        const pgp_key_t *subkey = rnp_key_store_get_key_by_grip(key_store, (uint8_t *) sgrip);
+    for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
+        const pgp_key_t *subkey =
+          rnp_key_store_get_key_by_grip(key_store, pgp_key_get_subkey_grip(key, i));
         if (!pgp_key_write_packets(subkey, &memdst)) {
             goto finish;
         }
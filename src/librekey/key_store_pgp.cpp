@@ -56,6 +56,7 @@ __RCSID("$NetBSD: keyring.c,v 1.50 2011/06/25 00:37:44 agc Exp $");
 
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #include <rnp/rnp_sdk.h>
 #include <librepgp/stream-common.h>
@@ -77,7 +78,7 @@ static pgp_map_t ss_rr_code_map[] = {
 };
 
 static bool
-create_key_from_pkt(pgp_key_t *key, pgp_key_pkt_t *pkt)
+create_key_from_pkt(pgp_key_t *key, pgp_key_pkt_t *pkt, arena *mem, const pgp_key_ids_t *ids)
 {
     pgp_key_pkt_t keypkt = {};
 
@@ -99,14 +100,14 @@ create_key_from_pkt(pgp_key_t *key, pgp_key_pkt_t *pkt)
     }
 
     /* this call transfers ownership */
-    if (!pgp_key_from_pkt(key, &keypkt, (pgp_content_enum) pkt->tag)) {
+    if (!pgp_key_from_pkt(key, &keypkt, (pgp_content_enum) pkt->tag, ids)) {
         RNP_LOG("failed to setup key fields");
         free_key_pkt(&keypkt);
         return false;
     }
 
     /* add key rawpacket */
-    if (!pgp_key_add_key_rawpacket(key, pkt)) {
+    if (!pgp_key_add_key_rawpacket(key, pkt, mem)) {
         free_key_pkt(&keypkt);
         return false;
     }
@@ -117,7 +118,7 @@ create_key_from_pkt(pgp_key_t *key, pgp_key_pkt_t *pkt)
 }
 
 static bool
-rnp_key_add_signature(pgp_key_t *key, pgp_signature_t *sig)
+rnp_key_add_signature(pgp_key_t *key, pgp_signature_t *sig, arena *mem)
 {
     pgp_subsig_t *subsig = NULL;
     uint8_t *     algs = NULL;
@@ -129,12 +130,16 @@ rnp_key_add_signature(pgp_key_t *key, pgp_signature_t *sig)
     }
 
     /* add signature rawpacket */
-    if (!pgp_key_add_sig_rawpacket(key, sig)) {
+    if (!pgp_key_add_sig_rawpacket(key, sig, mem)) {
         return false;
     }
 
     subsig->uid = pgp_key_get_userid_count(key) - 1;
-    if (!copy_signature_packet(&subsig->sig, sig)) {
+    if (mem && sig->raw) {
+        /* signature was parsed in place from the key store arena, so just move it */
+        subsig->sig = *sig;
+        memset(sig, 0, sizeof(*sig));
+    } else if (!copy_signature_packet(&subsig->sig, sig)) {
         return false;
     }
 
@@ -204,45 +209,20 @@ rnp_key_add_signature(pgp_key_t *key, pgp_signature_t *sig)
 }
 
 static bool
-rnp_key_add_signatures(pgp_key_t *key, list signatures)
+rnp_key_add_signatures(pgp_key_t *key, list signatures, arena *mem)
 {
     for (list_item *sig = list_front(signatures); sig; sig = list_next(sig)) {
-        if (!rnp_key_add_signature(key, (pgp_signature_t *) sig)) {
+        if (!rnp_key_add_signature(key, (pgp_signature_t *) sig, mem)) {
             return false;
         }
     }
     return true;
 }
 
-bool
-rnp_key_store_add_transferable_subkey(rnp_key_store_t *          keyring,
-                                      pgp_transferable_subkey_t *tskey,
-                                      pgp_key_t *                pkey)
-{
-    pgp_key_t skey = {};
-
-    /* create subkey */
-    if (!rnp_key_from_transferable_subkey(&skey, tskey, pkey)) {
-        RNP_LOG("failed to create subkey");
-        return false;
-    }
-
-    /* add it to the storage */
-    if (!rnp_key_store_add_key(keyring, &skey)) {
-        RNP_LOG("Failed to add subkey to key store.");
-        goto error;
-    }
-
-    return true;
-error:
-    pgp_key_free_data(&skey);
-    return false;
-}
-
-bool
-rnp_key_add_transferable_userid(pgp_key_t *key, pgp_transferable_userid_t *uid)
+static bool
+rnp_key_add_userid(pgp_key_t *key, pgp_transferable_userid_t *uid, arena *mem)
 {
-    if (!pgp_key_add_uid_rawpacket(key, &uid->uid)) {
+    if (!pgp_key_add_uid_rawpacket(key, &uid->uid, mem)) {
         return false;
     }
 
@@ -272,113 +252,194 @@ rnp_key_add_transferable_userid(pgp_key_t *key, pgp_transferable_userid_t *uid)
         return false;
     }
 
-    if (!rnp_key_add_signatures(key, uid->signatures)) {
+    if (!rnp_key_add_signatures(key, uid->signatures, mem)) {
         return false;
     }
 
     return true;
 }
 
-bool
-rnp_key_store_add_transferable_key(rnp_key_store_t *keyring, pgp_transferable_key_t *tkey)
+/* raw packets are allocated from mem if it is not NULL, so mem must outlive the key.
+ * ids, if not NULL, are precalculated fingerprint and grip of the key. */
+static bool
+key_from_transferable_key(pgp_key_t *             key,
+                          pgp_transferable_key_t *tkey,
+                          arena *                 mem,
+                          const pgp_key_ids_t *   ids)
 {
-    pgp_key_t  key = {};
-    pgp_key_t *addkey = NULL;
-
-    /* create key from transferable key */
-    if (!rnp_key_from_transferable_key(&key, tkey)) {
-        RNP_LOG("failed to create key");
+    memset(key, 0, sizeof(*key));
+    /* create key */
+    if (!create_key_from_pkt(key, &tkey->key, mem, ids)) {
         return false;
     }
 
-    /* add key to the storage before subkeys */
-    if (!(addkey = rnp_key_store_add_key(keyring, &key))) {
-        RNP_LOG("Failed to add key to key store.");
+    /* add direct-key signatures */
+    if (!rnp_key_add_signatures(key, tkey->signatures, mem)) {
         goto error;
     }
 
-    /* add subkeys */
-    for (list_item *skey = list_front(tkey->subkeys); skey; skey = list_next(skey)) {
-        pgp_transferable_subkey_t *subkey = (pgp_transferable_subkey_t *) skey;
-        if (!rnp_key_store_add_transferable_subkey(keyring, subkey, addkey)) {
+    /* add userids and their signatures */
+    for (list_item *uid = list_front(tkey->userids); uid; uid = list_next(uid)) {
+        pgp_transferable_userid_t *tuid = (pgp_transferable_userid_t *) uid;
+        if (!rnp_key_add_userid(key, tuid, mem)) {
             goto error;
         }
     }
 
     return true;
 error:
-    if (addkey) {
-        /* during key addition all fields are copied so will be cleaned below */
-        rnp_key_store_remove_key(keyring, addkey);
-        pgp_key_free_data(addkey);
-    } else {
-        pgp_key_free_data(&key);
-    }
+    pgp_key_free_data(key);
     return false;
 }
 
-bool
-rnp_key_from_transferable_key(pgp_key_t *key, pgp_transferable_key_t *tkey)
+static bool
+key_from_transferable_subkey(pgp_key_t *                subkey,
+                             pgp_transferable_subkey_t *tskey,
+                             pgp_key_t *                primary,
+                             arena *                    mem,
+                             const pgp_key_ids_t *      ids)
 {
-    memset(key, 0, sizeof(*key));
+    memset(subkey, 0, sizeof(*subkey));
+
     /* create key */
-    if (!create_key_from_pkt(key, &tkey->key)) {
+    if (!create_key_from_pkt(subkey, &tskey->subkey, mem, ids)) {
         return false;
     }
 
-    /* add direct-key signatures */
-    if (!rnp_key_add_signatures(key, tkey->signatures)) {
+    /* add subkey binding signatures */
+    if (!rnp_key_add_signatures(subkey, tskey->signatures, mem)) {
+        RNP_LOG("failed to add subkey signatures");
         goto error;
     }
 
-    /* add userids and their signatures */
-    for (list_item *uid = list_front(tkey->userids); uid; uid = list_next(uid)) {
-        pgp_transferable_userid_t *tuid = (pgp_transferable_userid_t *) uid;
-        if (!rnp_key_add_transferable_userid(key, tuid)) {
-            goto error;
-        }
+    /* setup key grips if primary is available */
+    if (primary && !pgp_key_link_subkey_grip(primary, subkey)) {
+        goto error;
+    }
+    return true;
+error:
+    pgp_key_free_data(subkey);
+    return false;
+}
+
+static bool
+add_transferable_subkey(rnp_key_store_t *          keyring,
+                        pgp_transferable_subkey_t *tskey,
+                        pgp_key_t *                pkey,
+                        const pgp_key_ids_t *      ids)
+{
+    pgp_key_t skey = {};
+
+    /* create subkey, keeping its raw packets in the key store arena */
+    if (!key_from_transferable_subkey(&skey, tskey, pkey, &keyring->packets, ids)) {
+        RNP_LOG("failed to create subkey");
+        return false;
+    }
+
+    /* add it to the storage */
+    if (!rnp_key_store_add_key(keyring, &skey)) {
+        RNP_LOG("Failed to add subkey to key store.");
+        goto error;
     }
 
     return true;
 error:
-    pgp_key_free_data(key);
+    pgp_key_free_data(&skey);
     return false;
 }
 
 bool
-rnp_key_from_transferable_subkey(pgp_key_t *                subkey,
-                                 pgp_transferable_subkey_t *tskey,
-                                 pgp_key_t *                primary)
+rnp_key_store_add_transferable_subkey(rnp_key_store_t *          keyring,
+                                      pgp_transferable_subkey_t *tskey,
+                                      pgp_key_t *                pkey)
 {
-    memset(subkey, 0, sizeof(*subkey));
+    return add_transferable_subkey(keyring, tskey, pkey, NULL);
+}
 
-    /* create key */
-    if (!create_key_from_pkt(subkey, &tskey->subkey)) {
+bool
+rnp_key_add_transferable_userid(pgp_key_t *key, pgp_transferable_userid_t *uid)
+{
+    return rnp_key_add_userid(key, uid, NULL);
+}
+
+/* ids, if not NULL, are for the primary key followed by the ones for each of subkeys */
+static bool
+add_transferable_key(rnp_key_store_t *       keyring,
+                     pgp_transferable_key_t *tkey,
+                     const pgp_key_ids_t *   ids)
+{
+    pgp_key_t  key = {};
+    pgp_key_t *addkey = NULL;
+
+    /* drop the excess certifications of the flooded key before doing anything else */
+    size_t dropped = transferable_key_limit_certifications(tkey, keyring->cert_limit, NULL, 0);
+    if (dropped) {
+        RNP_LOG("warning: skipped %zu third-party certifications over the limit", dropped);
+    }
+
+    /* create key from transferable key, keeping its raw packets in the key store arena */
+    if (!key_from_transferable_key(&key, tkey, &keyring->packets, ids)) {
+        RNP_LOG("failed to create key");
         return false;
     }
 
-    /* add subkey binding signatures */
-    if (!rnp_key_add_signatures(subkey, tskey->signatures)) {
-        RNP_LOG("failed to add subkey signatures");
+    /* add key to the storage before subkeys */
+    if (!(addkey = rnp_key_store_add_key(keyring, &key))) {
+        RNP_LOG("Failed to add key to key store.");
         goto error;
     }
 
-    /* setup key grips if primary is available */
-    if (primary && !pgp_key_link_subkey_grip(primary, subkey)) {
-        goto error;
+    /* add subkeys */
+    for (list_item *skey = list_front(tkey->subkeys); skey; skey = list_next(skey)) {
+        pgp_transferable_subkey_t *subkey = (pgp_transferable_subkey_t *) skey;
+        if (ids) {
+            ids++;
+        }
+        if (!add_transferable_subkey(keyring, subkey, addkey, ids)) {
+            goto error;
+        }
     }
+
     return true;
 error:
-    pgp_key_free_data(subkey);
+    if (addkey) {
+        /* during key addition all fields are copied so will be cleaned below */
+        pgp_key_free_data(addkey);
+        rnp_key_store_remove_key(keyring, addkey);
+    } else {
+        pgp_key_free_data(&key);
+    }
     return false;
 }
 
+bool
+rnp_key_store_add_transferable_key(rnp_key_store_t *keyring, pgp_transferable_key_t *tkey)
+{
+    return add_transferable_key(keyring, tkey, NULL);
+}
+
+bool
+rnp_key_from_transferable_key(pgp_key_t *key, pgp_transferable_key_t *tkey)
+{
+    return key_from_transferable_key(key, tkey, NULL, NULL);
+}
+
+bool
+rnp_key_from_transferable_subkey(pgp_key_t *                subkey,
+                                 pgp_transferable_subkey_t *tskey,
+                                 pgp_key_t *                primary)
+{
+    return key_from_transferable_subkey(subkey, tskey, primary, NULL, NULL);
+}
+
 rnp_result_t
 rnp_key_store_pgp_read_from_src(rnp_key_store_t *keyring, pgp_source_t *src)
 {
-    pgp_key_sequence_t        keys = {};
-    pgp_transferable_subkey_t tskey = {};
-    rnp_result_t              ret = RNP_ERROR_GENERIC;
+    pgp_key_sequence_t         keys = {};
+    pgp_transferable_subkey_t  tskey = {};
+    rnp_result_t               ret = RNP_ERROR_GENERIC;
+    std::vector<pgp_key_ids_t> ids;
+    size_t                     idx = 0;
 
     /* check whether we have transferable subkey in source */
     if (is_subkey_pkt(stream_pkt_type(src))) {
@@ -392,16 +453,40 @@ rnp_key_store_pgp_read_from_src(rnp_key_store_t *keyring, pgp_source_t *src)
         return ret;
     }
 
-    /* process armored or raw transferable key packets sequence(s) */
-    if ((ret = process_pgp_keys(src, &keys))) {
+    /* process armored or raw transferable key packets sequence(s), signatures are parsed
+     * in place from the key store arena and then moved to the keys */
+    if ((ret = process_pgp_keys_arena(src, &keys, &keyring->packets))) {
         return ret;
     }
 
+    /* fingerprints and grips of all keys are calculated at once, allowing batched hashing */
+    try {
+        std::vector<const pgp_key_pkt_t *> pkts;
+        for (list_item *key = list_front(keys.keys); key; key = list_next(key)) {
+            pgp_transferable_key_t *tkey = (pgp_transferable_key_t *) key;
+            pkts.push_back(&tkey->key);
+            for (list_item *sub = list_front(tkey->subkeys); sub; sub = list_next(sub)) {
+                pkts.push_back(&((pgp_transferable_subkey_t *) sub)->subkey);
+            }
+        }
+        ids.resize(pkts.size());
+        if (!pgp_key_ids_batch(pkts.data(), pkts.size(), ids.data())) {
+            /* fall back to per-key calculation, reporting the error there */
+            ids.clear();
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        ids.clear();
+    }
+
     for (list_item *key = list_front(keys.keys); key; key = list_next(key)) {
-        if (!rnp_key_store_add_transferable_key(keyring, (pgp_transferable_key_t *) key)) {
+        pgp_transferable_key_t *tkey = (pgp_transferable_key_t *) key;
+        const pgp_key_ids_t *   kids = ids.empty() ? NULL : &ids[idx];
+        if (!add_transferable_key(keyring, tkey, kids)) {
             ret = RNP_ERROR_BAD_STATE;
             goto done;
         }
+        idx += 1 + list_length(tkey->subkeys);
     }
 
     ret = RNP_SUCCESS;
@@ -463,11 +548,10 @@ do_write(rnp_key_store_t *key_store, pgp_dest_t *dst, bool secret)
         if (!rnp_key_write_packets_stream(key, dst)) {
             return false;
         }
-        for (list_item *subkey_grip = list_front(key->subkey_grips); subkey_grip;
-             subkey_grip = list_next(subkey_grip)) {
+        for (size_t i = 0; i < pgp_key_get_subkey_count(key); i++) {
             pgp_key_search_t search = {};
             search.type = PGP_KEY_SEARCH_GRIP;
-            memcpy(search.by.grip, (uint8_t *) subkey_grip, PGP_KEY_GRIP_SIZE);
+            memcpy(search.by.grip, pgp_key_get_subkey_grip(key, i), PGP_KEY_GRIP_SIZE);
             pgp_key_t *subkey = NULL;
             for (list_item *subkey_item = list_front(rnp_key_store_get_keys(key_store));
                  subkey_item;
@@ -39,6 +39,10 @@
 #include <stdlib.h>
 #include <dirent.h>
 #include <errno.h>
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include <rnp/rnp_sdk.h>
 #include <rekey/rnp_key_store.h>
@@ -67,9 +71,11 @@ rnp_key_store_new(pgp_key_store_format_t format, const char *path)
         return NULL;
     }
 
-    rnp_key_store_t *key_store = (rnp_key_store_t *) calloc(1, sizeof(*key_store));
-    if (!key_store) {
-        RNP_LOG("Can't allocate memory");
+    rnp_key_store_t *key_store = NULL;
+    try {
+        key_store = new rnp_key_store_t();
+    } catch (const std::exception &e) {
+        RNP_LOG("Can't allocate memory: %s", e.what());
         return NULL;
     }
 
@@ -103,7 +109,7 @@ rnp_key_store_load_from_path(rnp_key_store_t *         key_store,
             snprintf(path, sizeof(path), "%s/%s", key_store->path, ent->d_name);
             RNP_DLOG("Loading G10 key from file '%s'", path);
 
-            if (init_file_src(&src, path)) {
+            if (init_file_or_mmap_src(&src, path)) {
                 RNP_LOG("failed to read file %s", path);
                 continue;
             }
@@ -118,8 +124,8 @@ rnp_key_store_load_from_path(rnp_key_store_t *         key_store,
         return true;
     }
 
-    /* init file source and load from it */
-    if (init_file_src(&src, key_store->path)) {
+    /* init file source and load from it, mapping the file when possible */
+    if (init_file_or_mmap_src(&src, key_store->path)) {
         RNP_LOG("failed to read file %s", key_store->path);
         return false;
     }
@@ -247,6 +253,15 @@ rnp_key_store_clear(rnp_key_store_t *keyring)
         pgp_key_free_data((pgp_key_t *) key);
     }
     list_destroy(&keyring->keys);
+    arena_destroy(&keyring->packets);
+    keyring->keyseq.clear();
+    keyring->keybygrip.clear();
+    keyring->keybyfp.clear();
+    keyring->keybyid.clear();
+    keyring->keybyshortid.clear();
+    keyring->orphans.clear();
+    keyring->orphansbyfp.clear();
+    keyring->orphansbyid.clear();
 
     for (list_item *item = list_front(keyring->blobs); item; item = list_next(item)) {
         kbx_blob_t *blob = *((kbx_blob_t **) item);
@@ -268,7 +283,7 @@ rnp_key_store_free(rnp_key_store_t *keyring)
 
     rnp_key_store_clear(keyring);
     free((void *) keyring->path);
-    free(keyring);
+    delete keyring;
 }
 
 size_t
@@ -289,6 +304,127 @@ rnp_key_store_get_keys(const rnp_key_store_t *keyring)
     return keyring->keys;
 }
 
+static pgp_key_grip_t
+key_grip_ident(const uint8_t *grip)
+{
+    pgp_key_grip_t res;
+    memcpy(res.data(), grip, res.size());
+    return res;
+}
+
+static pgp_key_id_t
+key_id_ident(const uint8_t *keyid)
+{
+    pgp_key_id_t res;
+    memcpy(res.data(), keyid, res.size());
+    return res;
+}
+
+static pgp_key_short_id_t
+key_short_id_ident(const uint8_t *shortid)
+{
+    pgp_key_short_id_t res;
+    memcpy(res.data(), shortid, res.size());
+    return res;
+}
+
+static void
+key_bucket_remove(pgp_key_bucket_t &bucket, const pgp_key_t *key)
+{
+    for (auto it = bucket.begin(); it != bucket.end(); it++) {
+        if (*it == key) {
+            bucket.erase(it);
+            return;
+        }
+    }
+}
+
+template <typename T, typename K>
+static void
+key_index_remove(T &index, const K &ident, const pgp_key_t *key)
+{
+    auto it = index.find(ident);
+    if (it == index.end()) {
+        return;
+    }
+    key_bucket_remove(it->second, key);
+    if (it->second.empty()) {
+        index.erase(it);
+    }
+}
+
+static bool
+rnp_key_store_index_key(rnp_key_store_t *keyring, pgp_key_t *key)
+{
+    const uint8_t *keyid = pgp_key_get_keyid(key);
+    try {
+        keyring->keyseq[key] = keyring->nextseq++;
+        keyring->keybygrip[key_grip_ident(pgp_key_get_grip(key))] = key;
+        keyring->keybyfp[*pgp_key_get_fp(key)].push_back(key);
+        keyring->keybyid[key_id_ident(keyid)].push_back(key);
+        keyring->keybyshortid[key_short_id_ident(keyid + PGP_KEY_ID_SIZE / 2)].push_back(key);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+    return true;
+}
+
+static void
+rnp_key_store_unindex_key(rnp_key_store_t *keyring, const pgp_key_t *key)
+{
+    const uint8_t *keyid = pgp_key_get_keyid(key);
+    auto           git = keyring->keybygrip.find(key_grip_ident(pgp_key_get_grip(key)));
+    if ((git != keyring->keybygrip.end()) && (git->second == key)) {
+        keyring->keybygrip.erase(git);
+    }
+    key_index_remove(keyring->keybyfp, *pgp_key_get_fp(key), key);
+    key_index_remove(keyring->keybyid, key_id_ident(keyid), key);
+    key_index_remove(
+      keyring->keybyshortid, key_short_id_ident(keyid + PGP_KEY_ID_SIZE / 2), key);
+    keyring->keyseq.erase(key);
+}
+
+/* position of the key in keyring's keys list, or 0 if after is NULL */
+static uint64_t
+rnp_key_store_key_seq(const rnp_key_store_t *keyring, const pgp_key_t *after)
+{
+    if (!after) {
+        return 0;
+    }
+    auto it = keyring->keyseq.find(after);
+    assert(it != keyring->keyseq.end());
+    return it == keyring->keyseq.end() ? UINT64_MAX : it->second + 1;
+}
+
+/* first key from the bucket, placed not earlier than seq in the keys list */
+static pgp_key_t *
+key_bucket_next(const rnp_key_store_t * keyring,
+                const pgp_key_bucket_t *bucket,
+                uint64_t                seq,
+                uint64_t *              keyseq)
+{
+    if (!bucket) {
+        return NULL;
+    }
+    for (pgp_key_t *key : *bucket) {
+        uint64_t kseq = keyring->keyseq.at(key);
+        if (kseq >= seq) {
+            *keyseq = kseq;
+            return key;
+        }
+    }
+    return NULL;
+}
+
+template <typename T, typename K>
+static const pgp_key_bucket_t *
+key_index_bucket(const T &index, const K &ident)
+{
+    auto it = index.find(ident);
+    return it == index.end() ? NULL : &it->second;
+}
+
 static bool
 rnp_key_store_merge_subkey(pgp_key_t *dst, const pgp_key_t *src, pgp_key_t *primary)
 {
@@ -340,11 +476,12 @@ done:
 }
 
 static bool
-rnp_key_store_merge_key(pgp_key_t *dst, const pgp_key_t *src)
+rnp_key_store_merge_key(pgp_key_t *dst, const pgp_key_t *src, size_t cert_limit)
 {
     pgp_transferable_key_t dstkey = {};
     pgp_transferable_key_t srckey = {};
     pgp_key_t              tmpkey = {};
+    std::vector<size_t>    keep;
     bool                   res = false;
 
     if (pgp_key_is_subkey(dst) || pgp_key_is_subkey(src)) {
@@ -371,10 +508,23 @@ rnp_key_store_merge_key(pgp_key_t *dst, const pgp_key_t *src)
         /* no subkey processing here - they are separated from the main key */
     }
 
+    /* merge appends new signatures, so existing ones are the first ones of each userid */
+    try {
+        for (list_item *uid = list_front(dstkey.userids); cert_limit && uid;
+             uid = list_next(uid)) {
+            keep.push_back(list_length(((pgp_transferable_userid_t *) uid)->signatures));
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        goto done;
+    }
+
     if (transferable_key_merge(&dstkey, &srckey)) {
         RNP_LOG("failed to merge transferable keys");
         goto done;
     }
+    /* existing signatures are never dropped, new certifications are added below the limit */
+    transferable_key_limit_certifications(&dstkey, cert_limit, keep.data(), keep.size());
 
     if (!rnp_key_from_transferable_key(&tmpkey, &dstkey)) {
         RNP_LOG("failed to process key");
@@ -383,9 +533,9 @@ rnp_key_store_merge_key(pgp_key_t *dst, const pgp_key_t *src)
 
     /* move existing subkey grips since they are not present in transferable key */
     tmpkey.subkey_grips = dst->subkey_grips;
-    dst->subkey_grips = NULL;
-    for (list_item *li = list_front(src->subkey_grips); li; li = list_next(li)) {
-        if (!pgp_key_add_subkey_grip(&tmpkey, (uint8_t *) li)) {
+    memset(&dst->subkey_grips, 0, sizeof(dst->subkey_grips));
+    for (size_t i = 0; i < pgp_key_get_subkey_count(src); i++) {
+        if (!pgp_key_add_subkey_grip(&tmpkey, pgp_key_get_subkey_grip(src, i))) {
             RNP_LOG("failed to add subkey grip");
         }
     }
@@ -399,51 +549,98 @@ done:
     return res;
 }
 
+static void
+rnp_key_store_remove_orphan(rnp_key_store_t *keyring, const pgp_key_t *subkey)
+{
+    auto it = keyring->orphans.find(subkey);
+    if (it == keyring->orphans.end()) {
+        return;
+    }
+    for (auto &fp : it->second.fps) {
+        key_index_remove(keyring->orphansbyfp, fp, subkey);
+    }
+    for (auto &keyid : it->second.keyids) {
+        key_index_remove(keyring->orphansbyid, keyid, subkey);
+    }
+    keyring->orphans.erase(it);
+}
+
+/* register subkey without primary_grip so it may be linked once primary key is added */
 static bool
-rnp_key_store_refresh_subkey_grips(rnp_key_store_t *keyring, pgp_key_t *key)
+rnp_key_store_add_orphan(rnp_key_store_t *keyring, pgp_key_t *subkey)
 {
     uint8_t           keyid[PGP_KEY_ID_SIZE] = {0};
     pgp_fingerprint_t keyfp = {};
 
-    if (pgp_key_is_subkey(key)) {
-        RNP_LOG("wrong argument");
-        return false;
+    if (!pgp_key_is_subkey(subkey) || pgp_key_get_primary_grip(subkey)) {
+        return true;
     }
 
-    for (list_item *ki = list_front(rnp_key_store_get_keys(keyring)); ki; ki = list_next(ki)) {
-        pgp_key_t *skey = (pgp_key_t *) ki;
-        bool       found = false;
-
-        /* if we have primary_grip then we also added to subkey_grips */
-        if (!pgp_key_is_subkey(skey) || pgp_key_get_primary_grip(skey)) {
-            continue;
-        }
-
-        for (unsigned i = 0; i < pgp_key_get_subsig_count(skey); i++) {
-            pgp_subsig_t *subsig = pgp_key_get_subsig(skey, i);
-
+    try {
+        pgp_subkey_issuers_t &issuers = keyring->orphans[subkey];
+        for (unsigned i = 0; i < pgp_key_get_subsig_count(subkey); i++) {
+            pgp_subsig_t *subsig = pgp_key_get_subsig(subkey, i);
             if (subsig->sig.type != PGP_SIG_SUBKEY) {
                 continue;
             }
-
-            if (signature_get_keyfp(&subsig->sig, &keyfp) &&
-                fingerprint_equal(pgp_key_get_fp(key), &keyfp)) {
-                found = true;
-                break;
+            if (signature_get_keyfp(&subsig->sig, &keyfp)) {
+                issuers.fps.push_back(keyfp);
+                keyring->orphansbyfp[keyfp].push_back(subkey);
+            }
+            if (signature_get_keyid(&subsig->sig, keyid)) {
+                issuers.keyids.push_back(key_id_ident(keyid));
+                keyring->orphansbyid[key_id_ident(keyid)].push_back(subkey);
             }
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        rnp_key_store_remove_orphan(keyring, subkey);
+        return false;
+    }
+    return true;
+}
+
+/* link primary key with subkeys, which were added to the keyring before it */
+static bool
+rnp_key_store_refresh_subkey_grips(rnp_key_store_t *keyring, pgp_key_t *key)
+{
+    if (pgp_key_is_subkey(key)) {
+        RNP_LOG("wrong argument");
+        return false;
+    }
 
-            if (signature_get_keyid(&subsig->sig, keyid) &&
-                !memcmp(pgp_key_get_keyid(key), keyid, PGP_KEY_ID_SIZE)) {
-                found = true;
-                break;
+    /* keep the keys list order, as subkeys were linked before */
+    std::vector<std::pair<uint64_t, pgp_key_t *>> found;
+    const pgp_key_bucket_t *byfp =
+      key_index_bucket(keyring->orphansbyfp, *pgp_key_get_fp(key));
+    const pgp_key_bucket_t *byid =
+      key_index_bucket(keyring->orphansbyid, key_id_ident(pgp_key_get_keyid(key)));
+    try {
+        for (const pgp_key_bucket_t *bucket : {byfp, byid}) {
+            if (!bucket) {
+                continue;
+            }
+            for (pgp_key_t *skey : *bucket) {
+                found.push_back({keyring->keyseq.at(skey), skey});
             }
         }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+    std::sort(found.begin(), found.end());
 
-        if (found && !pgp_key_link_subkey_grip(key, skey)) {
+    for (auto &orphan : found) {
+        pgp_key_t *skey = orphan.second;
+        /* subkey may be found by both fingerprint and keyid */
+        if (pgp_key_get_primary_grip(skey)) {
+            continue;
+        }
+        rnp_key_store_remove_orphan(keyring, skey);
+        if (!pgp_key_link_subkey_grip(key, skey)) {
             return false;
         }
     }
-
     return true;
 }
 
@@ -467,6 +664,8 @@ rnp_key_store_add_key(rnp_key_store_t *keyring, pgp_key_t *srckey)
         bool mergeres = false;
         /* in case we already have key let's merge it in */
         if (pgp_key_is_subkey(added_key)) {
+            /* binding signatures may change so orphan will be registered again below */
+            rnp_key_store_remove_orphan(keyring, added_key);
             pgp_key_t *primary = rnp_key_store_get_primary_key(keyring, added_key);
             if (!primary) {
                 primary = rnp_key_store_get_primary_key(keyring, srckey);
@@ -475,8 +674,11 @@ rnp_key_store_add_key(rnp_key_store_t *keyring, pgp_key_t *srckey)
                 RNP_LOG("no primary key for subkey");
             }
             mergeres = rnp_key_store_merge_subkey(added_key, srckey, primary);
+            if (!rnp_key_store_add_orphan(keyring, added_key)) {
+                RNP_LOG("failed to register orphaned subkey");
+            }
         } else {
-            mergeres = rnp_key_store_merge_key(added_key, srckey);
+            mergeres = rnp_key_store_merge_key(added_key, srckey, keyring->cert_limit);
         }
 
         if (!mergeres) {
@@ -493,11 +695,20 @@ rnp_key_store_add_key(rnp_key_store_t *keyring, pgp_key_t *srckey)
             RNP_LOG("allocation failed");
             return NULL;
         }
+        if (!rnp_key_store_index_key(keyring, added_key)) {
+            rnp_key_store_unindex_key(keyring, added_key);
+            list_remove((list_item *) added_key);
+            RNP_LOG("failed to index key");
+            return NULL;
+        }
         /* primary key may be added after subkeys, so let's handle this case correctly */
         if (pgp_key_is_primary_key(added_key) &&
             !rnp_key_store_refresh_subkey_grips(keyring, added_key)) {
             RNP_LOG("failed to refresh subkey grips");
         }
+        if (!rnp_key_store_add_orphan(keyring, added_key)) {
+            RNP_LOG("failed to register orphaned subkey");
+        }
     }
 
     RNP_DLOG("keyc %lu", (long unsigned) rnp_key_store_get_key_count(keyring));
@@ -507,9 +718,9 @@ rnp_key_store_add_key(rnp_key_store_t *keyring, pgp_key_t *srckey)
 
         /* validate/re-validate all subkeys as well */
         if (pgp_key_is_primary_key(added_key)) {
-            for (list_item *grip = list_front(added_key->subkey_grips); grip;
-                 grip = list_next(grip)) {
-                pgp_key_t *subkey = rnp_key_store_get_key_by_grip(keyring, (uint8_t *) grip);
+            for (size_t i = 0; i < pgp_key_get_subkey_count(added_key); i++) {
+                pgp_key_t *subkey = rnp_key_store_get_key_by_grip(
+                  keyring, pgp_key_get_subkey_grip(added_key, i));
                 if (subkey) {
                     pgp_key_validate(subkey, keyring);
                 }
@@ -520,6 +731,40 @@ rnp_key_store_add_key(rnp_key_store_t *keyring, pgp_key_t *srckey)
     return added_key;
 }
 
+void
+rnp_key_store_validate(rnp_key_store_t *keyring, size_t threads)
+{
+    std::vector<pgp_key_t *>        keys;
+    std::unordered_set<pgp_key_t *> revalidated;
+
+    try {
+        for (list_item *li = list_front(keyring->keys); li; li = list_next(li)) {
+            pgp_key_t *key = (pgp_key_t *) li;
+            if (!pgp_key_is_subkey(key) && !key->validated) {
+                keys.push_back(key);
+                revalidated.insert(key);
+            }
+        }
+        /* subkey validity depends on the primary key's one */
+        for (list_item *li = list_front(keyring->keys); li; li = list_next(li)) {
+            pgp_key_t *key = (pgp_key_t *) li;
+            if (!pgp_key_is_subkey(key)) {
+                continue;
+            }
+            pgp_key_t *primary =
+              rnp_key_store_get_key_by_grip(keyring, pgp_key_get_primary_grip(key));
+            if (!key->validated || revalidated.count(primary)) {
+                keys.push_back(key);
+            }
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return;
+    }
+
+    pgp_key_validate_batch(keys.data(), keys.size(), keyring, threads);
+}
+
 pgp_key_t *
 rnp_key_store_import_key(rnp_key_store_t *        keyring,
                          pgp_key_t *              srckey,
@@ -561,6 +806,8 @@ rnp_key_store_remove_key(rnp_key_store_t *keyring, const pgp_key_t *key)
     if (!list_is_member(keyring->keys, (list_item *) key)) {
         return false;
     }
+    rnp_key_store_unindex_key(keyring, key);
+    rnp_key_store_remove_orphan(keyring, key);
     list_remove((list_item *) key);
     return true;
 }
@@ -592,21 +839,22 @@ rnp_key_store_get_key_by_id(const rnp_key_store_t *keyring,
 
     // if after is provided, make sure it is a member of the appropriate list
     assert(!after || list_is_member(keyring->keys, (list_item *) after));
-
-    for (list_item *key_item = after ? list_next((list_item *) after) :
-                                       list_front(keyring->keys);
-         key_item;
-         key_item = list_next(key_item)) {
-        pgp_key_t *key = (pgp_key_t *) key_item;
-        RNP_DHEX("keyring keyid", pgp_key_get_keyid(key), PGP_KEY_ID_SIZE);
-        RNP_DHEX("keyid", keyid, PGP_KEY_ID_SIZE);
-        if (memcmp(pgp_key_get_keyid(key), keyid, PGP_KEY_ID_SIZE) == 0 ||
-            memcmp(pgp_key_get_keyid(key) + PGP_KEY_ID_SIZE / 2, keyid, PGP_KEY_ID_SIZE / 2) ==
-              0) {
-            return key;
-        }
+    RNP_DHEX("keyid", keyid, PGP_KEY_ID_SIZE);
+
+    /* keyid may be either full 8-byte key id, or 4-byte short id in the first bytes */
+    const pgp_key_bucket_t *idkeys = key_index_bucket(keyring->keybyid, key_id_ident(keyid));
+    const pgp_key_bucket_t *shortkeys =
+      key_index_bucket(keyring->keybyshortid, key_short_id_ident(keyid));
+    uint64_t   seq = rnp_key_store_key_seq(keyring, after);
+    uint64_t   idseq = 0;
+    uint64_t   shortseq = 0;
+    pgp_key_t *idkey = key_bucket_next(keyring, idkeys, seq, &idseq);
+    pgp_key_t *shortkey = key_bucket_next(keyring, shortkeys, seq, &shortseq);
+
+    if (!idkey || (shortkey && (shortseq < idseq))) {
+        return shortkey;
     }
-    return NULL;
+    return idkey;
 }
 
 pgp_key_t *
@@ -617,29 +865,17 @@ rnp_key_store_get_key_by_grip(const rnp_key_store_t *keyring, const uint8_t *gri
     if (!grip) {
         return NULL;
     }
+    RNP_DHEX("looking for grip", grip, PGP_KEY_GRIP_SIZE);
 
-    for (list_item *key_item = list_front(keyring->keys); key_item;
-         key_item = list_next(key_item)) {
-        pgp_key_t *key = (pgp_key_t *) key_item;
-        RNP_DHEX("looking for grip", grip, PGP_KEY_GRIP_SIZE);
-        RNP_DHEX("key grip", pgp_key_get_grip(key), PGP_KEY_GRIP_SIZE);
-
-        if (memcmp(pgp_key_get_grip(key), grip, PGP_KEY_GRIP_SIZE) == 0) {
-            return key;
-        }
-    }
-    return NULL;
+    auto it = keyring->keybygrip.find(key_grip_ident(grip));
+    return it == keyring->keybygrip.end() ? NULL : it->second;
 }
 
 pgp_key_t *
 rnp_key_store_get_key_by_fpr(const rnp_key_store_t *keyring, const pgp_fingerprint_t *fpr)
 {
-    for (list_item *key = list_front(keyring->keys); key; key = list_next(key)) {
-        if (fingerprint_equal(pgp_key_get_fp((pgp_key_t *) key), fpr)) {
-            return (pgp_key_t *) key;
-        }
-    }
-    return NULL;
+    auto it = keyring->keybyfp.find(*fpr);
+    return it == keyring->keybyfp.end() ? NULL : it->second.front();
 }
 
 pgp_key_t *
@@ -674,62 +910,68 @@ rnp_key_store_get_primary_key(const rnp_key_store_t *keyring, const pgp_key_t *s
     return NULL;
 }
 
+/* grip data is accumulated in the string so many grips may be hashed in a batch */
 static bool
-grip_hash_mpi(pgp_hash_t *hash, const pgp_mpi_t *val, const char name, bool lzero)
+grip_hash_buf(std::string &data, const uint8_t *val, size_t len, const char name, bool lzero)
 {
-    size_t len;
     size_t idx;
     char   buf[20] = {0};
 
-    len = mpi_bytes(val);
-    for (idx = 0; (idx < len) && (val->mpi[idx] == 0); idx++)
+    for (idx = 0; (idx < len) && (val[idx] == 0); idx++)
         ;
 
     if (name) {
         size_t hlen = idx >= len ? 0 : len - idx;
-        if ((len > idx) && lzero && (val->mpi[idx] & 0x80)) {
+        if ((len > idx) && lzero && (val[idx] & 0x80)) {
             hlen++;
         }
 
         snprintf(buf, sizeof(buf), "(1:%c%zu:", name, hlen);
-        pgp_hash_add(hash, buf, strlen(buf));
+        data.append(buf);
     }
 
     if (idx < len) {
         /* gcrypt prepends mpis with zero if hihger bit is set */
-        if (lzero && (val->mpi[idx] & 0x80)) {
-            buf[0] = '\0';
-            pgp_hash_add(hash, buf, 1);
+        if (lzero && (val[idx] & 0x80)) {
+            data.push_back('\0');
         }
-        pgp_hash_add(hash, val->mpi + idx, len - idx);
+        data.append((const char *) val + idx, len - idx);
     }
 
     if (name) {
-        pgp_hash_add(hash, ")", 1);
+        data.push_back(')');
     }
 
     return true;
 }
 
 static bool
-grip_hash_ecc_hex(pgp_hash_t *hash, const char *hex, char name)
+grip_hash_mpi(std::string &data, const pgp_mpi_t *val, const char name, bool lzero)
+{
+    return grip_hash_buf(data, val->mpi, mpi_bytes(val), name, lzero);
+}
+
+static bool
+grip_hash_ecc_hex(std::string &data, const char *hex, char name)
 {
-    pgp_mpi_t mpi = {};
+    uint8_t buf[MAX_CURVE_BYTELEN * 2 + 1];
+    size_t  len = 0;
 
-    if (!hex2bin(hex, strlen(hex), mpi.mpi, sizeof(mpi.mpi), &mpi.len)) {
+    if (!hex2bin(hex, strlen(hex), buf, sizeof(buf), &len)) {
         RNP_LOG("wrong hex mpi");
         return false;
     }
 
     /* libgcrypt doesn't add leading zero when hashes ecc mpis */
-    return grip_hash_mpi(hash, &mpi, name, false);
+    return grip_hash_buf(data, buf, len, name, false);
 }
 
 static bool
-grip_hash_ec(pgp_hash_t *hash, const pgp_ec_key_t *key)
+grip_hash_ec(std::string &data, const pgp_ec_key_t *key)
 {
     const ec_curve_desc_t *desc = get_curve_desc(key->curve);
-    pgp_mpi_t              g = {};
+    uint8_t                g[MAX_CURVE_BYTELEN * 2 + 1];
+    size_t                 glen = 0;
     size_t                 len = 0;
     bool                   res = false;
 
@@ -739,86 +981,100 @@ grip_hash_ec(pgp_hash_t *hash, const pgp_ec_key_t *key)
     }
 
     /* build uncompressed point from gx and gy */
-    g.mpi[0] = 0x04;
-    g.len = 1;
-    if (!hex2bin(desc->gx, strlen(desc->gx), g.mpi + g.len, sizeof(g.mpi) - g.len, &len)) {
+    g[0] = 0x04;
+    glen = 1;
+    if (!hex2bin(desc->gx, strlen(desc->gx), g + glen, sizeof(g) - glen, &len)) {
         RNP_LOG("wrong x mpi");
         return false;
     }
-    g.len += len;
-    if (!hex2bin(desc->gy, strlen(desc->gy), g.mpi + g.len, sizeof(g.mpi) - g.len, &len)) {
+    glen += len;
+    if (!hex2bin(desc->gy, strlen(desc->gy), g + glen, sizeof(g) - glen, &len)) {
         RNP_LOG("wrong y mpi");
         return false;
     }
-    g.len += len;
+    glen += len;
 
     /* p, a, b, g, n, q */
-    res = grip_hash_ecc_hex(hash, desc->p, 'p') && grip_hash_ecc_hex(hash, desc->a, 'a') &&
-          grip_hash_ecc_hex(hash, desc->b, 'b') && grip_hash_mpi(hash, &g, 'g', false) &&
-          grip_hash_ecc_hex(hash, desc->n, 'n');
+    res = grip_hash_ecc_hex(data, desc->p, 'p') && grip_hash_ecc_hex(data, desc->a, 'a') &&
+          grip_hash_ecc_hex(data, desc->b, 'b') && grip_hash_buf(data, g, glen, 'g', false) &&
+          grip_hash_ecc_hex(data, desc->n, 'n');
 
     if ((key->curve == PGP_CURVE_ED25519) || (key->curve == PGP_CURVE_25519)) {
-        if (g.len < 1) {
+        if (key->p.len < 1) {
             RNP_LOG("wrong 25519 p");
             return false;
         }
-        g.len = key->p.len - 1;
-        memcpy(g.mpi, key->p.mpi + 1, g.len);
-        res &= grip_hash_mpi(hash, &g, 'q', false);
+        res &= grip_hash_buf(data, key->p.mpi + 1, key->p.len - 1, 'q', false);
     } else {
-        res &= grip_hash_mpi(hash, &key->p, 'q', false);
+        res &= grip_hash_mpi(data, &key->p, 'q', false);
     }
     return res;
 }
 
-/* keygrip is subjectKeyHash from pkcs#15 for RSA. */
-bool
-rnp_key_store_get_key_grip(const pgp_key_material_t *key, uint8_t *grip)
+/* append data, hashed to get the keygrip, which is subjectKeyHash from pkcs#15 for RSA. */
+static bool
+grip_data(std::string &data, const pgp_key_material_t *key)
 {
-    pgp_hash_t hash = {0};
-
-    if (!pgp_hash_create(&hash, PGP_HASH_SHA1)) {
-        RNP_LOG("bad sha1 alloc");
-        return false;
-    }
-
     switch (key->alg) {
     case PGP_PKA_RSA:
     case PGP_PKA_RSA_SIGN_ONLY:
     case PGP_PKA_RSA_ENCRYPT_ONLY:
-        grip_hash_mpi(&hash, &key->rsa.n, '\0', true);
-        break;
+        return grip_hash_mpi(data, &key->rsa.n, '\0', true);
 
     case PGP_PKA_DSA:
-        grip_hash_mpi(&hash, &key->dsa.p, 'p', true);
-        grip_hash_mpi(&hash, &key->dsa.q, 'q', true);
-        grip_hash_mpi(&hash, &key->dsa.g, 'g', true);
-        grip_hash_mpi(&hash, &key->dsa.y, 'y', true);
-        break;
+        return grip_hash_mpi(data, &key->dsa.p, 'p', true) &&
+               grip_hash_mpi(data, &key->dsa.q, 'q', true) &&
+               grip_hash_mpi(data, &key->dsa.g, 'g', true) &&
+               grip_hash_mpi(data, &key->dsa.y, 'y', true);
 
     case PGP_PKA_ELGAMAL:
-        grip_hash_mpi(&hash, &key->eg.p, 'p', true);
-        grip_hash_mpi(&hash, &key->eg.g, 'g', true);
-        grip_hash_mpi(&hash, &key->eg.y, 'y', true);
-        break;
+        return grip_hash_mpi(data, &key->eg.p, 'p', true) &&
+               grip_hash_mpi(data, &key->eg.g, 'g', true) &&
+               grip_hash_mpi(data, &key->eg.y, 'y', true);
 
     case PGP_PKA_ECDH:
     case PGP_PKA_ECDSA:
     case PGP_PKA_EDDSA:
     case PGP_PKA_SM2:
-        if (!grip_hash_ec(&hash, &key->ec)) {
-            pgp_hash_finish(&hash, grip);
-            return false;
-        }
-        break;
+        return grip_hash_ec(data, &key->ec);
 
     default:
         RNP_LOG("unsupported public-key algorithm %d", (int) key->alg);
-        pgp_hash_finish(&hash, grip);
         return false;
     }
+}
 
-    return pgp_hash_finish(&hash, grip) == PGP_KEY_GRIP_SIZE;
+bool
+rnp_key_store_get_key_grip(const pgp_key_material_t *key, uint8_t *grip)
+{
+    return rnp_key_store_get_key_grips(&key, 1, grip);
+}
+
+bool
+rnp_key_store_get_key_grips(const pgp_key_material_t *const *keys,
+                            size_t                           count,
+                            uint8_t *                        grips)
+{
+    try {
+        std::string         data;
+        std::vector<size_t> ends(count);
+        for (size_t i = 0; i < count; i++) {
+            if (!grip_data(data, keys[i])) {
+                return false;
+            }
+            ends[i] = data.size();
+        }
+        /* messages point to data, so it must not be modified from now on */
+        std::vector<pgp_hash_msg_t> msgs(count);
+        for (size_t i = 0; i < count; i++) {
+            size_t start = i ? ends[i - 1] : 0;
+            msgs[i] = {(const uint8_t *) data.data() + start, ends[i] - start};
+        }
+        return pgp_hash_batch(PGP_HASH_SHA1, msgs.data(), count, grips);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
 }
 
 pgp_key_t *
@@ -828,6 +1084,29 @@ rnp_key_store_search(const rnp_key_store_t * keyring,
 {
     // if after is provided, make sure it is a member of the appropriate list
     assert(!after || list_is_member(keyring->keys, (list_item *) after));
+
+    uint64_t seq = rnp_key_store_key_seq(keyring, after);
+    uint64_t keyseq = 0;
+    switch (search->type) {
+    case PGP_KEY_SEARCH_KEYID: {
+        auto bucket = key_index_bucket(keyring->keybyid, key_id_ident(search->by.keyid));
+        return key_bucket_next(keyring, bucket, seq, &keyseq);
+    }
+    case PGP_KEY_SEARCH_FINGERPRINT: {
+        auto bucket = key_index_bucket(keyring->keybyfp, search->by.fingerprint);
+        return key_bucket_next(keyring, bucket, seq, &keyseq);
+    }
+    case PGP_KEY_SEARCH_GRIP: {
+        pgp_key_t *key = rnp_key_store_get_key_by_grip(keyring, search->by.grip);
+        if (key && (keyring->keyseq.at(key) >= seq)) {
+            return key;
+        }
+        return NULL;
+    }
+    default:
+        break;
+    }
+
     for (list_item *key_item = after ? list_next((list_item *) after) :
                                        list_front(keyring->keys);
          key_item;
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base64-simd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RNP_BASE64_X86 1
+#include <immintrin.h>
+#define RNP_TARGET(isa) __attribute__((target(isa)))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define RNP_BASE64_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(RNP_BASE64_X86)
+/* Kernels below use the algorithms, described by Wojciech Mula and Daniel Lemire in
+ * "Faster Base64 Encoding and Decoding Using AVX2 Instructions". */
+
+/* lookups by lo and hi nibbles have a common bit set only for the invalid characters */
+static const uint8_t B64_LUT_LO[16] = {
+  0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b,
+  0x1a};
+static const uint8_t B64_LUT_HI[16] = {
+  0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+  0x10};
+/* value to add to the character with the hi nibble, '/' is handled separately */
+static const int8_t B64_LUT_ROLL[16] = {
+  0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0};
+
+RNP_TARGET("ssse3") static size_t
+base64_decode_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m128i lut_lo = _mm_loadu_si128((const __m128i *) B64_LUT_LO);
+    const __m128i lut_hi = _mm_loadu_si128((const __m128i *) B64_LUT_HI);
+    const __m128i lut_roll = _mm_loadu_si128((const __m128i *) B64_LUT_ROLL);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+    size_t        pos = 0;
+
+    while (len - pos >= 16) {
+        __m128i str = _mm_loadu_si128((const __m128i *) (in + pos));
+        __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+        __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+        __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+        __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+        _mm_storeu_si128((__m128i *) (out + pos), _mm_add_epi8(str, roll));
+
+        int invalid =
+          _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()));
+        if (invalid) {
+            return pos + __builtin_ctz(invalid);
+        }
+        pos += 16;
+    }
+    return pos;
+}
+
+RNP_TARGET("ssse3") static size_t
+base64_pack_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m128i merge_ab = _mm_set1_epi32(0x01400140);
+    const __m128i merge_abc = _mm_set1_epi32(0x00011000);
+    const __m128i shuffle =
+      _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t pos = 0;
+
+    /* 16 bytes are stored for each 12 decoded ones, so keep space for the extra 4 */
+    while (len - pos >= 24) {
+        __m128i val = _mm_loadu_si128((const __m128i *) (in + pos));
+        val = _mm_madd_epi16(_mm_maddubs_epi16(val, merge_ab), merge_abc);
+        _mm_storeu_si128((__m128i *) (out + pos / 4 * 3), _mm_shuffle_epi8(val, shuffle));
+        pos += 16;
+    }
+    return pos;
+}
+
+RNP_TARGET("ssse3") static inline __m128i
+base64_encode_ssse3_block(__m128i in)
+{
+    /* split 3 bytes to 4 6-bit values */
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    in = _mm_shuffle_epi8(in, shuffle);
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    in = _mm_or_si128(t1, t3);
+    /* translate 6-bit values to characters */
+    const __m128i lut =
+      _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i idx = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    idx = _mm_sub_epi8(idx, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, idx));
+}
+
+RNP_TARGET("ssse3") static size_t
+base64_encode_ssse3(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+
+    /* 16 bytes are loaded while only 12 are encoded */
+    while (len - pos >= 16) {
+        __m128i val = _mm_loadu_si128((const __m128i *) (in + pos));
+        _mm_storeu_si128((__m128i *) (out + pos / 3 * 4), base64_encode_ssse3_block(val));
+        pos += 12;
+    }
+    return pos;
+}
+
+RNP_TARGET("avx2") static size_t
+base64_decode_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m256i lut_lo =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) B64_LUT_LO));
+    const __m256i lut_hi =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) B64_LUT_HI));
+    const __m256i lut_roll =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) B64_LUT_ROLL));
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+    size_t        pos = 0;
+
+    while (len - pos >= 32) {
+        __m256i str = _mm256_loadu_si256((const __m256i *) (in + pos));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+        __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        _mm256_storeu_si256((__m256i *) (out + pos), _mm256_add_epi8(str, roll));
+
+        uint32_t invalid = (uint32_t) _mm256_movemask_epi8(
+          _mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256()));
+        if (invalid) {
+            return pos + __builtin_ctz(invalid);
+        }
+        pos += 32;
+    }
+    return pos + base64_decode_ssse3(in + pos, len - pos, out + pos);
+}
+
+RNP_TARGET("avx2") static size_t
+base64_pack_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m256i merge_ab = _mm256_set1_epi32(0x01400140);
+    const __m256i merge_abc = _mm256_set1_epi32(0x00011000);
+    const __m256i shuffle = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    size_t pos = 0;
+
+    /* each lane is stored as 16 bytes with 12 decoded ones, so keep space for the extra 4 */
+    while (len - pos >= 40) {
+        __m256i val = _mm256_loadu_si256((const __m256i *) (in + pos));
+        val = _mm256_madd_epi16(_mm256_maddubs_epi16(val, merge_ab), merge_abc);
+        val = _mm256_shuffle_epi8(val, shuffle);
+        uint8_t *dst = out + pos / 4 * 3;
+        _mm_storeu_si128((__m128i *) dst, _mm256_castsi256_si128(val));
+        _mm_storeu_si128((__m128i *) (dst + 12), _mm256_extracti128_si256(val, 1));
+        pos += 32;
+    }
+    return pos + base64_pack_ssse3(in + pos, len - pos, out + pos / 4 * 3);
+}
+
+RNP_TARGET("avx2") static size_t
+base64_encode_avx2(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const __m256i lut = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0));
+    const __m256i shuffle = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    size_t pos = 0;
+
+    /* each lane gets 12 input bytes, loaded as 16-byte value */
+    while (len - pos >= 28) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) (in + pos));
+        __m128i hi = _mm_loadu_si128((const __m128i *) (in + pos + 12));
+        __m256i val = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        val = _mm256_shuffle_epi8(val, shuffle);
+        __m256i t0 = _mm256_and_si256(val, _mm256_set1_epi32(0x0FC0FC00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(val, _mm256_set1_epi32(0x003F03F0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        val = _mm256_or_si256(t1, t3);
+        __m256i idx = _mm256_subs_epu8(val, _mm256_set1_epi8(51));
+        idx = _mm256_sub_epi8(idx, _mm256_cmpgt_epi8(val, _mm256_set1_epi8(25)));
+        val = _mm256_add_epi8(val, _mm256_shuffle_epi8(lut, idx));
+        _mm256_storeu_si256((__m256i *) (out + pos / 3 * 4), val);
+        pos += 24;
+    }
+    return pos + base64_encode_ssse3(in + pos, len - pos, out + pos / 3 * 4);
+}
+
+static bool
+base64_has_ssse3(void)
+{
+    return __builtin_cpu_supports("ssse3");
+}
+
+static bool
+base64_has_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+#if defined(RNP_BASE64_NEON)
+/* 6-bit values for the characters 0..63 and 64..127, 0xff for the invalid ones */
+static const uint8_t B64DEC_NEON[128] = {
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff,
+  0xff, 0xff, 0x3f, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+  0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+  0x19, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21,
+  0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30,
+  0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+static const uint8_t B64ENC_NEON[64] = {
+  'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+  'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+  'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+  'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+
+static inline uint8x16x4_t
+base64_neon_lut(const uint8_t *table)
+{
+    uint8x16x4_t lut;
+    lut.val[0] = vld1q_u8(table);
+    lut.val[1] = vld1q_u8(table + 16);
+    lut.val[2] = vld1q_u8(table + 32);
+    lut.val[3] = vld1q_u8(table + 48);
+    return lut;
+}
+
+static size_t
+base64_decode_neon(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const uint8x16x4_t lut_lo = base64_neon_lut(B64DEC_NEON);
+    const uint8x16x4_t lut_hi = base64_neon_lut(B64DEC_NEON + 64);
+    size_t             pos = 0;
+
+    while (len - pos >= 16) {
+        uint8x16_t str = vld1q_u8(in + pos);
+        /* table lookup gives 0 for the out of range indexes, so high chars are marked */
+        uint8x16_t val = vorrq_u8(vqtbl4q_u8(lut_lo, str),
+                                  vqtbl4q_u8(lut_hi, vsubq_u8(str, vdupq_n_u8(64))));
+        val = vorrq_u8(val, vcgeq_u8(str, vdupq_n_u8(128)));
+        vst1q_u8(out + pos, val);
+
+        /* 4 bits of mask for each invalid byte */
+        uint8x16_t invalid = vcgtq_u8(val, vdupq_n_u8(63));
+        uint64_t   mask = vget_lane_u64(
+          vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(invalid), 4)), 0);
+        if (mask) {
+            return pos + (__builtin_ctzll(mask) >> 2);
+        }
+        pos += 16;
+    }
+    return pos;
+}
+
+static size_t
+base64_pack_neon(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+
+    while (len - pos >= 64) {
+        uint8x16x4_t val = vld4q_u8(in + pos);
+        uint8x16x3_t res;
+        res.val[0] = vorrq_u8(vshlq_n_u8(val.val[0], 2), vshrq_n_u8(val.val[1], 4));
+        res.val[1] = vorrq_u8(vshlq_n_u8(val.val[1], 4), vshrq_n_u8(val.val[2], 2));
+        res.val[2] = vorrq_u8(vshlq_n_u8(val.val[2], 6), val.val[3]);
+        vst3q_u8(out + pos / 4 * 3, res);
+        pos += 64;
+    }
+    return pos;
+}
+
+static size_t
+base64_encode_neon(const uint8_t *in, size_t len, uint8_t *out)
+{
+    const uint8x16x4_t lut = base64_neon_lut(B64ENC_NEON);
+    const uint8x16_t   mask = vdupq_n_u8(0x3f);
+    size_t             pos = 0;
+
+    while (len - pos >= 48) {
+        uint8x16x3_t val = vld3q_u8(in + pos);
+        uint8x16x4_t res;
+        res.val[0] = vshrq_n_u8(val.val[0], 2);
+        res.val[1] =
+          vandq_u8(vorrq_u8(vshlq_n_u8(val.val[0], 4), vshrq_n_u8(val.val[1], 4)), mask);
+        res.val[2] =
+          vandq_u8(vorrq_u8(vshlq_n_u8(val.val[1], 2), vshrq_n_u8(val.val[2], 6)), mask);
+        res.val[3] = vandq_u8(val.val[2], mask);
+        for (int i = 0; i < 4; i++) {
+            res.val[i] = vqtbl4q_u8(lut, res.val[i]);
+        }
+        vst4q_u8(out + pos / 3 * 4, res);
+        pos += 48;
+    }
+    return pos;
+}
+
+static bool
+base64_has_neon(void)
+{
+    /* NEON is mandatory on AArch64 */
+    return true;
+}
+#endif
+
+typedef struct pgp_base64_impl_t {
+    pgp_base64_simd_t kernels;
+    bool (*supported)(void);
+} pgp_base64_impl_t;
+
+static const pgp_base64_impl_t base64_impls[] = {
+#if defined(RNP_BASE64_X86)
+  {{"avx2", base64_decode_avx2, base64_pack_avx2, base64_encode_avx2}, base64_has_avx2},
+  {{"ssse3", base64_decode_ssse3, base64_pack_ssse3, base64_encode_ssse3}, base64_has_ssse3},
+#endif
+#if defined(RNP_BASE64_NEON)
+  {{"neon", base64_decode_neon, base64_pack_neon, base64_encode_neon}, base64_has_neon},
+#endif
+  {{NULL, NULL, NULL, NULL}, NULL}};
+
+size_t
+base64_simd_count(void)
+{
+    size_t count = 0;
+    for (const pgp_base64_impl_t *impl = base64_impls; impl->supported; impl++) {
+        count += impl->supported();
+    }
+    return count;
+}
+
+const pgp_base64_simd_t *
+base64_simd_get(size_t idx)
+{
+    for (const pgp_base64_impl_t *impl = base64_impls; impl->supported; impl++) {
+        if (impl->supported() && !idx--) {
+            return &impl->kernels;
+        }
+    }
+    return NULL;
+}
+
+const pgp_base64_simd_t *
+base64_simd(void)
+{
+    /* CPU features do not change at runtime, so detect them once */
+    static const pgp_base64_simd_t *kernels = base64_simd_get(0);
+    return kernels;
+}
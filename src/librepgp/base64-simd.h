@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_BASE64_SIMD_H
+#define RNP_BASE64_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Vectorized base64 kernels, used by the armor streams. Each kernel processes the
+ *        longest prefix of input it is able to handle, and returns its length, leaving the
+ *        rest (whitespaces, padding, short tails) to the scalar code.
+ */
+typedef struct pgp_base64_simd_t {
+    const char *name;
+    /**
+     * @brief Convert base64 characters to 6-bit values. Stops before the first character
+     *        which is not in the base64 alphabet, including whitespaces and '='.
+     * @param in input characters
+     * @param len number of input characters
+     * @param out output buffer, must have space for len bytes
+     * @return number of converted characters, which is equal to number of output values
+     */
+    size_t (*decode)(const uint8_t *in, size_t len, uint8_t *out);
+    /**
+     * @brief Pack 6-bit values to bytes, 4 values to 3 bytes.
+     * @param in 6-bit values
+     * @param len number of values, must be multiple of 4
+     * @param out output buffer, must have space for len / 4 * 3 bytes
+     * @return number of packed values, multiple of 4
+     */
+    size_t (*pack)(const uint8_t *in, size_t len, uint8_t *out);
+    /**
+     * @brief Encode bytes to base64 characters, 3 bytes to 4 characters.
+     * @param in input bytes
+     * @param len number of input bytes
+     * @param out output buffer, must have space for len / 3 * 4 bytes
+     * @return number of encoded bytes, multiple of 3
+     */
+    size_t (*encode)(const uint8_t *in, size_t len, uint8_t *out);
+} pgp_base64_simd_t;
+
+/**
+ * @brief Get the fastest base64 kernels, supported by the current CPU.
+ *
+ * @return pointer to the kernels or NULL if only scalar code may be used
+ */
+const pgp_base64_simd_t *base64_simd(void);
+
+/**
+ * @brief Get number of the base64 kernels, supported by the current CPU.
+ */
+size_t base64_simd_count(void);
+
+/**
+ * @brief Get the base64 kernels by index, the fastest come first.
+ *
+ * @param idx index, must be less than base64_simd_count()
+ * @return pointer to the kernels
+ */
+const pgp_base64_simd_t *base64_simd_get(size_t idx);
+
+#endif
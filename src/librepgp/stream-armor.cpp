@@ -34,11 +34,14 @@
 #include "stream-def.h"
 #include "stream-armor.h"
 #include "stream-packet.h"
-#include "crypto/hash.h"
+#include "base64-simd.h"
 #include "types.h"
 
 #define ARMORED_BLOCK_SIZE (4096)
 
+/* CRC-24 initial value, see RFC 4880, section 6.1 */
+#define CRC24_INIT 0xB704CEL
+
 typedef struct pgp_source_armored_param_t {
     pgp_source_t *    readsrc;         /* source to read from */
     pgp_armored_msg_t type;            /* type of the message */
@@ -54,7 +57,7 @@ typedef struct pgp_source_armored_param_t {
     unsigned brestlen;   /* number of bytes in brest */
     bool     eofb64;     /* end of base64 stream reached */
     uint8_t  readcrc[3]; /* crc-24 from the armored data */
-    pgp_hash_t crc_ctx;  /* CTX used to calculate CRC */
+    uint32_t crc;        /* crc-24 of the decoded data */
 } pgp_source_armored_param_t;
 
 typedef struct pgp_dest_armored_param_t {
@@ -65,7 +68,7 @@ typedef struct pgp_dest_armored_param_t {
     unsigned          llen;    /* length of the base64 line, defaults to 76 as per RFC */
     uint8_t           tail[2]; /* bytes which didn't fit into 3-byte boundary */
     unsigned          tailc;   /* number of bytes in tail */
-    pgp_hash_t        crc_ctx; /* CTX used to calculate CRC */
+    uint32_t          crc;     /* crc-24 of the encoded data */
 } pgp_dest_armored_param_t;
 
 /*
@@ -95,6 +98,76 @@ static const uint8_t B64DEC[256] = {
   0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
   0xff};
 
+/* CRC-24 lookup table for the polynomial 0x864CFB */
+static const uint32_t CRC24_TABLE[256] = {
+  0x000000, 0x864cfb, 0x8ad50d, 0x0c99f6, 0x93e6e1, 0x15aa1a, 0x1933ec, 0x9f7f17, 0xa18139,
+  0x27cdc2, 0x2b5434, 0xad18cf, 0x3267d8, 0xb42b23, 0xb8b2d5, 0x3efe2e, 0xc54e89, 0x430272,
+  0x4f9b84, 0xc9d77f, 0x56a868, 0xd0e493, 0xdc7d65, 0x5a319e, 0x64cfb0, 0xe2834b, 0xee1abd,
+  0x685646, 0xf72951, 0x7165aa, 0x7dfc5c, 0xfbb0a7, 0x0cd1e9, 0x8a9d12, 0x8604e4, 0x00481f,
+  0x9f3708, 0x197bf3, 0x15e205, 0x93aefe, 0xad50d0, 0x2b1c2b, 0x2785dd, 0xa1c926, 0x3eb631,
+  0xb8faca, 0xb4633c, 0x322fc7, 0xc99f60, 0x4fd39b, 0x434a6d, 0xc50696, 0x5a7981, 0xdc357a,
+  0xd0ac8c, 0x56e077, 0x681e59, 0xee52a2, 0xe2cb54, 0x6487af, 0xfbf8b8, 0x7db443, 0x712db5,
+  0xf7614e, 0x19a3d2, 0x9fef29, 0x9376df, 0x153a24, 0x8a4533, 0x0c09c8, 0x00903e, 0x86dcc5,
+  0xb822eb, 0x3e6e10, 0x32f7e6, 0xb4bb1d, 0x2bc40a, 0xad88f1, 0xa11107, 0x275dfc, 0xdced5b,
+  0x5aa1a0, 0x563856, 0xd074ad, 0x4f0bba, 0xc94741, 0xc5deb7, 0x43924c, 0x7d6c62, 0xfb2099,
+  0xf7b96f, 0x71f594, 0xee8a83, 0x68c678, 0x645f8e, 0xe21375, 0x15723b, 0x933ec0, 0x9fa736,
+  0x19ebcd, 0x8694da, 0x00d821, 0x0c41d7, 0x8a0d2c, 0xb4f302, 0x32bff9, 0x3e260f, 0xb86af4,
+  0x2715e3, 0xa15918, 0xadc0ee, 0x2b8c15, 0xd03cb2, 0x567049, 0x5ae9bf, 0xdca544, 0x43da53,
+  0xc596a8, 0xc90f5e, 0x4f43a5, 0x71bd8b, 0xf7f170, 0xfb6886, 0x7d247d, 0xe25b6a, 0x641791,
+  0x688e67, 0xeec29c, 0x3347a4, 0xb50b5f, 0xb992a9, 0x3fde52, 0xa0a145, 0x26edbe, 0x2a7448,
+  0xac38b3, 0x92c69d, 0x148a66, 0x181390, 0x9e5f6b, 0x01207c, 0x876c87, 0x8bf571, 0x0db98a,
+  0xf6092d, 0x7045d6, 0x7cdc20, 0xfa90db, 0x65efcc, 0xe3a337, 0xef3ac1, 0x69763a, 0x578814,
+  0xd1c4ef, 0xdd5d19, 0x5b11e2, 0xc46ef5, 0x42220e, 0x4ebbf8, 0xc8f703, 0x3f964d, 0xb9dab6,
+  0xb54340, 0x330fbb, 0xac70ac, 0x2a3c57, 0x26a5a1, 0xa0e95a, 0x9e1774, 0x185b8f, 0x14c279,
+  0x928e82, 0x0df195, 0x8bbd6e, 0x872498, 0x016863, 0xfad8c4, 0x7c943f, 0x700dc9, 0xf64132,
+  0x693e25, 0xef72de, 0xe3eb28, 0x65a7d3, 0x5b59fd, 0xdd1506, 0xd18cf0, 0x57c00b, 0xc8bf1c,
+  0x4ef3e7, 0x426a11, 0xc426ea, 0x2ae476, 0xaca88d, 0xa0317b, 0x267d80, 0xb90297, 0x3f4e6c,
+  0x33d79a, 0xb59b61, 0x8b654f, 0x0d29b4, 0x01b042, 0x87fcb9, 0x1883ae, 0x9ecf55, 0x9256a3,
+  0x141a58, 0xefaaff, 0x69e604, 0x657ff2, 0xe33309, 0x7c4c1e, 0xfa00e5, 0xf69913, 0x70d5e8,
+  0x4e2bc6, 0xc8673d, 0xc4fecb, 0x42b230, 0xddcd27, 0x5b81dc, 0x57182a, 0xd154d1, 0x26359f,
+  0xa07964, 0xace092, 0x2aac69, 0xb5d37e, 0x339f85, 0x3f0673, 0xb94a88, 0x87b4a6, 0x01f85d,
+  0x0d61ab, 0x8b2d50, 0x145247, 0x921ebc, 0x9e874a, 0x18cbb1, 0xe37b16, 0x6537ed, 0x69ae1b,
+  0xefe2e0, 0x709df7, 0xf6d10c, 0xfa48fa, 0x7c0401, 0x42fa2f, 0xc4b6d4, 0xc82f22, 0x4e63d9,
+  0xd11cce, 0x575035, 0x5bc9c3, 0xdd8538};
+
+static uint32_t
+armor_crc24(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    while (len--) {
+        crc = (crc << 8) ^ CRC24_TABLE[((crc >> 16) ^ *buf++) & 0xff];
+    }
+    return crc & 0xffffff;
+}
+
+/* decode full 4-char groups of 6-bit values, updating crc while output is still hot */
+static uint8_t *
+armor_decode_groups(pgp_source_armored_param_t *param,
+                    const uint8_t *             dptr,
+                    const uint8_t *             pend,
+                    uint8_t *                   out)
+{
+    const pgp_base64_simd_t *simd = base64_simd();
+    uint8_t *                start = out;
+    uint32_t                 b24;
+
+    if (simd) {
+        size_t done = simd->pack(dptr, pend - dptr, out);
+        dptr += done;
+        out += done / 4 * 3;
+    }
+    while (dptr < pend) {
+        b24 = *dptr++ << 18;
+        b24 |= *dptr++ << 12;
+        b24 |= *dptr++ << 6;
+        b24 |= *dptr++;
+        *out++ = b24 >> 16;
+        *out++ = b24 >> 8;
+        *out++ = b24 & 0xff;
+    }
+    param->crc = armor_crc24(param->crc, start, out - start);
+    return out;
+}
+
 static int
 armor_read_padding(pgp_source_t *src)
 {
@@ -217,17 +290,18 @@ static ssize_t
 armored_src_read(pgp_source_t *src, void *buf, size_t len)
 {
     pgp_source_armored_param_t *param = (pgp_source_armored_param_t *) src->param;
-    uint8_t  b64buf[ARMORED_BLOCK_SIZE];     /* input base64 data with spaces and so on */
-    uint8_t  decbuf[ARMORED_BLOCK_SIZE + 4]; /* decoded 6-bit values */
-    uint8_t *bufptr = (uint8_t *) buf;       /* for better readability below */
-    uint8_t *bptr, *bend;                    /* pointer to input data in b64buf */
-    uint8_t *dptr, *dend, *pend; /* pointers to decoded data in decbuf: working pointer, last
-                                    available byte, last byte to process */
-    uint8_t  bval;
-    uint32_t b24;
-    ssize_t  read;
-    ssize_t  left = len;
-    int      eqcount = 0; /* number of '=' at the end of base64 stream */
+    const uint8_t *b64buf = NULL; /* input base64 data with spaces, borrowed from readsrc */
+    uint8_t        decbuf[ARMORED_BLOCK_SIZE + 4]; /* decoded 6-bit values */
+    uint8_t *      bufptr = (uint8_t *) buf;       /* for better readability below */
+    const uint8_t *bptr, *bend;                    /* pointer to input data in b64buf */
+    uint8_t *      dptr, *dend, *pend; /* pointers to decoded data in decbuf: working pointer,
+                                          last available byte, last byte to process */
+    uint8_t *      rptr;               /* pointer to the decoded data tail in rest */
+    uint8_t        bval;
+    uint32_t       b24;
+    ssize_t        read;
+    ssize_t        left = len;
+    int            eqcount = 0; /* number of '=' at the end of base64 stream */
 
     if (!param) {
         return -1;
@@ -238,7 +312,6 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
         if (param->restlen - param->restpos >= len) {
             memcpy(bufptr, &param->rest[param->restpos], len);
             param->restpos += len;
-            pgp_hash_add(&param->crc_ctx, bufptr, len);
             return len;
         } else {
             left = len - (param->restlen - param->restpos);
@@ -252,11 +325,12 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
         return len - left;
     }
 
+    const pgp_base64_simd_t *simd = base64_simd();
     memcpy(decbuf, param->brest, param->brestlen);
     dend = decbuf + param->brestlen;
 
     do {
-        read = src_peek(param->readsrc, b64buf, sizeof(b64buf));
+        read = src_peek_ptr(param->readsrc, ARMORED_BLOCK_SIZE, &b64buf);
         if (read < 0) {
             return read;
         }
@@ -270,6 +344,15 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
         bend = b64buf + read;
         /* checking input data, stripping away whitespaces, checking for end of the b64 data */
         while (bptr < bend) {
+            if (simd) {
+                /* vectorized code stops on eol, '=' or wrong character */
+                size_t done = simd->decode(bptr, bend - bptr, dptr);
+                bptr += done;
+                dptr += done;
+                if (bptr == bend) {
+                    break;
+                }
+            }
             if ((bval = B64DEC[*(bptr++)]) < 64) {
                 *(dptr++) = bval;
             } else if (bval == 0xfe) {
@@ -295,15 +378,8 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
         }
 
         /* this one would the most performance-consuming part for large chunks */
-        while (dptr < pend) {
-            b24 = *dptr++ << 18;
-            b24 |= *dptr++ << 12;
-            b24 |= *dptr++ << 6;
-            b24 |= *dptr++;
-            *bufptr++ = b24 >> 16;
-            *bufptr++ = b24 >> 8;
-            *bufptr++ = b24 & 0xff;
-        }
+        bufptr = armor_decode_groups(param, dptr, pend, bufptr);
+        dptr = pend;
 
         /* moving rest to the beginning of decbuf */
         memmove(decbuf, dptr, dend - dptr);
@@ -311,7 +387,7 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
 
         if (param->eofb64) {
             /* '=' reached, bptr points on it */
-            src_skip(param->readsrc, bptr - b64buf - 1);
+            src_consume(param->readsrc, bptr - b64buf - 1);
 
             /* reading b64 padding if any */
             if ((eqcount = armor_read_padding(src)) < 0) {
@@ -333,7 +409,7 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
             break;
         } else {
             /* all input is base64 data or eol/spaces, so skipping it */
-            src_skip(param->readsrc, read);
+            src_consume(param->readsrc, read);
         }
     } while (left >= 3);
 
@@ -341,18 +417,8 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
 
     dptr = decbuf;
     pend = decbuf + (dend - decbuf) / 4 * 4;
-    bptr = param->rest;
-    while (dptr < pend) {
-        b24 = *dptr++ << 18;
-        b24 |= *dptr++ << 12;
-        b24 |= *dptr++ << 6;
-        b24 |= *dptr++;
-        *bptr++ = b24 >> 16;
-        *bptr++ = b24 >> 8;
-        *bptr++ = b24 & 0xff;
-    }
-
-    pgp_hash_add(&param->crc_ctx, buf, bufptr - (uint8_t *) buf);
+    rptr = armor_decode_groups(param, dptr, pend, param->rest);
+    dptr = pend;
 
     if (param->eofb64) {
         if ((dend - dptr + eqcount) % 4 != 0) {
@@ -360,22 +426,18 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
             return -1;
         }
 
+        uint8_t *tail = rptr;
         if (eqcount == 1) {
             b24 = (*dptr << 10) | (*(dptr + 1) << 4) | (*(dptr + 2) >> 2);
-            *bptr++ = b24 >> 8;
-            *bptr++ = b24 & 0xff;
+            *rptr++ = b24 >> 8;
+            *rptr++ = b24 & 0xff;
         } else if (eqcount == 2) {
-            *bptr++ = (*dptr << 2) | (*(dptr + 1) >> 4);
-        }
-
-        uint8_t crc_fin[5];
-        /* Calculate CRC after reading whole input stream */
-        pgp_hash_add(&param->crc_ctx, param->rest, bptr - param->rest);
-        if (!pgp_hash_finish(&param->crc_ctx, crc_fin)) {
-            RNP_LOG("Can't finalize RNP ctx");
-            return -1;
+            *rptr++ = (*dptr << 2) | (*(dptr + 1) >> 4);
         }
 
+        /* crc is calculated over the whole input stream at this point */
+        uint32_t crc = armor_crc24(param->crc, tail, rptr - tail);
+        uint8_t  crc_fin[3] = {(uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t) crc};
         if (memcmp(param->readcrc, crc_fin, 3)) {
             RNP_LOG("CRC mismatch");
             return -1;
@@ -388,15 +450,12 @@ armored_src_read(pgp_source_t *src, void *buf, size_t len)
         param->brestlen = dend - dptr;
     }
 
-    param->restlen = bptr - param->rest;
+    param->restlen = rptr - param->rest;
 
     /* check whether we have some bytes to add */
     if ((left > 0) && (param->restlen > 0)) {
         read = left > param->restlen ? param->restlen : left;
         memcpy(bufptr, param->rest, read);
-        if (!param->eofb64) {
-            pgp_hash_add(&param->crc_ctx, bufptr, read);
-        }
         left -= read;
         param->restpos += read;
     }
@@ -410,7 +469,6 @@ armored_src_close(pgp_source_t *src)
     pgp_source_armored_param_t *param = (pgp_source_armored_param_t *) src->param;
 
     if (param) {
-        (void) pgp_hash_finish(&param->crc_ctx, NULL);
         free(param->armorhdr);
         free(param->version);
         free(param->comment);
@@ -643,10 +701,7 @@ init_armored_src(pgp_source_t *src, pgp_source_t *readsrc)
     param = (pgp_source_armored_param_t *) src->param;
     param->readsrc = readsrc;
 
-    if (!pgp_hash_create(&param->crc_ctx, PGP_HASH_CRC24)) {
-        RNP_LOG("Internal error");
-        return RNP_ERROR_GENERIC;
-    }
+    param->crc = CRC24_INIT;
 
     src->read = armored_src_read;
     src->close = armored_src_close;
@@ -765,15 +820,13 @@ armored_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
     uint32_t                  t;
     unsigned                  inllen;
     pgp_dest_armored_param_t *param = (pgp_dest_armored_param_t *) dst->param;
+    const pgp_base64_simd_t * simd = base64_simd();
 
     if (!param) {
         RNP_LOG("wrong param");
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
-    /* update crc */
-    pgp_hash_add(&param->crc_ctx, buf, len);
-
     /* processing tail if any */
     if (len + param->tailc < 3) {
         memcpy(&param->tail[param->tailc], buf, len);
@@ -784,6 +837,7 @@ armored_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         memcpy(&dec3[param->tailc], bufptr, 3 - param->tailc);
         bufptr += 3 - param->tailc;
         param->tailc = 0;
+        param->crc = armor_crc24(param->crc, dec3, 3);
         armored_encode3(encptr, dec3);
         encptr += 4;
         param->lout += 4;
@@ -820,7 +874,13 @@ armored_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
             param->lout = 0;
         }
 
-        /* processing one line */
+        /* processing one line, updating crc while input is still hot */
+        param->crc = armor_crc24(param->crc, bufptr, inlend - bufptr);
+        if (simd) {
+            size_t done = simd->encode(bufptr, inlend - bufptr, encptr);
+            bufptr += done;
+            encptr += done / 3 * 4;
+        }
         while (bufptr < inlend) {
             t = (bufptr[0] << 16) | (bufptr[1] << 8) | (bufptr[2]);
             bufptr += 3;
@@ -856,6 +916,7 @@ armored_dst_finish(pgp_dest_t *dst)
     pgp_dest_armored_param_t *param = (pgp_dest_armored_param_t *) dst->param;
 
     /* writing tail */
+    param->crc = armor_crc24(param->crc, param->tail, param->tailc);
     if (param->tailc == 1) {
         buf[0] = B64ENC[param->tail[0] >> 2];
         buf[1] = B64ENC[(param->tail[0] << 4) & 0xff];
@@ -878,8 +939,9 @@ armored_dst_finish(pgp_dest_t *dst)
     /* writing CRC and EOL */
     buf[0] = CH_EQ;
 
-    // At this point crc_ctx is initialized, so call can't fail
-    (void) pgp_hash_finish(&param->crc_ctx, crcbuf);
+    crcbuf[0] = param->crc >> 16;
+    crcbuf[1] = param->crc >> 8;
+    crcbuf[2] = param->crc;
     armored_encode3(&buf[1], crcbuf);
     dst_write(param->writedst, buf, 5);
     armor_write_eol(param);
@@ -901,8 +963,6 @@ armored_dst_close(pgp_dest_t *dst, bool discard)
         return;
     }
 
-    /* dst_close may be called without dst_finish on error */
-    (void) pgp_hash_finish(&param->crc_ctx, NULL);
     free(param);
     dst->param = NULL;
 }
@@ -925,11 +985,7 @@ init_armored_dst(pgp_dest_t *dst, pgp_dest_t *writedst, pgp_armored_msg_t msgtyp
     dst->writeb = 0;
     dst->clen = 0;
 
-    if (!pgp_hash_create(&param->crc_ctx, PGP_HASH_CRC24)) {
-        RNP_LOG("Internal error");
-        return RNP_ERROR_GENERIC;
-    }
-
+    param->crc = CRC24_INIT;
     param->writedst = writedst;
     param->type = msgtype;
     param->usecrlf = true;
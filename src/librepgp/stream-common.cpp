@@ -38,12 +38,116 @@
 #ifdef HAVE_LIMITS_H
 #include <limits.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <rnp/rnp_def.h>
 #include "rnp.h"
 #include "stream-common.h"
 #include "types.h"
 #include <algorithm>
 
+/* per-thread pool of the stream buffers, size classes are powers of two from
+ * PGP_STREAM_BUFFER_MIN_SIZE to PGP_STREAM_BUFFER_MAX_SIZE */
+#define STREAM_POOL_CLASSES 10
+#define STREAM_POOL_DEPTH 4
+#define STREAM_POOL_MAX_BYTES (8 * 1048576)
+
+typedef struct stream_buffer_pool_t {
+    uint8_t *bufs[STREAM_POOL_CLASSES][STREAM_POOL_DEPTH];
+    unsigned count[STREAM_POOL_CLASSES];
+    size_t   total;    /* number of bytes kept in the pool */
+    bool     disabled; /* thread is exiting, buffers are not kept anymore */
+
+    ~stream_buffer_pool_t()
+    {
+        for (unsigned cls = 0; cls < STREAM_POOL_CLASSES; cls++) {
+            for (unsigned idx = 0; idx < count[cls]; idx++) {
+                free(bufs[cls][idx]);
+            }
+            count[cls] = 0;
+        }
+        total = 0;
+        disabled = true;
+    }
+} stream_buffer_pool_t;
+
+static thread_local stream_buffer_pool_t stream_pool;
+/* buffer size for the streams initialized on this thread, 0 for the default one */
+static thread_local size_t stream_bufsize;
+
+static size_t
+stream_buffer_round(size_t size)
+{
+    size_t res = PGP_STREAM_BUFFER_MIN_SIZE;
+    while ((res < size) && (res < PGP_STREAM_BUFFER_MAX_SIZE)) {
+        res <<= 1;
+    }
+    return res;
+}
+
+static unsigned
+stream_buffer_class(size_t size)
+{
+    unsigned cls = 0;
+    while (((size_t) PGP_STREAM_BUFFER_MIN_SIZE << cls) < size) {
+        cls++;
+    }
+    return cls;
+}
+
+static uint8_t *
+stream_buffer_get(size_t size)
+{
+    unsigned cls = stream_buffer_class(size);
+    if ((cls < STREAM_POOL_CLASSES) && stream_pool.count[cls]) {
+        stream_pool.total -= size;
+        return stream_pool.bufs[cls][--stream_pool.count[cls]];
+    }
+    return (uint8_t *) malloc(size);
+}
+
+static void
+stream_buffer_put(uint8_t *buf, size_t size)
+{
+    if (!buf) {
+        return;
+    }
+    unsigned cls = stream_buffer_class(size);
+    if (stream_pool.disabled || (cls >= STREAM_POOL_CLASSES) ||
+        (stream_pool.count[cls] >= STREAM_POOL_DEPTH) ||
+        (stream_pool.total + size > STREAM_POOL_MAX_BYTES)) {
+        free(buf);
+        return;
+    }
+    stream_pool.bufs[cls][stream_pool.count[cls]++] = buf;
+    stream_pool.total += size;
+}
+
+size_t
+stream_set_buffer_size(size_t size)
+{
+    size_t prev = stream_bufsize;
+    stream_bufsize = size ? stream_buffer_round(size) : 0;
+    return prev;
+}
+
+size_t
+stream_buffer_size_for(uint64_t size)
+{
+    return stream_buffer_round(std::min(size, (uint64_t) PGP_STREAM_BUFFER_AUTO_MAX_SIZE));
+}
+
+static bool
+src_cache_alloc(pgp_source_cache_t *cache)
+{
+    if (!cache->buf && !(cache->buf = stream_buffer_get(cache->size))) {
+        RNP_LOG("cache allocation failed");
+        return false;
+    }
+    return true;
+}
+
 ssize_t
 src_read(pgp_source_t *src, void *buf, size_t len)
 {
@@ -80,7 +184,7 @@ src_read(pgp_source_t *src, void *buf, size_t len)
 
     // If we got here then we have empty cache or no cache at all
     while (left > 0) {
-        if (left > sizeof(cache->buf) || !readahead || !cache) {
+        if (!cache || !readahead || (left > cache->size) || !src_cache_alloc(cache)) {
             // If there is no cache or chunk is larger then read directly
             read = src->read(src, buf, left);
             if (read > 0) {
@@ -96,7 +200,7 @@ src_read(pgp_source_t *src, void *buf, size_t len)
             }
         } else {
             // Try to fill the cache to avoid small reads
-            read = src->read(src, &cache->buf[0], sizeof(cache->buf));
+            read = src->read(src, &cache->buf[0], cache->size);
             if (read == 0) {
                 src->eof = 1;
                 len = len - left;
@@ -140,7 +244,7 @@ src_peek(pgp_source_t *src, void *buf, size_t len)
     ssize_t             read;
     pgp_source_cache_t *cache = src->cache;
 
-    if (!cache || (len > sizeof(cache->buf))) {
+    if (!cache || (len > cache->size) || !src_cache_alloc(cache)) {
         return -1;
     }
 
@@ -169,7 +273,7 @@ src_peek(pgp_source_t *src, void *buf, size_t len)
     }
 
     while (cache->len < len) {
-        read = readahead ? sizeof(cache->buf) - cache->len : len - cache->len;
+        read = readahead ? cache->size - cache->len : len - cache->len;
         if (src->knownsize && (src->readb + read > src->size)) {
             read = src->size - src->readb;
         }
@@ -196,6 +300,80 @@ src_peek(pgp_source_t *src, void *buf, size_t len)
     return -1;
 }
 
+ssize_t
+src_peek_ptr(pgp_source_t *src, size_t len, const uint8_t **ptr)
+{
+    pgp_source_cache_t *cache = src->cache;
+    ssize_t             read;
+
+    *ptr = NULL;
+    if (src->eof || !len) {
+        return 0;
+    }
+
+    // Do not read more then available if source size is known
+    if (src->knownsize && (src->readb + len > src->size)) {
+        len = src->size - src->readb;
+        if (!len) {
+            src->eof = 1;
+            return 0;
+        }
+    }
+
+    // Cached data goes first, even if there is less then len bytes
+    if (cache && (cache->len > cache->pos)) {
+        *ptr = &cache->buf[cache->pos];
+        return std::min((size_t)(cache->len - cache->pos), len);
+    }
+
+    if (src->peek_ptr) {
+        read = src->peek_ptr(src, len, ptr);
+    } else if (cache && src_cache_alloc(cache)) {
+        size_t toread = cache->readahead ? cache->size : len;
+        toread = std::min(toread, (size_t) cache->size);
+        if (src->knownsize && (src->readb + toread > src->size)) {
+            toread = src->size - src->readb;
+        }
+        cache->pos = 0;
+        cache->len = 0;
+        read = src->read(src, &cache->buf[0], toread);
+        if (read > 0) {
+            cache->len = read;
+            *ptr = &cache->buf[0];
+            read = std::min((size_t) read, len);
+        }
+    } else {
+        return -1;
+    }
+
+    if (read < 0) {
+        src->error = 1;
+        *ptr = NULL;
+        return -1;
+    }
+    if (!read) {
+        src->eof = 1;
+        *ptr = NULL;
+    }
+    return read;
+}
+
+void
+src_consume(pgp_source_t *src, size_t len)
+{
+    pgp_source_cache_t *cache = src->cache;
+
+    if (cache && (cache->len > cache->pos)) {
+        cache->pos += len;
+    } else if (src->consume) {
+        src->consume(src, len);
+    }
+    src->readb += len;
+    if (src->knownsize && (src->readb == src->size)) {
+        src->eof = 1;
+    }
+}
+
 ssize_t
 src_skip(pgp_source_t *src, size_t len)
 {
@@ -209,6 +387,21 @@ src_skip(pgp_source_t *src, size_t len)
         return len;
     }
 
+    // Data which may be borrowed is skipped without copying
+    if (src->peek_ptr) {
+        while ((len > 0) && !src->eof) {
+            const uint8_t *ptr = NULL;
+            ssize_t        read = src_peek_ptr(src, len, &ptr);
+            if (read < 0) {
+                return read;
+            }
+            src_consume(src, read);
+            res += read;
+            len -= read;
+        }
+        return res;
+    }
+
     if (len < sizeof(sbuf)) {
         return src_read(src, sbuf, len);
     }
@@ -269,6 +462,7 @@ src_close(pgp_source_t *src)
     }
 
     if (src->cache) {
+        stream_buffer_put(src->cache->buf, src->cache->size);
         free(src->cache);
         src->cache = NULL;
     }
@@ -333,6 +527,7 @@ init_src_common(pgp_source_t *src, size_t paramsize)
         return false;
     }
     src->cache->readahead = true;
+    src->cache->size = stream_bufsize ? stream_bufsize : PGP_INPUT_CACHE_SIZE;
 
     if (paramsize > 0) {
         if ((src->param = calloc(1, paramsize)) == NULL) {
@@ -346,6 +541,25 @@ init_src_common(pgp_source_t *src, size_t paramsize)
     return true;
 }
 
+bool
+src_set_buffer_size(pgp_source_t *src, size_t size)
+{
+    pgp_source_cache_t *cache = src->cache;
+
+    if (!cache || (cache->len > cache->pos)) {
+        return false;
+    }
+    size = stream_buffer_round(size ? size : PGP_INPUT_CACHE_SIZE);
+    if (size != cache->size) {
+        stream_buffer_put(cache->buf, cache->size);
+        cache->buf = NULL;
+        cache->size = size;
+    }
+    cache->pos = 0;
+    cache->len = 0;
+    return true;
+}
+
 typedef struct pgp_source_file_param_t {
     int fd;
 } pgp_source_file_param_t;
@@ -445,6 +659,7 @@ init_stdin_src(pgp_source_t *src)
 typedef struct pgp_source_mem_param_t {
     const void *memory;
     bool        free;
+    bool        mapped; /* memory is the file mapping, which should be unmapped on close */
     size_t      len;
     size_t      pos;
 } pgp_source_mem_param_t;
@@ -475,6 +690,30 @@ mem_src_read(pgp_source_t *src, void *buf, size_t len)
     }
 }
 
+static ssize_t
+mem_src_peek_ptr(pgp_source_t *src, size_t len, const uint8_t **ptr)
+{
+    pgp_source_mem_param_t *param = (pgp_source_mem_param_t *) src->param;
+
+    if (param == NULL) {
+        return -1;
+    }
+    if (len > param->len - param->pos) {
+        len = param->len - param->pos;
+    }
+    *ptr = (const uint8_t *) param->memory + param->pos;
+    return len;
+}
+
+static void
+mem_src_consume(pgp_source_t *src, size_t len)
+{
+    pgp_source_mem_param_t *param = (pgp_source_mem_param_t *) src->param;
+    if (param) {
+        param->pos += len;
+    }
+}
+
 static void
 mem_src_close(pgp_source_t *src)
 {
@@ -483,6 +722,11 @@ mem_src_close(pgp_source_t *src)
         if (param->free) {
             free((void *) param->memory);
         }
+#ifdef HAVE_SYS_MMAN_H
+        if (param->mapped) {
+            munmap((void *) param->memory, param->len);
+        }
+#endif
         free(src->param);
         src->param = NULL;
     }
@@ -504,6 +748,8 @@ init_mem_src(pgp_source_t *src, const void *mem, size_t len, bool free)
     param->pos = 0;
     param->free = free;
     src->read = mem_src_read;
+    src->peek_ptr = mem_src_peek_ptr;
+    src->consume = mem_src_consume;
     src->close = mem_src_close;
     src->finish = NULL;
     src->size = len;
@@ -529,6 +775,68 @@ init_null_src(pgp_source_t *src)
     return RNP_SUCCESS;
 }
 
+rnp_result_t
+init_mmap_src(pgp_source_t *src, const char *path)
+{
+#ifdef HAVE_SYS_MMAN_H
+    struct stat st;
+    int         flags = O_RDONLY;
+#ifdef HAVE_O_BINARY
+    flags |= O_BINARY;
+#else
+#ifdef HAVE__O_BINARY
+    flags |= _O_BINARY;
+#endif
+#endif
+    /* type and size are checked on the opened file, so it cannot be replaced in between.
+     * Non-blocking mode is needed to not wait for the writer if path is a pipe. */
+    int fd = open(path, flags | O_NONBLOCK);
+    if (fd < 0) {
+        RNP_LOG("can't open '%s'", path);
+        return RNP_ERROR_READ;
+    }
+    if (fstat(fd, &st) != 0) {
+        RNP_LOG("can't stat '%s'", path);
+        close(fd);
+        return RNP_ERROR_READ;
+    }
+    /* empty files, devices and pipes cannot be mapped */
+    if (!S_ISREG(st.st_mode) || !st.st_size || ((uint64_t) st.st_size > SIZE_MAX)) {
+        close(fd);
+        return RNP_ERROR_NOT_SUPPORTED;
+    }
+
+    size_t len = st.st_size;
+    void * mem = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    /* mapping keeps the reference to the file */
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return RNP_ERROR_NOT_SUPPORTED;
+    }
+    (void) madvise(mem, len, MADV_SEQUENTIAL);
+
+    rnp_result_t ret = init_mem_src(src, mem, len, false);
+    if (ret) {
+        munmap(mem, len);
+        return ret;
+    }
+    ((pgp_source_mem_param_t *) src->param)->mapped = true;
+    return RNP_SUCCESS;
+#else
+    return RNP_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+rnp_result_t
+init_file_or_mmap_src(pgp_source_t *src, const char *path)
+{
+    rnp_result_t ret = init_mmap_src(src, path);
+    if (ret == RNP_ERROR_NOT_SUPPORTED) {
+        ret = init_file_src(src, path);
+    }
+    return ret;
+}
+
 rnp_result_t
 read_mem_src(pgp_source_t *src, pgp_source_t *readsrc)
 {
@@ -537,6 +845,19 @@ read_mem_src(pgp_source_t *src, pgp_source_t *readsrc)
     uint8_t      buf[4096];
     ssize_t      read;
 
+    /* memory source which was not read yet may be referenced instead of copying. Check read
+     * callback as well since application callback sources have PGP_STREAM_MEMORY type */
+    if ((readsrc->read == mem_src_read) && !readsrc->readb && readsrc->param) {
+        pgp_source_mem_param_t *param = (pgp_source_mem_param_t *) readsrc->param;
+        if ((ret = init_mem_src(src, param->memory, param->len, false))) {
+            return ret;
+        }
+        param->pos = param->len;
+        readsrc->readb = readsrc->size;
+        readsrc->eof = 1;
+        return RNP_SUCCESS;
+    }
+
     if ((ret = init_mem_dest(&dst, NULL, 0))) {
         return ret;
     }
@@ -570,7 +891,11 @@ rnp_result_t
 file_to_mem_src(pgp_source_t *src, const char *filename)
 {
     pgp_source_t fsrc = {};
-    rnp_result_t res = RNP_ERROR_GENERIC;
+    rnp_result_t res = init_mmap_src(src, filename);
+
+    if (res != RNP_ERROR_NOT_SUPPORTED) {
+        return res;
+    }
 
     if ((res = init_file_src(&fsrc, filename))) {
         return res;
@@ -613,22 +938,46 @@ init_dst_common(pgp_dest_t *dst, size_t paramsize)
     }
 
     dst->werr = RNP_SUCCESS;
+    dst->csize = stream_bufsize ? stream_bufsize : PGP_OUTPUT_CACHE_SIZE;
 
     return true;
 }
 
+bool
+dst_set_buffer_size(pgp_dest_t *dst, size_t size)
+{
+    if (dst->clen > 0) {
+        return false;
+    }
+    size = stream_buffer_round(size ? size : PGP_OUTPUT_CACHE_SIZE);
+    if (size != dst->csize) {
+        stream_buffer_put(dst->cache, dst->csize);
+        dst->cache = NULL;
+        dst->csize = size;
+    }
+    return true;
+}
+
+static void
+dst_cache_release(pgp_dest_t *dst)
+{
+    stream_buffer_put(dst->cache, dst->csize);
+    dst->cache = NULL;
+    dst->clen = 0;
+}
+
 void
 dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 {
     /* we call write function only if all previous calls succeeded */
     if ((len > 0) && (dst->write) && (dst->werr == RNP_SUCCESS)) {
         /* if cache non-empty and len will overflow it then fill it and write out */
-        if ((dst->clen > 0) && (dst->clen + len > sizeof(dst->cache))) {
-            memcpy(dst->cache + dst->clen, buf, sizeof(dst->cache) - dst->clen);
-            buf = (uint8_t *) buf + sizeof(dst->cache) - dst->clen;
-            len -= sizeof(dst->cache) - dst->clen;
-            dst->werr = dst->write(dst, dst->cache, sizeof(dst->cache));
-            dst->writeb += sizeof(dst->cache);
+        if ((dst->clen > 0) && (dst->clen + len > dst->csize)) {
+            memcpy(dst->cache + dst->clen, buf, dst->csize - dst->clen);
+            buf = (uint8_t *) buf + dst->csize - dst->clen;
+            len -= dst->csize - dst->clen;
+            dst->werr = dst->write(dst, dst->cache, dst->csize);
+            dst->writeb += dst->csize;
             dst->clen = 0;
             if (dst->werr != RNP_SUCCESS) {
                 return;
@@ -636,7 +985,8 @@ dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         }
 
         /* here everything will fit into the cache or cache is empty */
-        if (dst->no_cache || (len > sizeof(dst->cache))) {
+        if (dst->no_cache || (len > dst->csize) ||
+            (!dst->cache && !(dst->cache = stream_buffer_get(dst->csize)))) {
             dst->werr = dst->write(dst, buf, len);
             if (!dst->werr) {
                 dst->writeb += len;
@@ -688,6 +1038,8 @@ dst_finish(pgp_dest_t *dst)
             res = dst->finish(dst);
         }
         dst->finished = true;
+        /* return the write cache to the pool as soon as possible */
+        dst_cache_release(dst);
     }
 
     return res;
@@ -703,6 +1055,7 @@ dst_close(pgp_dest_t *dst, bool discard)
     if (dst->close) {
         dst->close(dst, discard);
     }
+    dst_cache_release(dst);
 }
 
 typedef struct pgp_dest_file_param_t {
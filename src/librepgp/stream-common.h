@@ -34,6 +34,12 @@
 #define PGP_INPUT_CACHE_SIZE 32768
 #define PGP_OUTPUT_CACHE_SIZE 32768
 
+/* limits for the stream buffer size, which may be configured per operation */
+#define PGP_STREAM_BUFFER_MIN_SIZE 8192
+#define PGP_STREAM_BUFFER_MAX_SIZE (4 * 1048576)
+/* maximum buffer size which is picked automatically basing on the data size */
+#define PGP_STREAM_BUFFER_AUTO_MAX_SIZE 1048576
+
 #define PGP_PARTIAL_PKT_FIRST_PART_MIN_SIZE 512
 
 typedef enum {
@@ -49,13 +55,18 @@ typedef enum {
     PGP_STREAM_ENCRYPTED,
     PGP_STREAM_SIGNED,
     PGP_STREAM_ARMORED,
-    PGP_STREAM_CLEARTEXT
+    PGP_STREAM_CLEARTEXT,
+    PGP_STREAM_PIPE
 } pgp_stream_type_t;
 
 typedef struct pgp_source_t pgp_source_t;
 typedef struct pgp_dest_t   pgp_dest_t;
 
 typedef ssize_t      pgp_source_read_func_t(pgp_source_t *src, void *buf, size_t len);
+typedef ssize_t      pgp_source_peek_ptr_func_t(pgp_source_t *  src,
+                                                size_t          len,
+                                                const uint8_t **ptr);
+typedef void         pgp_source_consume_func_t(pgp_source_t *src, size_t len);
 typedef rnp_result_t pgp_source_finish_func_t(pgp_source_t *src);
 typedef void         pgp_source_close_func_t(pgp_source_t *src);
 
@@ -63,9 +74,10 @@ typedef rnp_result_t pgp_dest_write_func_t(pgp_dest_t *dst, const void *buf, siz
 typedef rnp_result_t pgp_dest_finish_func_t(pgp_dest_t *src);
 typedef void         pgp_dest_close_func_t(pgp_dest_t *dst, bool discard);
 
-/* statically preallocated cache for sources */
+/* cache for sources, buffer is taken from the per-thread pool on the first use */
 typedef struct pgp_source_cache_t {
-    uint8_t  buf[PGP_INPUT_CACHE_SIZE];
+    uint8_t *buf;       /* cache buffer, NULL if not allocated yet */
+    unsigned size;      /* size of the cache buffer */
     unsigned pos;       /* current position in cache */
     unsigned len;       /* number of bytes available in cache */
     bool     readahead; /* whether read-ahead with larger chunks allowed */
@@ -77,6 +89,11 @@ typedef struct pgp_source_t {
     pgp_source_close_func_t * close;
     pgp_stream_type_t         type;
 
+    /* optional, expose the unread data stored by the source itself or by the underlying one,
+     * so it may be used without copying to the cache. Must be set together with consume */
+    pgp_source_peek_ptr_func_t *peek_ptr;
+    pgp_source_consume_func_t * consume;
+
     uint64_t size;  /* size of the data if available, see knownsize */
     uint64_t readb; /* number of bytes read from the stream via src_read. Do not confuse with
                        number of bytes as returned via the read since data may be cached */
@@ -88,6 +105,29 @@ typedef struct pgp_source_t {
     unsigned error : 1;     /* there were reading error */
 } pgp_source_t;
 
+/** @brief set size of the read and write buffers for the streams which will be initialized
+ *         later on the current thread. Buffers are taken from the per-thread pool, so
+ *         consequent operations reuse memory instead of allocating it.
+ *  @param size buffer size in bytes, 0 to use the default one. Rounded up to the power of two
+ *         within the PGP_STREAM_BUFFER_MIN_SIZE..PGP_STREAM_BUFFER_MAX_SIZE range.
+ *  @return previous value, which may be used to restore it
+ **/
+size_t stream_set_buffer_size(size_t size);
+
+/** @brief pick the buffer size for processing of the data with known size: small buffers for
+ *         the small messages and up to PGP_STREAM_BUFFER_AUTO_MAX_SIZE for the bulk data.
+ *  @param size size of the data
+ *  @return buffer size, which may be passed to stream_set_buffer_size()
+ **/
+size_t stream_buffer_size_for(uint64_t size);
+
+/** @brief change size of the source's cache. Works only if there is no cached data.
+ *  @param src initialized source
+ *  @param size new size, see stream_set_buffer_size()
+ *  @return true on success or false otherwise
+ **/
+bool src_set_buffer_size(pgp_source_t *src, size_t size);
+
 /** @brief helper function to allocate memory for source's cache and param
  *         Also fills src and param with zeroes
  *  @param src pointer to the source structure
@@ -117,11 +157,28 @@ bool src_read_eq(pgp_source_t *src, void *buf, size_t len);
  *  @param src source structure
  *  @param buf preallocated buffer which can store up to len bytes, or NULL if data should be
  *             discarded, just making sure that needed input is available in source
- *  @param len number of bytes to read. Must be less then PGP_INPUT_CACHE_SIZE.
+ *  @param len number of bytes to read. Must not be larger then the source's cache size.
  *  @return number of bytes read or -1 in case of error
  **/
 ssize_t src_peek(pgp_source_t *src, void *buf, size_t len);
 
+/** @brief borrow up to len contiguous bytes of the unread data without copying them. Data is
+ *         taken from the cache or directly from the source's own storage if it supports it.
+ *         May return less then len bytes even if more data is available, so caller should
+ *         call it in a loop. Pointer is valid till the next operation on the source.
+ *  @param src source structure
+ *  @param len maximum number of bytes to borrow
+ *  @param ptr on success pointer to the data will be stored here
+ *  @return number of bytes available at ptr, 0 on eof or -1 in case of error
+ **/
+ssize_t src_peek_ptr(pgp_source_t *src, size_t len, const uint8_t **ptr);
+
+/** @brief mark data, borrowed via src_peek_ptr, as read
+ *  @param src source structure
+ *  @param len number of bytes, must not exceed value returned by the last src_peek_ptr call
+ **/
+void src_consume(pgp_source_t *src, size_t len);
+
 /** @brief skip up to len bytes
  *  @param src source structure
  *  @param len number of bytes to skip
@@ -178,6 +235,25 @@ ssize_t src_peek_line(pgp_source_t *src, char *buf, size_t len);
  **/
 rnp_result_t init_file_src(pgp_source_t *src, const char *path);
 
+/** @brief init memory source, backed by the read-only mapping of the file. Data is read by
+ *         the operating system on demand, so huge files do not need to fit into memory.
+ *         File must not be truncated or rewritten in place while source is opened: reading
+ *         the truncated part of the mapping raises SIGBUS instead of returning an error.
+ *         Replacing the file via rename(), as key stores are saved, is safe.
+ *  @param src pre-allocated source structure
+ *  @param path path to the file
+ *  @return RNP_SUCCESS, RNP_ERROR_NOT_SUPPORTED if file cannot be mapped (i.e. it is empty,
+ *          not a regular file or system doesn't support mappings) or other error code
+ **/
+rnp_result_t init_mmap_src(pgp_source_t *src, const char *path);
+
+/** @brief init memory-mapped source if possible, falling back to the file source otherwise
+ *  @param src pre-allocated source structure
+ *  @param path path to the file
+ *  @return RNP_SUCCESS or error code
+ **/
+rnp_result_t init_file_or_mmap_src(pgp_source_t *src, const char *path);
+
 /** @brief init stdin source
  *  @param src pre-allocated source structure
  *  @return RNP_SUCCESS or error code
@@ -199,14 +275,17 @@ rnp_result_t init_mem_src(pgp_source_t *src, const void *mem, size_t len, bool f
  **/
 rnp_result_t init_null_src(pgp_source_t *src);
 
-/** @brief init memory source with contents of other source
+/** @brief init memory source with contents of other source. If readsrc is a memory source
+ *         which was not read yet then its memory is referenced instead of copying, so readsrc
+ *         must not be closed before src.
  *  @param src pre-allocated source structure
  *  @param readsrc opened source with data
  *  @return RNP_SUCCESS or error code
  **/
 rnp_result_t read_mem_src(pgp_source_t *src, pgp_source_t *readsrc);
 
-/** @brief init memory source with contents of the specified file
+/** @brief init memory source with contents of the specified file. File is mapped to memory
+ *         when possible.
  *  @param src pre-allocated source structure
  *  @param filename name of the file
  *  @return RNP_SUCCESS or error code
@@ -229,7 +308,8 @@ typedef struct pgp_dest_t {
     size_t   writeb;   /* number of bytes written */
     void *   param;    /* source-specific additional data */
     bool     no_cache; /* disable write caching */
-    uint8_t  cache[PGP_OUTPUT_CACHE_SIZE];
+    uint8_t *cache;    /* write cache, taken from the per-thread pool on the first use */
+    unsigned csize;    /* size of the write cache */
     unsigned clen;     /* number of bytes in cache */
     bool     finished; /* whether dst_finish was called on dest or not */
 } pgp_dest_t;
@@ -242,6 +322,13 @@ typedef struct pgp_dest_t {
  **/
 bool init_dst_common(pgp_dest_t *dst, size_t paramsize);
 
+/** @brief change size of the dest's write cache. Works only if cache is empty.
+ *  @param dst initialized dest
+ *  @param size new size, see stream_set_buffer_size()
+ *  @return true on success or false otherwise
+ **/
+bool dst_set_buffer_size(pgp_dest_t *dst, size_t size);
+
 /** @brief write buffer to the destination
  *
  *  @param dst destination structure
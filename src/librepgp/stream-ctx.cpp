@@ -28,6 +28,7 @@
 #include <assert.h>
 #include "defaults.h"
 #include "stream-ctx.h"
+#include "utils.h"
 
 rng_t *
 rnp_ctx_rng_handle(const rnp_ctx_t *ctx)
@@ -43,13 +44,19 @@ rnp_ctx_add_encryption_password(rnp_ctx_t *    ctx,
                                 pgp_symm_alg_t ealg,
                                 int            iterations)
 {
+    /* ffi operations bind generator only while executing, since may change the thread */
+    rng_t *                   rng = ctx->rng ? ctx->rng : rng_thread_local();
     rnp_symmetric_pass_info_t info = {};
 
     info.s2k.usage = PGP_S2KU_ENCRYPTED_AND_HASHED;
     info.s2k.specifier = PGP_S2KS_ITERATED_AND_SALTED;
     info.s2k.hash_alg = halg;
 
-    if (!rng_get_data(ctx->rng, info.s2k.salt, sizeof(info.s2k.salt))) {
+    if (!rng) {
+        RNP_LOG("failed to initialize RNG");
+        return RNP_ERROR_RNG;
+    }
+    if (!rng_get_data(rng, info.s2k.salt, sizeof(info.s2k.salt))) {
         return RNP_ERROR_GENERIC;
     }
     if (iterations == 0) {
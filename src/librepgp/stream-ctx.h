@@ -31,6 +31,7 @@
 #include <stdbool.h>
 #include <sys/types.h>
 #include "types.h"
+#include "parallel.h"
 
 typedef enum rnp_operation_t {
     RNP_OP_UNKNOWN = 0,
@@ -82,6 +83,9 @@ typedef struct rnp_signer_info_t {
  *  - sig_cb_param: parameter to be passed to on_signatures callback.
  *  - discard: dicard the output data (i.e. just decrypt and/or verify signatures)
  *
+ *  For any operation bufsize controls size of the read and write buffers used by streams. If
+ *  it is 0 then size is picked basing on the input size, if it is known.
+ *
  */
 
 typedef struct rnp_ctx_t {
@@ -95,6 +99,7 @@ typedef struct rnp_ctx_t {
     pgp_symm_alg_t  ealg;          /* encryption algorithm */
     int             zalg;          /* compression algorithm used */
     int             zlevel;        /* compression level */
+    size_t          zthreads;      /* number of threads to compress data blocks in parallel */
     pgp_aead_alg_t  aalg;          /* non-zero to use AEAD */
     int             abits;         /* AEAD chunk bits */
     bool            overwrite;     /* allow to overwrite output file if exists */
@@ -107,6 +112,11 @@ typedef struct rnp_ctx_t {
     void *          sig_cb_param;  /* callback data passed to on_signatures */
     rng_t *         rng;           /* pointer to rng_t */
     rnp_operation_t operation;     /* current operation type */
+    size_t          aead_threads;  /* number of threads to process AEAD chunks */
+    size_t          bufsize;       /* size of the stream buffers, 0 to pick automatically */
+    bool            pipeline;      /* run write stream stages on separate threads */
+
+    rnp_thread_pool_t *pool; /* worker threads for AEAD and compression, not owned */
 } rnp_ctx_t;
 
 typedef struct rnp_symmetric_pass_info_t {
@@ -60,4 +60,10 @@
 /* Preallocated cache length for AEAD encryption/decryption */
 #define PGP_AEAD_CACHE_LEN (PGP_INPUT_CACHE_SIZE + PGP_AEAD_MAX_TAG_LEN)
 
+/* Maximum AEAD chunk length, allowing multi-threaded encryption/decryption */
+#define PGP_AEAD_MT_MAX_CHUNK_LEN (1 << 22)
+
+/* Minimum input size for which write stream stages are run on separate threads */
+#define PGP_PIPELINE_MIN_SIZE (1 << 20)
+
 #endif /* !STREAM_DEF_H_ */
@@ -652,8 +652,13 @@ signature_dump_subpackets(rnp_dump_ctx_t * ctx,
 {
     bool empty = true;
 
-    for (list_item *li = list_front(sig->subpkts); li; li = list_next(li)) {
-        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) li;
+    if (!signature_expand_subpkts(sig)) {
+        dst_printf(dst, "failed to parse subpackets\n");
+        return;
+    }
+
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i);
         if (subpkt->hashed != hashed) {
             continue;
         }
@@ -949,6 +954,7 @@ stream_dump_pk_session_key(rnp_dump_ctx_t *ctx, pgp_source_t *src, pgp_dest_t *d
 
     indent_dest_decrease(dst);
     indent_dest_decrease(dst);
+    free_pk_sesskey(&pkey);
     return RNP_SUCCESS;
 }
 
@@ -1418,9 +1424,9 @@ obj_add_s2k_json(json_object *obj, pgp_s2k_t *s2k)
     return true;
 }
 
-static rnp_result_t stream_dump_signature_pkt_json(rnp_dump_ctx_t *       ctx,
-                                                   const pgp_signature_t *sig,
-                                                   json_object *          pkt);
+static rnp_result_t stream_dump_signature_pkt_json(rnp_dump_ctx_t * ctx,
+                                                   pgp_signature_t *sig,
+                                                   json_object *    pkt);
 
 static bool
 signature_dump_subpacket_json(rnp_dump_ctx_t *ctx, pgp_sig_subpkt_t *subpkt, json_object *obj)
@@ -1584,12 +1590,16 @@ signature_dump_subpacket_json(rnp_dump_ctx_t *ctx, pgp_sig_subpkt_t *subpkt, jso
 }
 
 static json_object *
-signature_dump_subpackets_json(rnp_dump_ctx_t *ctx, const pgp_signature_t *sig)
+signature_dump_subpackets_json(rnp_dump_ctx_t *ctx, pgp_signature_t *sig)
 {
+    if (!signature_expand_subpkts(sig)) {
+        return NULL;
+    }
+
     json_object *res = json_object_new_array();
 
-    for (list_item *li = list_front(sig->subpkts); li; li = list_next(li)) {
-        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) li;
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i);
         json_object *     jso_subpkt = json_object_new_object();
         if (json_object_array_add(res, jso_subpkt)) {
             json_object_put(jso_subpkt);
@@ -1628,9 +1638,9 @@ error:
 }
 
 static rnp_result_t
-stream_dump_signature_pkt_json(rnp_dump_ctx_t *       ctx,
-                               const pgp_signature_t *sig,
-                               json_object *          pkt)
+stream_dump_signature_pkt_json(rnp_dump_ctx_t * ctx,
+                               pgp_signature_t *sig,
+                               json_object *    pkt)
 {
     json_object *material = NULL;
     rnp_result_t ret = RNP_ERROR_OUT_OF_MEMORY;
@@ -1896,18 +1906,13 @@ done:
 }
 
 static rnp_result_t
-stream_dump_pk_session_key_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object *pkt)
+stream_dump_pk_session_key_pkt_json(rnp_dump_ctx_t *        ctx,
+                                    const pgp_pk_sesskey_t *pkey,
+                                    json_object *           pkt)
 {
-    pgp_pk_sesskey_t pkey;
-    rnp_result_t     ret;
-
-    if ((ret = stream_parse_pk_sesskey(src, &pkey))) {
-        return ret;
-    }
-
-    if (!obj_add_field_json(pkt, "version", json_object_new_int(pkey.version)) ||
-        !obj_add_hex_json(pkt, "keyid", pkey.key_id, PGP_KEY_ID_SIZE) ||
-        !obj_add_intstr_json(pkt, "algorithm", pkey.alg, pubkey_alg_map)) {
+    if (!obj_add_field_json(pkt, "version", json_object_new_int(pkey->version)) ||
+        !obj_add_hex_json(pkt, "keyid", pkey->key_id, PGP_KEY_ID_SIZE) ||
+        !obj_add_intstr_json(pkt, "algorithm", pkey->alg, pubkey_alg_map)) {
         return RNP_ERROR_OUT_OF_MEMORY;
     }
 
@@ -1916,31 +1921,32 @@ stream_dump_pk_session_key_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_obj
         return RNP_ERROR_OUT_OF_MEMORY;
     }
 
-    switch (pkey.alg) {
+    switch (pkey->alg) {
     case PGP_PKA_RSA:
-        if (!obj_add_mpi_json(material, "m", &pkey.material.rsa.m, ctx->dump_mpi)) {
+        if (!obj_add_mpi_json(material, "m", &pkey->material.rsa.m, ctx->dump_mpi)) {
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         break;
     case PGP_PKA_ELGAMAL:
-        if (!obj_add_mpi_json(material, "g", &pkey.material.eg.g, ctx->dump_mpi) ||
-            !obj_add_mpi_json(material, "m", &pkey.material.eg.m, ctx->dump_mpi)) {
+        if (!obj_add_mpi_json(material, "g", &pkey->material.eg.g, ctx->dump_mpi) ||
+            !obj_add_mpi_json(material, "m", &pkey->material.eg.m, ctx->dump_mpi)) {
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         break;
     case PGP_PKA_SM2:
-        if (!obj_add_mpi_json(material, "m", &pkey.material.sm2.m, ctx->dump_mpi)) {
+        if (!obj_add_mpi_json(material, "m", &pkey->material.sm2.m, ctx->dump_mpi)) {
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         break;
     case PGP_PKA_ECDH:
-        if (!obj_add_mpi_json(material, "p", &pkey.material.ecdh.p, ctx->dump_mpi) ||
+        if (!obj_add_mpi_json(material, "p", &pkey->material.ecdh.p, ctx->dump_mpi) ||
             !obj_add_field_json(
-              material, "m.bytes", json_object_new_int(pkey.material.ecdh.mlen))) {
+              material, "m.bytes", json_object_new_int(pkey->material.ecdh.mlen))) {
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         if (ctx->dump_mpi &&
-            !obj_add_hex_json(material, "m", pkey.material.ecdh.m, pkey.material.ecdh.mlen)) {
+            !obj_add_hex_json(
+              material, "m", pkey->material.ecdh.m, pkey->material.ecdh.mlen)) {
             return RNP_ERROR_OUT_OF_MEMORY;
         }
         break;
@@ -1950,6 +1956,21 @@ stream_dump_pk_session_key_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_obj
     return RNP_SUCCESS;
 }
 
+static rnp_result_t
+stream_dump_pk_session_key_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object *pkt)
+{
+    pgp_pk_sesskey_t pkey;
+    rnp_result_t     ret;
+
+    if ((ret = stream_parse_pk_sesskey(src, &pkey))) {
+        return ret;
+    }
+
+    ret = stream_dump_pk_session_key_pkt_json(ctx, &pkey, pkt);
+    free_pk_sesskey(&pkey);
+    return ret;
+}
+
 static rnp_result_t
 stream_dump_sk_session_key_json(pgp_source_t *src, json_object *pkt)
 {
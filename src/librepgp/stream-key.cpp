@@ -31,6 +31,8 @@
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
+#include <string>
+#include <unordered_map>
 #include "stream-def.h"
 #include "stream-key.h"
 #include "stream-armor.h"
@@ -81,19 +83,76 @@ copy_signatures(list *dst, const list *src)
     return true;
 }
 
+/* digest of the fields compared by signature_pkt_equal(), so equal signatures get equal ids */
 static bool
-list_has_signature(const list *lst, const pgp_signature_t *sig)
+signature_digest(const pgp_signature_t *sig, std::string &digest)
 {
-    for (list_item *lsig = list_front(*lst); lsig; lsig = list_next(lsig)) {
-        if (signature_pkt_equal((pgp_signature_t *) lsig, sig)) {
-            return true;
-        }
+    pgp_hash_t hash = {};
+    uint8_t    out[PGP_MAX_HASH_SIZE];
+    bool       res = false;
+
+    if (!pgp_hash_create(&hash, PGP_HASH_SHA256)) {
+        return false;
+    }
+    pgp_hash_add(&hash, sig->lbits, 2);
+    pgp_hash_uint32(&hash, sig->hashed_len);
+    pgp_hash_add(&hash, sig->hashed_data, sig->hashed_len);
+
+    switch (sig->palg) {
+    case PGP_PKA_RSA:
+        res = mpi_hash(&sig->material.rsa.s, &hash);
+        break;
+    case PGP_PKA_DSA:
+        res = mpi_hash(&sig->material.dsa.r, &hash) && mpi_hash(&sig->material.dsa.s, &hash);
+        break;
+    case PGP_PKA_ELGAMAL_ENCRYPT_OR_SIGN:
+        res = mpi_hash(&sig->material.eg.r, &hash) && mpi_hash(&sig->material.eg.s, &hash);
+        break;
+    case PGP_PKA_EDDSA:
+    case PGP_PKA_ECDSA:
+    case PGP_PKA_SM2:
+    case PGP_PKA_ECDH:
+        res = mpi_hash(&sig->material.ecc.r, &hash) && mpi_hash(&sig->material.ecc.s, &hash);
+        break;
+    default:
+        /* signature_pkt_equal() never matches these */
+        break;
+    }
+
+    size_t len = pgp_hash_finish(&hash, out);
+    if (!res || !len) {
+        return false;
+    }
+    digest.assign((const char *) out, len);
+    return true;
+}
+
+typedef std::unordered_map<std::string, const pgp_signature_t *> pgp_sig_digest_set_t;
+
+static void
+signature_set_add(pgp_sig_digest_set_t &set, const pgp_signature_t *sig)
+{
+    std::string digest;
+    if (signature_digest(sig, digest)) {
+        set.emplace(digest, sig);
     }
-    return false;
+}
+
+static bool
+signature_set_has(const pgp_sig_digest_set_t &set, const pgp_signature_t *sig)
+{
+    std::string digest;
+    if (!signature_digest(sig, digest)) {
+        return false;
+    }
+    auto it = set.find(digest);
+    return (it != set.end()) && signature_pkt_equal(it->second, sig);
 }
 
 /**
  * @brief Add signatures from src to list dst, skipping the duplicates.
+ *        Duplicates are looked up by digest, so merge of the flooded certificate, having
+ *        a lot of signatures, takes linear time.
  *
  * @param dst List which will contain all distinct signatures from src and dst
  * @param src List to merge signatures from
@@ -102,18 +161,31 @@ list_has_signature(const list *lst, const pgp_signature_t *sig)
 static rnp_result_t
 merge_signatures(list *dst, const list *src)
 {
-    for (list_item *sig = list_front(*src); sig; sig = list_next(sig)) {
-        if (list_has_signature(dst, (pgp_signature_t *) sig)) {
-            continue;
+    try {
+        pgp_sig_digest_set_t sigs;
+        sigs.reserve(list_length(*dst) + list_length(*src));
+        for (list_item *sig = list_front(*dst); sig; sig = list_next(sig)) {
+            signature_set_add(sigs, (pgp_signature_t *) sig);
         }
-        pgp_signature_t *newsig = (pgp_signature_t *) list_append(dst, NULL, sizeof(*newsig));
-        if (!newsig) {
-            return RNP_ERROR_OUT_OF_MEMORY;
-        }
-        if (!copy_signature_packet(newsig, (pgp_signature_t *) sig)) {
-            list_remove((list_item *) newsig);
-            return RNP_ERROR_OUT_OF_MEMORY;
+
+        for (list_item *sig = list_front(*src); sig; sig = list_next(sig)) {
+            if (signature_set_has(sigs, (pgp_signature_t *) sig)) {
+                continue;
+            }
+            pgp_signature_t *newsig =
+              (pgp_signature_t *) list_append(dst, NULL, sizeof(*newsig));
+            if (!newsig) {
+                return RNP_ERROR_OUT_OF_MEMORY;
+            }
+            if (!copy_signature_packet(newsig, (pgp_signature_t *) sig)) {
+                list_remove((list_item *) newsig);
+                return RNP_ERROR_OUT_OF_MEMORY;
+            }
+            signature_set_add(sigs, newsig);
         }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
     }
     return RNP_SUCCESS;
 }
@@ -339,6 +411,59 @@ transferable_key_merge(pgp_transferable_key_t *dst, const pgp_transferable_key_t
     return RNP_SUCCESS;
 }
 
+static bool
+signature_is_certification(const pgp_signature_t *sig)
+{
+    switch (signature_get_type(sig)) {
+    case PGP_CERT_GENERIC:
+    case PGP_CERT_PERSONA:
+    case PGP_CERT_CASUAL:
+    case PGP_CERT_POSITIVE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t
+transferable_key_limit_certifications(pgp_transferable_key_t *key,
+                                      size_t                  limit,
+                                      const size_t *          keep,
+                                      size_t                  keep_count)
+{
+    uint8_t keyid[PGP_KEY_ID_SIZE];
+    uint8_t signer[PGP_KEY_ID_SIZE];
+    size_t  dropped = 0;
+    size_t  uididx = 0;
+
+    if (!limit || pgp_keyid(keyid, sizeof(keyid), &key->key)) {
+        return 0;
+    }
+
+    for (list_item *uid = list_front(key->userids); uid; uid = list_next(uid), uididx++) {
+        list * sigs = &((pgp_transferable_userid_t *) uid)->signatures;
+        size_t certs = 0;
+        size_t kept = (keep && (uididx < keep_count)) ? keep[uididx] : 0;
+        size_t sigidx = 0;
+        /* self-signatures and revocations are always kept, as well as first certifications */
+        for (list_item *li = list_front(*sigs); li; sigidx++) {
+            pgp_signature_t *sig = (pgp_signature_t *) li;
+            li = list_next(li);
+            if (!signature_is_certification(sig) ||
+                (signature_get_keyid(sig, signer) && !memcmp(signer, keyid, sizeof(keyid)))) {
+                continue;
+            }
+            if ((++certs <= limit) || (sigidx < kept)) {
+                continue;
+            }
+            free_signature(sig);
+            list_remove((list_item *) sig);
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
 pgp_transferable_userid_t *
 transferable_key_add_userid(pgp_transferable_key_t *key, const char *userid)
 {
@@ -387,12 +512,7 @@ transferable_userid_certify(const pgp_key_pkt_t *          key,
         return NULL;
     }
 
-    if (pgp_keyid(keyid, sizeof(keyid), signer)) {
-        RNP_LOG("failed to calculate keyid");
-        goto end;
-    }
-
-    if (pgp_fingerprint(&keyfp, signer)) {
+    if (pgp_fingerprint_keyid(&keyfp, keyid, signer)) {
         RNP_LOG("failed to calculate keyfp");
         goto end;
     }
@@ -548,12 +668,7 @@ transferable_subkey_bind(const pgp_key_pkt_t *             key,
         return NULL;
     }
 
-    if (pgp_keyid(keyid, sizeof(keyid), key)) {
-        RNP_LOG("failed to calculate keyid");
-        goto end;
-    }
-
-    if (pgp_fingerprint(&keyfp, key)) {
+    if (pgp_fingerprint_keyid(&keyfp, keyid, key)) {
         RNP_LOG("failed to calculate keyfp");
         goto end;
     }
@@ -671,8 +786,9 @@ process_pgp_key_trusts(pgp_source_t *src)
     return RNP_SUCCESS;
 }
 
+/* signatures are parsed in place from the arena if mem is not NULL */
 static rnp_result_t
-process_pgp_key_signatures(pgp_source_t *src, list *sigs)
+process_pgp_key_signatures(pgp_source_t *src, list *sigs, arena *mem)
 {
     int          ptag;
     rnp_result_t ret = RNP_ERROR_BAD_FORMAT;
@@ -684,7 +800,9 @@ process_pgp_key_signatures(pgp_source_t *src, list *sigs)
             return RNP_ERROR_OUT_OF_MEMORY;
         }
 
-        if ((ret = stream_parse_signature(src, sig))) {
+        ret = mem ? stream_parse_signature_arena(src, sig, mem) :
+                    stream_parse_signature(src, sig);
+        if (ret) {
             list_remove((list_item *) sig);
             return ret;
         }
@@ -697,8 +815,8 @@ process_pgp_key_signatures(pgp_source_t *src, list *sigs)
     return ptag < 0 ? RNP_ERROR_BAD_FORMAT : RNP_SUCCESS;
 }
 
-rnp_result_t
-process_pgp_userid(pgp_source_t *src, pgp_transferable_userid_t *uid)
+static rnp_result_t
+read_pgp_userid(pgp_source_t *src, pgp_transferable_userid_t *uid, arena *mem)
 {
     int          ptag;
     rnp_result_t ret = RNP_ERROR_BAD_FORMAT;
@@ -719,7 +837,7 @@ process_pgp_userid(pgp_source_t *src, pgp_transferable_userid_t *uid)
         goto done;
     }
 
-    ret = process_pgp_key_signatures(src, &uid->signatures);
+    ret = process_pgp_key_signatures(src, &uid->signatures, mem);
 done:
     if (ret) {
         transferable_userid_destroy(uid);
@@ -729,7 +847,13 @@ done:
 }
 
 rnp_result_t
-process_pgp_subkey(pgp_source_t *src, pgp_transferable_subkey_t *subkey)
+process_pgp_userid(pgp_source_t *src, pgp_transferable_userid_t *uid)
+{
+    return read_pgp_userid(src, uid, NULL);
+}
+
+static rnp_result_t
+read_pgp_subkey(pgp_source_t *src, pgp_transferable_subkey_t *subkey, arena *mem)
 {
     int          ptag;
     rnp_result_t ret = RNP_ERROR_BAD_FORMAT;
@@ -749,7 +873,7 @@ process_pgp_subkey(pgp_source_t *src, pgp_transferable_subkey_t *subkey)
         goto done;
     }
 
-    ret = process_pgp_key_signatures(src, &subkey->signatures);
+    ret = process_pgp_key_signatures(src, &subkey->signatures, mem);
 done:
     if (ret) {
         transferable_subkey_destroy(subkey);
@@ -759,80 +883,13 @@ done:
 }
 
 rnp_result_t
-process_pgp_keys(pgp_source_t *src, pgp_key_sequence_t *keys)
+process_pgp_subkey(pgp_source_t *src, pgp_transferable_subkey_t *subkey)
 {
-    int                     ptag;
-    bool                    armored = false;
-    pgp_source_t            armorsrc = {0};
-    pgp_source_t *          origsrc = src;
-    bool                    has_secret = false;
-    bool                    has_public = false;
-    pgp_transferable_key_t *curkey = NULL;
-    rnp_result_t            ret = RNP_ERROR_GENERIC;
-
-    memset(keys, 0, sizeof(*keys));
-
-    /* check whether keys are armored */
-armoredpass:
-    if (is_armored_source(src)) {
-        if ((ret = init_armored_src(&armorsrc, src))) {
-            RNP_LOG("failed to parse armored data");
-            goto finish;
-        }
-        armored = true;
-        src = &armorsrc;
-    }
-
-    /* read sequence of transferable OpenPGP keys as described in RFC 4880, 11.1 - 11.2 */
-    while (!src_eof(src) && !src_error(src)) {
-        ptag = stream_pkt_type(src);
-
-        if ((ptag < 0) || !is_primary_key_pkt(ptag)) {
-            RNP_LOG("wrong key tag: %d", ptag);
-            ret = RNP_ERROR_BAD_FORMAT;
-            goto finish;
-        }
-
-        if (!(curkey =
-                (pgp_transferable_key_t *) list_append(&keys->keys, NULL, sizeof(*curkey)))) {
-            RNP_LOG("key alloc failed");
-            ret = RNP_ERROR_OUT_OF_MEMORY;
-            goto finish;
-        }
-
-        if ((ret = process_pgp_key(src, curkey))) {
-            goto finish;
-        }
-
-        has_secret |= (ptag == PGP_PTAG_CT_SECRET_KEY);
-        has_public |= (ptag == PGP_PTAG_CT_PUBLIC_KEY);
-    }
-
-    /* file may have multiple armored keys */
-    if (armored && !src_eof(origsrc) && is_armored_source(origsrc)) {
-        src_close(&armorsrc);
-        armored = false;
-        src = origsrc;
-        goto armoredpass;
-    }
-
-    if (has_secret && has_public) {
-        RNP_LOG("warning! public keys are mixed together with secret ones!");
-    }
-
-    ret = RNP_SUCCESS;
-finish:
-    if (armored) {
-        src_close(&armorsrc);
-    }
-    if (ret) {
-        key_sequence_destroy(keys);
-    }
-    return ret;
+    return read_pgp_subkey(src, subkey, NULL);
 }
 
-rnp_result_t
-process_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key)
+static rnp_result_t
+read_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key, arena *mem)
 {
     pgp_source_t armorsrc = {0};
     bool         armored = false;
@@ -869,7 +926,7 @@ process_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key)
     }
 
     /* direct-key signatures */
-    if ((ret = process_pgp_key_signatures(src, &key->signatures))) {
+    if ((ret = process_pgp_key_signatures(src, &key->signatures, mem))) {
         RNP_LOG("failed to parse key sigs");
         goto finish;
     }
@@ -888,7 +945,7 @@ process_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key)
             goto finish;
         }
 
-        if ((ret = process_pgp_userid(src, uid))) {
+        if ((ret = read_pgp_userid(src, uid, mem))) {
             goto finish;
         }
     }
@@ -907,7 +964,7 @@ process_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key)
             goto finish;
         }
 
-        if ((ret = process_pgp_subkey(src, subkey))) {
+        if ((ret = read_pgp_subkey(src, subkey, mem))) {
             goto finish;
         }
     }
@@ -923,6 +980,91 @@ finish:
     return ret;
 }
 
+rnp_result_t
+process_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key)
+{
+    return read_pgp_key(src, key, NULL);
+}
+
+rnp_result_t
+process_pgp_keys_arena(pgp_source_t *src, pgp_key_sequence_t *keys, arena *mem)
+{
+    int                     ptag;
+    bool                    armored = false;
+    pgp_source_t            armorsrc = {0};
+    pgp_source_t *          origsrc = src;
+    bool                    has_secret = false;
+    bool                    has_public = false;
+    pgp_transferable_key_t *curkey = NULL;
+    rnp_result_t            ret = RNP_ERROR_GENERIC;
+
+    memset(keys, 0, sizeof(*keys));
+
+    /* check whether keys are armored */
+armoredpass:
+    if (is_armored_source(src)) {
+        if ((ret = init_armored_src(&armorsrc, src))) {
+            RNP_LOG("failed to parse armored data");
+            goto finish;
+        }
+        armored = true;
+        src = &armorsrc;
+    }
+
+    /* read sequence of transferable OpenPGP keys as described in RFC 4880, 11.1 - 11.2 */
+    while (!src_eof(src) && !src_error(src)) {
+        ptag = stream_pkt_type(src);
+
+        if ((ptag < 0) || !is_primary_key_pkt(ptag)) {
+            RNP_LOG("wrong key tag: %d", ptag);
+            ret = RNP_ERROR_BAD_FORMAT;
+            goto finish;
+        }
+
+        if (!(curkey =
+                (pgp_transferable_key_t *) list_append(&keys->keys, NULL, sizeof(*curkey)))) {
+            RNP_LOG("key alloc failed");
+            ret = RNP_ERROR_OUT_OF_MEMORY;
+            goto finish;
+        }
+
+        if ((ret = read_pgp_key(src, curkey, mem))) {
+            goto finish;
+        }
+
+        has_secret |= (ptag == PGP_PTAG_CT_SECRET_KEY);
+        has_public |= (ptag == PGP_PTAG_CT_PUBLIC_KEY);
+    }
+
+    /* file may have multiple armored keys */
+    if (armored && !src_eof(origsrc) && is_armored_source(origsrc)) {
+        src_close(&armorsrc);
+        armored = false;
+        src = origsrc;
+        goto armoredpass;
+    }
+
+    if (has_secret && has_public) {
+        RNP_LOG("warning! public keys are mixed together with secret ones!");
+    }
+
+    ret = RNP_SUCCESS;
+finish:
+    if (armored) {
+        src_close(&armorsrc);
+    }
+    if (ret) {
+        key_sequence_destroy(keys);
+    }
+    return ret;
+}
+
+rnp_result_t
+process_pgp_keys(pgp_source_t *src, pgp_key_sequence_t *keys)
+{
+    return process_pgp_keys_arena(src, keys, NULL);
+}
+
 static bool
 write_pgp_signatures(list signatures, pgp_dest_t *dst)
 {
@@ -1183,7 +1325,8 @@ decrypt_secret_key(pgp_key_pkt_t *key, const char *password)
     }
 
     keysize = pgp_key_size(key->sec_protection.symm_alg);
-    if (!keysize || !pgp_s2k_derive_key(&key->sec_protection.s2k, password, keybuf, keysize)) {
+    if (!keysize ||
+        !pgp_s2k_derive_key_cached(&key->sec_protection.s2k, password, keybuf, keysize)) {
         RNP_LOG("failed to derive key");
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -33,6 +33,7 @@
 #include "rnp.h"
 #include "stream-common.h"
 #include "stream-sig.h"
+#include "arena.h"
 
 /* userid/userattr with all the corresponding signatures */
 typedef struct pgp_transferable_userid_t {
@@ -74,6 +75,24 @@ rnp_result_t transferable_key_from_key(pgp_transferable_key_t *dst, const pgp_ke
 rnp_result_t transferable_key_merge(pgp_transferable_key_t *      dst,
                                     const pgp_transferable_key_t *src);
 
+/**
+ * @brief Remove third-party certifications of each userid above the limit, keeping the first
+ *        ones. Self-signatures and revocations are not affected.
+ *        Certifications are not verified here: signer keys are usually not available, so
+ *        bogus certifications which go first still push out the valid ones over the limit.
+ *
+ * @param key transferable key
+ * @param limit maximum number of third-party certifications per userid, 0 means no limit
+ * @param keep if not NULL, number of the first signatures of each userid, which are counted
+ *             but never removed, i.e. the ones key had before the merge. May be NULL.
+ * @param keep_count number of items in keep. Userids after it have no protected signatures.
+ * @return number of removed certifications
+ */
+size_t transferable_key_limit_certifications(pgp_transferable_key_t *key,
+                                             size_t                  limit,
+                                             const size_t *          keep,
+                                             size_t                  keep_count);
+
 bool transferable_subkey_copy(pgp_transferable_subkey_t *      dst,
                               const pgp_transferable_subkey_t *src,
                               bool                             pubonly);
@@ -102,6 +121,13 @@ void key_sequence_destroy(pgp_key_sequence_t *keys);
 
 rnp_result_t process_pgp_keys(pgp_source_t *src, pgp_key_sequence_t *keys);
 
+/**
+ * @brief Same as process_pgp_keys(), but signatures are read to the memory, allocated from
+ *        the arena, and parsed there in place, see stream_parse_signature_arena().
+ *        Used for key store loading, where the arena keeps the keys' raw packets.
+ */
+rnp_result_t process_pgp_keys_arena(pgp_source_t *src, pgp_key_sequence_t *keys, arena *mem);
+
 rnp_result_t process_pgp_key(pgp_source_t *src, pgp_transferable_key_t *key);
 
 rnp_result_t process_pgp_subkey(pgp_source_t *src, pgp_transferable_subkey_t *subkey);
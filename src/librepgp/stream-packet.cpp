@@ -110,14 +110,11 @@ stream_pkt_type(pgp_source_t *src)
     return get_packet_type(hdr[0]);
 }
 
-ssize_t
-stream_pkt_hdr_len(pgp_source_t *src)
+/* get the packet header length from its first two bytes */
+static ssize_t
+get_pkt_hdr_len(const uint8_t *buf)
 {
-    uint8_t buf[2];
-    ssize_t read;
-
-    read = src_peek(src, buf, 2);
-    if ((read < 2) || !(buf[0] & PGP_PTAG_ALWAYS_SET)) {
+    if (!(buf[0] & PGP_PTAG_ALWAYS_SET)) {
         return -1;
     }
 
@@ -147,6 +144,17 @@ stream_pkt_hdr_len(pgp_source_t *src)
     }
 }
 
+ssize_t
+stream_pkt_hdr_len(pgp_source_t *src)
+{
+    uint8_t buf[2];
+
+    if (src_peek(src, buf, 2) < 2) {
+        return -1;
+    }
+    return get_pkt_hdr_len(buf);
+}
+
 ssize_t
 stream_read_pkt_len(pgp_source_t *src)
 {
@@ -413,8 +421,17 @@ add_packet_body_subpackets(pgp_packet_body_t *body, const pgp_signature_t *sig,
     /* add space for subpackets length */
     res = add_packet_body_uint16(&spbody, 0);
 
-    for (list_item *sp = list_front(sig->subpkts); sp; sp = list_next(sp)) {
-        subpkt = (pgp_sig_subpkt_t *) sp;
+    /* loaded signature, which was not modified, is written as it is. Otherwise subpkts
+     * array is populated. */
+    if (!sig->subpkts_expanded) {
+        const uint8_t *area = NULL;
+        size_t         len = 0;
+        signature_raw_area(sig, hashed, &area, &len);
+        res &= !len || add_packet_body(&spbody, area, len);
+    }
+
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        subpkt = (pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i);
 
         if (subpkt->hashed != hashed) {
             continue;
@@ -483,8 +500,9 @@ get_packet_body_buf(pgp_packet_body_t *body, uint8_t *val, size_t len)
     return true;
 }
 
-bool
-get_packet_body_mpi(pgp_packet_body_t *body, pgp_mpi_t *val)
+/* read the mpi bit count and check it against the following data, returning mpi length */
+static bool
+get_packet_body_mpi_len(pgp_packet_body_t *body, size_t *mpilen)
 {
     uint16_t bits;
     size_t   len;
@@ -502,21 +520,35 @@ get_packet_body_mpi(pgp_packet_body_t *body, pgp_mpi_t *val)
         RNP_LOG("0 mpi");
         return false;
     }
-    if (!get_packet_body_buf(body, val->mpi, len)) {
+    if (body->pos + len > body->len) {
         return false;
     }
     /* check the mpi bit count */
+    uint8_t  hbyte = body->data[body->pos];
     unsigned hbits = bits & 7 ? bits & 7 : 8;
-    if ((((unsigned) val->mpi[0] >> hbits) != 0) ||
-        !((unsigned) val->mpi[0] & (1U << (hbits - 1)))) {
+    if ((((unsigned) hbyte >> hbits) != 0) || !((unsigned) hbyte & (1U << (hbits - 1)))) {
         RNP_LOG("wrong mpi bit count");
         return false;
     }
-
-    val->len = len;
+    *mpilen = len;
     return true;
 }
 
+bool
+get_packet_body_mpi(pgp_packet_body_t *body, pgp_mpi_t *val)
+{
+    size_t len = 0;
+
+    if (!get_packet_body_mpi_len(body, &len)) {
+        return false;
+    }
+    if (!mpi_alloc(val, len)) {
+        RNP_LOG("allocation failed");
+        return false;
+    }
+    return get_packet_body_buf(body, val->mpi, len);
+}
+
 /* @brief Read ECC key curve and convert it to pgp_curve_t */
 static bool
 get_packet_body_key_curve(pgp_packet_body_t *body, pgp_curve_t *val)
@@ -1180,9 +1212,18 @@ stream_parse_pk_sesskey(pgp_source_t *src, pgp_pk_sesskey_t *pkey)
     res = RNP_SUCCESS;
 finish:
     free_packet_body(&pkt);
+    if (res) {
+        free_pk_sesskey(pkey);
+    }
     return res;
 }
 
+void
+free_pk_sesskey(pgp_pk_sesskey_t *pkey)
+{
+    encrypted_material_free(&pkey->material, pkey->alg);
+}
+
 rnp_result_t
 stream_parse_one_pass(pgp_source_t *src, pgp_one_pass_sig_t *onepass)
 {
@@ -1234,7 +1275,8 @@ finish:
 static rnp_result_t
 signature_read_v3(pgp_packet_body_t *pkt, pgp_signature_t *sig)
 {
-    uint8_t buf[16] = {};
+    uint8_t  buf[16] = {};
+    uint8_t *start = pkt->data + pkt->pos;
 
     if (!get_packet_body_buf(pkt, buf, 16)) {
         RNP_LOG("cannot get enough bytes");
@@ -1248,12 +1290,15 @@ signature_read_v3(pgp_packet_body_t *pkt, pgp_signature_t *sig)
     }
 
     /* hashed data */
-    if ((sig->hashed_data = (uint8_t *) malloc(5)) == NULL) {
+    sig->hashed_len = 5;
+    if (sig->raw) {
+        sig->hashed_data = start + 1;
+    } else if ((sig->hashed_data = (uint8_t *) malloc(5)) == NULL) {
         RNP_LOG("allocation failed");
         return RNP_ERROR_OUT_OF_MEMORY;
+    } else {
+        memcpy(sig->hashed_data, &buf[1], 5);
     }
-    memcpy(sig->hashed_data, &buf[1], 5);
-    sig->hashed_len = 5;
 
     /* signature type */
     sig->type = (pgp_sig_type_t) buf[1];
@@ -1430,86 +1475,233 @@ signature_parse_subpacket(pgp_sig_subpkt_t *subpkt)
     return oklen && checked;
 }
 
-/* parse signature subpackets */
+/* parse subpacket length, checking it against the buffer. Returns header length or 0. */
+static size_t
+signature_subpkt_hdr(const uint8_t *buf, size_t len, size_t *splen)
+{
+    size_t hdr;
+
+    if (len < 2) {
+        RNP_LOG("got single byte %d", (int) *buf);
+        return 0;
+    }
+
+    if (*buf < 192) {
+        *splen = *buf;
+        hdr = 1;
+    } else if (*buf < 255) {
+        *splen = ((buf[0] - 192) << 8) + buf[1] + 192;
+        hdr = 2;
+    } else {
+        if (len < 5) {
+            RNP_LOG("got 4-byte len but only %d bytes in buffer", (int) len);
+            return 0;
+        }
+        *splen = read_uint32(&buf[1]);
+        hdr = 5;
+    }
+
+    if (len - hdr < *splen) {
+        RNP_LOG(
+          "got subpacket len %d, while only %d bytes left", (int) *splen, (int) (len - hdr));
+        return 0;
+    }
+    return hdr;
+}
+
+/* fill subpacket's type, flags and data, pointing to the raw signature data */
+static void
+signature_subpkt_from_raw(pgp_sig_subpkt_t *subpkt,
+                          const uint8_t *   buf,
+                          size_t            len,
+                          bool              hashed)
+{
+    subpkt->type = (pgp_sig_subpacket_type_t)(*buf & 0x7f);
+    subpkt->critical = !!(*buf & 0x80);
+    subpkt->hashed = hashed;
+    subpkt->parsed = 0;
+    subpkt->data = (uint8_t *) buf + 1;
+    subpkt->len = len - 1;
+}
+
+void
+signature_raw_area(const pgp_signature_t *sig, bool hashed, const uint8_t **buf, size_t *len)
+{
+    *buf = NULL;
+    *len = 0;
+    if (sig->version < PGP_V4) {
+        return;
+    }
+    if (!hashed) {
+        *buf = sig->unhashed_data;
+        *len = sig->unhashed_len;
+        return;
+    }
+    /* version, type, palg, halg and 2 bytes of the length precede hashed subpackets */
+    if (sig->hashed_data && (sig->hashed_len >= 6)) {
+        *buf = sig->hashed_data + 6;
+        *len = sig->hashed_len - 6;
+    }
+}
+
+/* check signature subpackets for validity and index them. Offsets of unhashed subpackets
+ * are counted from the end of hashed ones, i.e. base is the hashed subpackets length. */
 static bool
-signature_parse_subpackets(pgp_signature_t *sig, uint8_t *buf, size_t len, bool hashed)
+signature_index_subpackets(
+  pgp_signature_t *sig, const uint8_t *buf, size_t len, size_t base, bool hashed)
 {
     pgp_sig_subpkt_t subpkt;
-    size_t           splen;
+    size_t           splen = 0;
+    size_t           pos = 0;
     bool             res = true;
 
-    while (len > 0) {
-        if (len < 2) {
-            RNP_LOG("got single byte %d", (int) *buf);
+    while (pos < len) {
+        size_t hdr = signature_subpkt_hdr(buf + pos, len - pos, &splen);
+        if (!hdr) {
             return false;
         }
-
-        /* subpacket length */
-        if (*buf < 192) {
-            splen = *buf;
-            buf++;
-            len--;
-        } else if (*buf < 255) {
-            splen = ((buf[0] - 192) << 8) + buf[1] + 192;
-            buf += 2;
-            len -= 2;
-        } else {
-            if (len < 5) {
-                RNP_LOG("got 4-byte len but only %d bytes in buffer", (int) len);
-                return false;
-            }
-            splen = read_uint32(&buf[1]);
-            buf += 5;
-            len -= 5;
-        }
+        size_t start = pos;
+        pos += hdr + splen;
 
         if (splen < 1) {
             RNP_LOG("got subpacket with 0 length, skipping");
             continue;
         }
 
-        /* subpacket data */
-        if (len < splen) {
-            RNP_LOG("got subpacket len %d, while only %d bytes left", (int) splen, (int) len);
+        /* subpacket is checked in place, without copying its data */
+        signature_subpkt_from_raw(&subpkt, buf + start + hdr, splen, hashed);
+        res = res && signature_parse_subpacket(&subpkt);
+        if (subpkt.parsed && (subpkt.type == PGP_SIG_SUBPKT_EMBEDDED_SIGNATURE)) {
+            free_signature(&subpkt.fields.sig);
+        }
+
+        if ((subpkt.type < PGP_SIG_SUBPKT_IDX_SIZE) && !sig->subpkt_idx[subpkt.type]) {
+            size_t off = base + start + 1;
+            sig->subpkt_idx[subpkt.type] =
+              off < PGP_SIG_SUBPKT_IDX_FAR ? off : PGP_SIG_SUBPKT_IDX_FAR;
+        }
+    }
+
+    return res;
+}
+
+/* get raw subpacket at the offset pos (hashed ones first, then unhashed), moving pos to the
+ * next one. Subpackets must be already checked with signature_index_subpackets(). */
+static bool
+signature_next_raw_subpkt(const pgp_signature_t *sig, size_t *pos, pgp_sig_subpkt_t *subpkt)
+{
+    const uint8_t *hbuf = NULL;
+    const uint8_t *ubuf = NULL;
+    size_t         hlen = 0;
+    size_t         ulen = 0;
+    size_t         splen = 0;
+
+    signature_raw_area(sig, true, &hbuf, &hlen);
+    signature_raw_area(sig, false, &ubuf, &ulen);
+
+    while (*pos < hlen + ulen) {
+        bool           hashed = *pos < hlen;
+        const uint8_t *buf = hashed ? hbuf + *pos : ubuf + (*pos - hlen);
+        size_t         len = hashed ? hlen - *pos : hlen + ulen - *pos;
+        size_t         hdr = signature_subpkt_hdr(buf, len, &splen);
+        if (!hdr) {
             return false;
         }
+        *pos += hdr + splen;
+        if (splen) {
+            signature_subpkt_from_raw(subpkt, buf + hdr, splen, hashed);
+            return true;
+        }
+    }
+    return false;
+}
 
-        memset(&subpkt, 0, sizeof(subpkt));
+bool
+signature_find_raw_subpkt(const pgp_signature_t *  sig,
+                          pgp_sig_subpacket_type_t type,
+                          pgp_sig_subpkt_t *       subpkt)
+{
+    size_t pos = 0;
 
-        if ((subpkt.data = (uint8_t *) malloc(splen - 1)) == NULL) {
-            RNP_LOG("subpacket data allocation failed");
+    if ((sig->version < PGP_V4) || sig->subpkts_expanded) {
+        return false;
+    }
+    /* index gives the offset of the first subpacket of the type, otherwise scan everything */
+    if (type < PGP_SIG_SUBPKT_IDX_SIZE) {
+        uint16_t idx = sig->subpkt_idx[type];
+        if (!idx) {
             return false;
         }
+        if (idx != PGP_SIG_SUBPKT_IDX_FAR) {
+            pos = idx - 1;
+        }
+    }
+
+    while (signature_next_raw_subpkt(sig, &pos, subpkt)) {
+        if (subpkt->type != type) {
+            continue;
+        }
+        /* embedded signature requires allocation, so is not parsed here */
+        if (type != PGP_SIG_SUBPKT_EMBEDDED_SIGNATURE) {
+            signature_parse_subpacket(subpkt);
+        }
+        return true;
+    }
+    return false;
+}
 
-        subpkt.type = (pgp_sig_subpacket_type_t)(*buf & 0x7f);
-        subpkt.critical = !!(*buf & 0x80);
-        subpkt.hashed = hashed;
-        subpkt.parsed = 0;
-        memcpy(subpkt.data, buf + 1, splen - 1);
-        subpkt.len = splen - 1;
+bool
+signature_expand_subpkts(pgp_signature_t *sig)
+{
+    pgp_sig_subpkt_t raw;
+    size_t           pos = 0;
 
-        res = res && signature_parse_subpacket(&subpkt);
+    if (sig->subpkts_expanded) {
+        return true;
+    }
 
-        if (!list_append(&sig->subpkts, &subpkt, sizeof(subpkt))) {
-            RNP_LOG("allocation failed");
-            return false;
+    while (signature_next_raw_subpkt(sig, &pos, &raw)) {
+        pgp_sig_subpkt_t subpkt;
+        memset(&subpkt, 0, sizeof(subpkt));
+        subpkt.type = raw.type;
+        subpkt.critical = raw.critical;
+        subpkt.hashed = raw.hashed;
+        subpkt.len = raw.len;
+        if (raw.len && !(subpkt.data = (uint8_t *) malloc(raw.len))) {
+            RNP_LOG("subpacket data allocation failed");
+            goto error;
+        }
+        if (raw.len) {
+            memcpy(subpkt.data, raw.data, raw.len);
         }
+        signature_parse_subpacket(&subpkt);
 
-        len -= splen;
-        buf += splen;
+        if (!dynarray_append(&sig->subpkts, &subpkt, sizeof(subpkt))) {
+            RNP_LOG("allocation failed");
+            free_signature_subpkt(&subpkt);
+            goto error;
+        }
     }
 
-    return res;
+    sig->subpkts_expanded = true;
+    return true;
+error:
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        free_signature_subpkt((pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i));
+    }
+    dynarray_destroy(&sig->subpkts);
+    return false;
 }
 
 /* parse v4-specific fields, not the whole signature */
 static rnp_result_t
 signature_read_v4(pgp_packet_body_t *pkt, pgp_signature_t *sig)
 {
-    uint8_t      buf[5];
-    uint8_t *    spbuf;
-    uint16_t     splen;
-    rnp_result_t res = RNP_ERROR_BAD_FORMAT;
+    uint8_t  buf[5];
+    uint16_t splen;
+    uint16_t hsplen;
+    /* hashed data starts with the version byte, which is already read */
+    uint8_t *start = pkt->data + pkt->pos - 1;
 
     if (!get_packet_body_buf(pkt, buf, 5)) {
         RNP_LOG("cannot get first 5 bytes");
@@ -1535,25 +1727,31 @@ signature_read_v4(pgp_packet_body_t *pkt, pgp_signature_t *sig)
     }
 
     /* building hashed data */
-    if ((sig->hashed_data = (uint8_t *) malloc(splen + 6)) == NULL) {
-        RNP_LOG("allocation failed");
-        return RNP_ERROR_OUT_OF_MEMORY;
-    }
+    sig->hashed_len = splen + 6;
+    if (sig->raw) {
+        sig->hashed_data = start;
+        pkt->pos += splen;
+    } else {
+        if ((sig->hashed_data = (uint8_t *) malloc(splen + 6)) == NULL) {
+            RNP_LOG("allocation failed");
+            return RNP_ERROR_OUT_OF_MEMORY;
+        }
 
-    sig->hashed_data[0] = sig->version;
-    memcpy(sig->hashed_data + 1, buf, 5);
+        sig->hashed_data[0] = sig->version;
+        memcpy(sig->hashed_data + 1, buf, 5);
 
-    if (!get_packet_body_buf(pkt, sig->hashed_data + 6, splen)) {
-        RNP_LOG("cannot get hashed subpackets data");
-        return RNP_ERROR_BAD_FORMAT;
+        if (!get_packet_body_buf(pkt, sig->hashed_data + 6, splen)) {
+            RNP_LOG("cannot get hashed subpackets data");
+            return RNP_ERROR_BAD_FORMAT;
+        }
     }
-    sig->hashed_len = splen + 6;
 
-    /* parsing hashed subpackets */
-    if (!signature_parse_subpackets(sig, sig->hashed_data + 6, splen, true)) {
+    /* checking hashed subpackets, they are parsed on demand */
+    if (!signature_index_subpackets(sig, sig->hashed_data + 6, splen, 0, true)) {
         RNP_LOG("failed to parse hashed subpackets");
         return RNP_ERROR_BAD_FORMAT;
     }
+    hsplen = splen;
 
     /* reading unhashed subpackets */
     if (!get_packet_body_uint16(pkt, &splen)) {
@@ -1566,34 +1764,67 @@ signature_read_v4(pgp_packet_body_t *pkt, pgp_signature_t *sig)
         return RNP_ERROR_BAD_FORMAT;
     }
 
-    if ((spbuf = (uint8_t *) malloc(splen)) == NULL) {
-        RNP_LOG("allocation of unhashed subpackets failed");
-        return RNP_ERROR_OUT_OF_MEMORY;
+    if (!splen) {
+        return RNP_SUCCESS;
     }
 
-    if (!get_packet_body_buf(pkt, spbuf, splen)) {
-        RNP_LOG("read of unhashed subpackets failed");
-        goto finish;
+    /* unhashed subpackets are kept in the signature, owned by it unless parsed in place */
+    sig->unhashed_len = splen;
+    if (sig->raw) {
+        sig->unhashed_data = pkt->data + pkt->pos;
+        pkt->pos += splen;
+    } else {
+        if ((sig->unhashed_data = (uint8_t *) malloc(splen)) == NULL) {
+            RNP_LOG("allocation of unhashed subpackets failed");
+            sig->unhashed_len = 0;
+            return RNP_ERROR_OUT_OF_MEMORY;
+        }
+
+        if (!get_packet_body_buf(pkt, sig->unhashed_data, splen)) {
+            RNP_LOG("read of unhashed subpackets failed");
+            return RNP_ERROR_BAD_FORMAT;
+        }
     }
 
-    if (!signature_parse_subpackets(sig, spbuf, splen, false)) {
+    if (!signature_index_subpackets(sig, sig->unhashed_data, splen, hsplen, false)) {
         RNP_LOG("failed to parse unhashed subpackets");
-        goto finish;
+        return RNP_ERROR_BAD_FORMAT;
     }
 
-    res = RNP_SUCCESS;
-finish:
-    free(spbuf);
-    return res;
+    return RNP_SUCCESS;
 }
 
-rnp_result_t
-stream_parse_signature_body(pgp_packet_body_t *pkt, pgp_signature_t *sig)
+/* read signature mpi, referencing the packet data if signature is parsed in place */
+static bool
+get_signature_mpi(pgp_packet_body_t *pkt, const pgp_signature_t *sig, pgp_mpi_t *val)
+{
+    size_t len = 0;
+
+    if (!sig->raw) {
+        return get_packet_body_mpi(pkt, val);
+    }
+    if (!get_packet_body_mpi_len(pkt, &len)) {
+        return false;
+    }
+    val->mpi = pkt->data + pkt->pos;
+    val->len = len;
+    pkt->pos += len;
+    return true;
+}
+
+/* raw is the whole packet if signature is parsed in place, or NULL */
+static rnp_result_t
+signature_parse_body(pgp_packet_body_t *pkt,
+                     pgp_signature_t *  sig,
+                     const uint8_t *    raw,
+                     size_t             raw_len)
 {
     uint8_t      ver;
     rnp_result_t res = RNP_ERROR_BAD_FORMAT;
 
     memset(sig, 0, sizeof(*sig));
+    sig->raw = raw;
+    sig->raw_len = raw_len;
     if (!get_packet_body_byte(pkt, &ver)) {
         goto finish;
     }
@@ -1624,13 +1855,13 @@ stream_parse_signature_body(pgp_packet_body_t *pkt, pgp_signature_t *sig)
     /* signature MPIs */
     switch (sig->palg) {
     case PGP_PKA_RSA:
-        if (!get_packet_body_mpi(pkt, &sig->material.rsa.s)) {
+        if (!get_signature_mpi(pkt, sig, &sig->material.rsa.s)) {
             goto finish;
         }
         break;
     case PGP_PKA_DSA:
-        if (!get_packet_body_mpi(pkt, &sig->material.dsa.r) ||
-            !get_packet_body_mpi(pkt, &sig->material.dsa.s)) {
+        if (!get_signature_mpi(pkt, sig, &sig->material.dsa.r) ||
+            !get_signature_mpi(pkt, sig, &sig->material.dsa.s)) {
             goto finish;
         }
         break;
@@ -1642,14 +1873,14 @@ stream_parse_signature_body(pgp_packet_body_t *pkt, pgp_signature_t *sig)
     case PGP_PKA_ECDSA:
     case PGP_PKA_SM2:
     case PGP_PKA_ECDH:
-        if (!get_packet_body_mpi(pkt, &sig->material.ecc.r) ||
-            !get_packet_body_mpi(pkt, &sig->material.ecc.s)) {
+        if (!get_signature_mpi(pkt, sig, &sig->material.ecc.r) ||
+            !get_signature_mpi(pkt, sig, &sig->material.ecc.s)) {
             goto finish;
         }
         break;
     case PGP_PKA_ELGAMAL_ENCRYPT_OR_SIGN:
-        if (!get_packet_body_mpi(pkt, &sig->material.eg.r) ||
-            !get_packet_body_mpi(pkt, &sig->material.eg.s)) {
+        if (!get_signature_mpi(pkt, sig, &sig->material.eg.r) ||
+            !get_signature_mpi(pkt, sig, &sig->material.eg.s)) {
             goto finish;
         }
         break;
@@ -1670,6 +1901,94 @@ finish:
     return res;
 }
 
+rnp_result_t
+stream_parse_signature_body(pgp_packet_body_t *pkt, pgp_signature_t *sig)
+{
+    return signature_parse_body(pkt, sig, NULL, 0);
+}
+
+rnp_result_t
+stream_parse_signature_raw(const uint8_t *raw, size_t len, pgp_signature_t *sig)
+{
+    pgp_packet_body_t pkt = {};
+    ssize_t           hlen = len < 2 ? -1 : get_pkt_hdr_len(raw);
+    ssize_t           plen;
+
+    /* indeterminate length is not allowed as well */
+    if ((hlen < 2) || ((size_t) hlen > len)) {
+        RNP_LOG("wrong packet header");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    if (get_packet_type(raw[0]) != PGP_PTAG_CT_SIGNATURE) {
+        RNP_LOG("wrong signature ptag: %d", get_packet_type(raw[0]));
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    plen = get_pkt_len((uint8_t *) raw);
+    if ((plen < 0) || ((size_t) plen != len - hlen)) {
+        RNP_LOG("wrong packet length");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+
+    packet_body_part_from_mem(&pkt, raw + hlen, plen);
+    return signature_parse_body(&pkt, sig, raw, len);
+}
+
+rnp_result_t
+stream_parse_signature_arena(pgp_source_t *src, pgp_signature_t *sig, arena *mem)
+{
+    pgp_packet_hdr_t hdr = {};
+    rnp_result_t     res = stream_peek_packet_hdr(src, &hdr);
+
+    if (res) {
+        return res;
+    }
+    if (hdr.tag != PGP_PTAG_CT_SIGNATURE) {
+        RNP_LOG("wrong signature ptag: %d", (int) hdr.tag);
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    if (hdr.partial || hdr.indeterminate) {
+        RNP_LOG("wrong signature packet length");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    if (hdr.pkt_len > PGP_MAX_PKT_SIZE) {
+        RNP_LOG("too large packet");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+
+    uint8_t newhdr[6];
+    newhdr[0] = PGP_PTAG_CT_SIGNATURE | PGP_PTAG_ALWAYS_SET | PGP_PTAG_NEW_FORMAT;
+    size_t   hlen = 1 + write_packet_len(&newhdr[1], hdr.pkt_len);
+    uint8_t *raw = (uint8_t *) arena_alloc(mem, hlen + hdr.pkt_len);
+    if (!raw) {
+        RNP_LOG("allocation failed");
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(raw, newhdr, hlen);
+    src_skip(src, hdr.hdr_len);
+    if (src_read(src, raw + hlen, hdr.pkt_len) != (ssize_t) hdr.pkt_len) {
+        RNP_LOG("failed to read signature packet");
+        return RNP_ERROR_READ;
+    }
+    /* on failure packet memory is just left in the arena */
+    return stream_parse_signature_raw(raw, hlen + hdr.pkt_len, sig);
+}
+
+bool
+signature_own_data(pgp_signature_t *sig)
+{
+    pgp_signature_t copy = {};
+
+    if (!sig->raw) {
+        return true;
+    }
+    if (!copy_signature_packet(&copy, sig)) {
+        return false;
+    }
+    free_signature(sig);
+    *sig = copy;
+    return true;
+}
+
 rnp_result_t
 stream_parse_signature(pgp_source_t *src, pgp_signature_t *sig)
 {
@@ -1700,24 +2019,41 @@ copy_signature_packet(pgp_signature_t *dst, const pgp_signature_t *src)
 
     memcpy(dst, src, sizeof(*src));
     dst->hashed_data = NULL;
-    dst->subpkts = NULL;
+    dst->unhashed_data = NULL;
+    dst->raw = NULL;
+    dst->raw_len = 0;
+    memset(&dst->subpkts, 0, sizeof(dst->subpkts));
+    if (!signature_material_copy(&dst->material, &src->material, src->palg)) {
+        return false;
+    }
     if (src->hashed_data) {
         if (!(dst->hashed_data = (uint8_t *) malloc(dst->hashed_len))) {
+            signature_material_free(&dst->material, dst->palg);
             return false;
         }
         memcpy(dst->hashed_data, src->hashed_data, dst->hashed_len);
     }
-
-    for (list_item *sp = list_front(src->subpkts); sp; sp = list_next(sp)) {
-        pgp_sig_subpkt_t *dstsp;
-        pgp_sig_subpkt_t *srcsp = (pgp_sig_subpkt_t *) sp;
-        /* subpacket may have internal pointers to the subpkt->data ! */
-        dstsp = (pgp_sig_subpkt_t *) list_append(&dst->subpkts, srcsp, sizeof(*dstsp));
-        if (!dstsp) {
+    if (src->unhashed_len) {
+        if (!(dst->unhashed_data = (uint8_t *) malloc(dst->unhashed_len))) {
             free_signature(dst);
             return false;
         }
+        memcpy(dst->unhashed_data, src->unhashed_data, dst->unhashed_len);
+    }
+
+    if (!dynarray_reserve(
+          &dst->subpkts, dynarray_length(&src->subpkts), sizeof(pgp_sig_subpkt_t))) {
+        free_signature(dst);
+        return false;
+    }
+    for (size_t i = 0; i < dynarray_length(&src->subpkts); i++) {
+        pgp_sig_subpkt_t *dstsp;
+        pgp_sig_subpkt_t *srcsp = (pgp_sig_subpkt_t *) dynarray_at(&src->subpkts, i);
+        /* subpacket may have internal pointers to the subpkt->data ! */
+        dstsp = (pgp_sig_subpkt_t *) dynarray_append(&dst->subpkts, srcsp, sizeof(*dstsp));
         if (!(dstsp->data = (uint8_t *) malloc(dstsp->len))) {
+            dstsp->len = 0;
+            memset(&dstsp->fields, 0, sizeof(dstsp->fields));
             free_signature(dst);
             return false;
         }
@@ -1778,11 +2114,15 @@ free_signature_subpkt(pgp_sig_subpkt_t *subpkt)
 void
 free_signature(pgp_signature_t *sig)
 {
-    free(sig->hashed_data);
-    for (list_item *sp = list_front(sig->subpkts); sp; sp = list_next(sp)) {
-        free_signature_subpkt((pgp_sig_subpkt_t *) sp);
+    if (!sig->raw) {
+        free(sig->hashed_data);
+        free(sig->unhashed_data);
+        signature_material_free(&sig->material, sig->palg);
     }
-    list_destroy(&sig->subpkts);
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        free_signature_subpkt((pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i));
+    }
+    dynarray_destroy(&sig->subpkts);
 }
 
 bool
@@ -2202,9 +2542,15 @@ copy_key_pkt(pgp_key_pkt_t *dst, const pgp_key_pkt_t *src, bool pubonly)
     }
 
     memcpy(dst, src, sizeof(*src));
+    dst->hashed_data = NULL;
+    dst->sec_data = NULL;
+    if (!key_material_copy(&dst->material, &src->material, pubonly)) {
+        return false;
+    }
     if (src->hashed_data) {
         dst->hashed_data = (uint8_t *) malloc(src->hashed_len);
         if (!dst->hashed_data) {
+            key_material_free(&dst->material);
             return false;
         }
         memcpy(dst->hashed_data, src->hashed_data, src->hashed_len);
@@ -2214,6 +2560,7 @@ copy_key_pkt(pgp_key_pkt_t *dst, const pgp_key_pkt_t *src, bool pubonly)
         dst->sec_data = (uint8_t *) malloc(src->sec_len);
         if (!dst->sec_data) {
             free(dst->hashed_data);
+            key_material_free(&dst->material);
             return false;
         }
         memcpy(dst->sec_data, src->sec_data, src->sec_len);
@@ -2229,8 +2576,6 @@ copy_key_pkt(pgp_key_pkt_t *dst, const pgp_key_pkt_t *src, bool pubonly)
         dst->tag = PGP_PTAG_CT_PUBLIC_SUBKEY;
     }
 
-    forget_secret_key_fields(&dst->material);
-    dst->sec_data = NULL;
     dst->sec_len = 0;
     memset(&dst->sec_protection, 0, sizeof(dst->sec_protection));
 
@@ -2273,9 +2618,7 @@ free_key_pkt(pgp_key_pkt_t *key)
         pgp_forget(key->sec_data, key->sec_len);
         free(key->sec_data);
     }
-    if (key->material.secret) {
-        pgp_forget(&key->material, sizeof(key->material));
-    }
+    key_material_free(&key->material);
     memset(key, 0, sizeof(*key));
 }
 
@@ -32,6 +32,7 @@
 #include <sys/types.h>
 #include "rnp.h"
 #include "stream-common.h"
+#include "arena.h"
 
 /* maximum size of the 'small' packet */
 #define PGP_MAX_PKT_SIZE 0x100000
@@ -270,6 +271,8 @@ bool stream_write_pk_sesskey(pgp_pk_sesskey_t *pkey, pgp_dest_t *dst);
 
 rnp_result_t stream_parse_pk_sesskey(pgp_source_t *src, pgp_pk_sesskey_t *pkey);
 
+void free_pk_sesskey(pgp_pk_sesskey_t *pkey);
+
 /* One-pass signature */
 
 bool stream_write_one_pass(pgp_one_pass_sig_t *onepass, pgp_dest_t *dst);
@@ -282,10 +285,68 @@ bool stream_write_signature(const pgp_signature_t *sig, pgp_dest_t *dst);
 
 bool signature_parse_subpacket(pgp_sig_subpkt_t *subpkt);
 
+/**
+ * @brief Get raw hashed or unhashed subpackets area of the v4 signature, excluding length.
+ *        Returned data is valid until the signature is modified or destroyed.
+ */
+void signature_raw_area(const pgp_signature_t *sig,
+                        bool                   hashed,
+                        const uint8_t **       buf,
+                        size_t *               len);
+
+/**
+ * @brief Lookup the first subpacket of the specified type in the raw subpackets of the loaded
+ *        signature, using the signature's subpacket index. Nothing is allocated or modified,
+ *        subpkt->data points to the signature's data, and embedded signature is not parsed.
+ * @return true if subpacket was found or false otherwise, including the case when
+ *         signature's subpkts array is already populated.
+ */
+bool signature_find_raw_subpkt(const pgp_signature_t *  sig,
+                               pgp_sig_subpacket_type_t type,
+                               pgp_sig_subpkt_t *       subpkt);
+
+/**
+ * @brief Populate the signature's subpkts array from the raw data, if it was not done yet.
+ *        This modifies the signature, so must not be called on a shared one concurrently.
+ */
+bool signature_expand_subpkts(pgp_signature_t *sig);
+
 rnp_result_t stream_parse_signature_body(pgp_packet_body_t *pkt, pgp_signature_t *sig);
 
 rnp_result_t stream_parse_signature(pgp_source_t *src, pgp_signature_t *sig);
 
+/**
+ * @brief Parse the signature packet in place, without copying its data. Signature's hashed
+ *        and unhashed data, as well as its MPIs, will point to the raw packet, so it must
+ *        stay unchanged and outlive the signature. copy_signature_packet() of such a
+ *        signature gives the one which owns its data.
+ * @param raw whole signature packet, including the header. Partial length is not allowed.
+ * @param len length of the packet
+ * @param sig signature to populate
+ * @return RNP_SUCCESS or error code if packet is malformed
+ */
+rnp_result_t stream_parse_signature_raw(const uint8_t *  raw,
+                                        size_t           len,
+                                        pgp_signature_t *sig);
+
+/**
+ * @brief Read the signature packet from the source to the memory, allocated from the arena,
+ *        and parse it there in place via stream_parse_signature_raw(). Packet is stored
+ *        with the new format header, like stream_write_signature() does, and is available
+ *        via sig->raw, so it may be used as the raw packet without copying.
+ * @param src source to read the packet from
+ * @param sig signature to populate
+ * @param mem arena to allocate the packet from, which must outlive the signature
+ * @return RNP_SUCCESS or error code if packet is malformed or read failed
+ */
+rnp_result_t stream_parse_signature_arena(pgp_source_t *src, pgp_signature_t *sig, arena *mem);
+
+/**
+ * @brief Make the signature, parsed via stream_parse_signature_raw(), own its data.
+ *        Must be called before modifying the signature's hashed data or material.
+ */
+bool signature_own_data(pgp_signature_t *sig);
+
 bool copy_signature_packet(pgp_signature_t *dst, const pgp_signature_t *src);
 
 bool signature_pkt_equal(const pgp_signature_t *sig1, const pgp_signature_t *sig2);
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <time.h>
 #include <rnp/rnp_def.h>
 #include "stream-ctx.h"
@@ -46,6 +47,7 @@
 #include "fingerprint.h"
 #include "pgp-key.h"
 #include "list.h"
+#include "parallel.h"
 
 #ifdef HAVE_ZLIB_H
 #include <zlib.h>
@@ -70,6 +72,17 @@ typedef struct pgp_processing_ctx_t {
     list                sources;
 } pgp_processing_ctx_t;
 
+/* read-ahead state of the multi-threaded AEAD decryption */
+typedef struct pgp_source_aead_batch_t {
+    std::vector<pgp_crypt_t> crypts;  /* cipher instance for each chunk of the batch */
+    std::vector<uint8_t>     buf;     /* encrypted chunks with tags, decrypted in place */
+    size_t                   outlen;  /* number of decrypted bytes at the start of buf */
+    size_t                   outpos;  /* index of the first unread decrypted byte */
+    size_t                   tailpos; /* position of the possible final tag in buf */
+    size_t                   taillen; /* length of the possible final tag */
+    uint64_t                 total;   /* total number of decrypted bytes */
+} pgp_source_aead_batch_t;
+
 /* common fields for encrypted, compressed and literal data */
 typedef struct pgp_source_packet_param_t {
     pgp_source_t *readsrc;                  /* source to read from, could be partial*/
@@ -100,6 +113,9 @@ typedef struct pgp_source_encrypted_param_t {
     pgp_aead_hdr_t            aead_hdr; /* AEAD encryption parameters */
     uint8_t                   aead_ad[PGP_AEAD_MAX_AD_LEN]; /* additional data */
     size_t                    aead_adlen;                   /* length of the additional data */
+    size_t                    threads; /* number of threads to decrypt AEAD chunks */
+    rnp_thread_pool_t *       pool;    /* worker threads to use or NULL */
+    pgp_source_aead_batch_t * batch;   /* multi-threaded AEAD decryption or NULL */
 } pgp_source_encrypted_param_t;
 
 typedef struct pgp_source_signed_param_t {
@@ -113,10 +129,10 @@ typedef struct pgp_source_signed_param_t {
     uint8_t               out[CT_BUF_LEN]; /* cleartext output cache for easier parsing */
     size_t                outlen;          /* total bytes in out */
     size_t                outpos;          /* offset of first available byte in out */
-    list                  onepasses;       /* list of one-pass singatures */
+    dynarray              onepasses;       /* array of one-pass singatures */
     list                  sigs;            /* list of signatures */
-    list                  hashes;          /* hash contexts */
-    list                  siginfos;        /* signature validation info */
+    dynarray              hashes;          /* hash contexts */
+    dynarray              siginfos;        /* signature validation info */
 } pgp_source_signed_param_t;
 
 typedef struct pgp_source_compressed_param_t {
@@ -225,6 +241,46 @@ partial_pkt_src_read(pgp_source_t *src, void *buf, size_t len)
     return write;
 }
 
+static ssize_t
+partial_pkt_src_peek_ptr(pgp_source_t *src, size_t len, const uint8_t **ptr)
+{
+    pgp_source_partial_param_t *param = (pgp_source_partial_param_t *) src->param;
+    ssize_t                     read;
+
+    if (param == NULL) {
+        return -1;
+    }
+
+    if (!param->pleft && !param->last) {
+        // reading next chunk, it is not a part of the data so may be done here
+        read = stream_read_partial_chunk_len(param->readsrc, &param->last);
+        if (read < 0) {
+            return -1;
+        }
+        param->psize = read;
+        param->pleft = read;
+    }
+
+    if (!param->pleft) {
+        return 0;
+    }
+
+    read = src_peek_ptr(param->readsrc, std::min(len, param->pleft), ptr);
+    if (!read) {
+        RNP_LOG("unexpected eof");
+    }
+    return read;
+}
+
+static void
+partial_pkt_src_consume(pgp_source_t *src, size_t len)
+{
+    pgp_source_partial_param_t *param = (pgp_source_partial_param_t *) src->param;
+
+    src_consume(param->readsrc, len);
+    param->pleft -= len;
+}
+
 static void
 partial_pkt_src_close(pgp_source_t *src)
 {
@@ -260,6 +316,8 @@ init_partial_pkt_src(pgp_source_t *src, pgp_source_t *readsrc)
     param->readsrc = readsrc;
 
     src->read = partial_pkt_src_read;
+    src->peek_ptr = partial_pkt_src_peek_ptr;
+    src->consume = partial_pkt_src_consume;
     src->close = partial_pkt_src_close;
     src->type = PGP_STREAM_PARLEN_PACKET;
 
@@ -283,6 +341,24 @@ literal_src_read(pgp_source_t *src, void *buf, size_t len)
     return src_read(param->pkt.readsrc, buf, len);
 }
 
+static ssize_t
+literal_src_peek_ptr(pgp_source_t *src, size_t len, const uint8_t **ptr)
+{
+    pgp_source_literal_param_t *param = (pgp_source_literal_param_t *) src->param;
+    if (!param) {
+        return -1;
+    }
+
+    return src_peek_ptr(param->pkt.readsrc, len, ptr);
+}
+
+static void
+literal_src_consume(pgp_source_t *src, size_t len)
+{
+    pgp_source_literal_param_t *param = (pgp_source_literal_param_t *) src->param;
+    src_consume(param->pkt.readsrc, len);
+}
+
 static void
 literal_src_close(pgp_source_t *src)
 {
@@ -579,6 +655,148 @@ encrypted_src_read_aead_part(pgp_source_encrypted_param_t *param)
     return res;
 }
 
+/* decrypt and authenticate single AEAD chunk or the final tag in place */
+static bool
+encrypted_decrypt_aead_chunk(pgp_source_encrypted_param_t *param,
+                             pgp_crypt_t *                 crypt,
+                             size_t                        idx,
+                             uint8_t *                     data,
+                             size_t                        len,
+                             const uint64_t *              total)
+{
+    uint8_t ad[PGP_AEAD_MAX_AD_LEN];
+    size_t  adlen = param->aead_adlen;
+    uint8_t nonce[PGP_AEAD_MAX_NONCE_LEN];
+    size_t  nlen;
+
+    memcpy(ad, param->aead_ad, adlen);
+    STORE64BE(ad + adlen - 8, idx);
+    if (total) {
+        STORE64BE(ad + adlen, *total);
+        adlen += 8;
+    }
+    nlen = pgp_cipher_aead_nonce(param->aead_hdr.aalg, param->aead_hdr.iv, nonce, idx);
+
+    return pgp_cipher_aead_set_ad(crypt, ad, adlen) &&
+           pgp_cipher_aead_start(crypt, nonce, nlen) &&
+           pgp_cipher_aead_finish(crypt, data, data, len);
+}
+
+/* read ahead a number of chunks and decrypt them in parallel. Should be called only when all
+ * the decrypted data from the previous batch was read. */
+static bool
+encrypted_src_read_aead_batch(pgp_source_encrypted_param_t *param)
+{
+    pgp_source_aead_batch_t *batch = param->batch;
+    size_t                   taglen = pgp_cipher_aead_tag_len(param->aead_hdr.aalg);
+    size_t                   chunkfull = param->chunklen + taglen;
+    size_t                   count = batch->crypts.size();
+    size_t                   need = count * chunkfull + taglen;
+    ssize_t                  read;
+
+    batch->outlen = batch->outpos = 0;
+    if (param->aead_validated) {
+        return true;
+    }
+
+    /* move the final tag candidate, left from the previous batch, and read the rest */
+    memmove(batch->buf.data(), batch->buf.data() + batch->tailpos, batch->taillen);
+    uint8_t *dst = batch->buf.data() + batch->taillen;
+    if ((read = src_read(param->pkt.readsrc, dst, need - batch->taillen)) < 0) {
+        return false;
+    }
+    size_t avail = batch->taillen + read;
+    bool   last = avail < need;
+    if (avail < taglen) {
+        RNP_LOG("unexpected end of data");
+        return false;
+    }
+    size_t datalen = avail - taglen;
+
+    /* split data to chunks: only the last one may be shorter */
+    std::vector<size_t> idxs;
+    size_t              chunkidx = param->chunkidx;
+    for (size_t off = 0; off < datalen; off += chunkfull) {
+        size_t len = std::min(chunkfull, datalen - off);
+        if (len < taglen) {
+            RNP_LOG("unexpected end of data");
+            return false;
+        }
+        idxs.push_back(chunkidx);
+        /* empty chunk doesn't increase the index, see encrypted_src_read_aead_part() */
+        if (len > taglen) {
+            chunkidx++;
+        }
+    }
+
+    std::vector<uint8_t> results(idxs.size(), 0);
+    rnp_parallel_for(param->pool, idxs.size(), param->threads, [&](size_t i) {
+        size_t off = i * chunkfull;
+        size_t len = std::min(chunkfull, datalen - off);
+        results[i] = encrypted_decrypt_aead_chunk(
+          param, &batch->crypts[i], idxs[i], batch->buf.data() + off, len, NULL);
+    });
+
+    /* release decrypted data in order, removing the tags */
+    for (size_t i = 0; i < idxs.size(); i++) {
+        if (!results[i]) {
+            RNP_LOG("failed to finalize aead chunk %zu", idxs[i]);
+            return false;
+        }
+        size_t off = i * chunkfull;
+        size_t len = std::min(chunkfull, datalen - off) - taglen;
+        memmove(batch->buf.data() + batch->outlen, batch->buf.data() + off, len);
+        batch->outlen += len;
+    }
+    batch->total += batch->outlen;
+    param->chunkidx = chunkidx;
+    batch->tailpos = datalen;
+    batch->taillen = taglen;
+
+    if (!last) {
+        return true;
+    }
+
+    /* check the final authentication tag */
+    if (!encrypted_decrypt_aead_chunk(param,
+                                      &batch->crypts[0],
+                                      chunkidx,
+                                      batch->buf.data() + datalen,
+                                      taglen,
+                                      &batch->total)) {
+        RNP_LOG("wrong last chunk");
+        return false;
+    }
+    param->aead_validated = true;
+    return true;
+}
+
+static ssize_t
+encrypted_src_read_aead_mt(pgp_source_encrypted_param_t *param, void *buf, size_t len)
+{
+    pgp_source_aead_batch_t *batch = param->batch;
+    size_t                   left = len;
+
+    while (left > 0) {
+        if (batch->outpos == batch->outlen) {
+            if (param->aead_validated) {
+                break;
+            }
+            if (!encrypted_src_read_aead_batch(param)) {
+                return -1;
+            }
+            continue;
+        }
+        size_t sz = std::min(left, batch->outlen - batch->outpos);
+        memcpy(buf, batch->buf.data() + batch->outpos, sz);
+        batch->outpos += sz;
+        buf = (uint8_t *) buf + sz;
+        left -= sz;
+    }
+
+    return len - left;
+}
+
 static ssize_t
 encrypted_src_read_aead(pgp_source_t *src, void *buf, size_t len)
 {
@@ -586,6 +804,10 @@ encrypted_src_read_aead(pgp_source_t *src, void *buf, size_t len)
     size_t                        cbytes;
     size_t                        left = len;
 
+    if (param->batch) {
+        return encrypted_src_read_aead_mt(param, buf, len);
+    }
+
     do {
         /* check whether we have something in the cache */
         cbytes = param->cachelen - param->cachepos;
@@ -634,9 +856,23 @@ encrypted_src_read_cfb(pgp_source_t *src, void *buf, size_t len)
         return 0;
     }
 
-    read = src_read(param->pkt.readsrc, buf, len);
-    if (read <= 0) {
-        return read;
+    /* decrypt directly from the underlying source's storage to the output */
+    read = 0;
+    while ((size_t) read < len) {
+        const uint8_t *ptr = NULL;
+        ssize_t        avail = src_peek_ptr(param->pkt.readsrc, len - read, &ptr);
+        if (avail < 0) {
+            return -1;
+        }
+        if (!avail) {
+            break;
+        }
+        pgp_cipher_cfb_decrypt(&param->decrypt, (uint8_t *) buf + read, ptr, avail);
+        src_consume(param->pkt.readsrc, avail);
+        read += avail;
+    }
+    if (!read) {
+        return 0;
     }
 
     if (param->has_mdc) {
@@ -648,21 +884,20 @@ encrypted_src_read_cfb(pgp_source_t *src, void *buf, size_t len)
                 return -1;
             }
 
+            /* mdc start is already decrypted to the buf, CFB stream continues on the rest */
             mdcsub = MDC_V1_SIZE - mdcread;
             memmove(&mdcbuf[mdcsub], mdcbuf, mdcread);
+            pgp_cipher_cfb_decrypt(&param->decrypt, &mdcbuf[mdcsub], &mdcbuf[mdcsub], mdcread);
             memcpy(mdcbuf, (uint8_t *) buf + read - mdcsub, mdcsub);
             read -= mdcsub;
             parsemdc = true;
         }
     }
 
-    pgp_cipher_cfb_decrypt(&param->decrypt, (uint8_t *) buf, (uint8_t *) buf, read);
-
     if (param->has_mdc) {
         pgp_hash_add(&param->mdc, buf, read);
 
         if (parsemdc) {
-            pgp_cipher_cfb_decrypt(&param->decrypt, mdcbuf, mdcbuf, MDC_V1_SIZE);
             pgp_cipher_cfb_finish(&param->decrypt);
             pgp_hash_add(&param->mdc, mdcbuf, 2);
             pgp_hash_finish(&param->mdc, hash);
@@ -705,6 +940,19 @@ encrypted_src_finish(pgp_source_t *src)
     return RNP_SUCCESS;
 }
 
+static void
+encrypted_free_aead_batch(pgp_source_encrypted_param_t *param)
+{
+    if (!param->batch) {
+        return;
+    }
+    for (auto &crypt : param->batch->crypts) {
+        pgp_cipher_aead_destroy(&crypt);
+    }
+    delete param->batch;
+    param->batch = NULL;
+}
+
 static void
 encrypted_src_close(pgp_source_t *src)
 {
@@ -714,6 +962,9 @@ encrypted_src_close(pgp_source_t *src)
     }
 
     list_destroy(&param->symencs);
+    for (list_item *pe = list_front(param->pubencs); pe; pe = list_next(pe)) {
+        free_pk_sesskey((pgp_pk_sesskey_t *) pe);
+    }
     list_destroy(&param->pubencs);
 
     if (param->pkt.partial) {
@@ -728,6 +979,8 @@ encrypted_src_close(pgp_source_t *src)
         pgp_cipher_cfb_finish(&param->decrypt);
     }
 
+    encrypted_free_aead_batch(param);
+
     free(src->param);
     src->param = NULL;
 }
@@ -738,7 +991,7 @@ signed_validate_signature(pgp_source_signed_param_t *param, pgp_signature_info_t
     pgp_hash_t shash = {};
 
     /* Get the hash context and clone it */
-    if (!pgp_hash_copy(&shash, pgp_hash_list_get(param->hashes, sinfo->sig->halg))) {
+    if (!pgp_hash_copy(&shash, pgp_hash_list_get(&param->hashes, sinfo->sig->halg))) {
         RNP_LOG("failed to clone hash context");
         sinfo->valid = false;
         return;
@@ -752,7 +1005,7 @@ static void
 signed_src_update(pgp_source_t *src, const void *buf, size_t len)
 {
     pgp_source_signed_param_t *param = (pgp_source_signed_param_t *) src->param;
-    pgp_hash_list_update(param->hashes, buf, len);
+    pgp_hash_list_update(&param->hashes, buf, len);
 }
 
 static ssize_t
@@ -767,6 +1020,25 @@ signed_src_read(pgp_source_t *src, void *buf, size_t len)
     return src_read(param->readsrc, buf, len);
 }
 
+static ssize_t
+signed_src_peek_ptr(pgp_source_t *src, size_t len, const uint8_t **ptr)
+{
+    pgp_source_signed_param_t *param = (pgp_source_signed_param_t *) src->param;
+
+    if (param == NULL) {
+        return -1;
+    }
+
+    return src_peek_ptr(param->readsrc, len, ptr);
+}
+
+static void
+signed_src_consume(pgp_source_t *src, size_t len)
+{
+    pgp_source_signed_param_t *param = (pgp_source_signed_param_t *) src->param;
+    src_consume(param->readsrc, len);
+}
+
 static void
 signed_src_close(pgp_source_t *src)
 {
@@ -776,9 +1048,9 @@ signed_src_close(pgp_source_t *src)
         return;
     }
 
-    list_destroy(&param->onepasses);
+    dynarray_destroy(&param->onepasses);
     pgp_hash_list_free(&param->hashes);
-    list_destroy(&param->siginfos);
+    dynarray_destroy(&param->siginfos);
     for (list_item *sig = list_front(param->sigs); sig; sig = list_next(sig)) {
         free_signature((pgp_signature_t *) sig);
     }
@@ -810,7 +1082,8 @@ signed_read_single_signature(pgp_source_signed_param_t *param,
         return RNP_ERROR_BAD_FORMAT;
     }
 
-    siginfo = (pgp_signature_info_t *) list_append(&param->siginfos, NULL, sizeof(*siginfo));
+    siginfo =
+      (pgp_signature_info_t *) dynarray_append(&param->siginfos, NULL, sizeof(*siginfo));
     if (!siginfo) {
         RNP_LOG("siginfo allocation failed");
         return RNP_ERROR_OUT_OF_MEMORY;
@@ -869,12 +1142,14 @@ signed_read_signatures(pgp_source_t *src)
     pgp_source_signed_param_t *param = (pgp_source_signed_param_t *) src->param;
 
     /* reading signatures */
-    for (list_item *op = list_back(param->onepasses); op; op = list_prev(op)) {
+    for (size_t i = dynarray_length(&param->onepasses); i > 0; i--) {
         if ((ret = signed_read_single_signature(param, src, &sig)) != RNP_SUCCESS) {
             return ret;
         }
 
-        if (!signature_matches_onepass(sig, (pgp_one_pass_sig_t *) op)) {
+        pgp_one_pass_sig_t *onepass =
+          (pgp_one_pass_sig_t *) dynarray_at(&param->onepasses, i - 1);
+        if (!signature_matches_onepass(sig, onepass)) {
             RNP_LOG("signature doesn't match one-pass");
             return RNP_ERROR_BAD_FORMAT;
         }
@@ -888,8 +1163,6 @@ signed_src_finish(pgp_source_t *src)
 {
     pgp_source_signed_param_t *param = (pgp_source_signed_param_t *) src->param;
     pgp_signature_info_t *     sinfo = NULL;
-    pgp_signature_info_t *     sinfos = NULL;
-    unsigned                   sinfoc = 0;
     pgp_key_request_ctx_t      keyctx;
     pgp_key_t *                key = NULL;
     rnp_result_t               ret = RNP_ERROR_GENERIC;
@@ -908,18 +1181,12 @@ signed_src_finish(pgp_source_t *src)
         RNP_LOG("warning: unexpected data on the stream end");
     }
 
-    sinfos = (pgp_signature_info_t *) calloc(list_length(param->siginfos),
-                                             sizeof(pgp_signature_info_t));
-    if (!sinfos) {
-        return RNP_ERROR_OUT_OF_MEMORY;
-    }
-
     /* validating signatures */
     keyctx.op = PGP_OP_VERIFY;
     keyctx.search.type = PGP_KEY_SEARCH_KEYID;
 
-    for (list_item *si = list_front(param->siginfos); si; si = list_next(si)) {
-        sinfo = (pgp_signature_info_t *) si;
+    for (size_t i = 0; i < dynarray_length(&param->siginfos); i++) {
+        sinfo = (pgp_signature_info_t *) dynarray_at(&param->siginfos, i);
         if (!sinfo->sig) {
             continue;
         }
@@ -951,10 +1218,8 @@ signed_src_finish(pgp_source_t *src)
 
     /* checking the validation results */
     ret = RNP_SUCCESS;
-    for (list_item *si = list_front(param->siginfos); si; si = list_next(si)) {
-        sinfo = (pgp_signature_info_t *) si;
-        sinfos[sinfoc++] = *sinfo;
-
+    for (size_t i = 0; i < dynarray_length(&param->siginfos); i++) {
+        sinfo = (pgp_signature_info_t *) dynarray_at(&param->siginfos, i);
         if (sinfo->no_signer && param->ctx->handler.ctx->discard) {
             /* if output is discarded then we interested in verification */
             ret = RNP_ERROR_SIGNATURE_INVALID;
@@ -966,12 +1231,14 @@ signed_src_finish(pgp_source_t *src)
         }
     }
 
-    /* call the callback with signature infos */
+    /* call the callback with signature infos, which are stored contiguously */
     if (param->ctx->handler.on_signatures) {
-        param->ctx->handler.on_signatures(sinfos, sinfoc, param->ctx->handler.param);
+        param->ctx->handler.on_signatures(
+          (pgp_signature_info_t *) dynarray_at(&param->siginfos, 0),
+          dynarray_length(&param->siginfos),
+          param->ctx->handler.param);
     }
 
-    free(sinfos);
     return ret;
 }
 
@@ -1250,6 +1517,40 @@ error:
     return false;
 }
 
+static bool
+encrypted_start_aead_mt(pgp_source_encrypted_param_t *param, uint8_t *key)
+{
+    pgp_source_aead_batch_t *batch = NULL;
+    size_t                   taglen = pgp_cipher_aead_tag_len(param->aead_hdr.aalg);
+
+    try {
+        batch = new pgp_source_aead_batch_t();
+        batch->buf.resize(param->threads * (param->chunklen + taglen) + taglen);
+        batch->crypts.reserve(param->threads);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        delete batch;
+        return false;
+    }
+    /* botan's cipher objects are not thread-safe, so each chunk gets its own one */
+    for (size_t i = 0; i < param->threads; i++) {
+        pgp_crypt_t crypt = {};
+        if (!pgp_cipher_aead_init(
+              &crypt, param->aead_hdr.ealg, param->aead_hdr.aalg, key, true)) {
+            for (auto &bcrypt : batch->crypts) {
+                pgp_cipher_aead_destroy(&bcrypt);
+            }
+            delete batch;
+            return false;
+        }
+        batch->crypts.push_back(crypt);
+    }
+    /* batch may be left from the previous key, which failed later on */
+    encrypted_free_aead_batch(param);
+    param->batch = batch;
+    return true;
+}
+
 static bool
 encrypted_start_aead(pgp_source_encrypted_param_t *param, pgp_symm_alg_t alg, uint8_t *key)
 {
@@ -1271,6 +1572,11 @@ encrypted_start_aead(pgp_source_encrypted_param_t *param, pgp_symm_alg_t alg, ui
         return false;
     }
 
+    if ((param->threads > 1) && (param->chunklen <= PGP_AEAD_MT_MAX_CHUNK_LEN) &&
+        !encrypted_start_aead_mt(param, key)) {
+        return false;
+    }
+
     return encrypted_start_aead_chunk(param, 0, false);
 }
 
@@ -1407,7 +1713,7 @@ encrypted_try_password(pgp_source_encrypted_param_t *param, const char *password
         pgp_sk_sesskey_t *skey = (pgp_sk_sesskey_t *) se;
 
         keysize = pgp_key_size(skey->alg);
-        if (!keysize || !pgp_s2k_derive_key(&skey->s2k, password, keybuf, keysize)) {
+        if (!keysize || !pgp_s2k_derive_key_cached(&skey->s2k, password, keybuf, keysize)) {
             continue;
         }
         RNP_DHEX("derived key: ", keybuf, keysize);
@@ -1569,6 +1875,8 @@ init_literal_src(pgp_source_t *src, pgp_source_t *readsrc)
     param = (pgp_source_literal_param_t *) src->param;
     param->pkt.readsrc = readsrc;
     src->read = literal_src_read;
+    src->peek_ptr = literal_src_peek_ptr;
+    src->consume = literal_src_consume;
     src->close = literal_src_close;
     src->type = PGP_STREAM_LITERAL;
 
@@ -1791,6 +2099,7 @@ encrypted_read_packet_data(pgp_source_encrypted_param_t *param)
             }
 
             if (!list_append(&param->pubencs, &pkey, sizeof(pkey))) {
+                free_pk_sesskey(&pkey);
                 return RNP_ERROR_OUT_OF_MEMORY;
             }
         } else if ((ptype == PGP_PTAG_CT_SE_DATA) || (ptype == PGP_PTAG_CT_SE_IP_DATA) ||
@@ -1872,6 +2181,8 @@ init_encrypted_src(pgp_processing_ctx_t *ctx, pgp_source_t *src, pgp_source_t *r
     }
     param = (pgp_source_encrypted_param_t *) src->param;
     param->pkt.readsrc = readsrc;
+    param->threads = ctx->handler.ctx ? ctx->handler.ctx->aead_threads : 0;
+    param->pool = ctx->handler.ctx ? ctx->handler.ctx->pool : NULL;
 
     src->close = encrypted_src_close;
     src->finish = encrypted_src_finish;
@@ -2043,6 +2354,10 @@ init_signed_src(pgp_processing_ctx_t *ctx, pgp_source_t *src, pgp_source_t *read
     param->ctx = ctx;
     param->cleartext = cleartext;
     src->read = cleartext ? cleartext_src_read : signed_src_read;
+    if (!cleartext) {
+        src->peek_ptr = signed_src_peek_ptr;
+        src->consume = signed_src_consume;
+    }
     src->close = signed_src_close;
     src->finish = signed_src_finish;
     src->type = cleartext ? PGP_STREAM_CLEARTEXT : PGP_STREAM_SIGNED;
@@ -2078,7 +2393,7 @@ init_signed_src(pgp_processing_ctx_t *ctx, pgp_source_t *src, pgp_source_t *read
                 continue;
             }
 
-            if (!list_append(&param->onepasses, &onepass, sizeof(onepass))) {
+            if (!dynarray_append(&param->onepasses, &onepass, sizeof(onepass))) {
                 errcode = RNP_ERROR_OUT_OF_MEMORY;
                 goto finish;
             }
@@ -2109,12 +2424,12 @@ init_signed_src(pgp_processing_ctx_t *ctx, pgp_source_t *src, pgp_source_t *read
     }
 
     /* checking what we have now */
-    if (!list_length(param->onepasses) && !list_length(param->sigs)) {
+    if (!dynarray_length(&param->onepasses) && !list_length(param->sigs)) {
         RNP_LOG("no signatures");
         errcode = RNP_ERROR_BAD_PARAMETERS;
         goto finish;
     }
-    if (list_length(param->onepasses) && list_length(param->sigs)) {
+    if (dynarray_length(&param->onepasses) && list_length(param->sigs)) {
         RNP_LOG("warning: one-passes are mixed with signatures");
     }
 
@@ -2269,7 +2584,7 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t *src)
     pgp_source_t         datasrc = {0};
     pgp_dest_t *         outdest = NULL;
     bool                 closeout = true;
-    uint8_t *            readbuf = NULL;
+    const uint8_t *      readptr = NULL;
     char *               filename = NULL;
 
     init_processing_ctx(&ctx);
@@ -2297,12 +2612,6 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t *src)
         goto finish;
     }
 
-    if ((readbuf = (uint8_t *) calloc(1, PGP_INPUT_CACHE_SIZE)) == NULL) {
-        RNP_LOG("allocation failure");
-        res = RNP_ERROR_OUT_OF_MEMORY;
-        goto finish;
-    }
-
     if (ctx.msg_type == PGP_MESSAGE_DETACHED) {
         /* detached signature case */
         if (!handler->src_provider || !handler->src_provider(handler, &datasrc)) {
@@ -2311,13 +2620,15 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t *src)
             goto finish;
         }
 
+        /* data is hashed in place, without copying it out of the source */
         while (!datasrc.eof) {
-            read = src_read(&datasrc, readbuf, PGP_INPUT_CACHE_SIZE);
+            read = src_peek_ptr(&datasrc, PGP_INPUT_CACHE_SIZE, &readptr);
             if (read < 0) {
                 res = RNP_ERROR_GENERIC;
                 break;
             } else if (read > 0) {
-                signed_src_update(ctx.signed_src, readbuf, read);
+                signed_src_update(ctx.signed_src, readptr, read);
+                src_consume(&datasrc, read);
             }
         }
 
@@ -2335,9 +2646,9 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t *src)
             goto finish;
         }
 
-        /* reading the input */
+        /* reading the input, borrowing data from the last layer which stored it */
         while (!decsrc->eof) {
-            read = src_read(decsrc, readbuf, PGP_INPUT_CACHE_SIZE);
+            read = src_peek_ptr(decsrc, PGP_INPUT_CACHE_SIZE, &readptr);
             if (read < 0) {
                 res = RNP_ERROR_GENERIC;
                 break;
@@ -2346,9 +2657,10 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t *src)
                 continue;
             }
             if (ctx.signed_src) {
-                signed_src_update(ctx.signed_src, readbuf, read);
+                signed_src_update(ctx.signed_src, readptr, read);
             }
-            dst_write(outdest, readbuf, read);
+            dst_write(outdest, readptr, read);
+            src_consume(decsrc, read);
             if (outdest->werr != RNP_SUCCESS) {
                 RNP_LOG("failed to output data");
                 res = RNP_ERROR_WRITE;
@@ -2373,6 +2685,5 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t *src)
 
 finish:
     free_processing_ctx(&ctx);
-    free(readbuf);
     return res;
 }
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <rnp/rnp_def.h>
+#include "stream-pipe.h"
+#include "utils.h"
+
+typedef struct pgp_dest_pipe_param_t {
+    pgp_dest_t              orig;                 /* original dest, used by the worker */
+    uint8_t *               bufs[PGP_PIPE_SLOTS]; /* ring of the buffers */
+    size_t                  lens[PGP_PIPE_SLOTS]; /* number of bytes in each buffer */
+    size_t                  blocksize;            /* size of each buffer */
+    size_t                  fill;                 /* bytes in the buffer being filled */
+    std::atomic<size_t>     head;                 /* number of consumed buffers */
+    std::atomic<size_t>     tail;                 /* number of buffers passed to the worker */
+    std::atomic<bool>       eof;                  /* no more buffers will be passed */
+    std::atomic<bool>       abort;                /* pipe is closed without finishing */
+    std::atomic<bool>       failed;               /* writing to the original dest failed */
+    std::atomic<bool>       pwait;                /* producer waits for the free buffer */
+    std::atomic<bool>       cwait;                /* consumer waits for the data */
+    std::mutex              lock;
+    std::condition_variable cond;
+    std::thread             worker;
+    rnp_result_t            werr;                 /* worker's result, valid after join */
+
+    pgp_dest_pipe_param_t()
+        : bufs(), lens(), blocksize(0), fill(0), head(0), tail(0), eof(false), abort(false),
+          failed(false), pwait(false), cwait(false), werr(RNP_SUCCESS)
+    {
+    }
+} pgp_dest_pipe_param_t;
+
+/* Queue operations do not lock anything unless the other side sleeps: waiting side raises its
+ * flag before checking the queue state, and notifying side checks the flag after changing
+ * the state, so with sequentially consistent atomics at least one of them sees the other. */
+template <typename Pred>
+static void
+pipe_wait(pgp_dest_pipe_param_t *param, std::atomic<bool> &waiting, Pred pred)
+{
+    if (pred()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(param->lock);
+    waiting = true;
+    param->cond.wait(lock, pred);
+    waiting = false;
+}
+
+static void
+pipe_notify(pgp_dest_pipe_param_t *param, std::atomic<bool> &waiting)
+{
+    if (waiting) {
+        std::lock_guard<std::mutex> lock(param->lock);
+        param->cond.notify_all();
+    }
+}
+
+static void
+pipe_worker(pgp_dest_pipe_param_t *param)
+{
+    while (true) {
+        size_t head = param->head;
+        pipe_wait(param, param->cwait, [param, head]() {
+            return (param->tail != head) || param->eof;
+        });
+        if (param->tail == head) {
+            /* eof is set after the last buffer is passed, so there is nothing left */
+            break;
+        }
+        /* after the failure or abort buffers are just skipped to unblock the producer */
+        if (!param->failed && !param->abort) {
+            size_t slot = head % PGP_PIPE_SLOTS;
+            dst_write(&param->orig, param->bufs[slot], param->lens[slot]);
+            if (param->orig.werr) {
+                param->werr = param->orig.werr;
+                param->failed = true;
+            }
+        }
+        param->head = head + 1;
+        pipe_notify(param, param->pwait);
+    }
+
+    if (!param->failed && !param->abort) {
+        param->werr = dst_finish(&param->orig);
+        param->failed = param->werr != RNP_SUCCESS;
+    }
+}
+
+static void
+pipe_push(pgp_dest_pipe_param_t *param)
+{
+    param->lens[param->tail % PGP_PIPE_SLOTS] = param->fill;
+    param->fill = 0;
+    param->tail++;
+    pipe_notify(param, param->cwait);
+}
+
+static rnp_result_t
+pipe_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
+{
+    pgp_dest_pipe_param_t *param = (pgp_dest_pipe_param_t *) dst->param;
+
+    while (len) {
+        if (param->failed) {
+            return RNP_ERROR_WRITE;
+        }
+        /* wait for the free buffer before starting to fill it */
+        if (!param->fill) {
+            size_t tail = param->tail;
+            pipe_wait(param, param->pwait, [param, tail]() {
+                return tail - param->head < PGP_PIPE_SLOTS;
+            });
+        }
+        uint8_t *slotbuf = param->bufs[param->tail % PGP_PIPE_SLOTS];
+        size_t   sz = std::min(len, param->blocksize - param->fill);
+        memcpy(slotbuf + param->fill, buf, sz);
+        param->fill += sz;
+        buf = (uint8_t *) buf + sz;
+        len -= sz;
+        if (param->fill == param->blocksize) {
+            pipe_push(param);
+        }
+    }
+    return RNP_SUCCESS;
+}
+
+static void
+pipe_stop(pgp_dest_pipe_param_t *param, bool abort)
+{
+    if (!param->worker.joinable()) {
+        return;
+    }
+    if (param->fill && !abort) {
+        pipe_push(param);
+    }
+    param->abort = abort;
+    param->eof = true;
+    {
+        /* eof is not a part of the queue, so notify under the lock unconditionally */
+        std::lock_guard<std::mutex> lock(param->lock);
+        param->cond.notify_all();
+    }
+    param->worker.join();
+}
+
+static rnp_result_t
+pipe_dst_finish(pgp_dest_t *dst)
+{
+    pgp_dest_pipe_param_t *param = (pgp_dest_pipe_param_t *) dst->param;
+
+    pipe_stop(param, false);
+    return param->werr;
+}
+
+static void
+pipe_dst_close(pgp_dest_t *dst, bool discard)
+{
+    pgp_dest_pipe_param_t *param = (pgp_dest_pipe_param_t *) dst->param;
+
+    if (!param) {
+        return;
+    }
+
+    pipe_stop(param, true);
+    dst_close(&param->orig, discard || param->failed);
+    for (size_t i = 0; i < PGP_PIPE_SLOTS; i++) {
+        free(param->bufs[i]);
+    }
+    delete param;
+    dst->param = NULL;
+}
+
+rnp_result_t
+init_pipe_dst(pgp_dest_t *dst)
+{
+    pgp_dest_pipe_param_t *param = NULL;
+
+    try {
+        param = new pgp_dest_pipe_param_t();
+    } catch (const std::exception &e) {
+        RNP_LOG("allocation failed: %s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+
+    param->blocksize = std::min((size_t) dst->csize, (size_t) PGP_PIPE_MAX_BLOCK_SIZE);
+    if (!param->blocksize) {
+        param->blocksize = PGP_OUTPUT_CACHE_SIZE;
+    }
+    for (size_t i = 0; i < PGP_PIPE_SLOTS; i++) {
+        if (!(param->bufs[i] = (uint8_t *) malloc(param->blocksize))) {
+            RNP_LOG("allocation failed");
+            goto error;
+        }
+    }
+
+    /* pipe batches data itself, so flush and disable the original cache */
+    dst_flush(dst);
+    if (dst->werr) {
+        goto error;
+    }
+    param->orig = *dst;
+    param->orig.no_cache = true;
+    try {
+        param->worker = std::thread(pipe_worker, param);
+    } catch (const std::exception &e) {
+        RNP_LOG("failed to start worker thread: %s", e.what());
+        goto error;
+    }
+
+    /* original dest is owned by the pipe now, including it's cache and param */
+    memset(dst, 0, sizeof(*dst));
+    dst->write = pipe_dst_write;
+    dst->finish = pipe_dst_finish;
+    dst->close = pipe_dst_close;
+    dst->type = PGP_STREAM_PIPE;
+    dst->param = param;
+    dst->werr = RNP_SUCCESS;
+    dst->no_cache = true;
+    return RNP_SUCCESS;
+error:
+    for (size_t i = 0; i < PGP_PIPE_SLOTS; i++) {
+        free(param->bufs[i]);
+    }
+    delete param;
+    return RNP_ERROR_GENERIC;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2020, [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef STREAM_PIPE_H_
+#define STREAM_PIPE_H_
+
+#include "stream-common.h"
+
+/* number of buffers in the queue between the threads */
+#define PGP_PIPE_SLOTS 8
+/* maximum size of the single buffer in the queue */
+#define PGP_PIPE_MAX_BLOCK_SIZE 262144
+
+/** @brief Move processing of the data, written to the dest, to the separate thread.
+ *         dst is converted in place to the pipe stream, which passes data to the worker
+ *         thread via the bounded single-producer/single-consumer queue of buffers. Worker
+ *         writes data to the original dest, and finishes it when pipe is finished.
+ *         Dests, to which original one writes, are used by the worker thread till the pipe
+ *         is finished or closed, so they must not be accessed by the caller meanwhile.
+ *         Pipe itself may be written only from a single thread at a time.
+ *
+ *  @param dst initialized dest
+ *  @return RNP_SUCCESS on success, or error code otherwise. On failure dst is left unchanged.
+ **/
+rnp_result_t init_pipe_dst(pgp_dest_t *dst);
+
+#endif
@@ -55,23 +55,57 @@ signature_matches_onepass(pgp_signature_t *sig, pgp_one_pass_sig_t *onepass)
            (sig->palg == onepass->palg) && (sig->type == onepass->type);
 }
 
-pgp_sig_subpkt_t *
-signature_get_subpkt(const pgp_signature_t *sig, pgp_sig_subpacket_type_t type)
+/* lookup subpacket in the subpkts array if it is populated, or in the raw data otherwise.
+ * In the latter case view is filled and returned, without any allocations. */
+static const pgp_sig_subpkt_t *
+signature_find_subpkt(const pgp_signature_t *  sig,
+                      pgp_sig_subpacket_type_t type,
+                      pgp_sig_subpkt_t *       view)
+{
+    if (!sig || (sig->version < PGP_V4)) {
+        return NULL;
+    }
+
+    if (!sig->subpkts_expanded) {
+        return signature_find_raw_subpkt(sig, type, view) ? view : NULL;
+    }
+
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i);
+        if (subpkt->type == type) {
+            return subpkt;
+        }
+    }
+    return NULL;
+}
+
+static bool
+signature_has_subpkt(const pgp_signature_t *sig, pgp_sig_subpacket_type_t type)
 {
-    pgp_sig_subpkt_t *res = NULL;
+    pgp_sig_subpkt_t view;
+    return signature_find_subpkt(sig, type, &view);
+}
 
+pgp_sig_subpkt_t *
+signature_get_subpkt(pgp_signature_t *sig, pgp_sig_subpacket_type_t type)
+{
     if (!sig || (sig->version < PGP_V4)) {
         return NULL;
     }
 
-    for (list_item *sp = list_front(sig->subpkts); sp; sp = list_next(sp)) {
-        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) sp;
+    if (!signature_expand_subpkts(sig)) {
+        RNP_LOG("failed to parse subpackets");
+        return NULL;
+    }
+
+    for (size_t i = 0; i < dynarray_length(&sig->subpkts); i++) {
+        pgp_sig_subpkt_t *subpkt = (pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, i);
         if (subpkt->type == type) {
             return subpkt;
         }
     }
 
-    return res;
+    return NULL;
 }
 
 pgp_sig_subpkt_t *
@@ -91,6 +125,10 @@ signature_add_subpkt(pgp_signature_t *        sig,
         return NULL;
     }
 
+    if (!signature_expand_subpkts(sig)) {
+        return NULL;
+    }
+
     if (reuse && (subpkt = signature_get_subpkt(sig, type))) {
         free(subpkt->data);
         memset(subpkt, 0, sizeof(*subpkt));
@@ -98,12 +136,12 @@ signature_add_subpkt(pgp_signature_t *        sig,
 
     if (!subpkt) {
         pgp_sig_subpkt_t s = {(pgp_sig_subpacket_type_t) 0};
-        subpkt = (pgp_sig_subpkt_t *) list_append(&sig->subpkts, &s, sizeof(s));
+        subpkt = (pgp_sig_subpkt_t *) dynarray_append(&sig->subpkts, &s, sizeof(s));
     }
 
     if (!subpkt || ((datalen > 0) && !(subpkt->data = (uint8_t *) calloc(1, datalen)))) {
         RNP_LOG("data allocation failed");
-        list_remove((list_item *) subpkt);
+        signature_remove_subpkt(sig, subpkt);
         return NULL;
     }
 
@@ -116,9 +154,14 @@ signature_add_subpkt(pgp_signature_t *        sig,
 void
 signature_remove_subpkt(pgp_signature_t *sig, pgp_sig_subpkt_t *subpkt)
 {
-    if (list_is_member(sig->subpkts, (list_item *) subpkt)) {
+    pgp_sig_subpkt_t *first = (pgp_sig_subpkt_t *) dynarray_at(&sig->subpkts, 0);
+    if (!subpkt || !first || (subpkt < first)) {
+        return;
+    }
+    size_t idx = subpkt - first;
+    if (idx < dynarray_length(&sig->subpkts)) {
         free_signature_subpkt(subpkt);
-        list_remove((list_item *) subpkt);
+        dynarray_remove(&sig->subpkts, idx);
     }
 }
 
@@ -131,20 +174,21 @@ signature_get_type(const pgp_signature_t *sig)
 bool
 signature_has_keyfp(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR);
 }
 
 bool
 signature_get_keyfp(const pgp_signature_t *sig, pgp_fingerprint_t *fp)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
     if (!sig || !fp || (sig->version < PGP_V4)) {
         return false;
     }
 
     fp->length = 0;
-    if (!(subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR))) {
+    if (!(subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR, &view))) {
         return false;
     }
     fp->length = subpkt->fields.issuer_fp.len;
@@ -188,14 +232,15 @@ signature_has_keyid(const pgp_signature_t *sig)
     }
 
     return (sig->version < PGP_V4) ||
-           signature_get_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_KEY_ID) ||
-           signature_get_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR);
+           signature_has_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_KEY_ID) ||
+           signature_has_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR);
 }
 
 bool
 signature_get_keyid(const pgp_signature_t *sig, uint8_t *id)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
     if (!sig || !id) {
         return false;
@@ -208,11 +253,11 @@ signature_get_keyid(const pgp_signature_t *sig, uint8_t *id)
     }
 
     /* version 4 and up use subpackets */
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_KEY_ID))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_KEY_ID, &view))) {
         memcpy(id, subpkt->fields.issuer, PGP_KEY_ID_SIZE);
         return true;
     }
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_ISSUER_FPR, &view))) {
         memcpy(id,
                subpkt->fields.issuer_fp.fp + subpkt->fields.issuer_fp.len - PGP_KEY_ID_SIZE,
                PGP_KEY_ID_SIZE);
@@ -251,7 +296,8 @@ signature_set_keyid(pgp_signature_t *sig, const uint8_t *id)
 uint32_t
 signature_get_creation(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
     if (!sig) {
         return 0;
@@ -259,7 +305,7 @@ signature_get_creation(const pgp_signature_t *sig)
     if (sig->version < PGP_V4) {
         return sig->creation_time;
     }
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_CREATION_TIME))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_CREATION_TIME, &view))) {
         return subpkt->fields.create;
     }
 
@@ -294,9 +340,10 @@ signature_set_creation(pgp_signature_t *sig, uint32_t ctime)
 uint32_t
 signature_get_expiration(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_EXPIRATION_TIME))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_EXPIRATION_TIME, &view))) {
         return subpkt->fields.expiry;
     }
 
@@ -327,15 +374,16 @@ signature_set_expiration(pgp_signature_t *sig, uint32_t etime)
 bool
 signature_has_key_expiration(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_KEY_EXPIRY);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_KEY_EXPIRY);
 }
 
 uint32_t
 signature_get_key_expiration(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_KEY_EXPIRY))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_KEY_EXPIRY, &view))) {
         return subpkt->fields.expiry;
     }
 
@@ -362,15 +410,16 @@ signature_set_key_expiration(pgp_signature_t *sig, uint32_t etime)
 bool
 signature_has_key_flags(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_KEY_FLAGS);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_KEY_FLAGS);
 }
 
 uint8_t
 signature_get_key_flags(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_KEY_FLAGS))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_KEY_FLAGS, &view))) {
         return subpkt->fields.key_flags;
     }
 
@@ -397,9 +446,10 @@ signature_set_key_flags(pgp_signature_t *sig, uint8_t flags)
 bool
 signature_get_primary_uid(pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_PRIMARY_USER_ID))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_PRIMARY_USER_ID, &view))) {
         return subpkt->fields.primary_uid;
     }
 
@@ -450,13 +500,14 @@ signature_get_preferred_algs(const pgp_signature_t *  sig,
                              size_t *                 len,
                              pgp_sig_subpacket_type_t type)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
     if (!algs || !len) {
         return false;
     }
 
-    if ((subpkt = signature_get_subpkt(sig, type))) {
+    if ((subpkt = signature_find_subpkt(sig, type, &view))) {
         *algs = subpkt->fields.preferred.arr;
         *len = subpkt->fields.preferred.len;
         return true;
@@ -468,7 +519,7 @@ signature_get_preferred_algs(const pgp_signature_t *  sig,
 bool
 signature_has_preferred_symm_algs(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_PREFERRED_SKA);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_PREFERRED_SKA);
 }
 
 bool
@@ -486,7 +537,7 @@ signature_set_preferred_symm_algs(pgp_signature_t *sig, uint8_t algs[], size_t l
 bool
 signature_has_preferred_hash_algs(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_PREFERRED_HASH);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_PREFERRED_HASH);
 }
 
 bool
@@ -504,7 +555,7 @@ signature_set_preferred_hash_algs(pgp_signature_t *sig, uint8_t algs[], size_t l
 bool
 signature_has_preferred_z_algs(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_PREF_COMPRESS);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_PREF_COMPRESS);
 }
 
 bool
@@ -522,15 +573,16 @@ signature_set_preferred_z_algs(pgp_signature_t *sig, uint8_t algs[], size_t len)
 bool
 signature_has_key_server_prefs(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_KEYSERV_PREFS);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_KEYSERV_PREFS);
 }
 
 uint8_t
 signature_get_key_server_prefs(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_KEYSERV_PREFS))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_KEYSERV_PREFS, &view))) {
         return subpkt->data[0];
     }
 
@@ -576,15 +628,16 @@ signature_set_preferred_key_server(pgp_signature_t *sig, const char *uri)
 bool
 signature_has_trust(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_TRUST);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_TRUST);
 }
 
 bool
 signature_get_trust(const pgp_signature_t *sig, uint8_t *level, uint8_t *amount)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_TRUST))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_TRUST, &view))) {
         if (level) {
             *level = subpkt->fields.trust.level;
         }
@@ -619,9 +672,10 @@ signature_set_trust(pgp_signature_t *sig, uint8_t level, uint8_t amount)
 bool
 signature_get_revocable(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_REVOCABLE))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_REVOCABLE, &view))) {
         return subpkt->fields.revocable;
     }
 
@@ -764,15 +818,16 @@ signature_add_notation_data(pgp_signature_t *sig,
 bool
 signature_has_key_server(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_PREF_KEYSERV);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_PREF_KEYSERV);
 }
 
 char *
 signature_get_key_server(const pgp_signature_t *sig)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_PREF_KEYSERV))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_PREF_KEYSERV, &view))) {
         char *res = (char *) malloc(subpkt->len + 1);
         if (res) {
             memcpy(res, subpkt->data, subpkt->len);
@@ -787,15 +842,16 @@ signature_get_key_server(const pgp_signature_t *sig)
 bool
 signature_has_revocation_reason(const pgp_signature_t *sig)
 {
-    return signature_get_subpkt(sig, PGP_SIG_SUBPKT_REVOCATION_REASON);
+    return signature_has_subpkt(sig, PGP_SIG_SUBPKT_REVOCATION_REASON);
 }
 
 bool
 signature_get_revocation_reason(const pgp_signature_t *sig, uint8_t *code, char **reason)
 {
-    pgp_sig_subpkt_t *subpkt;
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt;
 
-    if ((subpkt = signature_get_subpkt(sig, PGP_SIG_SUBPKT_REVOCATION_REASON))) {
+    if ((subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_REVOCATION_REASON, &view))) {
         if (code) {
             *code = subpkt->fields.revocation_reason.code;
         }
@@ -830,6 +886,11 @@ signature_fill_hashed_data(pgp_signature_t *sig)
         RNP_LOG("don't know version %d", (int) sig->version);
         return false;
     }
+    /* signature will be recalculated, so it cannot reference the raw packet anymore */
+    if (!signature_own_data(sig)) {
+        RNP_LOG("failed to copy signature data");
+        return false;
+    }
 
     if (!init_packet_body(&hbody, 0)) {
         RNP_LOG("allocation failed");
@@ -849,6 +910,7 @@ signature_fill_hashed_data(pgp_signature_t *sig)
 
     if (res) {
         /* get ownership on body data */
+        free(sig->hashed_data);
         sig->hashed_data = hbody.data;
         sig->hashed_len = hbody.len;
         return res;
@@ -1008,6 +1070,37 @@ signature_validate_certification(const pgp_signature_t *   sig,
     return signature_validate(sig, signer, &hash);
 }
 
+/* parse primary key binding signature, embedded into the sig. esig must be freed by caller */
+static bool
+signature_get_primary_binding(const pgp_signature_t *sig, pgp_signature_t *esig)
+{
+    pgp_sig_subpkt_t        view;
+    const pgp_sig_subpkt_t *subpkt = NULL;
+    pgp_packet_body_t       pkt = {};
+
+    if (!(subpkt = signature_find_subpkt(sig, PGP_SIG_SUBPKT_EMBEDDED_SIGNATURE, &view))) {
+        RNP_LOG("error! no primary key binding signature");
+        return false;
+    }
+    packet_body_part_from_mem(&pkt, subpkt->data, subpkt->len);
+    if (stream_parse_signature_body(&pkt, esig)) {
+        RNP_LOG("invalid embedded signature subpacket");
+        return false;
+    }
+    if (esig->type != PGP_SIG_PRIMARY) {
+        RNP_LOG("invalid primary key binding signature");
+        goto error;
+    }
+    if (esig->version < PGP_V4) {
+        RNP_LOG("invalid primary key binding signature version");
+        goto error;
+    }
+    return true;
+error:
+    free_signature(esig);
+    return false;
+}
+
 rnp_result_t
 signature_validate_binding(const pgp_signature_t *sig,
                            const pgp_key_pkt_t *  key,
@@ -1030,29 +1123,13 @@ signature_validate_binding(const pgp_signature_t *sig,
 
     /* check primary key binding signature if any */
     if (!res && (signature_get_key_flags(sig) & PGP_KF_SIGN)) {
-        pgp_sig_subpkt_t *subpkt =
-          signature_get_subpkt(sig, PGP_SIG_SUBPKT_EMBEDDED_SIGNATURE);
-        if (!subpkt) {
-            RNP_LOG("error! no primary key binding signature");
-            res = RNP_ERROR_SIGNATURE_INVALID;
-            goto finish;
-        }
-        if (!subpkt->parsed) {
-            RNP_LOG("invalid embedded signature subpacket");
-            res = RNP_ERROR_SIGNATURE_INVALID;
-            goto finish;
-        }
-        if (subpkt->fields.sig.type != PGP_SIG_PRIMARY) {
-            RNP_LOG("invalid primary key binding signature");
+        pgp_signature_t esig = {};
+        if (!signature_get_primary_binding(sig, &esig)) {
             res = RNP_ERROR_SIGNATURE_INVALID;
             goto finish;
         }
-        if (subpkt->fields.sig.version < PGP_V4) {
-            RNP_LOG("invalid primary key binding signature version");
-            res = RNP_ERROR_SIGNATURE_INVALID;
-            goto finish;
-        }
-        res = signature_validate(&subpkt->fields.sig, &subkey->material, &hashcp);
+        res = signature_validate(&esig, &subkey->material, &hashcp);
+        free_signature(&esig);
     }
 finish:
     pgp_hash_finish(&hashcp, NULL);
@@ -1097,8 +1174,11 @@ signature_check(pgp_signature_info_t *sinfo, pgp_hash_t *hash)
 
     /* Validate signature itself */
     if (sinfo->signer_valid || sinfo->signer->valid) {
-        sinfo->valid =
-          !signature_validate(sinfo->sig, pgp_key_get_material(sinfo->signer), hash);
+        sinfo->valid = !signature_validate_cached(sinfo->sig,
+                                                  pgp_key_get_material(sinfo->signer),
+                                                  hash,
+                                                  sinfo->cache,
+                                                  pgp_key_get_fp(sinfo->signer));
     } else {
         sinfo->valid = false;
         RNP_LOG("invalid or untrusted key");
@@ -1222,25 +1302,12 @@ signature_check_binding(pgp_signature_info_t *sinfo,
     if (!res && (signature_get_key_flags(sinfo->sig) & PGP_KF_SIGN)) {
         res = RNP_ERROR_SIGNATURE_INVALID;
         sinfo->valid = false;
-        pgp_sig_subpkt_t *subpkt =
-          signature_get_subpkt(sinfo->sig, PGP_SIG_SUBPKT_EMBEDDED_SIGNATURE);
-        if (!subpkt) {
-            RNP_LOG("error! no primary key binding signature");
-            goto finish;
-        }
-        if (!subpkt->parsed) {
-            RNP_LOG("invalid embedded signature subpacket");
-            goto finish;
-        }
-        if (subpkt->fields.sig.type != PGP_SIG_PRIMARY) {
-            RNP_LOG("invalid primary key binding signature");
-            goto finish;
-        }
-        if (subpkt->fields.sig.version < PGP_V4) {
-            RNP_LOG("invalid primary key binding signature version");
+        pgp_signature_t esig = {};
+        if (!signature_get_primary_binding(sinfo->sig, &esig)) {
             goto finish;
         }
-        res = signature_validate(&subpkt->fields.sig, &subkey->material, &hashcp);
+        res = signature_validate(&esig, &subkey->material, &hashcp);
+        free_signature(&esig);
         sinfo->valid = !res;
     }
 finish:
@@ -32,6 +32,7 @@
 #include <sys/types.h>
 #include "rnp.h"
 #include "stream-common.h"
+#include "sig-cache.h"
 
 /* information about the validated signature */
 typedef struct pgp_signature_info_t {
@@ -42,6 +43,7 @@ typedef struct pgp_signature_info_t {
     bool             no_signer; /* no signer's public key available */
     bool             expired;   /* signature is expired */
     bool             signer_valid; /* assume that signing key is valid */
+    pgp_sig_cache_t *cache;        /* optional cache of the verification results */
 } pgp_signature_info_t;
 
 /**
@@ -53,12 +55,15 @@ typedef struct pgp_signature_info_t {
 bool signature_matches_onepass(pgp_signature_t *sig, pgp_one_pass_sig_t *onepass);
 
 /**
- * @brief Get v4 signature's subpacket of the specified type
+ * @brief Get v4 signature's subpacket of the specified type.
+ *        Loaded signature's subpackets are parsed on demand, populating sig->subpkts, so this
+ *        must not be called on a shared signature concurrently. signature_get_* functions
+ *        read the raw data instead, and do not modify the signature.
  * @param sig loaded or populated signature, could not be NULL
  * @param type type of the subpacket to lookup for
  * @return pointer to the subpacket structure or NULL if it was not found or error occurred
  */
-pgp_sig_subpkt_t *signature_get_subpkt(const pgp_signature_t *  sig,
+pgp_sig_subpkt_t *signature_get_subpkt(pgp_signature_t *        sig,
                                        pgp_sig_subpacket_type_t type);
 
 /**
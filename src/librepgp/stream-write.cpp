@@ -44,13 +44,16 @@
 #include "stream-packet.h"
 #include "stream-armor.h"
 #include "stream-sig.h"
+#include "stream-pipe.h"
 #include "list.h"
 #include "pgp-key.h"
 #include "fingerprint.h"
 #include "types.h"
 #include "crypto/signatures.h"
+#include "parallel.h"
 #include <time.h>
 #include <algorithm>
+#include <vector>
 
 /* 8192 bytes, as GnuPG */
 #define PGP_PARTIAL_PKT_SIZE_BITS (13)
@@ -67,6 +70,25 @@ typedef struct pgp_dest_packet_param_t {
     size_t      hdrlen;                   /* number of bytes in hdr */
 } pgp_dest_packet_param_t;
 
+/* multi-threaded compression state: input is split into blocks, which are compressed
+ * independently and concatenated into a single stream */
+typedef struct pgp_dest_compress_batch_t {
+    std::vector<z_stream>             zs;       /* deflate stream for each block */
+    std::vector<std::vector<uint8_t>> out;      /* compressed blocks */
+    std::vector<uint8_t>              in;       /* cached input blocks */
+    size_t                            len;      /* number of cached input bytes */
+    size_t                            blocklen; /* length of the input block */
+    size_t                            threads;  /* number of threads to use */
+    rnp_thread_pool_t *               pool;     /* worker threads to use or NULL */
+    int                               level;    /* compression level */
+    std::vector<uint8_t>              dict;     /* deflate: end of previous input */
+    uint32_t                          adler;    /* zlib: adler32 of the input */
+    uint32_t                          bzcrc;    /* bzip2: combined stream crc */
+    uint64_t                          bits;     /* bzip2: bit accumulator */
+    unsigned                          bitcount; /* bzip2: bits in accumulator */
+    std::vector<uint8_t>              bitbuf;   /* bzip2: bit writer output */
+} pgp_dest_compress_batch_t;
+
 typedef struct pgp_dest_compressed_param_t {
     pgp_dest_packet_param_t pkt;
     pgp_compression_type_t  alg;
@@ -77,8 +99,17 @@ typedef struct pgp_dest_compressed_param_t {
     bool    zstarted;                        /* whether we initialize zlib/bzip2  */
     uint8_t cache[PGP_INPUT_CACHE_SIZE / 2]; /* pre-allocated cache for compression */
     size_t  len;                             /* number of bytes cached */
+    pgp_dest_compress_batch_t *batch;        /* multi-threaded compression or NULL */
 } pgp_dest_compressed_param_t;
 
+/* multi-threaded AEAD encryption state */
+typedef struct pgp_dest_aead_batch_t {
+    std::vector<pgp_crypt_t> crypts; /* cipher instance for each chunk of the batch */
+    std::vector<uint8_t>     buf;    /* chunks, each followed by the space for tag */
+    size_t                   len;    /* number of cached plaintext bytes */
+    uint64_t                 total;  /* total number of encrypted bytes */
+} pgp_dest_aead_batch_t;
+
 typedef struct pgp_dest_encrypted_param_t {
     pgp_dest_packet_param_t pkt;     /* underlying packet-related params */
     rnp_ctx_t *             ctx;     /* rnp operation context with additional parameters */
@@ -95,6 +126,7 @@ typedef struct pgp_dest_encrypted_param_t {
     size_t                  chunkidx; /* index of the current AEAD chunk */
     size_t                  cachelen; /* how many bytes are in cache, for AEAD */
     uint8_t                 cache[PGP_AEAD_CACHE_LEN]; /* pre-allocated cache for encryption */
+    pgp_dest_aead_batch_t * batch; /* multi-threaded AEAD encryption or NULL */
 } pgp_dest_encrypted_param_t;
 
 typedef struct pgp_dest_signer_info_t {
@@ -110,7 +142,7 @@ typedef struct pgp_dest_signed_param_t {
     rnp_ctx_t *              ctx;      /* rnp operation context with additional parameters */
     pgp_password_provider_t *password_provider; /* password provider from write handler */
     list                     siginfos;          /* list of  pgp_dest_signer_info_t */
-    list                     hashes;    /* hashes to pass raw data through and then sign */
+    dynarray                 hashes;    /* hashes to pass raw data through and then sign */
     bool                     clr_start; /* we are on the start of the line */
     uint8_t                  clr_buf[CT_BUF_LEN]; /* buffer to hold partial line data */
     size_t                   clr_buflen;          /* number of bytes in buffer */
@@ -378,6 +410,133 @@ encrypted_start_aead_chunk(pgp_dest_encrypted_param_t *param, size_t idx, bool l
     return res ? RNP_SUCCESS : RNP_ERROR_BAD_PARAMETERS;
 }
 
+/* encrypt single AEAD chunk or produce the final tag in place */
+static bool
+encrypted_encrypt_aead_chunk(pgp_dest_encrypted_param_t *param,
+                             pgp_crypt_t *               crypt,
+                             size_t                      idx,
+                             uint8_t *                   data,
+                             size_t                      len,
+                             const uint64_t *            total)
+{
+    uint8_t ad[PGP_AEAD_MAX_AD_LEN];
+    size_t  adlen = param->adlen;
+    uint8_t nonce[PGP_AEAD_MAX_NONCE_LEN];
+    size_t  nlen;
+
+    memcpy(ad, param->ad, adlen);
+    STORE64BE(ad + adlen - 8, idx);
+    if (total) {
+        STORE64BE(ad + adlen, *total);
+        adlen += 8;
+    }
+    nlen = pgp_cipher_aead_nonce(param->aalg, param->iv, nonce, idx);
+
+    return pgp_cipher_aead_set_ad(crypt, ad, adlen) &&
+           pgp_cipher_aead_start(crypt, nonce, nlen) &&
+           pgp_cipher_aead_finish(crypt, data, data, len);
+}
+
+/* encrypt all the cached chunks in parallel and write them out */
+static rnp_result_t
+encrypted_dst_flush_aead_batch(pgp_dest_encrypted_param_t *param)
+{
+    pgp_dest_aead_batch_t *batch = param->batch;
+    size_t                 taglen = pgp_cipher_aead_tag_len(param->aalg);
+    size_t                 chunkfull = param->chunklen + taglen;
+    size_t                 count = (batch->len + param->chunklen - 1) / param->chunklen;
+
+    if (!count) {
+        return RNP_SUCCESS;
+    }
+
+    std::vector<uint8_t> results(count, 0);
+    rnp_parallel_for(param->ctx->pool, count, param->ctx->aead_threads, [&](size_t i) {
+        size_t len = std::min(param->chunklen, batch->len - i * param->chunklen);
+        results[i] = encrypted_encrypt_aead_chunk(param,
+                                                  &batch->crypts[i],
+                                                  param->chunkidx + i,
+                                                  batch->buf.data() + i * chunkfull,
+                                                  len,
+                                                  NULL);
+    });
+    for (size_t i = 0; i < count; i++) {
+        if (!results[i]) {
+            RNP_LOG("failed to encrypt aead chunk");
+            return RNP_ERROR_BAD_STATE;
+        }
+    }
+
+    /* only the last chunk may be incomplete, so output is contiguous */
+    dst_write(param->pkt.writedst, batch->buf.data(), batch->len + count * taglen);
+    param->chunkidx += count;
+    batch->total += batch->len;
+    batch->len = 0;
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+encrypted_dst_write_aead_mt(pgp_dest_encrypted_param_t *param, const void *buf, size_t len)
+{
+    pgp_dest_aead_batch_t *batch = param->batch;
+    size_t                 taglen = pgp_cipher_aead_tag_len(param->aalg);
+    size_t                 capacity = batch->crypts.size() * param->chunklen;
+    rnp_result_t           res;
+
+    while (len > 0) {
+        if (batch->len == capacity) {
+            if ((res = encrypted_dst_flush_aead_batch(param))) {
+                return res;
+            }
+        }
+        /* copy up to the end of the current chunk */
+        size_t chunk = batch->len / param->chunklen;
+        size_t chunkpos = batch->len % param->chunklen;
+        size_t sz = std::min(len, param->chunklen - chunkpos);
+        memcpy(batch->buf.data() + chunk * (param->chunklen + taglen) + chunkpos, buf, sz);
+        batch->len += sz;
+        buf = (uint8_t *) buf + sz;
+        len -= sz;
+    }
+
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+encrypted_dst_finish_aead_mt(pgp_dest_encrypted_param_t *param)
+{
+    uint8_t      tag[PGP_AEAD_MAX_TAG_LEN];
+    rnp_result_t res;
+
+    if ((res = encrypted_dst_flush_aead_batch(param))) {
+        return res;
+    }
+    if (!encrypted_encrypt_aead_chunk(param,
+                                      &param->batch->crypts[0],
+                                      param->chunkidx,
+                                      tag,
+                                      0,
+                                      &param->batch->total)) {
+        RNP_LOG("failed to write final aead tag");
+        return RNP_ERROR_BAD_STATE;
+    }
+    dst_write(param->pkt.writedst, tag, pgp_cipher_aead_tag_len(param->aalg));
+    return RNP_SUCCESS;
+}
+
+static void
+encrypted_dst_destroy_aead_mt(pgp_dest_encrypted_param_t *param)
+{
+    if (!param->batch) {
+        return;
+    }
+    for (auto &crypt : param->batch->crypts) {
+        pgp_cipher_aead_destroy(&crypt);
+    }
+    delete param->batch;
+    param->batch = NULL;
+}
+
 static rnp_result_t
 encrypted_dst_write_aead(pgp_dest_t *dst, const void *buf, size_t len)
 {
@@ -396,6 +555,10 @@ encrypted_dst_write_aead(pgp_dest_t *dst, const void *buf, size_t len)
         return RNP_SUCCESS;
     }
 
+    if (param->batch) {
+        return encrypted_dst_write_aead_mt(param, buf, len);
+    }
+
     /* because of botan's FFI granularity we need to make things a bit complicated */
     gran = pgp_cipher_aead_granularity(&param->encrypt);
 
@@ -442,7 +605,15 @@ encrypted_dst_finish(pgp_dest_t *dst)
     pgp_dest_encrypted_param_t *param = (pgp_dest_encrypted_param_t *) dst->param;
     rnp_result_t                res;
 
-    if (param->aead) {
+    if (param->aead && param->batch) {
+        res = encrypted_dst_finish_aead_mt(param);
+        encrypted_dst_destroy_aead_mt(param);
+        pgp_cipher_aead_destroy(&param->encrypt);
+
+        if (res) {
+            return res;
+        }
+    } else if (param->aead) {
         size_t chunks = param->chunkidx;
         /* if we didn't write anything in current chunk then discard it and restart */
         if (param->chunkout || param->cachelen) {
@@ -481,6 +652,7 @@ encrypted_dst_close(pgp_dest_t *dst, bool discard)
         pgp_cipher_cfb_finish(&param->encrypt);
     } else {
         pgp_cipher_aead_destroy(&param->encrypt);
+        encrypted_dst_destroy_aead_mt(param);
     }
     close_streamed_packet(&param->pkt, discard);
     free(param);
@@ -592,6 +764,7 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
 
     ret = RNP_SUCCESS;
 finish:
+    free_pk_sesskey(&pkey);
     pgp_forget(enckey, sizeof(enckey));
     pgp_forget(&checksum, sizeof(checksum));
     return ret;
@@ -747,6 +920,35 @@ encrypted_start_cfb(pgp_dest_encrypted_param_t *param, uint8_t *enckey)
     return RNP_SUCCESS;
 }
 
+static rnp_result_t
+encrypted_start_aead_mt(pgp_dest_encrypted_param_t *param, uint8_t *enckey)
+{
+    size_t threads = param->ctx->aead_threads;
+    size_t taglen = pgp_cipher_aead_tag_len(param->ctx->aalg);
+
+    try {
+        param->batch = new pgp_dest_aead_batch_t();
+        param->batch->buf.resize(threads * (param->chunklen + taglen));
+        param->batch->crypts.reserve(threads);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        delete param->batch;
+        param->batch = NULL;
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    /* botan's cipher objects are not thread-safe, so each chunk gets its own one */
+    for (size_t i = 0; i < threads; i++) {
+        pgp_crypt_t crypt = {};
+        if (!pgp_cipher_aead_init(
+              &crypt, param->ctx->ealg, param->ctx->aalg, enckey, false)) {
+            encrypted_dst_destroy_aead_mt(param);
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+        param->batch->crypts.push_back(crypt);
+    }
+    return RNP_SUCCESS;
+}
+
 static rnp_result_t
 encrypted_start_aead(pgp_dest_encrypted_param_t *param, uint8_t *enckey)
 {
@@ -789,6 +991,13 @@ encrypted_start_aead(pgp_dest_encrypted_param_t *param, uint8_t *enckey)
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
+    if ((param->ctx->aead_threads > 1) && (param->chunklen <= PGP_AEAD_MT_MAX_CHUNK_LEN)) {
+        rnp_result_t res = encrypted_start_aead_mt(param, enckey);
+        if (res) {
+            return res;
+        }
+    }
+
     return encrypted_start_aead_chunk(param, 0, false);
 }
 
@@ -962,14 +1171,14 @@ cleartext_dst_writeline(pgp_dest_signed_param_t *param,
         }
 
         /* hashing line body and \r\n */
-        pgp_hash_list_update(param->hashes, buf, ptr + 1 - buf);
+        pgp_hash_list_update(&param->hashes, buf, ptr + 1 - buf);
         if (hashcrlf) {
-            pgp_hash_list_update(param->hashes, ST_CRLF, 2);
+            pgp_hash_list_update(&param->hashes, ST_CRLF, 2);
         }
         param->clr_start = hashcrlf;
     } else if (len > 0) {
         /* hashing just line's data */
-        pgp_hash_list_update(param->hashes, buf, len);
+        pgp_hash_list_update(&param->hashes, buf, len);
         param->clr_start = false;
     }
 }
@@ -1076,7 +1285,7 @@ signed_fill_signature(pgp_dest_signed_param_t *param,
         return RNP_ERROR_OUT_OF_MEMORY;
     }
 
-    if (!pgp_hash_copy(&hash, pgp_hash_list_get(param->hashes, sig->halg))) {
+    if (!pgp_hash_copy(&hash, pgp_hash_list_get(&param->hashes, sig->halg))) {
         RNP_LOG("failed to obtain hash");
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -1222,7 +1431,7 @@ static void
 signed_dst_update(pgp_dest_t *dst, const void *buf, size_t len)
 {
     pgp_dest_signed_param_t *param = (pgp_dest_signed_param_t *) dst->param;
-    pgp_hash_list_update(param->hashes, buf, len);
+    pgp_hash_list_update(&param->hashes, buf, len);
 }
 
 static rnp_result_t
@@ -1321,7 +1530,7 @@ init_signed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *write
     }
 
     /* Do we have any signatures? */
-    if (!list_length(param->hashes)) {
+    if (!dynarray_length(&param->hashes)) {
         ret = RNP_ERROR_BAD_PARAMETERS;
         goto finish;
     }
@@ -1332,10 +1541,10 @@ init_signed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *write
         dst_write(param->writedst, ST_CRLF, strlen(ST_CRLF));
         dst_write(param->writedst, ST_HEADER_HASH, strlen(ST_HEADER_HASH));
 
-        for (list_item *hash = list_front(param->hashes); hash; hash = list_next(hash)) {
-            hname = pgp_hash_name((pgp_hash_t *) hash);
+        for (size_t i = 0; i < dynarray_length(&param->hashes); i++) {
+            hname = pgp_hash_name((pgp_hash_t *) dynarray_at(&param->hashes, i));
             dst_write(param->writedst, hname, strlen(hname));
-            if (hash != list_back(param->hashes)) {
+            if (i + 1 < dynarray_length(&param->hashes)) {
                 dst_write(param->writedst, ST_COMMA, 1);
             }
         }
@@ -1352,6 +1561,345 @@ finish:
     return ret;
 }
 
+/* deflate: length of the input block, compressed independently */
+#define PGP_ZIP_MT_BLOCK_LEN 131072
+/* deflate: window size, block is primed with this amount of the previous input */
+#define PGP_ZIP_MT_DICT_LEN 32768
+/* bzip2: input length which always fits a single bzip2 block, since initial run-length
+ * encoding may expand data up to 1.25 times */
+#define PGP_BZ_MT_BLOCK_LEN(level) (((level) * 100000 - 19) / 5 * 4 - 8)
+
+static bool
+compressed_mt_supported(pgp_compression_type_t alg)
+{
+    switch (alg) {
+    case PGP_C_ZIP:
+    case PGP_C_ZLIB:
+        return true;
+#ifdef HAVE_BZLIB_H
+    case PGP_C_BZIP2:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static void
+compressed_destroy_mt(pgp_dest_compressed_param_t *param)
+{
+    if (!param->batch) {
+        return;
+    }
+    for (auto &z : param->batch->zs) {
+        deflateEnd(&z);
+    }
+    delete param->batch;
+    param->batch = NULL;
+}
+
+static rnp_result_t
+compressed_start_mt(pgp_dest_compressed_param_t *param,
+                    int                          level,
+                    size_t                       threads,
+                    rnp_thread_pool_t *          pool)
+{
+    pgp_dest_compress_batch_t *batch = NULL;
+    bool                       bzip2 = param->alg == PGP_C_BZIP2;
+
+    if (bzip2 && ((level < 1) || (level > 9))) {
+        RNP_LOG("wrong bzip2 level %d", level);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    try {
+        batch = new pgp_dest_compress_batch_t();
+        batch->blocklen = bzip2 ? PGP_BZ_MT_BLOCK_LEN(level) : PGP_ZIP_MT_BLOCK_LEN;
+        batch->in.resize(threads * batch->blocklen);
+        batch->out.resize(threads);
+        if (!bzip2) {
+            /* z_stream must not be moved after the initialization */
+            batch->zs.resize(threads);
+            batch->dict.reserve(PGP_ZIP_MT_DICT_LEN);
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        delete batch;
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    batch->threads = threads;
+    batch->pool = pool;
+    batch->level = level;
+    batch->adler = adler32(0, Z_NULL, 0);
+    param->batch = batch;
+
+    size_t outlen = batch->blocklen + batch->blocklen / 100 + 600;
+    for (size_t i = 0; !bzip2 && (i < threads); i++) {
+        /* blocks are raw deflate streams, zlib header and trailer are written separately */
+        if (deflateInit2(&batch->zs[i], level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+            Z_OK) {
+            RNP_LOG("failed to init zlib");
+            compressed_destroy_mt(param);
+            return RNP_ERROR_NOT_SUPPORTED;
+        }
+        /* sync flush marker is not counted by deflateBound() */
+        outlen = deflateBound(&batch->zs[i], batch->blocklen) + 16;
+    }
+    try {
+        for (auto &out : batch->out) {
+            out.resize(outlen);
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        compressed_destroy_mt(param);
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (param->alg == PGP_C_ZLIB) {
+        int     zlevel = level < 0 ? 6 : level;
+        uint8_t hdr[2] = {0x78, 0};
+        hdr[1] = (zlevel < 2 ? 0 : (zlevel < 6 ? 1 : (zlevel == 6 ? 2 : 3))) << 6;
+        hdr[1] += 31 - ((hdr[0] << 8) + hdr[1]) % 31;
+        dst_write(param->pkt.writedst, hdr, 2);
+    }
+    if (bzip2) {
+        uint8_t hdr[4] = {'B', 'Z', 'h', (uint8_t)('0' + level)};
+        dst_write(param->pkt.writedst, hdr, 4);
+    }
+    return RNP_SUCCESS;
+}
+
+static bool
+compressed_deflate_block(z_stream *            z,
+                         const uint8_t *       dict,
+                         size_t                dictlen,
+                         const uint8_t *       in,
+                         size_t                len,
+                         bool                  last,
+                         std::vector<uint8_t> &out,
+                         size_t *              outlen)
+{
+    if (deflateReset(z) != Z_OK) {
+        return false;
+    }
+    if (dictlen && (deflateSetDictionary(z, dict, dictlen) != Z_OK)) {
+        return false;
+    }
+    z->next_in = (Bytef *) in;
+    z->avail_in = len;
+    z->next_out = out.data();
+    z->avail_out = out.size();
+    /* sync flush ends the block on the byte boundary, so blocks may be concatenated */
+    int zret = deflate(z, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((zret != (last ? Z_STREAM_END : Z_OK)) || z->avail_in) {
+        return false;
+    }
+    *outlen = out.size() - z->avail_out;
+    return true;
+}
+
+#ifdef HAVE_BZLIB_H
+static bool
+compressed_bzip2_block(int                   level,
+                       const uint8_t *       in,
+                       size_t                len,
+                       std::vector<uint8_t> &out,
+                       size_t *              outlen)
+{
+    bz_stream bz = {};
+    int       zret;
+
+    if (BZ2_bzCompressInit(&bz, level, 0, 0) != BZ_OK) {
+        return false;
+    }
+    bz.next_in = (char *) in;
+    bz.avail_in = len;
+    bz.next_out = (char *) out.data();
+    bz.avail_out = out.size();
+    do {
+        zret = BZ2_bzCompress(&bz, BZ_FINISH);
+    } while ((zret == BZ_FINISH_OK) && bz.avail_out);
+    *outlen = out.size() - bz.avail_out;
+    BZ2_bzCompressEnd(&bz);
+    return zret == BZ_STREAM_END;
+}
+#endif
+
+static void
+compressed_put_bits(pgp_dest_compress_batch_t *batch, uint32_t value, unsigned count)
+{
+    batch->bits = (batch->bits << count) | (value & ((1ULL << count) - 1));
+    batch->bitcount += count;
+    while (batch->bitcount >= 8) {
+        batch->bitbuf.push_back((uint8_t)(batch->bits >> (batch->bitcount - 8)));
+        batch->bitcount -= 8;
+    }
+}
+
+static uint32_t
+compressed_get_bits(const uint8_t *buf, uint64_t pos, unsigned count)
+{
+    uint32_t res = 0;
+    for (unsigned i = 0; i < count; i++, pos++) {
+        res = (res << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+    }
+    return res;
+}
+
+/* append blocks of the single-block bzip2 stream to the output stream. Stream consists of
+ * the 'BZh' + level header, blocks started with 48-bit magic and 32-bit block crc, 48-bit end
+ * of stream magic with 32-bit combined crc, and zero padding to the byte boundary. */
+static bool
+compressed_bzip2_append(pgp_dest_compress_batch_t *batch, const uint8_t *buf, size_t len)
+{
+    if (len < 14) {
+        return false;
+    }
+    uint64_t total = (uint64_t) len * 8;
+    for (unsigned pad = 0; pad < 8; pad++) {
+        uint64_t eos = total - pad - 80;
+        if ((compressed_get_bits(buf, eos, 24) != 0x177245) ||
+            (compressed_get_bits(buf, eos + 24, 24) != 0x385090)) {
+            continue;
+        }
+        if (eos == 32) {
+            /* empty input, there are no blocks */
+            return true;
+        }
+        uint32_t crc = compressed_get_bits(buf, 80, 32);
+        if ((compressed_get_bits(buf, 32, 24) != 0x314159) ||
+            (compressed_get_bits(buf, 56, 24) != 0x265359) ||
+            (compressed_get_bits(buf, eos + 48, 32) != crc)) {
+            return false;
+        }
+        /* blocks start right after the 4-byte header, so whole bytes are read from the
+         * input. Output bit position and the tail of the last block are not byte-aligned. */
+        uint64_t pos = 32;
+        for (; eos - pos >= 8; pos += 8) {
+            compressed_put_bits(batch, buf[pos >> 3], 8);
+        }
+        compressed_put_bits(batch, compressed_get_bits(buf, pos, eos - pos), eos - pos);
+        batch->bzcrc = ((batch->bzcrc << 1) | (batch->bzcrc >> 31)) ^ crc;
+        return true;
+    }
+    return false;
+}
+
+/* compress all the cached blocks in parallel and write them out */
+static rnp_result_t
+compressed_flush_mt(pgp_dest_compressed_param_t *param, bool last)
+{
+    pgp_dest_compress_batch_t *batch = param->batch;
+    bool                       bzip2 = param->alg == PGP_C_BZIP2;
+    size_t                     count = (batch->len + batch->blocklen - 1) / batch->blocklen;
+
+    /* deflate stream must be ended with the final block, even if it is empty */
+    if (!bzip2 && last && !count) {
+        count = 1;
+    }
+    if (!count) {
+        return RNP_SUCCESS;
+    }
+    if (param->alg == PGP_C_ZLIB) {
+        batch->adler = adler32(batch->adler, batch->in.data(), batch->len);
+    }
+
+    std::vector<uint8_t> results(count, 0);
+    std::vector<size_t>  outlens(count, 0);
+    rnp_parallel_for(batch->pool, count, batch->threads, [&](size_t i) {
+        const uint8_t *in = batch->in.data() + i * batch->blocklen;
+        size_t         len = std::min(batch->blocklen, batch->len - i * batch->blocklen);
+#ifdef HAVE_BZLIB_H
+        if (bzip2) {
+            results[i] =
+              compressed_bzip2_block(batch->level, in, len, batch->out[i], &outlens[i]);
+            return;
+        }
+#endif
+        /* block is primed with the previous input, so compression ratio is not affected */
+        const uint8_t *dict = i ? in - PGP_ZIP_MT_DICT_LEN : batch->dict.data();
+        size_t         dictlen = i ? PGP_ZIP_MT_DICT_LEN : batch->dict.size();
+        bool           final = last && (i == count - 1);
+        results[i] = compressed_deflate_block(
+          &batch->zs[i], dict, dictlen, in, len, final, batch->out[i], &outlens[i]);
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        if (!results[i]) {
+            RNP_LOG("failed to compress block");
+            return RNP_ERROR_BAD_STATE;
+        }
+        if (!bzip2) {
+            dst_write(param->pkt.writedst, batch->out[i].data(), outlens[i]);
+            continue;
+        }
+        if (!compressed_bzip2_append(batch, batch->out[i].data(), outlens[i])) {
+            RNP_LOG("wrong bzip2 block");
+            return RNP_ERROR_BAD_STATE;
+        }
+    }
+    if (bzip2) {
+        dst_write(param->pkt.writedst, batch->bitbuf.data(), batch->bitbuf.size());
+        batch->bitbuf.clear();
+    }
+    /* all blocks except the last one are full, and longer then dictionary */
+    if (!bzip2 && !last) {
+        batch->dict.assign(batch->in.data() + batch->len - PGP_ZIP_MT_DICT_LEN,
+                           batch->in.data() + batch->len);
+    }
+    batch->len = 0;
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+compressed_dst_write_mt(pgp_dest_compressed_param_t *param, const void *buf, size_t len)
+{
+    pgp_dest_compress_batch_t *batch = param->batch;
+    rnp_result_t               res;
+
+    while (len > 0) {
+        /* batch is compressed only when there is more data, so last batch is never empty */
+        if (batch->len == batch->in.size()) {
+            if ((res = compressed_flush_mt(param, false))) {
+                return res;
+            }
+        }
+        size_t sz = std::min(len, batch->in.size() - batch->len);
+        memcpy(batch->in.data() + batch->len, buf, sz);
+        batch->len += sz;
+        buf = (uint8_t *) buf + sz;
+        len -= sz;
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+compressed_dst_finish_mt(pgp_dest_compressed_param_t *param)
+{
+    pgp_dest_compress_batch_t *batch = param->batch;
+    rnp_result_t               res;
+
+    if ((res = compressed_flush_mt(param, true))) {
+        return res;
+    }
+    if (param->alg == PGP_C_ZLIB) {
+        uint8_t trailer[4];
+        STORE32BE(trailer, batch->adler);
+        dst_write(param->pkt.writedst, trailer, 4);
+    }
+    if (param->alg == PGP_C_BZIP2) {
+        compressed_put_bits(batch, 0x177245, 24);
+        compressed_put_bits(batch, 0x385090, 24);
+        compressed_put_bits(batch, batch->bzcrc, 32);
+        if (batch->bitcount) {
+            compressed_put_bits(batch, 0, 8 - batch->bitcount);
+        }
+        dst_write(param->pkt.writedst, batch->bitbuf.data(), batch->bitbuf.size());
+        batch->bitbuf.clear();
+    }
+    return RNP_SUCCESS;
+}
+
 static rnp_result_t
 compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 {
@@ -1363,6 +1911,10 @@ compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
+    if (param->batch) {
+        return compressed_dst_write_mt(param, buf, len);
+    }
+
     if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
         param->z.next_in = (unsigned char *) buf;
         param->z.avail_in = len;
@@ -1428,7 +1980,12 @@ compressed_dst_finish(pgp_dest_t *dst)
     int                          zret;
     pgp_dest_compressed_param_t *param = (pgp_dest_compressed_param_t *) dst->param;
 
-    if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
+    if (param->batch) {
+        rnp_result_t ret = compressed_dst_finish_mt(param);
+        if (ret) {
+            return ret;
+        }
+    } else if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
         param->z.next_in = Z_NULL;
         param->z.avail_in = 0;
         param->z.next_out = param->cache + param->len;
@@ -1453,7 +2010,7 @@ compressed_dst_finish(pgp_dest_t *dst)
         dst_write(param->pkt.writedst, param->cache, param->len);
     }
 #ifdef HAVE_BZLIB_H
-    if (param->alg == PGP_C_BZIP2) {
+    if (!param->batch && (param->alg == PGP_C_BZIP2)) {
         param->bz.next_in = NULL;
         param->bz.avail_in = 0;
         param->bz.next_out = (char *) (param->cache + param->len);
@@ -1506,6 +2063,7 @@ compressed_dst_close(pgp_dest_t *dst, bool discard)
         }
 #endif
     }
+    compressed_destroy_mt(param);
 
     close_streamed_packet(&param->pkt, discard);
     free(param);
@@ -1545,6 +2103,13 @@ init_compressed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *w
     buf = param->alg;
     dst_write(param->pkt.writedst, &buf, 1);
 
+    /* multi-threaded compression, if requested */
+    if ((handler->ctx->zthreads > 1) && compressed_mt_supported(param->alg)) {
+        ret = compressed_start_mt(
+          param, handler->ctx->zlevel, handler->ctx->zthreads, handler->ctx->pool);
+        goto finish;
+    }
+
     /* initializing compression */
     switch (param->alg) {
     case PGP_C_ZIP:
@@ -1678,7 +2243,7 @@ finish:
 }
 
 static rnp_result_t
-process_stream_sequence(pgp_source_t *src, pgp_dest_t *streams, unsigned count)
+process_stream_sequence(pgp_source_t *src, pgp_dest_t *streams, unsigned count, bool pipeline)
 {
     uint8_t *    readbuf = NULL;
     ssize_t      read;
@@ -1702,6 +2267,19 @@ process_stream_sequence(pgp_source_t *src, pgp_dest_t *streams, unsigned count)
         }
     }
 
+    /* run CPU-heavy stages on their own threads, so the whole sequence works at the speed of
+     * the slowest stage. Reading, hashing and literal framing stay on the calling thread. */
+    if (pipeline && (!src->knownsize || (src->size >= PGP_PIPELINE_MIN_SIZE))) {
+        for (unsigned i = 0; i < count; i++) {
+            if ((streams[i].type == PGP_STREAM_ARMORED) ||
+                (streams[i].type == PGP_STREAM_ENCRYPTED) ||
+                (streams[i].type == PGP_STREAM_COMPRESSED)) {
+                /* not fatal: stage will be processed on the calling thread */
+                init_pipe_dst(&streams[i]);
+            }
+        }
+    }
+
     /* processing source stream */
     while (!src->eof) {
         read = src_read(src, readbuf, PGP_INPUT_CACHE_SIZE);
@@ -1726,6 +2304,10 @@ process_stream_sequence(pgp_source_t *src, pgp_dest_t *streams, unsigned count)
                     ret = RNP_ERROR_WRITE;
                     goto finish;
                 }
+                /* streams behind the pipe are owned by it's worker thread */
+                if (streams[i].type == PGP_STREAM_PIPE) {
+                    break;
+                }
             }
         }
     }
@@ -1787,7 +2369,7 @@ rnp_encrypt_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst
     destc++;
 
     /* processing stream sequence */
-    ret = process_stream_sequence(src, dests, destc);
+    ret = process_stream_sequence(src, dests, destc, handler->ctx->pipeline);
 finish:
     for (int i = destc - 1; i >= 0; i--) {
         dst_close(&dests[i], ret != RNP_SUCCESS);
@@ -1845,7 +2427,7 @@ rnp_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
     }
 
     /* process source with streams stack */
-    ret = process_stream_sequence(src, dests, destc);
+    ret = process_stream_sequence(src, dests, destc, handler->ctx->pipeline);
 finish:
     for (int i = destc - 1; i >= 0; i--) {
         dst_close(&dests[i], ret != RNP_SUCCESS);
@@ -1909,7 +2491,7 @@ rnp_encrypt_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t
     destc++;
 
     /* process source with streams stack */
-    ret = process_stream_sequence(src, dests, destc);
+    ret = process_stream_sequence(src, dests, destc, handler->ctx->pipeline);
 finish:
     for (int i = destc - 1; i >= 0; i--) {
         dst_close(&dests[i], ret != RNP_SUCCESS);
@@ -0,0 +1,40 @@
+# Copyright (c) 2020 Ribose Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+# BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+# rnp_key_store_t has C++ members, so it must be created via rnp_key_store_new() only.
+# Usage: cmake -DSRC_DIR=<source dir> -P check-keystore-alloc.cmake
+
+file(GLOB_RECURSE _sources "${SRC_DIR}/src/*.cpp" "${SRC_DIR}/src/*.c" "${SRC_DIR}/src/*.h")
+set(_found)
+foreach(_source IN LISTS _sources)
+  file(STRINGS "${_source}" _lines
+    REGEX "\\(rnp_key_store_t \\*\\) *(calloc|malloc|realloc)")
+  foreach(_line IN LISTS _lines)
+    list(APPEND _found "${_source}: ${_line}")
+  endforeach()
+endforeach()
+if (_found)
+  string(REPLACE ";" "\n" _found "${_found}")
+  message(FATAL_ERROR "Key store must be created via rnp_key_store_new():\n${_found}")
+endif()
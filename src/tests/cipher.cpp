@@ -34,6 +34,10 @@
 #include "rnp_tests.h"
 #include "support.h"
 #include "fingerprint.h"
+#include <rekey/rnp_key_store.h>
+#include "crypto/pubkey_cache.h"
+#include <thread>
+#include <vector>
 
 extern rng_t global_rng;
 
@@ -87,6 +91,163 @@ TEST_F(rnp_tests, hash_test_success)
     }
 }
 
+TEST_F(rnp_tests, hash_test_reuse)
+{
+    pgp_hash_t    hash = {0};
+    pgp_hash_t    other = {0};
+    pgp_hash_t    copy = {0};
+    uint8_t       hash_output[PGP_MAX_HASH_SIZE];
+    const uint8_t test_input[3] = {'a', 'b', 'c'};
+    const char *  expected =
+      "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD";
+    const char *expected_a =
+      "CA978112CA1BBDCAFAC231B39A23DC4DA786EFF8147C4E72B9807785AFEE48BB";
+
+    for (int i = 0; i < 10; i++) {
+        /* abandoned hash must not leak its state to the next one */
+        assert_true(pgp_hash_create(&hash, PGP_HASH_SHA256));
+        pgp_hash_add(&hash, test_input, sizeof(test_input));
+        assert_int_equal(pgp_hash_finish(&hash, NULL), 32);
+        /* a few simultaneously used objects */
+        assert_true(pgp_hash_create(&hash, PGP_HASH_SHA256));
+        assert_true(pgp_hash_create(&other, PGP_HASH_SHA256));
+        assert_true(hash.handle != other.handle);
+        pgp_hash_add(&other, test_input, 1);
+        pgp_hash_add(&hash, test_input, 1);
+        assert_true(pgp_hash_copy(&copy, &hash));
+        pgp_hash_add(&hash, test_input + 1, sizeof(test_input) - 1);
+        pgp_hash_add(&copy, test_input + 1, sizeof(test_input) - 1);
+        assert_int_equal(pgp_hash_finish(&hash, hash_output), 32);
+        assert_int_equal(0, test_value_equal("SHA256", expected, hash_output, 32));
+        assert_int_equal(pgp_hash_finish(&copy, hash_output), 32);
+        assert_int_equal(0, test_value_equal("SHA256", expected, hash_output, 32));
+        assert_int_equal(pgp_hash_finish(&other, hash_output), 32);
+        assert_int_equal(0, test_value_equal("SHA256", expected_a, hash_output, 32));
+    }
+}
+
+TEST_F(rnp_tests, fingerprint_keyid_test)
+{
+    const char *paths[] = {"data/keyrings/1/pubring.gpg", "data/keyrings/4/rsav3-p.asc"};
+
+    for (const char *path : paths) {
+        pgp_source_t       src = {};
+        pgp_key_sequence_t keys = {};
+        assert_rnp_success(init_file_src(&src, path));
+        assert_rnp_success(process_pgp_keys(&src, &keys));
+        src_close(&src);
+
+        for (list_item *li = list_front(keys.keys); li; li = list_next(li)) {
+            pgp_transferable_key_t *key = (pgp_transferable_key_t *) li;
+            pgp_fingerprint_t       fp1 = {};
+            pgp_fingerprint_t       fp2 = {};
+            uint8_t                 keyid1[PGP_KEY_ID_SIZE] = {0};
+            uint8_t                 keyid2[PGP_KEY_ID_SIZE] = {0};
+
+            assert_rnp_success(pgp_fingerprint_keyid(&fp1, keyid1, &key->key));
+            assert_rnp_success(pgp_fingerprint(&fp2, &key->key));
+            assert_rnp_success(pgp_keyid(keyid2, PGP_KEY_ID_SIZE, &key->key));
+            assert_true(fingerprint_equal(&fp1, &fp2));
+            assert_int_equal(memcmp(keyid1, keyid2, PGP_KEY_ID_SIZE), 0);
+        }
+        key_sequence_destroy(&keys);
+    }
+}
+
+static void
+hash_batch_expected(pgp_hash_alg_t alg, const pgp_hash_msg_t *msgs, size_t count, uint8_t *out)
+{
+    size_t len = pgp_digest_length(alg);
+    for (size_t i = 0; i < count; i++) {
+        pgp_hash_t hash = {0};
+        assert_true(pgp_hash_create(&hash, alg));
+        pgp_hash_add(&hash, msgs[i].data, msgs[i].len);
+        assert_int_equal(pgp_hash_finish(&hash, out + i * len), len);
+    }
+}
+
+TEST_F(rnp_tests, hash_test_batch)
+{
+    std::vector<uint8_t> data(4096);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+
+    /* messages of various lengths, covering all of the padding cases */
+    std::vector<pgp_hash_msg_t> msgs;
+    for (size_t len = 0; len <= 300; len++) {
+        msgs.push_back({data.data() + len, len});
+    }
+    msgs.push_back({data.data(), data.size()});
+
+    const pgp_hash_alg_t algs[] = {PGP_HASH_SHA1, PGP_HASH_SHA256, PGP_HASH_SHA512};
+    const size_t         counts[] = {1, 2, 7, 8, 9, 16, 17, 33, msgs.size()};
+    for (pgp_hash_alg_t alg : algs) {
+        size_t               len = pgp_digest_length(alg);
+        std::vector<uint8_t> expected(msgs.size() * len);
+        std::vector<uint8_t> out(msgs.size() * len);
+        hash_batch_expected(alg, msgs.data(), msgs.size(), expected.data());
+
+        for (size_t count : counts) {
+            /* library's choice of the implementation */
+            std::fill(out.begin(), out.end(), 0);
+            assert_true(pgp_hash_batch(alg, msgs.data(), count, out.data()));
+            assert_int_equal(memcmp(out.data(), expected.data(), count * len), 0);
+            if (alg == PGP_HASH_SHA512) {
+                continue;
+            }
+            /* each of the multi-buffer implementations, supported by the cpu */
+            for (size_t idx = 0; idx < hash_simd_count(); idx++) {
+                const pgp_hash_simd_t *simd = hash_simd_get(idx);
+                if (!simd) {
+                    continue;
+                }
+                std::fill(out.begin(), out.end(), 0);
+                assert_true(hash_simd_batch(
+                  simd, alg == PGP_HASH_SHA1, msgs.data(), count, out.data()));
+                assert_int_equal(memcmp(out.data(), expected.data(), count * len), 0);
+            }
+        }
+    }
+    /* empty batch */
+    assert_true(pgp_hash_batch(PGP_HASH_SHA256, NULL, 0, NULL));
+}
+
+TEST_F(rnp_tests, fingerprint_batch_test)
+{
+    const char *paths[] = {"data/keyrings/1/pubring.gpg", "data/keyrings/4/rsav3-p.asc"};
+
+    for (const char *path : paths) {
+        pgp_source_t       src = {};
+        pgp_key_sequence_t keys = {};
+        assert_rnp_success(init_file_src(&src, path));
+        assert_rnp_success(process_pgp_keys(&src, &keys));
+        src_close(&src);
+
+        std::vector<const pgp_key_pkt_t *> pkts;
+        for (list_item *li = list_front(keys.keys); li; li = list_next(li)) {
+            pgp_transferable_key_t *key = (pgp_transferable_key_t *) li;
+            pkts.push_back(&key->key);
+            for (list_item *sk = list_front(key->subkeys); sk; sk = list_next(sk)) {
+                pkts.push_back(&((pgp_transferable_subkey_t *) sk)->subkey);
+            }
+        }
+        assert_true(pkts.size() > 0);
+
+        std::vector<pgp_key_ids_t> ids(pkts.size());
+        assert_true(pgp_key_ids_batch(pkts.data(), pkts.size(), ids.data()));
+        for (size_t i = 0; i < pkts.size(); i++) {
+            pgp_fingerprint_t fp = {};
+            uint8_t           grip[PGP_KEY_GRIP_SIZE] = {0};
+            assert_rnp_success(pgp_fingerprint(&fp, pkts[i]));
+            assert_true(rnp_key_store_get_key_grip(&pkts[i]->material, grip));
+            assert_true(fingerprint_equal(&fp, &ids[i].fp));
+            assert_int_equal(memcmp(grip, ids[i].grip, PGP_KEY_GRIP_SIZE), 0);
+        }
+        key_sequence_destroy(&keys);
+    }
+}
+
 TEST_F(rnp_tests, cipher_test_success)
 {
     const uint8_t  key[16] = {0};
@@ -118,11 +279,64 @@ TEST_F(rnp_tests, cipher_test_success)
     assert_int_equal(0, pgp_cipher_cfb_finish(&crypt));
 }
 
+TEST_F(rnp_tests, cipher_cfb_bulk)
+{
+    const pgp_symm_alg_t algs[] = {
+      PGP_SA_AES_128, PGP_SA_AES_256, PGP_SA_CAST5, PGP_SA_TWOFISH};
+    /* uneven chunks to cover block boundaries, tail and multi-call bulk processing */
+    const size_t chunks[] = {1, 7, 15, 16, 17, 100, 4095, 4096, 4097, 9000, 11, 3000};
+    uint8_t      key[PGP_MAX_KEY_SIZE];
+    uint8_t      iv[PGP_MAX_BLOCK_SIZE];
+    size_t       total = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(chunks); i++) {
+        total += chunks[i];
+    }
+    std::vector<uint8_t> plain(total);
+    std::vector<uint8_t> enc(total);
+    std::vector<uint8_t> enc_byte(total);
+    std::vector<uint8_t> dec(total);
+    rng_get_data(&global_rng, plain.data(), total);
+    rng_get_data(&global_rng, key, sizeof(key));
+    rng_get_data(&global_rng, iv, sizeof(iv));
+
+    for (size_t a = 0; a < ARRAY_SIZE(algs); a++) {
+        pgp_crypt_t crypt;
+        /* encrypt at once */
+        assert_true(pgp_cipher_cfb_start(&crypt, algs[a], key, iv));
+        assert_int_equal(pgp_cipher_cfb_encrypt(&crypt, enc.data(), plain.data(), total), 0);
+        assert_int_equal(pgp_cipher_cfb_finish(&crypt), 0);
+        /* encrypt byte-by-byte, which doesn't use the full block path */
+        assert_true(pgp_cipher_cfb_start(&crypt, algs[a], key, iv));
+        for (size_t i = 0; i < total; i++) {
+            assert_int_equal(pgp_cipher_cfb_encrypt(&crypt, &enc_byte[i], &plain[i], 1), 0);
+        }
+        assert_int_equal(pgp_cipher_cfb_finish(&crypt), 0);
+        assert_true(enc == enc_byte);
+        /* decrypt in place with uneven chunks */
+        dec = enc;
+        assert_true(pgp_cipher_cfb_start(&crypt, algs[a], key, iv));
+        size_t pos = 0;
+        for (size_t i = 0; i < ARRAY_SIZE(chunks); i++) {
+            assert_int_equal(
+              pgp_cipher_cfb_decrypt(&crypt, &dec[pos], &dec[pos], chunks[i]), 0);
+            pos += chunks[i];
+        }
+        assert_int_equal(pgp_cipher_cfb_finish(&crypt), 0);
+        assert_true(dec == plain);
+        /* decrypt at once to the separate buffer */
+        assert_true(pgp_cipher_cfb_start(&crypt, algs[a], key, iv));
+        assert_int_equal(pgp_cipher_cfb_decrypt(&crypt, dec.data(), enc.data(), total), 0);
+        assert_int_equal(pgp_cipher_cfb_finish(&crypt), 0);
+        assert_true(dec == plain);
+    }
+}
+
 TEST_F(rnp_tests, pkcs1_rsa_test_success)
 {
     uint8_t             ptext[1024 / 8] = {'a', 'b', 'c', 0};
     uint8_t             dec[1024 / 8];
-    pgp_rsa_encrypted_t enc;
+    pgp_rsa_encrypted_t enc = {};
     size_t              dec_size;
     pgp_key_pkt_t       seckey;
 
@@ -178,6 +392,73 @@ TEST_F(rnp_tests, pkcs1_rsa_test_success)
     free_key_pkt(&seckey);
 }
 
+TEST_F(rnp_tests, pubkey_cache_verify)
+{
+    uint8_t              message[32];
+    const pgp_hash_alg_t hash_alg = PGP_HASH_SHA256;
+    pgp_rsa_signature_t  sig = {};
+    pgp_key_pkt_t        seckey1;
+    pgp_key_pkt_t        seckey2;
+
+    rnp_keygen_crypto_params_t key_desc;
+    key_desc.key_alg = PGP_PKA_RSA;
+    key_desc.hash_alg = hash_alg;
+    key_desc.rsa.modulus_bit_len = 1024;
+    key_desc.rng = &global_rng;
+    assert_true(pgp_generate_seckey(&key_desc, &seckey1, true));
+    assert_true(pgp_generate_seckey(&key_desc, &seckey2, true));
+    const pgp_rsa_key_t *key1 = &seckey1.material.rsa;
+    const pgp_rsa_key_t *key2 = &seckey2.material.rsa;
+
+    pubkey_cache_clear();
+    assert_int_equal(pubkey_cache_size(), 0);
+    assert_true(rng_get_data(&global_rng, message, sizeof(message)));
+    assert_rnp_success(
+      rsa_sign_pkcs1(&global_rng, &sig, hash_alg, message, sizeof(message), key1));
+
+    /* key is loaded once, verify operation is reused */
+    for (int i = 0; i < 10; i++) {
+        assert_rnp_success(rsa_verify_pkcs1(&sig, hash_alg, message, sizeof(message), key1));
+    }
+    assert_int_equal(pubkey_cache_size(), 1);
+    assert_rnp_failure(rsa_verify_pkcs1(&sig, hash_alg, message, sizeof(message), key2));
+    assert_int_equal(pubkey_cache_size(), 2);
+    message[0] ^= 0xff;
+    assert_rnp_failure(rsa_verify_pkcs1(&sig, hash_alg, message, sizeof(message), key1));
+    message[0] ^= 0xff;
+    assert_rnp_success(rsa_verify_pkcs1(&sig, hash_alg, message, sizeof(message), key1));
+
+    /* concurrent verification with the same cached key */
+    std::vector<std::thread> threads;
+    std::vector<int>         failures(4, 0);
+    for (size_t t = 0; t < failures.size(); t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 20; i++) {
+                if (rsa_verify_pkcs1(
+                      &sig, PGP_HASH_SHA256, message, sizeof(message), key1)) {
+                    failures[t]++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int failed : failures) {
+        assert_int_equal(failed, 0);
+    }
+
+    /* public key check result is cached as well */
+    assert_rnp_success(rsa_validate_key(&global_rng, key1, false));
+    assert_rnp_success(rsa_validate_key(&global_rng, key1, true));
+
+    pubkey_cache_clear();
+    assert_int_equal(pubkey_cache_size(), 0);
+    assert_rnp_success(rsa_verify_pkcs1(&sig, hash_alg, message, sizeof(message), key1));
+    free_key_pkt(&seckey1);
+    free_key_pkt(&seckey2);
+}
+
 TEST_F(rnp_tests, rnp_test_eddsa)
 {
     rnp_keygen_crypto_params_t key_desc;
@@ -268,7 +549,7 @@ elgamal_roundtrip(pgp_eg_key_t *key)
 
 TEST_F(rnp_tests, raw_elgamal_random_key_test_success)
 {
-    pgp_eg_key_t key;
+    pgp_eg_key_t key = {};
 
     assert_int_equal(elgamal_generate(&global_rng, &key, 1024), RNP_SUCCESS);
     elgamal_roundtrip(&key);
@@ -330,7 +611,7 @@ TEST_F(rnp_tests, ecdh_roundtrip)
     } curves[] = {
       {PGP_CURVE_NIST_P_256, 32}, {PGP_CURVE_NIST_P_384, 48}, {PGP_CURVE_NIST_P_521, 66}};
 
-    pgp_ecdh_encrypted_t enc;
+    pgp_ecdh_encrypted_t enc = {};
     uint8_t              plaintext[32] = {0};
     size_t               plaintext_len = sizeof(plaintext);
     uint8_t              result[32] = {0};
@@ -373,7 +654,7 @@ TEST_F(rnp_tests, ecdh_decryptionNegativeCases)
     size_t               plaintext_len = sizeof(plaintext);
     uint8_t              result[32] = {0};
     size_t               result_len = sizeof(result);
-    pgp_ecdh_encrypted_t enc;
+    pgp_ecdh_encrypted_t enc = {};
 
     rnp_keygen_crypto_params_t key_desc;
     key_desc.key_alg = PGP_PKA_ECDH;
@@ -443,7 +724,7 @@ TEST_F(rnp_tests, sm2_roundtrip)
     const pgp_ec_key_t *eckey = &seckey.material.ec;
 
     pgp_hash_alg_t      hashes[] = {PGP_HASH_SM3, PGP_HASH_SHA256, PGP_HASH_SHA512};
-    pgp_sm2_encrypted_t enc;
+    pgp_sm2_encrypted_t enc = {};
     rnp_result_t        ret;
 
     for (size_t i = 0; i < ARRAY_SIZE(hashes); ++i) {
@@ -467,10 +748,10 @@ TEST_F(rnp_tests, sm2_sm3_signature_test)
 {
     const char *msg = "no backdoors here";
 
-    pgp_ec_key_t       sm2_key;
+    pgp_ec_key_t       sm2_key = {};
     pgp_hash_t         hash;
     rng_t              rng;
-    pgp_ec_signature_t sig;
+    pgp_ec_signature_t sig = {};
 
     pgp_hash_alg_t hash_alg = PGP_HASH_SM3;
     const size_t   hash_len = pgp_digest_length(hash_alg);
@@ -522,10 +803,10 @@ TEST_F(rnp_tests, sm2_sha256_signature_test)
 {
     const char *msg = "hi chappy";
 
-    pgp_ec_key_t       sm2_key;
+    pgp_ec_key_t       sm2_key = {};
     pgp_hash_t         hash;
     rng_t              rng;
-    pgp_ec_signature_t sig;
+    pgp_ec_signature_t sig = {};
 
     pgp_hash_alg_t hash_alg = PGP_HASH_SHA256;
     const size_t   hash_len = pgp_digest_length(hash_alg);
@@ -719,6 +1000,71 @@ TEST_F(rnp_tests, s2k_iteration_encode_decode)
     assert_int_equal(pgp_s2k_decode_iterations(0xFF), MAX_ITER);
 }
 
+static time_t s2k_cache_fake_time = 0;
+
+static time_t
+s2k_cache_fake_clock(void)
+{
+    return s2k_cache_fake_time;
+}
+
+TEST_F(rnp_tests, s2k_derive_key_cache)
+{
+    pgp_s2k_t s2k = {};
+    uint8_t   ref[32] = {0};
+    uint8_t   key[32] = {0};
+
+    s2k.usage = PGP_S2KU_ENCRYPTED_AND_HASHED;
+    s2k.specifier = PGP_S2KS_ITERATED_AND_SALTED;
+    s2k.hash_alg = PGP_HASH_SHA256;
+    s2k.iterations = 96;
+    assert_true(rng_get_data(&global_rng, s2k.salt, sizeof(s2k.salt)));
+    assert_true(pgp_s2k_derive_key(&s2k, "password", ref, sizeof(ref)));
+
+    // cache is disabled by default
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password", key, sizeof(key)));
+    assert_int_equal(memcmp(key, ref, sizeof(ref)), 0);
+    assert_int_equal(pgp_s2k_cache_count(), 0);
+
+    assert_false(pgp_s2k_cache_configure(2, 0));
+    assert_true(pgp_s2k_cache_configure(2, 60));
+    // shorter key is a prefix of the longer one, so may be taken from the cache
+    memset(key, 0, sizeof(key));
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password", key, 16));
+    assert_int_equal(memcmp(key, ref, 16), 0);
+    assert_int_equal(pgp_s2k_cache_count(), 1);
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password", key, sizeof(key)));
+    assert_int_equal(memcmp(key, ref, sizeof(ref)), 0);
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password", key, 16));
+    assert_int_equal(memcmp(key, ref, 16), 0);
+    assert_int_equal(pgp_s2k_cache_count(), 1);
+    // different password must not hit the cache
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password2", key, sizeof(key)));
+    assert_int_not_equal(memcmp(key, ref, sizeof(ref)), 0);
+    assert_int_equal(pgp_s2k_cache_count(), 2);
+    // cache is bounded
+    s2k.salt[0] ^= 0xff;
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password", key, sizeof(key)));
+    assert_int_not_equal(memcmp(key, ref, sizeof(ref)), 0);
+    assert_int_equal(pgp_s2k_cache_count(), 2);
+    // disabling cache wipes it
+    assert_true(pgp_s2k_cache_configure(0, 0));
+    assert_int_equal(pgp_s2k_cache_count(), 0);
+    // entries expire
+    s2k_cache_fake_time = time(NULL);
+    pgp_s2k_cache_set_clock(s2k_cache_fake_clock);
+    assert_true(pgp_s2k_cache_configure(2, 10));
+    assert_true(pgp_s2k_derive_key_cached(&s2k, "password", key, sizeof(key)));
+    assert_int_equal(pgp_s2k_cache_count(), 1);
+    s2k_cache_fake_time += 9;
+    assert_int_equal(pgp_s2k_cache_count(), 1);
+    s2k_cache_fake_time += 1;
+    assert_int_equal(pgp_s2k_cache_count(), 0);
+    pgp_s2k_cache_set_clock(NULL);
+    assert_int_equal(rnp_set_s2k_cache(1, 0), RNP_ERROR_BAD_PARAMETERS);
+    assert_rnp_success(rnp_set_s2k_cache(0, 0));
+}
+
 static bool
 read_key_pkt(pgp_key_pkt_t *key, const char *path)
 {
@@ -868,3 +1214,53 @@ TEST_F(rnp_tests, test_validate_key_material)
 
     rng_destroy(&rng);
 }
+
+TEST_F(rnp_tests, test_mpi_ownership)
+{
+    pgp_mpi_t a = {};
+    pgp_mpi_t b = {};
+
+    /* MPI storage is sized to the value, not to the maximum MPI size */
+    assert_true(hex2mpi(&a, "010203"));
+    assert_int_equal(a.len, 3);
+    assert_int_equal(mpi_bits(&a), 17);
+    assert_true(mpi_copy(&b, &a));
+    assert_true(mpi_equal(&a, &b));
+    assert_true(a.mpi != b.mpi);
+    /* overwriting releases the previous value */
+    assert_true(hex2mpi(&a, "ff"));
+    assert_int_equal(a.len, 1);
+    assert_false(mpi_equal(&a, &b));
+    assert_false(mpi_alloc(&a, PGP_MPINT_SIZE + 1));
+    assert_true(mpi_alloc(&a, PGP_MPINT_SIZE));
+    assert_int_equal(a.len, PGP_MPINT_SIZE);
+    mpi_forget(&a);
+    assert_null(a.mpi);
+    assert_int_equal(a.len, 0);
+    mpi_free(&b);
+    assert_null(b.mpi);
+
+    /* key packet copies must not share MPI buffers with the source */
+    pgp_key_pkt_t key = {};
+    pgp_key_pkt_t keycp = {};
+    assert_true(read_key_pkt(&key, KEYS "rsa-sec.pgp"));
+    assert_rnp_success(decrypt_secret_key(&key, NULL));
+    assert_true(copy_key_pkt(&keycp, &key, false));
+    assert_true(keycp.material.secret);
+    assert_true(keycp.material.rsa.n.mpi != key.material.rsa.n.mpi);
+    assert_true(keycp.material.rsa.d.mpi != key.material.rsa.d.mpi);
+    assert_true(mpi_equal(&keycp.material.rsa.d, &key.material.rsa.d));
+    free_key_pkt(&key);
+    assert_rnp_success(validate_pgp_key_material(&keycp.material, &global_rng));
+    free_key_pkt(&keycp);
+
+    assert_true(read_key_pkt(&key, KEYS "rsa-sec.pgp"));
+    assert_rnp_success(decrypt_secret_key(&key, NULL));
+    assert_true(copy_key_pkt(&keycp, &key, true));
+    assert_false(keycp.material.secret);
+    assert_null(keycp.material.rsa.d.mpi);
+    assert_null(keycp.sec_data);
+    assert_true(mpi_equal(&keycp.material.rsa.n, &key.material.rsa.n));
+    free_key_pkt(&key);
+    free_key_pkt(&keycp);
+}
@@ -33,6 +33,8 @@ SMALLSIZE = 0
 SMALLFILE = 'smalltest.txt'
 LARGEFILE = 'largetest.txt'
 PASSWORD = 'password'
+KEYRING_KEYS = 100
+KEYRING_ITERATIONS = 10
 
 def setup(workdir):
     # Searching for rnp and gnupg
@@ -237,6 +239,24 @@ class Benchmark(object):
         print_test_results(fsize, tmrnp, tmgpg, 'DECRYPT-LARGE-ARMOR')
         os.remove(inenc)
 
+    def large_file_cipher_throughput(self):
+        '''
+        Large file symmetric encryption/decryption throughput
+        '''
+        infile, rnpout, gpgout, iterations, fsize = get_file_params('large')
+        inenc = infile + '.enc'
+        for cipher in ['AES128', 'AES256', 'CAST5', 'TWOFISH']:
+            tmenc = run_iterated(iterations, rnp_symencrypt_file, infile, rnpout, cipher, 0, 'zip', False)
+            rnp_symencrypt_file(infile, inenc, cipher, 0, 'zip', False)
+            tmdec = run_iterated(iterations, rnp_decrypt_file, inenc, rnpout)
+            if not tmenc or not tmdec:
+                logging.info('THROUGHPUT-{}:TEST FAILED'.format(cipher))
+                continue
+            encspeed = fsize / 1024.0 / 1024.0 / tmenc
+            decspeed = fsize / 1024.0 / 1024.0 / tmdec
+            logging.info('{:<30}: encrypt {:.2f} MB/sec, decrypt {:.2f} MB/sec'.format('THROUGHPUT-{}'.format(cipher), encspeed, decspeed))
+            os.remove(inenc)
+
         # 3. Signing
         #print '\n#3. Signing\n'
         # 4. Verification
@@ -246,6 +266,39 @@ class Benchmark(object):
         # 6. Detached signature
         #print '\n#6. Detached signing and verification\n'
 
+    def keyring_load_search_validate(self):
+        '''
+        Keyring load, validation and search for the keyring with many keys
+        '''
+        homedir = path.join(WORKDIR, '.rnp-keyring')
+        os.mkdir(homedir, 0700)
+        for i in range(0, KEYRING_KEYS):
+            pipe = pswd_pipe(PASSWORD)
+            params = ['--homedir', homedir, '--pass-fd', str(pipe), '--numbits', '1024', '--userid', 'key{}@rnp'.format(i), '--generate-key']
+            ret, _, _ = run_proc(RNPK, params)
+            os.close(pipe)
+            if ret != 0:
+                logging.info('KEYRING:TEST FAILED')
+                shutil.rmtree(homedir)
+                return
+
+        runs = [('KEYRING-LOAD-LIST', ['--list-keys', '--with-sigs']),
+                ('KEYRING-SEARCH', ['--list-keys', 'key{}@rnp'.format(KEYRING_KEYS - 1)])]
+        for name, params in runs:
+            runtime = 0
+            for i in range(0, KEYRING_ITERATIONS):
+                tstart = perf_timer()
+                ret = run_proc_fast(RNPK, ['--homedir', homedir] + params)
+                runtime += perf_timer() - tstart
+                if ret != 0:
+                    runtime = 0
+                    break
+            if not runtime:
+                logging.info('{}:TEST FAILED'.format(name))
+                continue
+            logging.info('{:<30}: {:.2f} runs/sec ({} keys)'.format(name, KEYRING_ITERATIONS / runtime, KEYRING_KEYS))
+        shutil.rmtree(homedir)
+
 # Usage ./cli_perf.py [working_directory]
 #
 # It's better to use RAMDISK to perform tests
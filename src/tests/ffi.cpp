@@ -24,7 +24,9 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
 #include <fstream>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -32,6 +34,7 @@
 #include "rnp_tests.h"
 #include "support.h"
 #include "librepgp/stream-common.h"
+#include "parallel.h"
 #include <json.h>
 #include <vector>
 #include <string>
@@ -374,6 +377,167 @@ TEST_F(rnp_tests, test_ffi_load_keys)
     free(buf);
 }
 
+TEST_F(rnp_tests, test_ffi_input_from_file)
+{
+    rnp_ffi_t   ffi = NULL;
+    rnp_input_t input = NULL;
+    size_t      count = 0;
+
+    assert_int_equal(RNP_ERROR_NULL_POINTER,
+                     rnp_input_from_file(NULL, "data/keyrings/1/pubring.gpg", 0));
+    assert_int_equal(RNP_ERROR_NULL_POINTER, rnp_input_from_file(&input, NULL, 0));
+    assert_int_equal(RNP_ERROR_BAD_PARAMETERS,
+                     rnp_input_from_file(&input, "data/keyrings/1/pubring.gpg", 0x80));
+    assert_null(input);
+    assert_rnp_failure(rnp_input_from_file(&input, "data/keyrings/1/nonexisting.gpg", 0));
+    assert_rnp_failure(
+      rnp_input_from_file(&input, "data/keyrings/1/nonexisting.gpg", RNP_INPUT_FILE_MMAP));
+    assert_null(input);
+
+    /* load keys via the file and via the mapping */
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_input_from_file(&input, "data/keyrings/1/pubring.gpg", 0));
+    assert_rnp_success(rnp_load_keys(ffi, "GPG", input, RNP_LOAD_SAVE_PUBLIC_KEYS));
+    rnp_input_destroy(input);
+    assert_rnp_success(
+      rnp_input_from_file(&input, "data/keyrings/1/secring.gpg", RNP_INPUT_FILE_MMAP));
+    assert_rnp_success(rnp_load_keys(ffi, "GPG", input, RNP_LOAD_SAVE_SECRET_KEYS));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(count, 7);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 7);
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_signature_cache)
+{
+    rnp_ffi_t   ffi = NULL;
+    rnp_input_t input = NULL;
+    size_t      count;
+
+    assert_int_equal(RNP_SUCCESS, rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_int_equal(RNP_ERROR_NULL_POINTER, rnp_ffi_set_signature_cache(NULL, 100));
+    assert_int_equal(RNP_SUCCESS, rnp_ffi_set_signature_cache(ffi, 100));
+    // load the same keyring twice, second time results should be taken from the cache
+    for (int i = 0; i < 2; i++) {
+        assert_int_equal(RNP_SUCCESS,
+                         rnp_input_from_path(&input, "data/keyrings/1/pubring.gpg"));
+        assert_int_equal(RNP_SUCCESS,
+                         rnp_load_keys(ffi, "GPG", input, RNP_LOAD_SAVE_PUBLIC_KEYS));
+        rnp_input_destroy(input);
+        input = NULL;
+    }
+    assert_int_equal(RNP_SUCCESS, rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(7, count);
+    // disable the cache
+    assert_int_equal(RNP_SUCCESS, rnp_ffi_set_signature_cache(ffi, 0));
+    assert_int_equal(RNP_SUCCESS, rnp_input_from_path(&input, "data/keyrings/1/pubring.gpg"));
+    assert_int_equal(RNP_SUCCESS, rnp_load_keys(ffi, "GPG", input, RNP_LOAD_SAVE_PUBLIC_KEYS));
+    rnp_input_destroy(input);
+    assert_int_equal(RNP_SUCCESS, rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(7, count);
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+load_keys_gpg(rnp_ffi_t ffi, const char *path)
+{
+    rnp_input_t input = NULL;
+    if (rnp_input_from_path(&input, path)) {
+        return false;
+    }
+    bool res = !rnp_load_keys(ffi, "GPG", input, RNP_LOAD_SAVE_PUBLIC_KEYS);
+    rnp_input_destroy(input);
+    return res;
+}
+
+static bool
+import_pub_keys(rnp_ffi_t ffi, const char *path)
+{
+    rnp_input_t input = NULL;
+    if (rnp_input_from_path(&input, path)) {
+        return false;
+    }
+    bool res = !rnp_import_keys(ffi, input, RNP_LOAD_SAVE_PUBLIC_KEYS, NULL);
+    rnp_input_destroy(input);
+    return res;
+}
+
+static size_t
+get_alice_sig_count(rnp_ffi_t ffi)
+{
+    rnp_key_handle_t key = NULL;
+    rnp_uid_handle_t uid = NULL;
+    size_t           count = 0;
+
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "Alice <alice@rnp>", &key));
+    assert_non_null(key);
+    assert_rnp_success(rnp_key_get_uid_handle_at(key, 0, &uid));
+    assert_rnp_success(rnp_uid_get_signature_count(uid, &count));
+    rnp_uid_handle_destroy(uid);
+    rnp_key_handle_destroy(key);
+    return count;
+}
+
+TEST_F(rnp_tests, test_ffi_certification_limit)
+{
+    rnp_ffi_t        ffi = NULL;
+    rnp_input_t      input = NULL;
+    rnp_key_handle_t key = NULL;
+    rnp_uid_handle_t uid = NULL;
+    size_t           count = 0;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_int_equal(RNP_ERROR_NULL_POINTER, rnp_ffi_set_certification_limit(NULL, 1));
+    assert_rnp_success(rnp_ffi_set_certification_limit(ffi, 1));
+    // self-signatures are not limited
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/1/pubring.gpg"));
+    assert_rnp_success(rnp_import_keys(ffi, input, RNP_LOAD_SAVE_PUBLIC_KEYS, NULL));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(7, count);
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key0-uid2", &key));
+    assert_non_null(key);
+    assert_rnp_success(rnp_key_get_uid_count(key, &count));
+    assert_int_equal(3, count);
+    for (size_t i = 0; i < 3; i++) {
+        assert_rnp_success(rnp_key_get_uid_handle_at(key, i, &uid));
+        assert_rnp_success(rnp_uid_get_signature_count(uid, &count));
+        assert_int_equal(1, count);
+        rnp_uid_handle_destroy(uid);
+    }
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_ffi_set_certification_limit(ffi, 0));
+    rnp_ffi_destroy(ffi);
+
+    // alice has distinct certification by basil in each of keyrings
+    const char *case1 = "data/test_key_validity/case1/pubring.gpg";
+    const char *case2 = "data/test_key_validity/case2/pubring.gpg";
+    // loading doesn't limit certifications
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_set_certification_limit(ffi, 1));
+    assert_true(load_keys_gpg(ffi, case1));
+    assert_true(load_keys_gpg(ffi, case2));
+    assert_int_equal(get_alice_sig_count(ffi), 3);
+    // import of the update doesn't drop existing certifications
+    assert_true(import_pub_keys(ffi, case1));
+    assert_true(import_pub_keys(ffi, case2));
+    assert_int_equal(get_alice_sig_count(ffi), 3);
+    rnp_ffi_destroy(ffi);
+    // import adds new certifications below the limit only
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_set_certification_limit(ffi, 1));
+    assert_true(import_pub_keys(ffi, case1));
+    assert_int_equal(get_alice_sig_count(ffi), 2);
+    assert_true(import_pub_keys(ffi, case2));
+    assert_int_equal(get_alice_sig_count(ffi), 2);
+    assert_rnp_success(rnp_ffi_set_certification_limit(ffi, 2));
+    assert_true(import_pub_keys(ffi, case2));
+    assert_int_equal(get_alice_sig_count(ffi), 3);
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_clear_keys)
 {
     rnp_ffi_t   ffi = NULL;
@@ -2450,6 +2614,58 @@ TEST_F(rnp_tests, test_ffi_add_userid)
     rnp_ffi_destroy(ffi);
 }
 
+TEST_F(rnp_tests, test_ffi_signature_handle_after_add_uid)
+{
+    char *    json = NULL;
+    char *    results = NULL;
+    rnp_ffi_t ffi = NULL;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_set_key_provider(ffi, unused_getkeycb, NULL));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, unused_getpasscb, NULL));
+    load_test_data("test_ffi_json/generate-primary.json", &json, NULL);
+    assert_rnp_success(rnp_generate_key_json(ffi, json, &results));
+    free(json);
+    rnp_buffer_destroy(results);
+
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "test0", &key));
+    rnp_uid_handle_t uid = NULL;
+    assert_rnp_success(rnp_key_get_uid_handle_at(key, 0, &uid));
+    rnp_signature_handle_t sig = NULL;
+    assert_rnp_success(rnp_uid_get_signature_at(uid, 0, &sig));
+    uint32_t creation = 0;
+    assert_rnp_success(rnp_signature_get_creation(sig, &creation));
+    char *keyid = NULL;
+    assert_rnp_success(rnp_signature_get_keyid(sig, &keyid));
+    assert_non_null(keyid);
+
+    /* key signatures are stored contiguously, so adding many of them reallocates storage */
+    for (int i = 0; i < 20; i++) {
+        char userid[32] = {0};
+        snprintf(userid, sizeof(userid), "added uid %d", i);
+        assert_rnp_success(rnp_key_add_uid(key, userid, "SHA256", 2147317200, 0x00, false));
+    }
+    size_t count = 0;
+    assert_rnp_success(rnp_key_get_uid_count(key, &count));
+    assert_int_equal(count, 21);
+
+    /* existing signature handle must still refer to the same signature */
+    uint32_t newcreation = 0;
+    assert_rnp_success(rnp_signature_get_creation(sig, &newcreation));
+    assert_int_equal(creation, newcreation);
+    char *newkeyid = NULL;
+    assert_rnp_success(rnp_signature_get_keyid(sig, &newkeyid));
+    assert_string_equal(keyid, newkeyid);
+    rnp_buffer_destroy(keyid);
+    rnp_buffer_destroy(newkeyid);
+
+    rnp_signature_handle_destroy(sig);
+    rnp_uid_handle_destroy(uid);
+    rnp_key_handle_destroy(key);
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_keygen_json_sub_pass_required)
 {
     char *    json = NULL;
@@ -6272,6 +6488,150 @@ TEST_F(rnp_tests, test_ffi_aead_params)
     rnp_ffi_destroy(ffi);
 }
 
+static bool
+aead_encrypt_buf(rnp_ffi_t                   ffi,
+                 const char *                aalg,
+                 int                         bits,
+                 const std::vector<uint8_t> &data,
+                 std::vector<uint8_t> &      enc)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, data.data(), data.size(), false) ||
+        rnp_output_to_memory(&output, 0) || rnp_op_encrypt_create(&op, ffi, input, output) ||
+        rnp_op_encrypt_set_aead(op, aalg) || rnp_op_encrypt_set_aead_bits(op, bits) ||
+        rnp_op_encrypt_set_compression(op, "Uncompressed", 0) ||
+        rnp_op_encrypt_add_password(op, "pass1", NULL, 0, NULL) ||
+        rnp_op_encrypt_execute(op) || rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    enc.assign(buf, buf + len);
+    res = true;
+done:
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static bool
+aead_decrypt_buf(rnp_ffi_t ffi, const std::vector<uint8_t> &enc, std::vector<uint8_t> &data)
+{
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    uint8_t *    buf = NULL;
+    size_t       len = 0;
+    bool         res = false;
+
+    if (rnp_input_from_memory(&input, enc.data(), enc.size(), false) ||
+        rnp_output_to_memory(&output, 0) || rnp_decrypt(ffi, input, output) ||
+        rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    data.assign(buf, buf + len);
+    res = true;
+done:
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_aead_threads)
+{
+    rnp_ffi_t ffi = NULL;
+    rnp_ffi_t ffi_mt = NULL;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_create(&ffi_mt, "GPG", "GPG"));
+    assert_rnp_failure(rnp_ffi_set_aead_threads(NULL, 4));
+    assert_rnp_success(rnp_ffi_set_aead_threads(ffi_mt, 4));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "pass1"));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi_mt, getpasscb, (void *) "pass1"));
+
+    /* sizes around the chunk (64 bytes) and batch (4 chunks) boundaries */
+    const size_t sizes[] = {0, 1, 63, 64, 65, 256, 257, 300, 1024, 100000};
+    const char * aalgs[] = {"EAX", "OCB"};
+    for (size_t a = 0; a < ARRAY_SIZE(aalgs); a++) {
+        for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+            std::vector<uint8_t> data(sizes[i]);
+            std::vector<uint8_t> enc, enc_mt, dec;
+            for (size_t j = 0; j < data.size(); j++) {
+                data[j] = j * 7 + i;
+            }
+            assert_true(aead_encrypt_buf(ffi, aalgs[a], 0, data, enc));
+            assert_true(aead_encrypt_buf(ffi_mt, aalgs[a], 0, data, enc_mt));
+            /* multi-threaded encryption must be compatible with the sequential one */
+            assert_true(aead_decrypt_buf(ffi, enc_mt, dec));
+            assert_true(dec == data);
+            assert_true(aead_decrypt_buf(ffi_mt, enc, dec));
+            assert_true(dec == data);
+            assert_true(aead_decrypt_buf(ffi_mt, enc_mt, dec));
+            assert_true(dec == data);
+            /* corrupted data must be rejected */
+            if (data.size() > 200) {
+                enc_mt[enc_mt.size() - 100] ^= 0x01;
+                assert_false(aead_decrypt_buf(ffi_mt, enc_mt, dec));
+                assert_false(aead_decrypt_buf(ffi, enc_mt, dec));
+            }
+        }
+    }
+    /* large chunks are processed sequentially */
+    std::vector<uint8_t> data(10000, 0x42), enc, dec;
+    assert_true(aead_encrypt_buf(ffi_mt, "EAX", 20, data, enc));
+    assert_true(aead_decrypt_buf(ffi_mt, enc, dec));
+    assert_true(dec == data);
+    /* thread count is limited to the number of cores, so no per-thread buffer blowup */
+    assert_int_equal(rnp_parallel_clamp_threads(100000), rnp_parallel_threads());
+    assert_int_equal(rnp_parallel_clamp_threads(1), 1);
+    assert_rnp_success(rnp_ffi_set_aead_threads(ffi_mt, 100000));
+    assert_true(aead_encrypt_buf(ffi_mt, "OCB", 0, data, enc));
+    assert_true(aead_decrypt_buf(ffi_mt, enc, dec));
+    assert_true(dec == data);
+
+    rnp_ffi_destroy(ffi);
+    rnp_ffi_destroy(ffi_mt);
+}
+
+TEST_F(rnp_tests, test_parallel_thread_pool)
+{
+    rnp_thread_pool_t pool;
+    /* each item must be processed exactly once, with or without pool */
+    for (size_t count : {0, 1, 2, 7, 1000}) {
+        for (size_t threads : {0, 1, 3, 100}) {
+            std::vector<std::atomic<size_t>> hits(count);
+            for (auto &hit : hits) {
+                hit = 0;
+            }
+            rnp_parallel_for(&pool, count, threads, [&hits](size_t idx) { hits[idx]++; });
+            rnp_parallel_for(NULL, count, threads, [&hits](size_t idx) { hits[idx]++; });
+            for (auto &hit : hits) {
+                assert_int_equal(hit.load(), 2);
+            }
+        }
+    }
+    /* pool may be shared by several threads, and used from inside of the item */
+    std::atomic<size_t>      total(0);
+    std::vector<std::thread> callers;
+    for (size_t i = 0; i < 4; i++) {
+        callers.emplace_back([&pool, &total]() {
+            for (size_t j = 0; j < 50; j++) {
+                rnp_parallel_for(&pool, 8, 0, [&pool, &total](size_t) {
+                    rnp_parallel_for(&pool, 4, 0, [&total](size_t) { total++; });
+                });
+            }
+        });
+    }
+    for (auto &caller : callers) {
+        caller.join();
+    }
+    assert_int_equal(total.load(), 4 * 50 * 8 * 4);
+}
+
 TEST_F(rnp_tests, test_ffi_detached_verify_input)
 {
     rnp_ffi_t    ffi = NULL;
@@ -6478,3 +6838,614 @@ TEST_F(rnp_tests, test_ffi_op_verify_sig_count)
     rnp_output_destroy(output);
     rnp_ffi_destroy(ffi);
 }
+
+TEST_F(rnp_tests, test_ffi_op_buffer_size)
+{
+    rnp_ffi_t        ffi = NULL;
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_sign_t    op = NULL;
+    rnp_op_encrypt_t encop = NULL;
+    rnp_op_verify_t  verify = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+
+    test_ffi_init(&ffi);
+    /* sign with small buffers */
+    test_ffi_init_sign_memory_input(&input, &output);
+    assert_rnp_success(rnp_op_sign_create(&op, ffi, input, output));
+    assert_rnp_failure(rnp_op_sign_set_buffer_size(NULL, 8192));
+    assert_rnp_failure(rnp_op_sign_set_buffer_size(op, 100 * 1048576));
+    assert_rnp_success(rnp_op_sign_set_buffer_size(op, 1));
+    test_ffi_setup_signatures(&ffi, &op);
+    assert_rnp_success(rnp_op_sign_execute(op));
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+    assert_rnp_success(rnp_op_sign_destroy(op));
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+    /* verify with large ones */
+    test_ffi_init_verify_memory_input(&input, &output, buf, len);
+    assert_rnp_success(rnp_op_verify_create(&verify, ffi, input, output));
+    assert_rnp_failure(rnp_op_verify_set_buffer_size(NULL, 8192));
+    assert_rnp_failure(rnp_op_verify_set_buffer_size(verify, 100 * 1048576));
+    assert_rnp_success(rnp_op_verify_set_buffer_size(verify, 1048576));
+    assert_rnp_success(rnp_op_verify_execute(verify));
+    test_ffi_check_signatures(&verify);
+    assert_rnp_success(rnp_op_verify_destroy(verify));
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+    rnp_buffer_destroy(buf);
+
+    /* encrypt bulk data with different buffer sizes */
+    const size_t sizes[] = {0, 8192, 65536, 4 * 1048576};
+    std::vector<uint8_t> data(300000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i * 13;
+    }
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "pass1"));
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+        assert_rnp_success(rnp_input_from_memory(&input, data.data(), data.size(), false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_encrypt_create(&encop, ffi, input, output));
+        assert_rnp_failure(rnp_op_encrypt_set_buffer_size(NULL, sizes[i]));
+        assert_rnp_success(rnp_op_encrypt_set_buffer_size(encop, sizes[i]));
+        assert_rnp_success(rnp_op_encrypt_add_password(encop, "pass1", NULL, 0, NULL));
+        assert_rnp_success(rnp_op_encrypt_set_armor(encop, i % 2));
+        assert_rnp_success(rnp_op_encrypt_execute(encop));
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+        assert_rnp_success(rnp_op_encrypt_destroy(encop));
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+
+        assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        /* buffer size is picked automatically here */
+        assert_rnp_success(rnp_decrypt(ffi, input, output));
+        rnp_buffer_destroy(buf);
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        assert_int_equal(len, data.size());
+        assert_int_equal(memcmp(buf, data.data(), len), 0);
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+    }
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
+
+TEST_F(rnp_tests, test_ffi_pipeline)
+{
+    rnp_ffi_t        ffi = NULL;
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    rnp_op_verify_t  verify = NULL;
+    rnp_key_handle_t key = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    size_t           sig_count = 0;
+
+    test_ffi_init(&ffi);
+    assert_rnp_failure(rnp_ffi_set_pipeline(NULL, true));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "password"));
+
+    /* large enough to be processed with pipeline */
+    std::vector<uint8_t> data(3 * 1048576 + 17);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 13 + (i >> 13));
+    }
+
+    const char *zalgs[] = {"Uncompressed", "ZIP", "ZLIB", "BZip2"};
+    for (size_t i = 0; i < 2 * ARRAY_SIZE(zalgs); i++) {
+        bool pipeline = i % 2;
+        assert_rnp_success(rnp_ffi_set_pipeline(ffi, pipeline));
+        assert_rnp_success(rnp_input_from_memory(&input, data.data(), data.size(), false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+        assert_rnp_success(rnp_locate_key(ffi, "userid", "key1-uid1", &key));
+        assert_rnp_success(rnp_op_encrypt_add_recipient(op, key));
+        rnp_key_handle_destroy(key);
+        assert_rnp_success(rnp_locate_key(ffi, "userid", "key1-uid2", &key));
+        assert_rnp_success(rnp_op_encrypt_add_signature(op, key, NULL));
+        rnp_key_handle_destroy(key);
+        assert_rnp_success(rnp_op_encrypt_set_compression(op, zalgs[i / 2], 6));
+        assert_rnp_success(rnp_op_encrypt_set_armor(op, (i / 2) % 2));
+        assert_rnp_success(rnp_op_encrypt_execute(op));
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+        assert_rnp_success(rnp_op_encrypt_destroy(op));
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+
+        assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_verify_create(&verify, ffi, input, output));
+        assert_rnp_success(rnp_op_verify_execute(verify));
+        assert_rnp_success(rnp_op_verify_get_signature_count(verify, &sig_count));
+        assert_int_equal(sig_count, 1);
+        assert_rnp_success(rnp_op_verify_destroy(verify));
+        rnp_buffer_destroy(buf);
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        assert_int_equal(len, data.size());
+        assert_int_equal(memcmp(buf, data.data(), len), 0);
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+    }
+
+    /* output errors are reported when stages run on the separate threads */
+    assert_rnp_success(rnp_ffi_set_pipeline(ffi, true));
+    assert_rnp_success(rnp_input_from_memory(&input, data.data(), data.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 100000));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+    assert_rnp_success(rnp_op_encrypt_add_password(op, "pass1", NULL, 0, NULL));
+    assert_rnp_success(rnp_op_encrypt_set_compression(op, "Uncompressed", 0));
+    assert_rnp_success(rnp_op_encrypt_set_armor(op, true));
+    assert_rnp_failure(rnp_op_encrypt_execute(op));
+    assert_rnp_success(rnp_op_encrypt_destroy(op));
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
+
+TEST_F(rnp_tests, test_ffi_compression_threads)
+{
+    rnp_ffi_t        ffi = NULL;
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    size_t           zlen = 0;
+
+    test_ffi_init(&ffi);
+    assert_rnp_failure(rnp_op_encrypt_set_compression_threads(NULL, 4));
+    assert_rnp_failure(rnp_op_sign_set_compression_threads(NULL, 4));
+
+    /* compressible data, spanning multiple blocks for every algorithm */
+    std::vector<uint8_t> data(5 * 1048576 + 1234);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (i % 1024 < 512) ? "compressible"[i % 12] : (uint8_t)((i * 7) ^ (i >> 11));
+    }
+
+    const char *zalgs[] = {"ZIP", "ZLIB", "BZip2"};
+    for (size_t i = 0; i < 2 * ARRAY_SIZE(zalgs); i++) {
+        size_t threads = (i % 2) ? 4 : 0;
+        assert_rnp_success(rnp_input_from_memory(&input, data.data(), data.size(), false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+        assert_rnp_success(rnp_op_encrypt_add_password(op, "pass1", NULL, 0, NULL));
+        assert_rnp_success(rnp_op_encrypt_set_compression(op, zalgs[i / 2], 6));
+        assert_rnp_success(rnp_op_encrypt_set_compression_threads(op, threads));
+        assert_rnp_success(rnp_op_encrypt_execute(op));
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+        assert_rnp_success(rnp_op_encrypt_destroy(op));
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+        /* compression ratio must stay close to the sequential one */
+        if (!threads) {
+            zlen = len;
+        } else {
+            assert_true(len < zlen + zlen / 20);
+        }
+
+        assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "pass1"));
+        assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_decrypt(ffi, input, output));
+        rnp_buffer_destroy(buf);
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        assert_int_equal(len, data.size());
+        assert_int_equal(memcmp(buf, data.data(), len), 0);
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+    }
+
+    /* empty input must produce valid compressed stream as well */
+    for (size_t i = 0; i < ARRAY_SIZE(zalgs); i++) {
+        assert_rnp_success(rnp_input_from_memory(&input, data.data(), 0, false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+        assert_rnp_success(rnp_op_encrypt_add_password(op, "pass1", NULL, 0, NULL));
+        assert_rnp_success(rnp_op_encrypt_set_compression(op, zalgs[i], 9));
+        assert_rnp_success(rnp_op_encrypt_set_compression_threads(op, 2));
+        assert_rnp_success(rnp_op_encrypt_execute(op));
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+        assert_rnp_success(rnp_op_encrypt_destroy(op));
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+
+        assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_decrypt(ffi, input, output));
+        rnp_buffer_destroy(buf);
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        assert_int_equal(len, 0);
+        assert_rnp_success(rnp_input_destroy(input));
+        assert_rnp_success(rnp_output_destroy(output));
+    }
+
+    /* thread count is limited, so huge value doesn't allocate a block buffer per thread */
+    assert_rnp_success(rnp_input_from_memory(&input, data.data(), data.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+    assert_rnp_success(rnp_op_encrypt_add_password(op, "pass1", NULL, 0, NULL));
+    assert_rnp_success(rnp_op_encrypt_set_compression(op, "BZip2", 9));
+    assert_rnp_success(rnp_op_encrypt_set_compression_threads(op, 100000));
+    assert_rnp_success(rnp_op_encrypt_execute(op));
+    assert_rnp_success(rnp_op_encrypt_destroy(op));
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
+
+/* encrypt and sign data, then decrypt and verify it, returning the first error */
+static rnp_result_t
+ffi_encrypt_verify_roundtrip(rnp_ffi_t ffi, const std::vector<uint8_t> &data)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    rnp_op_verify_t  verify = NULL;
+    rnp_key_handle_t key = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    size_t           sigs = 0;
+    rnp_result_t     ret;
+
+    if ((ret = rnp_input_from_memory(&input, data.data(), data.size(), false)) ||
+        (ret = rnp_output_to_memory(&output, 0)) ||
+        (ret = rnp_op_encrypt_create(&op, ffi, input, output)) ||
+        (ret = rnp_locate_key(ffi, "userid", "key1-uid1", &key)) ||
+        (ret = rnp_op_encrypt_add_recipient(op, key)) ||
+        (ret = rnp_key_handle_destroy(key)) ||
+        (ret = rnp_locate_key(ffi, "userid", "key1-uid2", &key)) ||
+        (ret = rnp_op_encrypt_add_signature(op, key, NULL)) ||
+        (ret = rnp_key_handle_destroy(key)) || (ret = rnp_op_encrypt_execute(op)) ||
+        (ret = rnp_output_memory_get_buf(output, &buf, &len, true))) {
+        goto done;
+    }
+    rnp_op_encrypt_destroy(op);
+    op = NULL;
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    output = NULL;
+
+    if ((ret = rnp_input_from_memory(&input, buf, len, false)) ||
+        (ret = rnp_output_to_memory(&output, 0)) ||
+        (ret = rnp_op_verify_create(&verify, ffi, input, output)) ||
+        (ret = rnp_op_verify_execute(verify)) ||
+        (ret = rnp_op_verify_get_signature_count(verify, &sigs))) {
+        goto done;
+    }
+    rnp_buffer_destroy(buf);
+    if ((ret = rnp_output_memory_get_buf(output, &buf, &len, true))) {
+        goto done;
+    }
+    if ((sigs != 1) || (len != data.size()) || memcmp(buf, data.data(), len)) {
+        ret = RNP_ERROR_BAD_STATE;
+    }
+done:
+    rnp_op_encrypt_destroy(op);
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    rnp_buffer_destroy(buf);
+    return ret;
+}
+
+TEST_F(rnp_tests, test_ffi_concurrent_operations)
+{
+    rnp_ffi_t ffi = NULL;
+
+    test_ffi_init(&ffi);
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "password"));
+
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 7 + (i >> 9));
+    }
+
+    /* readers encrypt, sign, verify and lookup keys, while writer imports and removes
+     * the keys which are not used by them */
+    std::atomic<bool>        stop(false);
+    std::vector<std::thread> threads;
+    std::vector<int>         failures(6, 0);
+    for (size_t t = 0; t + 1 < failures.size(); t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 8; i++) {
+                size_t           count = 0;
+                rnp_key_handle_t key = NULL;
+                if (ffi_encrypt_verify_roundtrip(ffi, data) ||
+                    rnp_get_public_key_count(ffi, &count) || (count < 7) ||
+                    rnp_locate_key(ffi, "keyid", "7BC6709B15C23A4A", &key) || !key) {
+                    failures[t]++;
+                }
+                rnp_key_handle_destroy(key);
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        while (!stop) {
+            rnp_input_t      input = NULL;
+            rnp_key_handle_t key = NULL;
+            bool             found = false;
+            if (rnp_input_from_path(&input, "data/keyrings/2/pubring.gpg") ||
+                rnp_import_keys(ffi, input, RNP_LOAD_SAVE_PUBLIC_KEYS, NULL) ||
+                rnp_locate_key(ffi, "keyid", "DC70C124A50283F1", &key) || !key ||
+                rnp_key_have_public(key, &found) || !found ||
+                rnp_key_remove(key, RNP_KEY_REMOVE_PUBLIC)) {
+                failures.back()++;
+            }
+            rnp_key_handle_destroy(key);
+            rnp_input_destroy(input);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    for (size_t t = 0; t + 1 < threads.size(); t++) {
+        threads[t].join();
+    }
+    stop = true;
+    threads.back().join();
+    for (int failed : failures) {
+        assert_int_equal(failed, 0);
+    }
+
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
+
+TEST_F(rnp_tests, test_ffi_concurrent_key_update)
+{
+    rnp_ffi_t              ffi = NULL;
+    rnp_key_handle_t       key = NULL;
+    rnp_uid_handle_t       uid = NULL;
+    rnp_signature_handle_t sig = NULL;
+    char *                 keyid = NULL;
+
+    /* readers use handles to alice while writer imports the updates of her key */
+    const char *case1 = "data/test_key_validity/case1/pubring.gpg";
+    const char *case2 = "data/test_key_validity/case2/pubring.gpg";
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(load_keys_gpg(ffi, case1));
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "Alice <alice@rnp>", &key));
+    assert_non_null(key);
+    assert_rnp_success(rnp_key_get_uid_handle_at(key, 0, &uid));
+    assert_rnp_success(rnp_uid_get_signature_at(uid, 0, &sig));
+    assert_rnp_success(rnp_signature_get_keyid(sig, &keyid));
+
+    std::atomic<bool>        stop(false);
+    std::vector<std::thread> threads;
+    std::vector<int>         failures(5, 0);
+    for (size_t t = 0; t + 1 < failures.size(); t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 200; i++) {
+                size_t count = 0;
+                char * uidstr = NULL;
+                char * sigid = NULL;
+                if (rnp_key_get_uid_count(key, &count) || (count != 1) ||
+                    rnp_key_get_uid_at(key, 0, &uidstr) ||
+                    strcmp(uidstr, "Alice <alice@rnp>") ||
+                    rnp_uid_get_signature_count(uid, &count) || (count < 2) ||
+                    rnp_signature_get_keyid(sig, &sigid) || strcmp(sigid, keyid)) {
+                    failures[t]++;
+                }
+                rnp_buffer_destroy(uidstr);
+                rnp_buffer_destroy(sigid);
+                for (size_t idx = 0; idx < count; idx++) {
+                    rnp_signature_handle_t usig = NULL;
+                    uint32_t               created = 0;
+                    if (rnp_uid_get_signature_at(uid, idx, &usig) ||
+                        rnp_signature_get_creation(usig, &created) || !created) {
+                        failures[t]++;
+                    }
+                    rnp_signature_handle_destroy(usig);
+                }
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        for (size_t i = 0; !stop; i++) {
+            if (!import_pub_keys(ffi, i % 2 ? case1 : case2)) {
+                failures.back()++;
+            }
+        }
+    });
+    for (size_t t = 0; t + 1 < threads.size(); t++) {
+        threads[t].join();
+    }
+    stop = true;
+    threads.back().join();
+    for (int failed : failures) {
+        assert_int_equal(failed, 0);
+    }
+    assert_int_equal(get_alice_sig_count(ffi), 3);
+
+    rnp_buffer_destroy(keyid);
+    rnp_signature_handle_destroy(sig);
+    rnp_uid_handle_destroy(uid);
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
+
+TEST_F(rnp_tests, test_ffi_operation_other_thread)
+{
+    rnp_ffi_t         ffi = NULL;
+    rnp_input_t       input = NULL;
+    rnp_output_t      output = NULL;
+    rnp_op_encrypt_t  op = NULL;
+    rnp_op_generate_t genop = NULL;
+    uint8_t *         buf = NULL;
+    size_t            len = 0;
+
+    test_ffi_init(&ffi);
+    std::string data = "data, encrypted on the other thread";
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (const uint8_t *) data.data(), data.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+
+    /* creating thread exits before the operation is used, destroying its generator */
+    std::thread creator([&]() {
+        assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+        assert_rnp_success(rnp_op_generate_create(&genop, ffi, "ECDSA"));
+    });
+    creator.join();
+    std::thread executor([&]() {
+        assert_rnp_success(rnp_op_encrypt_add_password(op, "pass1", NULL, 0, NULL));
+        assert_rnp_success(rnp_op_encrypt_execute(op));
+        assert_rnp_success(rnp_op_generate_set_curve(genop, "NIST P-256"));
+        assert_rnp_success(rnp_op_generate_set_protection_password(genop, "pass1"));
+        assert_rnp_success(rnp_op_generate_execute(genop));
+    });
+    executor.join();
+    assert_rnp_success(rnp_op_encrypt_destroy(op));
+    assert_rnp_success(rnp_op_generate_destroy(genop));
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+    assert_rnp_success(rnp_output_destroy(output));
+
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "pass1"));
+    assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_decrypt(ffi, input, output));
+    rnp_buffer_destroy(buf);
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    assert_int_equal(len, data.size());
+    assert_int_equal(memcmp(buf, data.data(), len), 0);
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
+
+/* sign data with key1-uid2, producing embedded or detached signature */
+static std::vector<uint8_t>
+ffi_sign_data(rnp_ffi_t ffi, const std::string &data, bool detached)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_sign_t    op = NULL;
+    rnp_key_handle_t key = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (const uint8_t *) data.data(), data.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    if (detached) {
+        assert_rnp_success(rnp_op_sign_detached_create(&op, ffi, input, output));
+    } else {
+        assert_rnp_success(rnp_op_sign_create(&op, ffi, input, output));
+    }
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key1-uid2", &key));
+    assert_rnp_success(rnp_op_sign_add_signature(op, key, NULL));
+    assert_rnp_success(rnp_key_handle_destroy(key));
+    assert_rnp_success(rnp_op_sign_execute(op));
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    std::vector<uint8_t> res(buf, buf + len);
+    assert_rnp_success(rnp_op_sign_destroy(op));
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+    return res;
+}
+
+static void
+ffi_verify_batch_cb(rnp_op_verify_batch_t op,
+                    size_t                idx,
+                    rnp_op_verify_t       verify,
+                    rnp_result_t          status,
+                    void *                app_ctx)
+{
+    std::vector<int> *calls = (std::vector<int> *) app_ctx;
+    (*calls)[idx]++;
+}
+
+TEST_F(rnp_tests, test_ffi_verify_batch)
+{
+    rnp_ffi_t             ffi = NULL;
+    rnp_op_verify_batch_t batch = NULL;
+    rnp_op_verify_t       verify = NULL;
+    rnp_result_t          status = RNP_ERROR_GENERIC;
+    size_t                count = 0;
+
+    test_ffi_init(&ffi);
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, getpasscb, (void *) "password"));
+
+    /* even items have embedded signatures, odd ones - detached */
+    const size_t                      items = 40;
+    std::vector<std::string>          data;
+    std::vector<std::vector<uint8_t>> sigs;
+    for (size_t i = 0; i < items; i++) {
+        data.push_back("batch verification item " + std::to_string(i));
+        sigs.push_back(ffi_sign_data(ffi, data[i], i % 2));
+    }
+    /* corrupt the detached data and the embedded signature */
+    data[5][0] ^= 0x01;
+    sigs[8][sigs[8].size() / 2] ^= 0x01;
+
+    assert_rnp_failure(rnp_op_verify_batch_create(NULL, ffi));
+    assert_rnp_failure(rnp_op_verify_batch_create(&batch, NULL));
+    assert_rnp_success(rnp_op_verify_batch_create(&batch, ffi));
+    assert_rnp_success(rnp_op_verify_batch_set_threads(batch, 4));
+    std::vector<int> calls(items, 0);
+    assert_rnp_success(rnp_op_verify_batch_set_callback(batch, ffi_verify_batch_cb, &calls));
+
+    std::vector<rnp_input_t>  inputs;
+    std::vector<rnp_output_t> outputs;
+    for (size_t i = 0; i < items; i++) {
+        rnp_input_t input = NULL;
+        assert_rnp_success(
+          rnp_input_from_memory(&input, sigs[i].data(), sigs[i].size(), false));
+        inputs.push_back(input);
+        if (!(i % 2)) {
+            rnp_output_t output = NULL;
+            /* check both discarded and written out data */
+            if (i % 4) {
+                assert_rnp_success(rnp_output_to_memory(&output, 0));
+                outputs.push_back(output);
+            }
+            assert_rnp_success(rnp_op_verify_batch_add(batch, input, output));
+            continue;
+        }
+        rnp_input_t signed_data = NULL;
+        assert_rnp_success(rnp_input_from_memory(
+          &signed_data, (const uint8_t *) data[i].data(), data[i].size(), false));
+        inputs.push_back(signed_data);
+        assert_rnp_success(rnp_op_verify_batch_add_detached(batch, signed_data, input));
+    }
+    assert_rnp_success(rnp_op_verify_batch_get_item_count(batch, &count));
+    assert_int_equal(count, items);
+    assert_rnp_success(rnp_op_verify_batch_execute(batch));
+
+    for (size_t i = 0; i < items; i++) {
+        assert_int_equal(calls[i], 1);
+        assert_rnp_success(rnp_op_verify_batch_get_item(batch, i, &verify, &status));
+        if ((i == 5) || (i == 8)) {
+            assert_rnp_failure(status);
+            continue;
+        }
+        assert_rnp_success(status);
+        size_t                    sig_count = 0;
+        rnp_op_verify_signature_t sig = NULL;
+        assert_rnp_success(rnp_op_verify_get_signature_count(verify, &sig_count));
+        assert_int_equal(sig_count, 1);
+        assert_rnp_success(rnp_op_verify_get_signature_at(verify, 0, &sig));
+        assert_rnp_success(rnp_op_verify_signature_get_status(sig));
+    }
+    assert_rnp_failure(rnp_op_verify_batch_get_item(batch, items, &verify, &status));
+
+    /* written out data */
+    for (size_t i = 0; i < outputs.size(); i++) {
+        uint8_t *buf = NULL;
+        size_t   len = 0;
+        size_t   idx = i * 4 + 2;
+        assert_rnp_success(rnp_output_memory_get_buf(outputs[i], &buf, &len, false));
+        assert_int_equal(len, data[idx].size());
+        assert_int_equal(memcmp(buf, data[idx].data(), len), 0);
+    }
+
+    assert_rnp_success(rnp_op_verify_batch_destroy(batch));
+    for (auto input : inputs) {
+        assert_rnp_success(rnp_input_destroy(input));
+    }
+    for (auto output : outputs) {
+        assert_rnp_success(rnp_output_destroy(output));
+    }
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}
@@ -919,8 +919,8 @@ TEST_F(rnp_tests, test_generated_key_sigs)
     pgp_key_t *      sub_pub = NULL, *sub_sec = NULL;
 
     // create a couple keyrings
-    pubring = (rnp_key_store_t *) calloc(1, sizeof(*pubring));
-    secring = (rnp_key_store_t *) calloc(1, sizeof(*secring));
+    pubring = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
+    secring = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
     assert_non_null(pubring);
     assert_non_null(secring);
 
@@ -46,7 +46,7 @@ TEST_F(rnp_tests, test_key_add_userid)
                                    "54505a936a4a970e",
                                    "326ef111425d14a5"};
 
-    rnp_key_store_t *ks = (rnp_key_store_t *) calloc(1, sizeof(*ks));
+    rnp_key_store_t *ks = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
     assert_non_null(ks);
 
     assert_rnp_success(init_file_src(&src, "data/keyrings/1/secring.gpg"));
@@ -129,7 +129,7 @@ TEST_F(rnp_tests, test_key_add_userid)
     key = NULL;
 
     // start over
-    ks = (rnp_key_store_t *) calloc(1, sizeof(*ks));
+    ks = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
     assert_non_null(ks);
     // read from the saved packets
     assert_rnp_success(init_mem_src(&src, mem_dest_get_memory(&dst), dst.writeb, false));
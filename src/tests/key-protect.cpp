@@ -55,7 +55,7 @@ TEST_F(rnp_tests, test_key_protect_load_pgp)
     // load our keyring and do some quick checks
     {
         pgp_source_t     src = {};
-        rnp_key_store_t *ks = (rnp_key_store_t *) calloc(1, sizeof(*ks));
+        rnp_key_store_t *ks = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
         assert_non_null(ks);
 
         assert_rnp_success(init_file_src(&src, "data/keyrings/1/secring.gpg"));
@@ -128,15 +128,19 @@ TEST_F(rnp_tests, test_key_protect_load_pgp)
     assert_false(mpi_empty(&pgp_key_get_material(key)->rsa.u));
 
     // save the secret MPIs for some later comparisons
-    pgp_mpi_t d = pgp_key_get_material(key)->rsa.d;
-    pgp_mpi_t p = pgp_key_get_material(key)->rsa.p;
-    pgp_mpi_t q = pgp_key_get_material(key)->rsa.q;
-    pgp_mpi_t u = pgp_key_get_material(key)->rsa.u;
+    pgp_mpi_t d = {};
+    pgp_mpi_t p = {};
+    pgp_mpi_t q = {};
+    pgp_mpi_t u = {};
+    assert_true(mpi_copy(&d, &pgp_key_get_material(key)->rsa.d));
+    assert_true(mpi_copy(&p, &pgp_key_get_material(key)->rsa.p));
+    assert_true(mpi_copy(&q, &pgp_key_get_material(key)->rsa.q));
+    assert_true(mpi_copy(&u, &pgp_key_get_material(key)->rsa.u));
 
     // confirm that packets[0] is no longer encrypted
     {
         pgp_source_t     memsrc = {};
-        rnp_key_store_t *ks = (rnp_key_store_t *) calloc(1, sizeof(*ks));
+        rnp_key_store_t *ks = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
         assert_non_null(ks);
         pgp_rawpacket_t *pkt = pgp_key_get_rawpacket(key, 0);
 
@@ -250,5 +254,9 @@ TEST_F(rnp_tests, test_key_protect_load_pgp)
     assert_true(mpi_equal(&pgp_key_get_material(key)->rsa.u, &u));
 
     // cleanup
+    mpi_forget(&d);
+    mpi_forget(&p);
+    mpi_forget(&q);
+    mpi_forget(&u);
     pgp_key_free(key);
 }
@@ -255,3 +255,52 @@ TEST_F(rnp_tests, test_key_store_search_by_name)
     rnp_key_store_free(pub_store);
     rnp_key_store_free(sec_store);
 }
+
+/* Check that key store indexes stay consistent with the keys list after removal. */
+TEST_F(rnp_tests, test_key_store_search_index)
+{
+    rnp_key_store_t *store =
+      rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_non_null(store);
+    assert_true(rnp_key_store_load_from_path(store, NULL));
+    assert_int_equal(rnp_key_store_get_key_count(store), 7);
+
+    for (list_item *li = list_front(rnp_key_store_get_keys(store)); li; li = list_next(li)) {
+        pgp_key_t *key = (pgp_key_t *) li;
+        assert_true(rnp_key_store_get_key_by_grip(store, pgp_key_get_grip(key)) == key);
+        assert_true(rnp_key_store_get_key_by_fpr(store, pgp_key_get_fp(key)) == key);
+        assert_true(rnp_key_store_get_key_by_id(store, pgp_key_get_keyid(key), NULL) == key);
+        // short key id is passed in the first 4 bytes
+        uint8_t shortid[PGP_KEY_ID_SIZE] = {0};
+        memcpy(shortid, pgp_key_get_keyid(key) + PGP_KEY_ID_SIZE / 2, PGP_KEY_ID_SIZE / 2);
+        assert_true(rnp_key_store_get_key_by_id(store, shortid, NULL) == key);
+        assert_null(rnp_key_store_get_key_by_id(store, shortid, key));
+
+        pgp_key_search_t search = {};
+        search.type = PGP_KEY_SEARCH_GRIP;
+        memcpy(search.by.grip, pgp_key_get_grip(key), PGP_KEY_GRIP_SIZE);
+        assert_true(rnp_key_store_search(store, &search, NULL) == key);
+        assert_null(rnp_key_store_search(store, &search, key));
+    }
+
+    // remove subkey 326ef111425d14a5 and make sure it cannot be found anymore
+    pgp_key_t *key = rnp_tests_get_key_by_id(store, "326ef111425d14a5", NULL);
+    assert_non_null(key);
+    uint8_t           grip[PGP_KEY_GRIP_SIZE];
+    uint8_t           keyid[PGP_KEY_ID_SIZE];
+    pgp_fingerprint_t fp = *pgp_key_get_fp(key);
+    memcpy(grip, pgp_key_get_grip(key), PGP_KEY_GRIP_SIZE);
+    memcpy(keyid, pgp_key_get_keyid(key), PGP_KEY_ID_SIZE);
+    pgp_key_free_data(key);
+    assert_true(rnp_key_store_remove_key(store, key));
+    assert_int_equal(rnp_key_store_get_key_count(store), 6);
+    assert_null(rnp_key_store_get_key_by_grip(store, grip));
+    assert_null(rnp_key_store_get_key_by_fpr(store, &fp));
+    assert_null(rnp_key_store_get_key_by_id(store, keyid, NULL));
+    assert_non_null(rnp_tests_get_key_by_id(store, "7bc6709b15c23a4a", NULL));
+
+    // clear the store and make sure nothing is found
+    rnp_key_store_clear(store);
+    assert_null(rnp_tests_get_key_by_id(store, "7bc6709b15c23a4a", NULL));
+    rnp_key_store_free(store);
+}
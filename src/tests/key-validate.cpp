@@ -127,6 +127,114 @@ TEST_F(rnp_tests, test_key_validate)
     rnp_key_store_free(secring);
 }
 
+TEST_F(rnp_tests, test_key_validate_bulk)
+{
+    rnp_key_store_t *pubring;
+    pgp_key_t *      key = NULL;
+
+    pubring = rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_non_null(pubring);
+    pubring->disable_validation = true;
+    assert_true(rnp_key_store_load_from_path(pubring, NULL));
+    for (size_t i = 0; i < rnp_key_store_get_key_count(pubring); i++) {
+        assert_false(rnp_key_store_get_key(pubring, i)->validated);
+    }
+    /* validation results must match the ones of the per-key validation */
+    rnp_key_store_validate(pubring, 4);
+    for (size_t i = 0; i < rnp_key_store_get_key_count(pubring); i++) {
+        assert_true(rnp_key_store_get_key(pubring, i)->validated);
+    }
+    assert_non_null(key = rnp_tests_get_key_by_id(pubring, "1d7e8a5393c997a8", NULL));
+    assert_false(key->valid);
+    key->valid = true;
+    assert_true(all_keys_valid(pubring));
+    rnp_key_store_free(pubring);
+
+    pubring = rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/2/pubring.gpg");
+    assert_non_null(pubring);
+    pubring->disable_validation = true;
+    assert_true(rnp_key_store_load_from_path(pubring, NULL));
+    rnp_key_store_validate(pubring, 1);
+    assert_true(all_keys_valid(pubring));
+    rnp_key_store_free(pubring);
+}
+
+TEST_F(rnp_tests, test_key_validate_batch)
+{
+    const char *paths[] = {"data/keyrings/1/pubring.gpg",
+                           "data/keyrings/1/secring.gpg",
+                           "data/keyrings/2/pubring.gpg",
+                           "data/keyrings/5/pubring.gpg",
+                           NULL};
+
+    for (size_t i = 0; paths[i]; i++) {
+        rnp_key_store_t *keyring = rnp_key_store_new(PGP_KEY_STORE_GPG, paths[i]);
+        assert_non_null(keyring);
+        assert_true(rnp_key_store_load_from_path(keyring, NULL));
+        size_t                   count = rnp_key_store_get_key_count(keyring);
+        std::vector<pgp_key_t *> keys;
+        std::vector<bool>        valid;
+        for (size_t k = 0; k < count; k++) {
+            pgp_key_t *key = rnp_key_store_get_key(keyring, k);
+            keys.push_back(key);
+            valid.push_back(key->valid);
+            key->valid = !key->valid;
+            key->validated = false;
+        }
+        /* results must be the same as of sequential validation */
+        pgp_key_validate_batch(keys.data(), keys.size(), keyring, 4);
+        for (size_t k = 0; k < count; k++) {
+            assert_true(keys[k]->validated);
+            assert_true(keys[k]->valid == valid[k]);
+        }
+        rnp_key_store_free(keyring);
+    }
+}
+
+TEST_F(rnp_tests, test_key_validate_sig_cache)
+{
+    pgp_sig_cache_t *cache = sig_cache_new(1000);
+    assert_non_null(cache);
+
+    rnp_key_store_t *pubring =
+      rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_non_null(pubring);
+    pubring->sigcache = cache;
+    assert_true(rnp_key_store_load_from_path(pubring, NULL));
+    assert_true(sig_cache_size(cache) > 0);
+
+    /* second revalidation must not add new results, and validity must stay the same */
+    pgp_key_t *key = NULL;
+    assert_non_null(key = rnp_tests_get_key_by_id(pubring, "1d7e8a5393c997a8", NULL));
+    assert_false(key->valid);
+    size_t cached = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < rnp_key_store_get_key_count(pubring); i++) {
+            rnp_key_store_get_key(pubring, i)->validated = false;
+        }
+        rnp_key_store_validate(pubring, 2);
+        if (pass) {
+            assert_int_equal(sig_cache_size(cache), cached);
+        }
+        cached = sig_cache_size(cache);
+    }
+    assert_false(key->valid);
+    key->valid = true;
+    assert_true(all_keys_valid(pubring));
+    rnp_key_store_free(pubring);
+
+    /* cache is bounded */
+    sig_cache_free(cache);
+    cache = sig_cache_new(2);
+    pubring = rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_non_null(pubring);
+    pubring->sigcache = cache;
+    assert_true(rnp_key_store_load_from_path(pubring, NULL));
+    assert_int_equal(sig_cache_size(cache), 2);
+    rnp_key_store_free(pubring);
+    sig_cache_free(cache);
+}
+
 #define DATA_PATH "data/test_forged_keys/"
 
 static void
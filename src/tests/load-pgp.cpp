@@ -40,7 +40,7 @@ TEST_F(rnp_tests, test_load_v3_keyring_pgp)
 {
     pgp_source_t src = {};
 
-    rnp_key_store_t *key_store = (rnp_key_store_t *) calloc(1, sizeof(*key_store));
+    rnp_key_store_t *key_store = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
     assert_non_null(key_store);
 
     // load pubring in to the key store
@@ -63,7 +63,7 @@ TEST_F(rnp_tests, test_load_v3_keyring_pgp)
 
     // load secret keyring and decrypt the key
 
-    key_store = (rnp_key_store_t *) calloc(1, sizeof(*key_store));
+    key_store = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
     assert_non_null(key_store);
 
     assert_rnp_success(init_file_src(&src, "data/keyrings/4/secring.pgp"));
@@ -103,7 +103,7 @@ TEST_F(rnp_tests, test_load_v4_keyring_pgp)
 {
     pgp_source_t src = {};
 
-    rnp_key_store_t *key_store = (rnp_key_store_t *) calloc(1, sizeof(*key_store));
+    rnp_key_store_t *key_store = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
     assert_non_null(key_store);
 
     // load it in to the key store
@@ -131,7 +131,7 @@ check_pgp_keyring_counts(const char *   path,
                          const unsigned subkey_counts[])
 {
     pgp_source_t     src = {};
-    rnp_key_store_t *key_store = (rnp_key_store_t *) calloc(1, sizeof(*key_store));
+    rnp_key_store_t *key_store = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
 
     assert_non_null(key_store);
     // load it in to the key store
@@ -1015,6 +1015,7 @@ TEST_F(rnp_tests, test_load_subkey)
     assert_int_equal(pgp_key_get_rawpacket(skey2, 0)->tag, PGP_PTAG_CT_PUBLIC_SUBKEY);
     assert_null(pgp_key_get_primary_grip(skey2));
     assert_false(skey1 == skey2);
+    assert_int_equal(key_store->orphans.size(), 2);
 
     /* load primary key without subkey signatures */
     assert_true(load_keystore(key_store, MERGE_PATH "key-pub-uid-1.pgp"));
@@ -1032,6 +1033,9 @@ TEST_F(rnp_tests, test_load_subkey)
     assert_int_equal(pgp_key_get_subkey_count(key), 1);
     assert_true(skey1->valid);
     assert_false(skey2->valid);
+    assert_int_equal(key_store->orphans.size(), 1);
+    assert_true(key_store->orphansbyfp.empty());
+    assert_true(key_store->orphansbyid.empty());
 
     /* load second subkey with signature */
     assert_true(load_keystore(key_store, MERGE_PATH "key-pub-just-subkey-2.pgp"));
@@ -1043,6 +1047,47 @@ TEST_F(rnp_tests, test_load_subkey)
     assert_true(check_subkey_grip(key, skey2, 1));
     assert_int_equal(pgp_key_get_subkey_count(key), 2);
     assert_true(skey2->valid);
+    assert_true(key_store->orphans.empty());
+
+    rnp_key_store_free(key_store);
+}
+
+TEST_F(rnp_tests, test_load_keyring_arena)
+{
+    rnp_key_store_t *key_store =
+      rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_non_null(key_store);
+    assert_true(rnp_key_store_load_from_path(key_store, NULL));
+    assert_int_equal(rnp_key_store_get_key_count(key_store), 7);
+
+    /* raw packets of the loaded keys are kept in a few large blocks */
+    size_t packets = 0;
+    for (list_item *li = list_front(key_store->keys); li; li = list_next(li)) {
+        pgp_key_t *key = (pgp_key_t *) li;
+        for (size_t i = 0; i < pgp_key_get_rawpacket_count(key); i++) {
+            assert_true(pgp_key_get_rawpacket(key, i)->in_arena);
+            packets++;
+        }
+    }
+    assert_true(packets > rnp_key_store_get_key_count(key_store));
+    assert_true(arena_block_count(&key_store->packets) < packets);
+    assert_true(key_store->packets.total > 0);
 
+    /* copy of the key owns its packets and outlives the key store */
+    pgp_key_t *key = rnp_key_store_get_key(key_store, 0);
+    pgp_key_t  keycp = {};
+    assert_rnp_success(pgp_key_copy(&keycp, key, false));
+    size_t   len = pgp_key_get_rawpacket(key, 0)->length;
+    uint8_t *raw = (uint8_t *) malloc(len);
+    assert_non_null(raw);
+    memcpy(raw, pgp_key_get_rawpacket(key, 0)->raw, len);
     rnp_key_store_free(key_store);
+
+    for (size_t i = 0; i < pgp_key_get_rawpacket_count(&keycp); i++) {
+        assert_false(pgp_key_get_rawpacket(&keycp, i)->in_arena);
+    }
+    assert_int_equal(pgp_key_get_rawpacket(&keycp, 0)->length, len);
+    assert_int_equal(memcmp(pgp_key_get_rawpacket(&keycp, 0)->raw, raw, len), 0);
+    free(raw);
+    pgp_key_free_data(&keycp);
 }
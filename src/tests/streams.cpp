@@ -30,14 +30,18 @@
 #include "crypto/hash.h"
 #include "crypto/signatures.h"
 #include "pgp-key.h"
+#include "utils.h"
 #include <time.h>
 #include "rnp.h"
 #include <librepgp/stream-ctx.h>
 #include <librepgp/stream-packet.h>
 #include <librepgp/stream-sig.h>
 #include <librepgp/stream-key.h>
+#include "../librekey/key_store_pgp.h"
 #include <librepgp/stream-dump.h>
 #include <librepgp/stream-armor.h>
+#include <librepgp/stream-pipe.h>
+#include <librepgp/base64-simd.h>
 
 static bool
 stream_hash_file(pgp_hash_t *hash, const char *path)
@@ -326,6 +330,306 @@ TEST_F(rnp_tests, test_stream_file)
     assert_int_equal(unlink(dirname), 0);
 }
 
+TEST_F(rnp_tests, test_stream_borrow)
+{
+    const char *   filename = "dummyfile.dat";
+    uint8_t        data[PGP_INPUT_CACHE_SIZE * 3];
+    uint8_t        tmpbuf[16] = {0};
+    const uint8_t *ptr = NULL;
+    pgp_source_t   src = {};
+    pgp_dest_t     dst = {};
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t) i;
+    }
+
+    /* memory source hands out pointers to the memory itself */
+    assert_rnp_success(init_mem_src(&src, data, sizeof(data), false));
+    assert_int_equal(src_peek_ptr(&src, 100, &ptr), 100);
+    assert_true(ptr == data);
+    src_consume(&src, 10);
+    assert_int_equal(src.readb, 10);
+    assert_int_equal(src_peek_ptr(&src, sizeof(data), &ptr), sizeof(data) - 10);
+    assert_true(ptr == data + 10);
+    /* peeked data goes to the cache, and is returned first */
+    assert_int_equal(src_peek(&src, tmpbuf, 4), 4);
+    assert_int_equal(tmpbuf[0], 10);
+    assert_int_equal(src_peek_ptr(&src, sizeof(data), &ptr), PGP_INPUT_CACHE_SIZE);
+    assert_true(ptr != data + 10);
+    assert_int_equal(memcmp(ptr, data + 10, PGP_INPUT_CACHE_SIZE), 0);
+    src_consume(&src, 4);
+    assert_int_equal(src_peek_ptr(&src, 100, &ptr), 100);
+    assert_int_equal(memcmp(ptr, data + 14, 100), 0);
+    src_consume(&src, PGP_INPUT_CACHE_SIZE - 4);
+    assert_int_equal(src_peek_ptr(&src, 100, &ptr), 100);
+    assert_true(ptr == data + 10 + PGP_INPUT_CACHE_SIZE);
+    /* skip and read are in sync with borrowed reads */
+    assert_int_equal(src_skip(&src, 1000), 1000);
+    assert_int_equal(src_read(&src, tmpbuf, 2), 2);
+    assert_int_equal(tmpbuf[0], data[1010 + PGP_INPUT_CACHE_SIZE]);
+    /* the rest of cached data, then the rest of memory */
+    while (!src.eof) {
+        ssize_t read = src_peek_ptr(&src, sizeof(data), &ptr);
+        assert_true(read > 0);
+        assert_int_equal(memcmp(ptr, data + src.readb, read), 0);
+        src_consume(&src, read);
+    }
+    assert_int_equal(src.readb, sizeof(data));
+    assert_int_equal(src_peek_ptr(&src, 1, &ptr), 0);
+    assert_null(ptr);
+    src_close(&src);
+
+    /* file source borrows from the cache */
+    assert_rnp_success(init_file_dest(&dst, filename, true));
+    dst_write(&dst, data, sizeof(data));
+    dst_close(&dst, false);
+    assert_rnp_success(init_file_src(&src, filename));
+    size_t total = 0;
+    while (!src_eof(&src)) {
+        ssize_t read = src_peek_ptr(&src, sizeof(data), &ptr);
+        assert_true(read >= 0);
+        assert_true(read <= PGP_INPUT_CACHE_SIZE);
+        assert_int_equal(memcmp(ptr, data + total, read), 0);
+        src_consume(&src, read);
+        total += read;
+    }
+    assert_int_equal(total, sizeof(data));
+    assert_int_equal(src.readb, sizeof(data));
+    src_close(&src);
+    assert_int_equal(unlink(filename), 0);
+}
+
+TEST_F(rnp_tests, test_stream_buffer_size)
+{
+    const char * filename = "dummyfile.dat";
+    uint8_t      data[100000];
+    uint8_t      tmpbuf[1000] = {0};
+    pgp_source_t src = {};
+    pgp_dest_t   dst = {};
+
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7);
+    }
+
+    /* sizes are rounded to the power of two and clamped */
+    assert_int_equal(stream_buffer_size_for(0), PGP_STREAM_BUFFER_MIN_SIZE);
+    assert_int_equal(stream_buffer_size_for(100), PGP_STREAM_BUFFER_MIN_SIZE);
+    assert_int_equal(stream_buffer_size_for(sizeof(data)), 131072);
+    assert_int_equal(stream_buffer_size_for(1ULL << 40), PGP_STREAM_BUFFER_AUTO_MAX_SIZE);
+    assert_int_equal(stream_set_buffer_size(1), 0);
+    assert_int_equal(stream_set_buffer_size(20000), PGP_STREAM_BUFFER_MIN_SIZE);
+    assert_int_equal(stream_set_buffer_size(100 * 1048576), 32768);
+    assert_int_equal(stream_set_buffer_size(0), PGP_STREAM_BUFFER_MAX_SIZE);
+
+    /* streams, created after the setting, use the small buffers */
+    stream_set_buffer_size(1000);
+    assert_rnp_success(init_file_dest(&dst, filename, true));
+    assert_int_equal(dst.csize, PGP_STREAM_BUFFER_MIN_SIZE);
+    assert_null(dst.cache);
+    for (size_t i = 0; i < sizeof(data); i += 333) {
+        dst_write(&dst, data + i, std::min((size_t) 333, sizeof(data) - i));
+        assert_true(dst.clen <= PGP_STREAM_BUFFER_MIN_SIZE);
+    }
+    assert_non_null(dst.cache);
+    dst_close(&dst, false);
+    assert_null(dst.cache);
+    assert_rnp_success(init_file_src(&src, filename));
+    stream_set_buffer_size(0);
+    assert_int_equal(src.cache->size, PGP_STREAM_BUFFER_MIN_SIZE);
+    assert_null(src.cache->buf);
+    for (size_t i = 0; i < sizeof(data); i += sizeof(tmpbuf)) {
+        assert_true(src_read_eq(&src, tmpbuf, sizeof(tmpbuf)));
+        assert_int_equal(memcmp(tmpbuf, data + i, sizeof(tmpbuf)), 0);
+        assert_true(src.cache->len <= PGP_STREAM_BUFFER_MIN_SIZE);
+    }
+    assert_true(src_eof(&src));
+    src_close(&src);
+
+    /* size may be changed only while there is no cached data */
+    assert_rnp_success(init_file_src(&src, filename));
+    assert_int_equal(src.cache->size, PGP_INPUT_CACHE_SIZE);
+    assert_true(src_set_buffer_size(&src, 500000));
+    assert_int_equal(src.cache->size, 524288);
+    assert_true(src_read_eq(&src, tmpbuf, 10));
+    assert_int_equal(src.cache->len, sizeof(data));
+    assert_false(src_set_buffer_size(&src, 0));
+    assert_true(src_skip(&src, sizeof(data) - 10) == sizeof(data) - 10);
+    assert_true(src_set_buffer_size(&src, 0));
+    assert_int_equal(src.cache->size, PGP_INPUT_CACHE_SIZE);
+    assert_true(src_eof(&src));
+    src_close(&src);
+
+    assert_rnp_success(init_file_dest(&dst, filename, true));
+    dst_write(&dst, data, 10);
+    assert_false(dst_set_buffer_size(&dst, 1048576));
+    dst_flush(&dst);
+    assert_true(dst_set_buffer_size(&dst, 1048576));
+    assert_int_equal(dst.csize, 1048576);
+    dst_write(&dst, data, sizeof(data));
+    assert_int_equal(dst.clen, sizeof(data));
+    assert_int_equal(dst.writeb, 10);
+    assert_rnp_success(dst_finish(&dst));
+    assert_int_equal(dst.writeb, sizeof(data) + 10);
+    assert_null(dst.cache);
+    dst_close(&dst, false);
+    assert_rnp_success(init_file_src(&src, filename));
+    assert_true(src_read_eq(&src, tmpbuf, 10));
+    assert_int_equal(memcmp(tmpbuf, data, 10), 0);
+    assert_true(src_read_eq(&src, tmpbuf, sizeof(tmpbuf)));
+    assert_int_equal(memcmp(tmpbuf, data, sizeof(tmpbuf)), 0);
+    src_close(&src);
+    assert_int_equal(unlink(filename), 0);
+}
+
+TEST_F(rnp_tests, test_stream_pipe)
+{
+    const char *         filename = "dummyfile.dat";
+    std::vector<uint8_t> data(1000000);
+    uint8_t              tmpbuf[4096];
+    uint8_t              small[100];
+    pgp_dest_t           filedst = {};
+    pgp_dest_t           armordst = {};
+    pgp_dest_t           memdst = {};
+    pgp_source_t         filesrc = {};
+    pgp_source_t         armorsrc = {};
+
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)(i * 13 + (i >> 11));
+    }
+
+    /* chain of two pipes: armoring and file writing are done by the worker threads */
+    assert_rnp_success(init_file_dest(&filedst, filename, true));
+    assert_rnp_success(init_armored_dst(&armordst, &filedst, PGP_ARMORED_MESSAGE));
+    assert_rnp_success(init_pipe_dst(&filedst));
+    assert_int_equal(filedst.type, PGP_STREAM_PIPE);
+    assert_rnp_success(init_pipe_dst(&armordst));
+    assert_int_equal(armordst.type, PGP_STREAM_PIPE);
+    size_t written = 0;
+    for (size_t chunk = 1; written < data.size(); chunk = chunk * 3 % 100003) {
+        size_t len = std::min(chunk, data.size() - written);
+        dst_write(&armordst, data.data() + written, len);
+        assert_rnp_success(armordst.werr);
+        written += len;
+    }
+    assert_rnp_success(dst_finish(&armordst));
+    assert_rnp_success(dst_finish(&filedst));
+    dst_close(&armordst, false);
+    dst_close(&filedst, false);
+
+    assert_rnp_success(init_file_src(&filesrc, filename));
+    assert_rnp_success(init_armored_src(&armorsrc, &filesrc));
+    size_t read = 0;
+    while (!src_eof(&armorsrc)) {
+        ssize_t res = src_read(&armorsrc, tmpbuf, sizeof(tmpbuf));
+        assert_true(res >= 0);
+        assert_true(read + res <= data.size());
+        assert_int_equal(memcmp(tmpbuf, data.data() + read, res), 0);
+        read += res;
+    }
+    assert_int_equal(read, data.size());
+    src_close(&armorsrc);
+    src_close(&filesrc);
+
+    /* closing pipe without finishing discards the data */
+    assert_rnp_success(init_file_dest(&filedst, filename, true));
+    assert_rnp_success(init_pipe_dst(&filedst));
+    dst_write(&filedst, data.data(), data.size());
+    dst_close(&filedst, true);
+    assert_false(file_exists(filename));
+
+    /* write error is reported back to the writer */
+    assert_rnp_success(init_mem_dest(&memdst, small, sizeof(small)));
+    assert_rnp_success(init_pipe_dst(&memdst));
+    for (size_t i = 0; (i < 100) && !memdst.werr; i++) {
+        dst_write(&memdst, data.data(), data.size());
+    }
+    assert_int_not_equal(memdst.werr, RNP_SUCCESS);
+    assert_rnp_failure(dst_finish(&memdst));
+    dst_close(&memdst, true);
+
+    /* error which happened only on finish */
+    assert_rnp_success(init_mem_dest(&memdst, small, sizeof(small)));
+    assert_rnp_success(init_pipe_dst(&memdst));
+    dst_write(&memdst, data.data(), sizeof(small) + 1);
+    assert_rnp_success(memdst.werr);
+    assert_rnp_failure(dst_finish(&memdst));
+    dst_close(&memdst, false);
+}
+
+#ifdef HAVE_SYS_MMAN_H
+TEST_F(rnp_tests, test_stream_mmap)
+{
+    const char * filename = "dummyfile.dat";
+    const char * dirname = "dummydir";
+    const char * filedata = "dummy message to be stored in the file";
+    const int    iterations = 10000;
+    const int    filedatalen = strlen(filedata);
+    uint8_t      tmpbuf[1024] = {0};
+    pgp_dest_t   dst = {};
+    pgp_source_t src = {};
+    pgp_source_t memsrc = {};
+
+    /* non-existing file, directory and empty file */
+    assert_rnp_failure(init_mmap_src(&src, filename));
+    assert_rnp_failure(init_file_or_mmap_src(&src, filename));
+    assert_int_equal(RNP_MKDIR(dirname, S_IRWXU), 0);
+    assert_int_equal(init_mmap_src(&src, dirname), RNP_ERROR_NOT_SUPPORTED);
+    assert_rnp_failure(init_file_or_mmap_src(&src, dirname));
+    assert_int_equal(rmdir(dirname), 0);
+    assert_rnp_success(init_file_dest(&dst, filename, false));
+    dst_close(&dst, false);
+    assert_int_equal(init_mmap_src(&src, filename), RNP_ERROR_NOT_SUPPORTED);
+    /* empty file falls back to the file source */
+    assert_rnp_success(init_file_or_mmap_src(&src, filename));
+    assert_int_equal(src.type, PGP_STREAM_FILE);
+    assert_int_equal(src_read(&src, tmpbuf, sizeof(tmpbuf)), 0);
+    assert_true(src_eof(&src));
+    src_close(&src);
+
+    /* populate file */
+    assert_rnp_success(init_file_dest(&dst, filename, true));
+    for (int i = 0; i < iterations; i++) {
+        dst_write(&dst, filedata, filedatalen);
+    }
+    dst_close(&dst, false);
+
+    /* read it back via mapping */
+    assert_rnp_success(init_mmap_src(&src, filename));
+    assert_int_equal(src.type, PGP_STREAM_MEMORY);
+    assert_int_equal(src.size, filedatalen * iterations);
+    assert_non_null(mem_src_get_memory(&src));
+    assert_int_equal(src_peek(&src, tmpbuf, filedatalen), filedatalen);
+    assert_int_equal(memcmp(tmpbuf, filedata, filedatalen), 0);
+    for (int i = 0; i < iterations; i++) {
+        assert_int_equal(src_read(&src, tmpbuf, filedatalen), filedatalen);
+        assert_int_equal(memcmp(tmpbuf, filedata, filedatalen), 0);
+    }
+    assert_true(src_eof(&src));
+    src_close(&src);
+
+    /* memory source over the mapping references it instead of copying */
+    assert_rnp_success(init_file_or_mmap_src(&src, filename));
+    assert_int_equal(src.type, PGP_STREAM_MEMORY);
+    assert_int_equal(src_peek(&src, tmpbuf, 4), 4);
+    assert_rnp_success(read_mem_src(&memsrc, &src));
+    assert_true(mem_src_get_memory(&memsrc) == mem_src_get_memory(&src));
+    assert_int_equal(memsrc.size, filedatalen * iterations);
+    assert_true(src_eof(&src));
+    assert_int_equal(src_read(&memsrc, tmpbuf, filedatalen), filedatalen);
+    assert_int_equal(memcmp(tmpbuf, filedata, filedatalen), 0);
+    src_close(&memsrc);
+    src_close(&src);
+
+    /* file to memory uses mapping as well */
+    assert_rnp_success(file_to_mem_src(&src, filename));
+    assert_int_equal(src.size, filedatalen * iterations);
+    assert_int_equal(memcmp(mem_src_get_memory(&src), filedata, filedatalen), 0);
+    src_close(&src);
+
+    assert_int_equal(unlink(filename), 0);
+}
+#endif
+
 TEST_F(rnp_tests, test_stream_signatures)
 {
     rnp_key_store_t * pubring;
@@ -1150,6 +1454,314 @@ TEST_F(rnp_tests, test_stream_key_signatures)
     rng_destroy(&rng);
 }
 
+/* append copy of the certification, made distinct and issued by some third-party key */
+static void
+add_flood_certification(pgp_transferable_userid_t *uid,
+                        const pgp_signature_t *    sig,
+                        unsigned                   idx)
+{
+    uint8_t          keyid[PGP_KEY_ID_SIZE] = {0xF1, 0x00, 0xD0};
+    pgp_signature_t *newsig =
+      (pgp_signature_t *) list_append(&uid->signatures, NULL, sizeof(*newsig));
+    assert_non_null(newsig);
+    assert_true(copy_signature_packet(newsig, sig));
+    assert_int_equal(newsig->palg, PGP_PKA_RSA);
+    pgp_mpi_t *s = &newsig->material.rsa.s;
+    s->mpi[s->len - 1] ^= (uint8_t) idx;
+    s->mpi[s->len - 2] ^= (uint8_t)(idx >> 8);
+    STORE32BE(keyid + 4, idx);
+    assert_true(signature_set_keyid(newsig, keyid));
+}
+
+TEST_F(rnp_tests, test_stream_key_merge_flooded)
+{
+    pgp_source_t           keysrc = {0};
+    pgp_key_sequence_t     keyseq = {};
+    pgp_transferable_key_t dst = {};
+    pgp_transferable_key_t src = {};
+    const size_t           flood = 2000;
+
+    assert_rnp_success(init_file_src(&keysrc, "data/keyrings/1/pubring.gpg"));
+    assert_rnp_success(process_pgp_keys(&keysrc, &keyseq));
+    src_close(&keysrc);
+    pgp_transferable_key_t *key = (pgp_transferable_key_t *) list_front(keyseq.keys);
+    assert_non_null(key);
+    assert_int_equal(list_length(key->userids), 3);
+    pgp_transferable_userid_t *uid = (pgp_transferable_userid_t *) list_front(key->userids);
+    const pgp_signature_t *    selfsig = (pgp_signature_t *) list_front(uid->signatures);
+    assert_int_equal(list_length(uid->signatures), 1);
+
+    /* src has each certification twice, dst has the first half of them */
+    assert_true(transferable_key_copy(&dst, key, false));
+    assert_true(transferable_key_copy(&src, key, false));
+    pgp_transferable_userid_t *dstuid = (pgp_transferable_userid_t *) list_front(dst.userids);
+    pgp_transferable_userid_t *srcuid = (pgp_transferable_userid_t *) list_front(src.userids);
+    for (unsigned i = 0; i < flood; i++) {
+        add_flood_certification(srcuid, selfsig, i + 1);
+        add_flood_certification(srcuid, selfsig, i + 1);
+        if (i < flood / 2) {
+            add_flood_certification(dstuid, selfsig, i + 1);
+        }
+    }
+    assert_int_equal(list_length(srcuid->signatures), 2 * flood + 1);
+    assert_int_equal(list_length(dstuid->signatures), flood / 2 + 1);
+    /* merge skips the duplicates */
+    assert_rnp_success(transferable_key_merge(&dst, &src));
+    assert_int_equal(list_length(dstuid->signatures), flood + 1);
+    assert_rnp_success(transferable_key_merge(&dst, &src));
+    assert_rnp_success(transferable_key_merge(&dst, key));
+    assert_int_equal(list_length(dstuid->signatures), flood + 1);
+    assert_int_equal(list_length(dst.userids), 3);
+
+    /* key store with limit applies it on adding new key and on merge */
+    rnp_key_store_t *keyring = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
+    assert_non_null(keyring);
+    keyring->cert_limit = 100;
+    pgp_transferable_key_t tmp = {};
+    assert_true(transferable_key_copy(&tmp, &dst, false));
+    assert_true(rnp_key_store_add_transferable_key(keyring, &tmp));
+    transferable_key_destroy(&tmp);
+    pgp_key_t *pkey = rnp_key_store_get_key(keyring, 0);
+    assert_non_null(pkey);
+    assert_int_equal(rnp_key_store_get_key_count(keyring), 4);
+    assert_int_equal(pgp_key_get_subsig_count(pkey), 103);
+    assert_true(transferable_key_copy(&tmp, key, false));
+    for (unsigned i = 0; i < 50; i++) {
+        add_flood_certification(
+          (pgp_transferable_userid_t *) list_front(tmp.userids), selfsig, flood + i + 1);
+    }
+    assert_true(rnp_key_store_add_transferable_key(keyring, &tmp));
+    transferable_key_destroy(&tmp);
+    assert_int_equal(rnp_key_store_get_key_count(keyring), 4);
+    assert_int_equal(pgp_key_get_subsig_count(pkey), 103);
+    rnp_key_store_free(keyring);
+
+    /* existing certifications over the limit are kept on merge */
+    keyring = rnp_key_store_new(PGP_KEY_STORE_GPG, "");
+    assert_non_null(keyring);
+    assert_true(transferable_key_copy(&tmp, &dst, false));
+    assert_true(rnp_key_store_add_transferable_key(keyring, &tmp));
+    transferable_key_destroy(&tmp);
+    pkey = rnp_key_store_get_key(keyring, 0);
+    assert_int_equal(pgp_key_get_subsig_count(pkey), flood + 3);
+    keyring->cert_limit = 100;
+    assert_true(transferable_key_copy(&tmp, key, false));
+    for (unsigned i = 0; i < 50; i++) {
+        add_flood_certification(
+          (pgp_transferable_userid_t *) list_front(tmp.userids), selfsig, flood + i + 1);
+    }
+    assert_true(rnp_key_store_add_transferable_key(keyring, &tmp));
+    transferable_key_destroy(&tmp);
+    assert_int_equal(pgp_key_get_subsig_count(pkey), flood + 3);
+    rnp_key_store_free(keyring);
+
+    /* limit third-party certifications, self-signature must stay */
+    assert_int_equal(transferable_key_limit_certifications(&src, 0, NULL, 0), 0);
+    assert_int_equal(list_length(srcuid->signatures), 2 * flood + 1);
+    assert_int_equal(transferable_key_limit_certifications(&dst, 10, NULL, 0), flood - 10);
+    assert_int_equal(list_length(dstuid->signatures), 11);
+    assert_true(
+      signature_pkt_equal((pgp_signature_t *) list_front(dstuid->signatures), selfsig));
+    assert_int_equal(transferable_key_limit_certifications(&dst, 10, NULL, 0), 0);
+
+    transferable_key_destroy(&dst);
+    transferable_key_destroy(&src);
+    key_sequence_destroy(&keyseq);
+}
+
+static std::vector<uint8_t>
+write_signature_to_vec(const pgp_signature_t *sig)
+{
+    pgp_dest_t memdst = {};
+    assert_rnp_success(init_mem_dest(&memdst, NULL, 0));
+    assert_true(stream_write_signature(sig, &memdst));
+    uint8_t *            mem = (uint8_t *) mem_dest_get_memory(&memdst);
+    std::vector<uint8_t> res(mem, mem + memdst.writeb);
+    dst_close(&memdst, true);
+    return res;
+}
+
+static void
+check_lazy_signature(pgp_signature_t *sig)
+{
+    pgp_signature_t   copy = {};
+    pgp_fingerprint_t fp1 = {};
+    pgp_fingerprint_t fp2 = {};
+    uint8_t           keyid1[PGP_KEY_ID_SIZE] = {0};
+    uint8_t           keyid2[PGP_KEY_ID_SIZE] = {0};
+
+    /* loaded signature's subpackets are not parsed */
+    assert_false(sig->subpkts_expanded);
+    assert_int_equal(dynarray_length(&sig->subpkts), 0);
+    assert_true(copy_signature_packet(&copy, sig));
+    assert_true(signature_expand_subpkts(&copy));
+    assert_true(copy.subpkts_expanded);
+    assert_int_not_equal(dynarray_length(&copy.subpkts), 0);
+
+    /* raw lookups must give the same results as parsed subpackets */
+    assert_int_equal(signature_get_creation(sig), signature_get_creation(&copy));
+    assert_int_equal(signature_get_expiration(sig), signature_get_expiration(&copy));
+    assert_int_equal(signature_get_key_expiration(sig), signature_get_key_expiration(&copy));
+    assert_int_equal(signature_get_key_flags(sig), signature_get_key_flags(&copy));
+    assert_int_equal(signature_has_keyfp(sig), signature_has_keyfp(&copy));
+    assert_int_equal(signature_get_keyfp(sig, &fp1), signature_get_keyfp(&copy, &fp2));
+    assert_true(fingerprint_equal(&fp1, &fp2));
+    assert_true(signature_get_keyid(sig, keyid1));
+    assert_true(signature_get_keyid(&copy, keyid2));
+    assert_int_equal(memcmp(keyid1, keyid2, PGP_KEY_ID_SIZE), 0);
+    assert_int_equal(signature_get_primary_uid(sig), signature_get_primary_uid(&copy));
+    assert_false(sig->subpkts_expanded);
+
+    /* written as it was loaded */
+    assert_true(write_signature_to_vec(sig) == write_signature_to_vec(&copy));
+    free_signature(&copy);
+}
+
+TEST_F(rnp_tests, test_stream_signature_lazy_subpackets)
+{
+    pgp_source_t       keysrc = {0};
+    pgp_key_sequence_t keyseq = {};
+    size_t             count = 0;
+
+    assert_rnp_success(init_file_src(&keysrc, "data/keyrings/1/pubring.gpg"));
+    assert_rnp_success(process_pgp_keys(&keysrc, &keyseq));
+    src_close(&keysrc);
+    for (list_item *li = list_front(keyseq.keys); li; li = list_next(li)) {
+        pgp_transferable_key_t *key = (pgp_transferable_key_t *) li;
+        for (list_item *ui = list_front(key->userids); ui; ui = list_next(ui)) {
+            pgp_transferable_userid_t *uid = (pgp_transferable_userid_t *) ui;
+            for (list_item *si = list_front(uid->signatures); si; si = list_next(si)) {
+                check_lazy_signature((pgp_signature_t *) si);
+                count++;
+            }
+        }
+        for (list_item *ki = list_front(key->subkeys); ki; ki = list_next(ki)) {
+            pgp_transferable_subkey_t *skey = (pgp_transferable_subkey_t *) ki;
+            for (list_item *si = list_front(skey->signatures); si; si = list_next(si)) {
+                check_lazy_signature((pgp_signature_t *) si);
+                count++;
+            }
+        }
+    }
+    assert_true(count > 0);
+    key_sequence_destroy(&keyseq);
+
+    /* subpacket with offset, which doesn't fit the index, and one with unknown type */
+    pgp_signature_t sig = {};
+    const uint8_t   keyid[PGP_KEY_ID_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8};
+    sig.version = PGP_V4;
+    sig.type = PGP_CERT_GENERIC;
+    sig.palg = PGP_PKA_RSA;
+    sig.halg = PGP_HASH_SHA256;
+    assert_true(mpi_alloc(&sig.material.rsa.s, 1));
+    sig.material.rsa.s.mpi[0] = 1;
+    std::string big(65400, 'v');
+    std::string small(1000, 'v');
+    assert_true(signature_add_notation_data(&sig, true, "big@rnp", big.c_str()));
+    signature_get_subpkt(&sig, PGP_SIG_SUBPKT_NOTATION_DATA)->hashed = 0;
+    assert_true(signature_add_notation_data(&sig, true, "small@rnp", small.c_str()));
+    assert_true(signature_set_creation(&sig, 1000));
+    pgp_sig_subpkt_t *unknown =
+      signature_add_subpkt(&sig, (pgp_sig_subpacket_type_t) 100, 3, false);
+    assert_non_null(unknown);
+    unknown->hashed = 1;
+    assert_true(signature_set_keyid(&sig, keyid));
+    assert_true(signature_fill_hashed_data(&sig));
+    std::vector<uint8_t> data = write_signature_to_vec(&sig);
+    free_signature(&sig);
+
+    pgp_source_t memsrc = {};
+    assert_rnp_success(init_mem_src(&memsrc, data.data(), data.size(), false));
+    assert_rnp_success(stream_parse_signature(&memsrc, &sig));
+    src_close(&memsrc);
+    assert_int_equal(sig.subpkt_idx[PGP_SIG_SUBPKT_ISSUER_KEY_ID], PGP_SIG_SUBPKT_IDX_FAR);
+    uint8_t keyid2[PGP_KEY_ID_SIZE] = {0};
+    assert_true(signature_get_keyid(&sig, keyid2));
+    assert_int_equal(memcmp(keyid, keyid2, PGP_KEY_ID_SIZE), 0);
+    assert_int_equal(signature_get_creation(&sig), 1000);
+    pgp_sig_subpkt_t view;
+    assert_true(signature_find_raw_subpkt(&sig, (pgp_sig_subpacket_type_t) 100, &view));
+    assert_int_equal(view.len, 3);
+    assert_true(view.hashed);
+    assert_false(signature_find_raw_subpkt(&sig, PGP_SIG_SUBPKT_KEY_FLAGS, &view));
+    assert_true(write_signature_to_vec(&sig) == data);
+    check_lazy_signature(&sig);
+    /* parsing on demand */
+    assert_non_null(signature_get_subpkt(&sig, PGP_SIG_SUBPKT_NOTATION_DATA));
+    assert_true(sig.subpkts_expanded);
+    assert_int_equal(dynarray_length(&sig.subpkts), 5);
+    assert_int_equal(signature_get_creation(&sig), 1000);
+    assert_true(write_signature_to_vec(&sig) == data);
+    free_signature(&sig);
+}
+
+TEST_F(rnp_tests, test_stream_signature_raw_in_place)
+{
+    rnp_key_store_t *pubring =
+      rnp_key_store_new(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_non_null(pubring);
+    assert_true(rnp_key_store_load_from_path(pubring, NULL));
+    assert_true(rnp_key_store_get_key_count(pubring) > 0);
+    for (size_t i = 0; i < rnp_key_store_get_key_count(pubring); i++) {
+        pgp_key_t *key = rnp_key_store_get_key(pubring, i);
+        pgp_key_t  copy = {};
+        /* loaded signatures are parsed over raw packets in the key store arena */
+        assert_true(pgp_key_get_subsig_count(key) > 0);
+        for (size_t j = 0; j < pgp_key_get_subsig_count(key); j++) {
+            pgp_signature_t *sig = &pgp_key_get_subsig(key, j)->sig;
+            bool             found = false;
+            assert_non_null(sig->raw);
+            for (size_t k = 0; k < pgp_key_get_rawpacket_count(key); k++) {
+                pgp_rawpacket_t *pkt = pgp_key_get_rawpacket(key, k);
+                if (pkt->raw == sig->raw) {
+                    assert_true(pkt->in_arena);
+                    assert_int_equal(pkt->length, sig->raw_len);
+                    found = true;
+                }
+            }
+            assert_true(found);
+            assert_true(sig->hashed_data > sig->raw);
+            assert_true(sig->hashed_data < sig->raw + sig->raw_len);
+            check_lazy_signature(sig);
+        }
+        assert_rnp_success(pgp_key_validate(key, pubring));
+        /* while copied ones own their data */
+        assert_rnp_success(pgp_key_copy(&copy, key, false));
+        assert_int_equal(pgp_key_get_subsig_count(&copy), pgp_key_get_subsig_count(key));
+        for (size_t j = 0; j < pgp_key_get_subsig_count(&copy); j++) {
+            pgp_signature_t *sig = &pgp_key_get_subsig(&copy, j)->sig;
+            assert_null(sig->raw);
+            assert_true(signature_pkt_equal(sig, &pgp_key_get_subsig(key, j)->sig));
+        }
+        pgp_key_free_data(&copy);
+    }
+
+    /* parse in place, then take ownership and wipe the packet */
+    pgp_key_t *          key = rnp_key_store_get_key(pubring, 0);
+    pgp_signature_t *    keysig = &pgp_key_get_subsig(key, 0)->sig;
+    std::vector<uint8_t> raw = write_signature_to_vec(keysig);
+    pgp_signature_t      sig = {};
+    assert_rnp_success(stream_parse_signature_raw(raw.data(), raw.size(), &sig));
+    assert_true(sig.raw == raw.data());
+    assert_true(sig.hashed_data > raw.data());
+    assert_true(sig.hashed_data < raw.data() + raw.size());
+    assert_true(signature_pkt_equal(&sig, keysig));
+    assert_true(signature_own_data(&sig));
+    assert_null(sig.raw);
+    std::fill(raw.begin(), raw.end(), 0);
+    assert_true(signature_pkt_equal(&sig, keysig));
+    assert_int_equal(signature_get_creation(&sig), signature_get_creation(keysig));
+    free_signature(&sig);
+
+    /* malformed packets */
+    raw = write_signature_to_vec(keysig);
+    assert_rnp_failure(stream_parse_signature_raw(raw.data(), raw.size() - 1, &sig));
+    assert_rnp_failure(stream_parse_signature_raw(raw.data(), 1, &sig));
+    raw[0] = 0xC0 | PGP_PTAG_CT_USER_ID;
+    assert_rnp_failure(stream_parse_signature_raw(raw.data(), raw.size(), &sig));
+    rnp_key_store_free(pubring);
+}
+
 static void
 validate_key_sigs(const char *path)
 {
@@ -1563,3 +2175,77 @@ TEST_F(rnp_tests, test_stream_dearmor_edge_cases)
     len = snprintf(msg, sizeof(msg), "%s\n\n%s\n=miZpp\n%s\n", HDR, b64, FTR);
     assert_false(try_dearmor(msg, len));
 }
+
+static const char B64_ALPHA[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+TEST_F(rnp_tests, test_stream_armor_simd)
+{
+    /* check each of the available base64 kernels against the scalar code */
+    uint8_t bin[3 * 1024];
+    uint8_t chars[4 * 1024 + 4];
+    uint8_t vals[4 * 1024 + 4];
+    uint8_t back[3 * 1024];
+    for (size_t i = 0; i < sizeof(bin); i++) {
+        bin[i] = (uint8_t)(i * 131 + (i >> 5) * 7 + 3);
+    }
+    for (size_t idx = 0; idx < base64_simd_count(); idx++) {
+        const pgp_base64_simd_t *simd = base64_simd_get(idx);
+        assert_non_null(simd);
+        size_t done = simd->encode(bin, sizeof(bin), chars);
+        assert_int_equal(done % 3, 0);
+        assert_true(done <= sizeof(bin));
+        for (size_t i = 0; i < done; i += 3) {
+            uint32_t v = (bin[i] << 16) | (bin[i + 1] << 8) | bin[i + 2];
+            assert_int_equal(chars[i / 3 * 4], B64_ALPHA[v >> 18]);
+            assert_int_equal(chars[i / 3 * 4 + 1], B64_ALPHA[(v >> 12) & 0x3f]);
+            assert_int_equal(chars[i / 3 * 4 + 2], B64_ALPHA[(v >> 6) & 0x3f]);
+            assert_int_equal(chars[i / 3 * 4 + 3], B64_ALPHA[v & 0x3f]);
+        }
+        size_t clen = done / 3 * 4;
+        /* decoding must stop right before the first non-base64 character */
+        chars[clen] = '\n';
+        size_t dlen = simd->decode(chars, clen + 1, vals);
+        assert_true(dlen <= clen);
+        for (size_t i = 0; i < dlen; i++) {
+            assert_int_equal(B64_ALPHA[vals[i]], chars[i]);
+        }
+        /* packing back must give the original data */
+        size_t plen = simd->pack(vals, dlen - dlen % 4, back);
+        assert_int_equal(plen % 4, 0);
+        assert_int_equal(memcmp(back, bin, plen / 4 * 3), 0);
+        chars[dlen / 2] = '=';
+        assert_true(simd->decode(chars, clen, vals) <= dlen / 2);
+    }
+
+    /* roundtrip of the larger data via armor streams, including crc check */
+    std::vector<uint8_t> data(1024 * 1024 + 17);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t)((i * 2654435761u) >> 13);
+    }
+    pgp_source_t src = {};
+    pgp_dest_t   dst = {};
+    assert_rnp_success(init_mem_src(&src, data.data(), data.size(), false));
+    assert_rnp_success(init_mem_dest(&dst, NULL, 0));
+    assert_rnp_success(rnp_armor_source(&src, &dst, PGP_ARMORED_MESSAGE));
+    src_close(&src);
+    std::string armored((char *) mem_dest_get_memory(&dst), dst.writeb);
+    dst_close(&dst, true);
+
+    assert_rnp_success(init_mem_src(&src, armored.data(), armored.size(), false));
+    assert_rnp_success(init_mem_dest(&dst, NULL, 0));
+    assert_rnp_success(rnp_dearmor_source(&src, &dst));
+    assert_int_equal(dst.writeb, data.size());
+    assert_int_equal(memcmp(mem_dest_get_memory(&dst), data.data(), data.size()), 0);
+    src_close(&src);
+    dst_close(&dst, true);
+
+    /* swap two characters in the middle of the body: crc must not match */
+    size_t pos = armored.size() / 2;
+    while ((armored[pos] == armored[pos + 1]) || !isalnum(armored[pos]) ||
+           !isalnum(armored[pos + 1])) {
+        pos++;
+    }
+    std::swap(armored[pos], armored[pos + 1]);
+    assert_false(try_dearmor(armored.data(), armored.size()));
+}
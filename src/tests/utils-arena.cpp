@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rnp_tests.h"
+#include "support.h"
+#include "arena.h"
+
+TEST_F(rnp_tests, test_utils_arena)
+{
+    arena mem = {};
+
+    // empty arena
+    assert_int_equal(arena_block_count(&mem), 0);
+    assert_int_equal(arena_block_count(NULL), 0);
+    assert_null(arena_alloc(&mem, 0));
+    assert_null(arena_alloc(NULL, 1));
+    arena_destroy(&mem);
+
+    // small allocations share the same block and are aligned
+    uint8_t *prev = NULL;
+    for (size_t i = 1; i <= 100; i++) {
+        uint8_t *buf = (uint8_t *) arena_alloc(&mem, i);
+        assert_non_null(buf);
+        assert_int_equal((uintptr_t) buf % alignof(max_align_t), 0);
+        assert_true(!prev || (buf > prev));
+        memset(buf, (int) i, i);
+        prev = buf;
+    }
+    assert_int_equal(arena_block_count(&mem), 1);
+    assert_true(mem.total >= 5050);
+
+    // allocations overflowing the block
+    for (size_t i = 0; i < 64; i++) {
+        assert_non_null(arena_alloc(&mem, 1024));
+    }
+    assert_int_equal(arena_block_count(&mem), 2);
+
+    // oversized allocation gets a dedicated block, current one is still used
+    uint8_t *big = (uint8_t *) arena_alloc(&mem, ARENA_BLOCK_SIZE * 2);
+    assert_non_null(big);
+    memset(big, 0xAA, ARENA_BLOCK_SIZE * 2);
+    assert_int_equal(arena_block_count(&mem), 3);
+    assert_non_null(arena_alloc(&mem, 16));
+    assert_int_equal(arena_block_count(&mem), 3);
+
+    // memdup
+    const char *str = "arena string";
+    char *      dup = (char *) arena_memdup(&mem, str, strlen(str) + 1);
+    assert_non_null(dup);
+    assert_string_equal(dup, str);
+    assert_true(dup != str);
+
+    // splice keeps the allocations and the current block of the destination
+    arena other = {};
+    char *odup = (char *) arena_memdup(&other, str, strlen(str) + 1);
+    assert_non_null(odup);
+    assert_non_null(arena_alloc(&other, ARENA_BLOCK_SIZE));
+    size_t   total = mem.total + other.total;
+    uint8_t *cur = (uint8_t *) arena_alloc(&mem, 16);
+    assert_non_null(cur);
+    arena_splice(&mem, &other);
+    assert_int_equal(arena_block_count(&other), 0);
+    assert_int_equal(other.total, 0);
+    assert_int_equal(arena_block_count(&mem), 5);
+    assert_int_equal(mem.total, total + 16);
+    assert_true((uint8_t *) arena_alloc(&mem, 16) == cur + 16);
+    assert_string_equal(odup, str);
+    arena_splice(&mem, &other);
+    assert_int_equal(arena_block_count(&mem), 5);
+    arena_splice(&other, &mem);
+    assert_int_equal(arena_block_count(&other), 5);
+    assert_int_equal(arena_block_count(&mem), 0);
+    arena_destroy(&other);
+
+    // destroy leaves the empty arena, which may be reused
+    arena_destroy(&mem);
+    assert_int_equal(arena_block_count(&mem), 0);
+    assert_int_equal(mem.total, 0);
+
+    // custom block size
+    mem.block_size = 64;
+    for (size_t i = 0; i < 8; i++) {
+        assert_non_null(arena_alloc(&mem, 32));
+    }
+    assert_int_equal(arena_block_count(&mem), 4);
+    assert_null(arena_alloc(&mem, SIZE_MAX));
+    arena_destroy(&mem);
+    assert_int_equal(mem.block_size, 64);
+}
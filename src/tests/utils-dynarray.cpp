@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2020 [Ribose Inc](https://www.ribose.com).
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1.  Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ * 2.  Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rnp_tests.h"
+#include "support.h"
+#include "dynarray.h"
+
+TEST_F(rnp_tests, test_utils_dynarray)
+{
+    dynarray arr = {};
+
+    // empty array
+    assert_int_equal(dynarray_length(&arr), 0);
+    assert_null(dynarray_at(&arr, 0));
+    assert_null(dynarray_back(&arr));
+    assert_int_equal(dynarray_length(NULL), 0);
+    assert_null(dynarray_at(NULL, 0));
+
+    // append with reallocations
+    for (int i = 0; i < 100; i++) {
+        int *val = (int *) dynarray_append(&arr, &i, sizeof(i));
+        assert_non_null(val);
+        assert_int_equal(*val, i);
+    }
+    assert_int_equal(dynarray_length(&arr), 100);
+    assert_true(arr.capacity >= 100);
+    for (int i = 0; i < 100; i++) {
+        assert_int_equal(*(int *) dynarray_at(&arr, i), i);
+    }
+    assert_int_equal(*(int *) dynarray_back(&arr), 99);
+    assert_null(dynarray_at(&arr, 100));
+
+    // zero-initialized item
+    int *zero = (int *) dynarray_append(&arr, NULL, sizeof(int));
+    assert_non_null(zero);
+    assert_int_equal(*zero, 0);
+    // item size mismatch
+    assert_null(dynarray_append(&arr, NULL, sizeof(uint64_t)));
+    assert_false(dynarray_reserve(&arr, 1000, sizeof(uint64_t)));
+    assert_int_equal(dynarray_length(&arr), 101);
+
+    // remove from the end, middle and start
+    dynarray_remove(&arr, 100);
+    dynarray_remove(&arr, 50);
+    dynarray_remove(&arr, 0);
+    dynarray_remove(&arr, 1000);
+    assert_int_equal(dynarray_length(&arr), 98);
+    assert_int_equal(*(int *) dynarray_at(&arr, 0), 1);
+    assert_int_equal(*(int *) dynarray_at(&arr, 48), 49);
+    assert_int_equal(*(int *) dynarray_at(&arr, 49), 51);
+    assert_int_equal(*(int *) dynarray_back(&arr), 99);
+
+    // moving the array transfers the storage
+    dynarray moved = arr;
+    memset(&arr, 0, sizeof(arr));
+    assert_int_equal(dynarray_length(&moved), 98);
+    dynarray_destroy(&arr);
+    dynarray_destroy(&moved);
+    assert_int_equal(dynarray_length(&moved), 0);
+    assert_null(moved.items);
+
+    // reserve doesn't change the length
+    assert_true(dynarray_reserve(&arr, 10, sizeof(uint64_t)));
+    assert_int_equal(dynarray_length(&arr), 0);
+    assert_int_equal(arr.capacity, 10);
+    assert_false(dynarray_reserve(&arr, 0, 0));
+    uint64_t big = 0x0102030405060708;
+    assert_non_null(dynarray_append(&arr, &big, sizeof(big)));
+    assert_int_equal(arr.capacity, 10);
+    assert_true(*(uint64_t *) dynarray_at(&arr, 0) == big);
+    dynarray_destroy(&arr);
+}